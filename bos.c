@@ -0,0 +1,744 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		bos.c
+ *
+ * @brief 		Code file for waiting on CXL FM API background operations
+ *
+ * @details 	A command that returns FMRC_BACKGROUND_OP_STARTED finishes
+ * 				later on the device. One Background Operation Status poll per
+ * 				device serves every waiter. The interval between polls follows
+ * 				the rate at which the Percent Complete advances. A scheduler
+ * 				sends the commands that may run in the background one at a
+ * 				time, the next one once the last one finished.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2026
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* INT_MAX, UINT_MAX
+ */
+#include <limits.h>
+
+/* memset()
+ */
+#include <string.h>
+
+#include "main.h"
+
+/* MACROS ====================================================================*/
+
+/**
+ * Default bounds of the poll interval in milliseconds
+ */
+#define FMBO_MIN_MS 	1
+#define FMBO_MAX_MS 	1000
+
+/**
+ * Times a background job is sent while the device reports FMRC_BUSY
+ */
+#define FMBO_BUSY_TRIES 	8
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Clamp a poll interval to the bounds of a poller
+ */
+static unsigned fmapi_bos_clamp(struct fmapi_bos_poller *p, __u64 ms)
+{
+	if (ms < p->min_ms)
+		return p->min_ms;
+	if (ms > p->max_ms)
+		return p->max_ms;
+	return ms;
+}
+
+/**
+ * Interval before the first poll of an operation
+ *
+ * The duration last seen for the same opcode is used when there is one.
+ * Otherwise the commands the opcode registry marks as background, such as
+ * Bind and Unbind, are expected to finish soonest.
+ */
+static unsigned fmapi_bos_first(struct fmapi_bos_poller *p, __u16 opcode)
+{
+	const struct fmapi_opcode_info *info;
+	unsigned i;
+
+	for ( i = 0 ; i < FM_BOS_HISTORY ; i++ )
+		if ( (p->hist[i].ms > 0) && (p->hist[i].opcode == opcode) )
+			return fmapi_bos_clamp(p, p->hist[i].ms);
+
+	info = fmapi_opcode_info(opcode);
+	if ( (info != NULL) && info->bg )
+		return fmapi_bos_clamp(p, 10);
+
+	return fmapi_bos_clamp(p, p->max_ms / 8);
+}
+
+/**
+ * Remember how long an operation took
+ */
+static void fmapi_bos_learn(struct fmapi_bos_poller *p, __u16 opcode, __u64 ms)
+{
+	unsigned i;
+
+	if (ms == 0)
+		ms = 1;
+
+	for ( i = 0 ; i < FM_BOS_HISTORY ; i++ )
+		if ( (p->hist[i].ms > 0) && (p->hist[i].opcode == opcode) )
+			break;
+
+	// Replace the oldest entry when the opcode is new
+	if (i == FM_BOS_HISTORY)
+		i = p->next_hist++ % FM_BOS_HISTORY;
+
+	p->hist[i].opcode = opcode;
+	p->hist[i].ms = (ms > UINT_MAX) ? UINT_MAX : ms;
+}
+
+/**
+ * Complete every waiter
+ *
+ * @param[in] p struct fmapi_bos_poller*
+ * @param[in] status int 0, or a negative enum _FMER if polling failed
+ * @param[in] bos struct fmapi_isc_bos* Final status. Ignored unless status is 0
+ */
+static void fmapi_bos_finish(struct fmapi_bos_poller *p, int status, struct fmapi_isc_bos *bos)
+{
+	struct fmapi_bos_wait *w, *next;
+
+	// Detach the waiters first so callbacks may add new ones
+	w = p->head;
+	p->head = NULL;
+	p->tail = NULL;
+
+	for ( ; w != NULL ; w = next )
+	{
+		next = w->next;
+		w->next = NULL;
+
+		w->status = status;
+		if (status == 0)
+		{
+			// The last background operation was not the one waited on
+			if ( (w->opcode != 0) && (w->opcode != bos->opcode) )
+				w->status = -FMER_INVALID;
+			w->rc = bos->rc;
+			w->ext = bos->ext;
+		}
+
+		w->done = 1;
+		if (w->cb != NULL)
+			w->cb(w);
+	}
+}
+
+/**
+ * Take in a Background Operation Status response and schedule the next poll
+ *
+ * While the Percent Complete advances the next poll is due when the operation
+ * should finish at the rate seen so far. While it does not the interval
+ * doubles.
+ *
+ * @param[in] x struct fmapi_xfer* of a struct fmapi_bos_poller
+ */
+static void fmapi_bos_done(struct fmapi_xfer *x)
+{
+	struct fmapi_bos_poller *p = (struct fmapi_bos_poller*) x->arg;
+	struct fmapi_isc_bos *bos = &p->rsp.obj.isc_bos;
+	__u64 now, dt;
+	unsigned dp;
+
+	p->inflight = 0;
+	now = fmapi_now_ms();
+
+	if (x->status != 0)
+	{
+		fmapi_bos_finish(p, (x->status < 0) ? x->status : -FMER_INVALID, NULL);
+		return;
+	}
+
+	if ( !bos->running || (bos->pcnt >= 100) )
+	{
+		fmapi_bos_learn(p, bos->opcode, now - p->start);
+		fmapi_bos_finish(p, 0, bos);
+		return;
+	}
+
+	if (bos->pcnt > p->pcnt)
+	{
+		// Percent Complete is truncated. Take the progress at its upper bound
+		// so coarse early samples do not push the next poll past the end
+		dp = bos->pcnt - p->pcnt + 1;
+		dt = now - p->pcnt_ms;
+		p->interval = fmapi_bos_clamp(p, dt * (100 - bos->pcnt) / dp);
+		p->pcnt = bos->pcnt;
+		p->pcnt_ms = now;
+	}
+	else
+		p->interval = fmapi_bos_clamp(p, (__u64) p->interval * 2);
+
+	p->due = now + p->interval;
+}
+
+/**
+ * Initialize a background operation poller for the device of a session
+ *
+ * @param[out] p struct fmapi_bos_poller*
+ * @param[in] s struct fmapi_session* Session polls are sent on
+ * @param[in] min_ms unsigned Shortest interval between polls. 0 selects a default
+ * @param[in] max_ms unsigned Longest interval between polls. 0 selects a default
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_bos_poller_init(struct fmapi_bos_poller *p, struct fmapi_session *s, unsigned min_ms, unsigned max_ms)
+{
+	// Validate Inputs
+	if ( (p == NULL) || (s == NULL) )
+		return -FMER_INVALID;
+
+	memset(p, 0, sizeof(*p));
+	p->s = s;
+	p->min_ms = (min_ms == 0) ? FMBO_MIN_MS : min_ms;
+	p->max_ms = (max_ms == 0) ? FMBO_MAX_MS : max_ms;
+	if (p->max_ms < p->min_ms)
+		p->max_ms = p->min_ms;
+
+	fmapi_fill_isc_bos(&p->req);
+
+	return 0;
+}
+
+/**
+ * Wait for the background operation of the device to finish
+ *
+ * @param[in] p struct fmapi_bos_poller*
+ * @param[in,out] w struct fmapi_bos_wait* with opcode, cb and arg set
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_bos_wait_submit(struct fmapi_bos_poller *p, struct fmapi_bos_wait *w)
+{
+	__u64 now;
+
+	// Validate Inputs
+	if ( (p == NULL) || (w == NULL) )
+		return -FMER_INVALID;
+
+	w->status = 0;
+	w->rc = 0;
+	w->ext = 0;
+	w->done = 0;
+	w->next = NULL;
+
+	// The first waiter starts the polling of a new operation
+	if (p->head == NULL)
+	{
+		now = fmapi_now_ms();
+		p->start = now;
+		p->pcnt = 0;
+		p->pcnt_ms = now;
+		p->interval = fmapi_bos_first(p, w->opcode);
+		p->due = now + p->interval;
+		p->head = w;
+	}
+	else
+		p->tail->next = w;
+	p->tail = w;
+
+	return 0;
+}
+
+/**
+ * Send the Background Operation Status poll if it is due
+ *
+ * @param[in] p struct fmapi_bos_poller*
+ * @return 1 if a poll was sent, 0 if not, or a negative enum _FMER upon error
+ */
+int fmapi_bos_poller_expire(struct fmapi_bos_poller *p)
+{
+	int rv;
+
+	if ( (p == NULL) || (p->head == NULL) || p->inflight || (fmapi_now_ms() < p->due) )
+		return 0;
+
+	memset(&p->x, 0, sizeof(p->x));
+	p->x.req = &p->req;
+	p->x.rsp = &p->rsp;
+	p->x.cb = fmapi_bos_done;
+	p->x.arg = p;
+
+	// A busy session sends the poll on a later call
+	rv = fmapi_session_submit(p->s, &p->x);
+	if (rv == -FMER_BUSY)
+		return 0;
+	if (rv < 0)
+	{
+		fmapi_bos_finish(p, rv, NULL);
+		return rv;
+	}
+
+	p->inflight = 1;
+	p->polls++;
+
+	return 1;
+}
+
+/**
+ * Milliseconds until the next poll is due
+ *
+ * @param[in] p struct fmapi_bos_poller*
+ * @return milliseconds, or -1 if no poll is due
+ */
+int fmapi_bos_poller_timeout(struct fmapi_bos_poller *p)
+{
+	__u64 now;
+
+	if ( (p == NULL) || (p->head == NULL) || p->inflight )
+		return -1;
+
+	now = fmapi_now_ms();
+	if (p->due <= now)
+		return 0;
+	if (p->due - now > INT_MAX)
+		return INT_MAX;
+
+	return p->due - now;
+}
+
+/**
+ * Wait for a waiter to complete
+ *
+ * @param[in] p struct fmapi_bos_poller*
+ * @param[in] w struct fmapi_bos_wait* submitted on p
+ * @return w->status
+ */
+int fmapi_bos_wait(struct fmapi_bos_poller *p, struct fmapi_bos_wait *w)
+{
+	int rv, ms;
+
+	if ( (p == NULL) || (w == NULL) )
+		return -FMER_INVALID;
+
+	while (!w->done)
+	{
+		rv = fmapi_bos_poller_expire(p);
+		if (w->done)
+			break;
+		if (rv < 0)
+			return rv;
+
+		// A due poll that found no free tag waits for a response to free one
+		ms = fmapi_bos_poller_timeout(p);
+		if (p->s->inflight >= p->s->window)
+			ms = -1;
+
+		rv = fmapi_session_step_ms(p->s, ms);
+		if (rv < 0)
+			fmapi_session_fail(p->s, rv);
+	}
+
+	return w->status;
+}
+
+/**
+ * Send a request and wait for it to finish, in the background if it must
+ *
+ * @param[in] p struct fmapi_bos_poller*
+ * @param[in] req struct fmapi_msg* Request to send
+ * @param[out] rsp struct fmapi_msg* to decode the response into. May be NULL
+ * @param[in] param void * passed to fmapi_msg_decode() for the response
+ * @param[out] ext __u16* Vendor Specific Extended Status of a background
+ * 				operation, else 0. May be NULL
+ * @return Response return code [FMRC] of the request or of its background
+ * 			operation, or a negative enum _FMER upon error
+ */
+int fmapi_bos_call(struct fmapi_bos_poller *p, struct fmapi_msg *req, struct fmapi_msg *rsp, void *param, __u16 *ext)
+{
+	struct fmapi_bos_wait w;
+	int rv;
+
+	// Validate Inputs
+	if ( (p == NULL) || (req == NULL) )
+		return -FMER_INVALID;
+
+	if (ext != NULL)
+		*ext = 0;
+
+	rv = fmapi_session_call(p->s, req, rsp, param);
+	if (rv != FMRC_BACKGROUND_OP_STARTED)
+		return rv;
+
+	memset(&w, 0, sizeof(w));
+	w.opcode = req->hdr.opcode;
+
+	rv = fmapi_bos_wait_submit(p, &w);
+	if (rv < 0)
+		return rv;
+
+	rv = fmapi_bos_wait(p, &w);
+	if (rv != 0)
+		return rv;
+
+	if (ext != NULL)
+		*ext = w.ext;
+
+	return w.rc;
+}
+
+/**
+ * Check whether a request may start a background operation
+ *
+ * The commands the opcode registry marks as background may always run in the
+ * background. Other requests say so in their header.
+ */
+static int fmapi_bos_is_bg(struct fmapi_msg *m)
+{
+	const struct fmapi_opcode_info *info;
+
+	info = fmapi_opcode_info(m->hdr.opcode);
+	if ( (info != NULL) && info->bg )
+		return 1;
+
+	return m->hdr.background;
+}
+
+static void fmapi_bos_sched_next(struct fmapi_bos_sched *sc);
+
+/**
+ * Complete a job
+ */
+static void fmapi_bos_job_finish(struct fmapi_bos_job *j, int status, __u16 ext)
+{
+	j->status = status;
+	j->ext = ext;
+	j->done = 1;
+	if (j->cb != NULL)
+		j->cb(j);
+}
+
+/**
+ * Complete a foreground job
+ */
+static void fmapi_bos_job_fg_done(struct fmapi_xfer *x)
+{
+	struct fmapi_bos_job *j = (struct fmapi_bos_job*) x->arg;
+
+	fmapi_bos_job_finish(j, x->status, (j->rsp != NULL) ? j->rsp->hdr.ext_status : 0);
+}
+
+/**
+ * Complete the current job once its background operation finished
+ */
+static void fmapi_bos_job_bg_done(struct fmapi_bos_wait *w)
+{
+	struct fmapi_bos_job *j = (struct fmapi_bos_job*) w->arg;
+	struct fmapi_bos_sched *sc = j->sc;
+
+	sc->cur = NULL;
+	fmapi_bos_job_finish(j, (w->status != 0) ? w->status : w->rc, w->ext);
+	fmapi_bos_sched_next(sc);
+}
+
+/**
+ * Resend the current job once the operation that kept the device busy finished
+ */
+static void fmapi_bos_job_bg_retry(struct fmapi_bos_wait *w)
+{
+	struct fmapi_bos_job *j = (struct fmapi_bos_job*) w->arg;
+	struct fmapi_bos_sched *sc = j->sc;
+
+	if (w->status < 0)
+	{
+		sc->cur = NULL;
+		fmapi_bos_job_finish(j, w->status, 0);
+		fmapi_bos_sched_next(sc);
+		return;
+	}
+
+	j->sent = 0;
+	fmapi_bos_sched_next(sc);
+}
+
+/**
+ * Take in the response to the current job
+ *
+ * STEPS
+ * 1: Wait for the background operation the job started
+ * 2: Wait for the operation keeping the device busy, then resend
+ * 3: Complete a job that finished in the foreground
+ */
+static void fmapi_bos_job_sent(struct fmapi_xfer *x)
+{
+	struct fmapi_bos_job *j = (struct fmapi_bos_job*) x->arg;
+	struct fmapi_bos_sched *sc = j->sc;
+	int rv;
+
+	memset(&j->w, 0, sizeof(j->w));
+	j->w.arg = j;
+
+	// STEP 1: Wait for the background operation the job started
+	if (x->status == FMRC_BACKGROUND_OP_STARTED)
+	{
+		j->w.opcode = j->req->hdr.opcode;
+		j->w.cb = fmapi_bos_job_bg_done;
+		rv = fmapi_bos_wait_submit(sc->p, &j->w);
+		if (rv == 0)
+			return;
+		x->status = rv;
+	}
+
+	// STEP 2: Wait for the operation keeping the device busy, then resend
+	else if ( (x->status == FMRC_BUSY) && (j->tries < FMBO_BUSY_TRIES) )
+	{
+		j->w.opcode = 0;
+		j->w.cb = fmapi_bos_job_bg_retry;
+		rv = fmapi_bos_wait_submit(sc->p, &j->w);
+		if (rv == 0)
+			return;
+		x->status = rv;
+	}
+
+	// STEP 3: Complete a job that finished in the foreground
+	sc->cur = NULL;
+	fmapi_bos_job_finish(j, x->status, (j->rsp != NULL) ? j->rsp->hdr.ext_status : 0);
+	fmapi_bos_sched_next(sc);
+}
+
+/**
+ * Send the current background job, starting the next queued one if idle
+ *
+ * Nothing is sent while the session has no free tag. A later call of
+ * fmapi_bos_sched_expire() sends it.
+ */
+static void fmapi_bos_sched_next(struct fmapi_bos_sched *sc)
+{
+	struct fmapi_bos_job *j;
+	int rv;
+
+	for (;;)
+	{
+		if (sc->cur == NULL)
+		{
+			if (sc->head == NULL)
+				return;
+			sc->cur = sc->head;
+			sc->head = sc->cur->next;
+			if (sc->head == NULL)
+				sc->tail = NULL;
+			sc->cur->next = NULL;
+		}
+
+		j = sc->cur;
+		if (j->sent)
+			return;
+
+		memset(&j->x, 0, sizeof(j->x));
+		j->x.req = j->req;
+		j->x.rsp = j->rsp;
+		j->x.param = j->param;
+		j->x.cb = fmapi_bos_job_sent;
+		j->x.arg = j;
+
+		rv = fmapi_session_submit(sc->s, &j->x);
+		if (rv == -FMER_BUSY)
+			return;
+		if (rv >= 0)
+		{
+			j->sent = 1;
+			j->tries++;
+			sc->sent++;
+			return;
+		}
+
+		// The job could not be sent. Complete it and move on
+		sc->cur = NULL;
+		fmapi_bos_job_finish(j, rv, 0);
+	}
+}
+
+/**
+ * Initialize a background operation scheduler for the device of a session
+ *
+ * @param[out] sc struct fmapi_bos_sched*
+ * @param[in] p struct fmapi_bos_poller* of the device. Its session is used
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_bos_sched_init(struct fmapi_bos_sched *sc, struct fmapi_bos_poller *p)
+{
+	// Validate Inputs
+	if ( (sc == NULL) || (p == NULL) )
+		return -FMER_INVALID;
+
+	memset(sc, 0, sizeof(*sc));
+	sc->p = p;
+	sc->s = p->s;
+
+	return 0;
+}
+
+/**
+ * Submit a job
+ *
+ * @param[in] sc struct fmapi_bos_sched*
+ * @param[in,out] j struct fmapi_bos_job* with req, rsp, param, cb and arg set
+ * @return 0 upon success, -FMER_BUSY if a foreground job found no free tag,
+ * 			or another negative enum _FMER upon error
+ */
+int fmapi_bos_job_submit(struct fmapi_bos_sched *sc, struct fmapi_bos_job *j)
+{
+	int rv;
+
+	// Validate Inputs
+	if ( (sc == NULL) || (j == NULL) || (j->req == NULL) )
+		return -FMER_INVALID;
+
+	j->status = 0;
+	j->ext = 0;
+	j->done = 0;
+	j->sent = 0;
+	j->tries = 0;
+	j->sc = sc;
+	j->next = NULL;
+
+	// Foreground jobs are sent right away
+	if (!fmapi_bos_is_bg(j->req))
+	{
+		memset(&j->x, 0, sizeof(j->x));
+		j->x.req = j->req;
+		j->x.rsp = j->rsp;
+		j->x.param = j->param;
+		j->x.cb = fmapi_bos_job_fg_done;
+		j->x.arg = j;
+
+		rv = fmapi_session_submit(sc->s, &j->x);
+		return (rv < 0) ? rv : 0;
+	}
+
+	if (sc->head == NULL)
+		sc->head = j;
+	else
+		sc->tail->next = j;
+	sc->tail = j;
+
+	fmapi_bos_sched_next(sc);
+
+	return 0;
+}
+
+/**
+ * Send what is due: a background job waiting for a tag, or a poll
+ *
+ * @param[in] sc struct fmapi_bos_sched*
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_bos_sched_expire(struct fmapi_bos_sched *sc)
+{
+	int rv;
+
+	if (sc == NULL)
+		return -FMER_INVALID;
+
+	fmapi_bos_sched_next(sc);
+
+	rv = fmapi_bos_poller_expire(sc->p);
+	return (rv < 0) ? rv : 0;
+}
+
+/**
+ * Milliseconds until fmapi_bos_sched_expire() has something to send
+ *
+ * @param[in] sc struct fmapi_bos_sched*
+ * @return milliseconds, or -1 if nothing falls due
+ */
+int fmapi_bos_sched_timeout(struct fmapi_bos_sched *sc)
+{
+	if (sc == NULL)
+		return -1;
+
+	// A job waiting for a tag is sent once a response frees one
+	if ( (sc->cur != NULL) && !sc->cur->sent )
+		return -1;
+
+	return fmapi_bos_poller_timeout(sc->p);
+}
+
+/**
+ * Wait for a job to complete
+ *
+ * @param[in] sc struct fmapi_bos_sched*
+ * @param[in] j struct fmapi_bos_job* submitted on sc
+ * @return j->status
+ */
+int fmapi_bos_job_wait(struct fmapi_bos_sched *sc, struct fmapi_bos_job *j)
+{
+	int rv, ms;
+
+	if ( (sc == NULL) || (j == NULL) )
+		return -FMER_INVALID;
+
+	while (!j->done)
+	{
+		fmapi_bos_sched_expire(sc);
+		if (j->done)
+			break;
+
+		ms = fmapi_bos_sched_timeout(sc);
+		if (sc->s->inflight >= sc->s->window)
+			ms = -1;
+
+		rv = fmapi_session_step_ms(sc->s, ms);
+		if (rv < 0)
+			fmapi_session_fail(sc->s, rv);
+	}
+
+	return j->status;
+}
+
+/**
+ * Send a request through a scheduler and wait for it to finish
+ *
+ * @param[in] sc struct fmapi_bos_sched*
+ * @param[in] req struct fmapi_msg* Request to send
+ * @param[out] rsp struct fmapi_msg* to decode the response into. May be NULL
+ * @param[in] param void * passed to fmapi_msg_decode() for the response
+ * @param[out] ext __u16* Vendor Specific Extended Status. May be NULL
+ * @return Response return code [FMRC] of the request or of its background
+ * 			operation, or a negative enum _FMER upon error
+ */
+int fmapi_bos_sched_call(struct fmapi_bos_sched *sc, struct fmapi_msg *req, struct fmapi_msg *rsp, void *param, __u16 *ext)
+{
+	struct fmapi_bos_job j;
+	int rv;
+
+	// Validate Inputs
+	if ( (sc == NULL) || (req == NULL) )
+		return -FMER_INVALID;
+
+	memset(&j, 0, sizeof(j));
+	j.req = req;
+	j.rsp = rsp;
+	j.param = param;
+
+	// A foreground job finding no free tag waits for one like fmapi_session_call()
+	while ( (rv = fmapi_bos_job_submit(sc, &j)) == -FMER_BUSY )
+	{
+		rv = fmapi_session_step(sc->s);
+		if (rv < 0)
+		{
+			fmapi_session_fail(sc->s, rv);
+			return rv;
+		}
+	}
+	if (rv < 0)
+		return rv;
+
+	rv = fmapi_bos_job_wait(sc, &j);
+	if (ext != NULL)
+		*ext = j.ext;
+
+	return rv;
+}
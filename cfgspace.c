@@ -0,0 +1,662 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		cfgspace.c
+ *
+ * @brief 		Code file for reading PCIe configuration space images through
+ * 				the CXL FM API
+ *
+ * @details 	Send PPB CXL.io Configuration and Send LD CXL.io Configuration
+ * 				move one DWord per request. The DWords of an image are read
+ * 				with a window of requests in flight on a session and the
+ * 				capability lists are walked with the offsets of
+ * 				<linux/pci_regs.h>. A cache of DWords answers repeat reads
+ * 				and is invalidated per port by Physical Port Control and
+ * 				Bind / Unbind.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2026
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* calloc(), free()
+ */
+#include <stdlib.h>
+
+/* memset(), memcpy()
+ */
+#include <string.h>
+
+#include "main.h"
+
+/* MACROS ====================================================================*/
+
+/**
+ * Number of DWords in an image
+ */
+#define FMCF_DWORDS 	(FM_CFG_SPACE_LEN / 4)
+
+/**
+ * Test / set a DWord in a DWord bitmask
+ */
+#define FMCF_TEST(map, i) 	((map)[(i) >> 3] & (1 << ((i) & 7)))
+#define FMCF_SET(map, i) 	((map)[(i) >> 3] |= (1 << ((i) & 7)))
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * One configuration read in flight
+ */
+struct fmapi_cfg_slot
+{
+	struct fmapi_pipe_slot ps;			//!< Slot of the pipe. Must be first
+	struct fmapi_msg req;				//!< Request
+	unsigned dw;						//!< Index of the DWord read
+};
+
+/**
+ * State of a set of configuration reads
+ */
+struct fmapi_cfg_read
+{
+	struct fmapi_session *s;			//!< Session the requests are sent on
+	int ppid;							//!< Physical port of the PPB or MLD
+	int ldid;							//!< Target LD ID, or -1 for the PPB
+	struct fmapi_cfg_image *img;		//!< Image to fill
+	const __u32 *gen;					//!< Generation of the port in a cache. NULL if not cached
+	__u32 gen0;							//!< Generation when the reads started
+	const __u8 *want;					//!< Bitmask of DWords being fetched
+	unsigned dw;						//!< Next DWord of want to consider
+	struct fmapi_pipe p;				//!< Requests in flight
+};
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Store the read data of a configuration response in the image
+ *
+ * Both response payloads are the 4 data bytes. When the image belongs to a
+ * cache that was invalidated since the read was sent the data is passed on
+ * but not marked valid.
+ */
+static int fmapi_cfg_decode(struct fmapi_xfer *x, __u8 *frame, size_t len)
+{
+	struct fmapi_cfg_slot *sl = (struct fmapi_cfg_slot*) x->arg;
+	struct fmapi_cfg_read *op = (struct fmapi_cfg_read*) sl->ps.pipe->arg;
+	struct fmapi_cfg_image *img = op->img;
+
+	if (len < FMLN_HDR + 4)
+		return -FMER_TRUNCATED;
+
+	memcpy(&img->data[sl->dw * 4], &frame[FMLN_HDR], 4);
+	if ( (op->gen == NULL) || (*op->gen == op->gen0) )
+		FMCF_SET(img->valid, sl->dw);
+
+	return 0;
+}
+
+/**
+ * Prepare the read of the next DWord wanted that is not already in the image
+ *
+ * @return 1 if a request was filled, 0 once every DWord wanted is sent
+ */
+static int fmapi_cfg_next(struct fmapi_pipe *p, struct fmapi_pipe_slot *ps)
+{
+	struct fmapi_cfg_read *op = (struct fmapi_cfg_read*) p->arg;
+	struct fmapi_cfg_slot *sl = (struct fmapi_cfg_slot*) ps;
+	__u8 zero[4];
+	unsigned off;
+
+	while ( (op->dw < FMCF_DWORDS) && (!FMCF_TEST(op->want, op->dw) || FMCF_TEST(op->img->valid, op->dw)) )
+		op->dw++;
+	if (op->dw >= FMCF_DWORDS)
+		return 0;
+
+	sl->dw = op->dw++;
+	off = sl->dw * 4;
+	memset(zero, 0, sizeof(zero));
+	if (op->ldid < 0)
+		fmapi_fill_psc_cfg(&sl->req, op->ppid, off & 0xFF, (off >> 8) & 0x0F, 0x0F, FMCT_READ, NULL);
+	else
+		fmapi_fill_mpc_cfg(&sl->req, op->ppid, op->ldid, off & 0xFF, (off >> 8) & 0x0F, 0x0F, FMCT_READ, zero);
+
+	sl->ps.x.req = &sl->req;
+	sl->ps.x.decode = fmapi_cfg_decode;
+
+	return 1;
+}
+
+/**
+ * Read every DWord set in want that is not already in the image
+ *
+ * @param[in] op struct fmapi_cfg_read*
+ * @param[in] want __u8* Bitmask of DWords to read
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+static int fmapi_cfg_fetch(struct fmapi_cfg_read *op, const __u8 *want)
+{
+	op->want = want;
+	op->dw = 0;
+
+	return fmapi_pipe_run(&op->p);
+}
+
+/**
+ * Read a byte range into the image
+ */
+static int fmapi_cfg_fetch_range(struct fmapi_cfg_read *op, unsigned off, unsigned len)
+{
+	__u8 want[FMCF_DWORDS / 8];
+	unsigned dw;
+
+	memset(want, 0, sizeof(want));
+	for ( dw = off / 4 ; (dw < FMCF_DWORDS) && (dw * 4 < off + len) ; dw++ )
+		FMCF_SET(want, dw);
+
+	return fmapi_cfg_fetch(op, want);
+}
+
+/**
+ * Get a DWord of the image, reading it first if needed
+ */
+static int fmapi_cfg_dword(struct fmapi_cfg_read *op, unsigned off, __u32 *val)
+{
+	int rv;
+
+	off &= ~3U;
+	if (!FMCF_TEST(op->img->valid, off / 4))
+	{
+		rv = fmapi_cfg_fetch_range(op, off, 4);
+		if (rv != 0)
+			return rv;
+	}
+
+	*val = fmapi_get_le32(&op->img->data[off]);
+	return 0;
+}
+
+/**
+ * Record a capability found while walking a list
+ *
+ * @return 0 upon success, -FMER_OVERFLOW if the table is full
+ */
+static int fmapi_cfg_add(struct fmapi_cfg_image *img, __u16 id, __u16 off, int ext)
+{
+	if (img->num >= FM_MAX_CFG_CAPS)
+		return -FMER_OVERFLOW;
+
+	img->cap[img->num].id = id;
+	img->cap[img->num].off = off;
+	img->cap[img->num].ext = ext;
+	img->num++;
+
+	return 0;
+}
+
+/**
+ * Walk the capability list and the extended capability list
+ *
+ * Each header not yet in the image is one dependent read. A loop in a list
+ * or an offset outside its region ends the walk of that list.
+ *
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+static int fmapi_cfg_walk(struct fmapi_cfg_read *op)
+{
+	struct fmapi_cfg_image *img = op->img;
+	__u32 val;
+	unsigned off, n;
+	int rv;
+
+	img->num = 0;
+
+	// Capability list, present if the Status register says so
+	rv = fmapi_cfg_dword(op, PCI_COMMAND, &val);
+	if (rv != 0)
+		return rv;
+	if ( (val >> 16) & PCI_STATUS_CAP_LIST )
+	{
+		rv = fmapi_cfg_dword(op, PCI_CAPABILITY_LIST, &val);
+		if (rv != 0)
+			return rv;
+
+		off = val & 0xFC;
+		for ( n = 0 ; (off >= PCI_STD_HEADER_SIZEOF) && (n < (PCI_CFG_SPACE_SIZE - PCI_STD_HEADER_SIZEOF) / PCI_CAP_SIZEOF) ; n++ )
+		{
+			rv = fmapi_cfg_dword(op, off, &val);
+			if (rv != 0)
+				return rv;
+
+			if (fmapi_cfg_add(img, val & 0xFF, off, 0) != 0)
+				break;
+
+			off = (val >> (8 * PCI_CAP_LIST_NEXT)) & 0xFC;
+		}
+	}
+
+	// Extended capability list, starting right after the legacy region
+	off = PCI_CFG_SPACE_SIZE;
+	for ( n = 0 ; (off >= PCI_CFG_SPACE_SIZE) && (n < (PCI_CFG_SPACE_EXP_SIZE - PCI_CFG_SPACE_SIZE) / PCI_CAP_SIZEOF) ; n++ )
+	{
+		rv = fmapi_cfg_dword(op, off, &val);
+		if (rv != 0)
+			return rv;
+
+		// No extended capabilities, or a function without extended space
+		if ( (val == 0) || (val == 0xFFFFFFFF) )
+			break;
+
+		if (fmapi_cfg_add(img, PCI_EXT_CAP_ID(val), off, 1) != 0)
+			break;
+
+		off = PCI_EXT_CAP_NEXT(val);
+	}
+
+	return 0;
+}
+
+/**
+ * Check whether a filter selects a capability
+ */
+static int fmapi_cfg_match(const struct fmapi_cfg_filter *f, struct fmapi_cfg_cap *c)
+{
+	unsigned i;
+
+	if (c->ext)
+	{
+		for ( i = 0 ; i < f->next ; i++ )
+			if (f->ext[i] == c->id)
+				return 1;
+	}
+	else
+	{
+		for ( i = 0 ; i < f->ncap ; i++ )
+			if (f->cap[i] == c->id)
+				return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Mark the DWords of a capability in a bitmask
+ *
+ * A capability is taken to extend up to the next capability of its region in
+ * address order, or to the end of the region. Vendor-Specific and Designated
+ * Vendor-Specific Extended Capabilities carry their length in the second
+ * header DWord, which is read first to bound them.
+ *
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+static int fmapi_cfg_want_cap(struct fmapi_cfg_read *op, unsigned k, __u8 *want)
+{
+	struct fmapi_cfg_image *img = op->img;
+	struct fmapi_cfg_cap *c = &img->cap[k];
+	unsigned end, i, dw, len;
+	__u32 val;
+	int rv;
+
+	end = c->ext ? PCI_CFG_SPACE_EXP_SIZE : PCI_CFG_SPACE_SIZE;
+	for ( i = 0 ; i < img->num ; i++ )
+		if ( (img->cap[i].ext == c->ext) && (img->cap[i].off > c->off) && (img->cap[i].off < end) )
+			end = img->cap[i].off;
+
+	if ( c->ext && ((c->id == PCI_EXT_CAP_ID_VNDR) || (c->id == PCI_EXT_CAP_ID_DVSEC)) && ((unsigned) c->off + PCI_VNDR_HEADER < end) )
+	{
+		rv = fmapi_cfg_dword(op, c->off + PCI_VNDR_HEADER, &val);
+		if (rv != 0)
+			return rv;
+
+		len = PCI_VNDR_HEADER_LEN(val);
+		if ( (len > PCI_VNDR_HEADER) && (c->off + len < end) )
+			end = c->off + len;
+	}
+
+	for ( dw = c->off / 4 ; dw < (end + 3) / 4 ; dw++ )
+		FMCF_SET(want, dw);
+
+	return 0;
+}
+
+/**
+ * Read a configuration space image of a PPB or an LD
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] ppid int Physical port of the PPB or MLD
+ * @param[in] ldid int Target LD ID, or -1 to read the PPB itself
+ * @param[in] f const struct fmapi_cfg_filter* Capabilities to read. NULL reads everything
+ * @param[out] img struct fmapi_cfg_image* to fill
+ * @param[in] depth unsigned Maximum number of requests in flight. 0 selects a default
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+int fmapi_cfg_snapshot(struct fmapi_session *s, int ppid, int ldid, const struct fmapi_cfg_filter *f, struct fmapi_cfg_image *img, unsigned depth)
+{
+	struct fmapi_cfg_read op;
+	__u8 want[FMCF_DWORDS / 8];
+	unsigned i;
+	int rv;
+
+	// Validate Inputs
+	if ( (s == NULL) || (img == NULL) || (ppid < 0) || (ppid >= FM_MAX_PORTS) )
+		return -FMER_INVALID;
+
+	memset(img, 0, sizeof(*img));
+	memset(&op, 0, sizeof(op));
+	op.s = s;
+	op.ppid = ppid;
+	op.ldid = ldid;
+	op.img = img;
+
+	rv = fmapi_pipe_init(&op.p, s, depth, sizeof(struct fmapi_cfg_slot), fmapi_cfg_next, &op);
+	if (rv != 0)
+		return rv;
+
+	/* STEPS
+	 * 1: Read the standard header, or everything when there is no filter
+	 * 2: Walk the capability lists
+	 * 3: Read the capabilities selected by the filter
+	 */
+
+	// STEP 1: Read the standard header, or everything when there is no filter
+	if (f == NULL)
+		rv = fmapi_cfg_fetch_range(&op, 0, FM_CFG_SPACE_LEN);
+	else
+		rv = fmapi_cfg_fetch_range(&op, 0, PCI_STD_HEADER_SIZEOF);
+	if (rv != 0)
+		goto end;
+
+	// STEP 2: Walk the capability lists
+	rv = fmapi_cfg_walk(&op);
+	if ( (rv != 0) || (f == NULL) )
+		goto end;
+
+	// STEP 3: Read the capabilities selected by the filter
+	memset(want, 0, sizeof(want));
+	for ( i = 0 ; (i < img->num) && (rv == 0) ; i++ )
+		if (fmapi_cfg_match(f, &img->cap[i]))
+			rv = fmapi_cfg_want_cap(&op, i, want);
+	if (rv == 0)
+		rv = fmapi_cfg_fetch(&op, want);
+
+end:
+
+	fmapi_pipe_free(&op.p);
+
+	return rv;
+}
+
+/**
+ * Find a capability in an image
+ *
+ * @param[in] img struct fmapi_cfg_image* filled by fmapi_cfg_snapshot()
+ * @param[in] id unsigned Capability ID [PCI_CAP_ID_*] or Extended Capability ID [PCI_EXT_CAP_ID_*]
+ * @param[in] ext int 1 to look for an extended capability
+ * @return offset of the first matching capability, or 0 if not found
+ */
+unsigned fmapi_cfg_find(struct fmapi_cfg_image *img, unsigned id, int ext)
+{
+	unsigned i;
+
+	if (img == NULL)
+		return 0;
+
+	for ( i = 0 ; i < img->num ; i++ )
+		if ( (img->cap[i].id == id) && (img->cap[i].ext == (ext != 0)) )
+			return img->cap[i].off;
+
+	return 0;
+}
+
+/**
+ * Drop the cached DWords of a port
+ */
+static void fmapi_cfg_cache_drop(struct fmapi_cfg_cache *c, int ppid)
+{
+	unsigned i;
+
+	c->gen[ppid]++;
+	for ( i = 0 ; i <= FM_MAX_NUM_LD ; i++ )
+		if (c->img[ppid][i] != NULL)
+			memset(c->img[ppid][i]->valid, 0, sizeof(c->img[ppid][i]->valid));
+}
+
+/**
+ * Initialize a configuration space cache
+ *
+ * @param[out] c struct fmapi_cfg_cache*
+ * @param[in] s struct fmapi_session* Session misses and writes are sent on
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_cfg_cache_init(struct fmapi_cfg_cache *c, struct fmapi_session *s)
+{
+	// Validate Inputs
+	if ( (c == NULL) || (s == NULL) )
+		return -FMER_INVALID;
+
+	memset(c, 0, sizeof(*c));
+	c->s = s;
+
+	return 0;
+}
+
+/**
+ * Release the memory held by a configuration space cache
+ *
+ * @param[in] c struct fmapi_cfg_cache*
+ */
+void fmapi_cfg_cache_free(struct fmapi_cfg_cache *c)
+{
+	unsigned p, i;
+
+	if (c == NULL)
+		return;
+
+	for ( p = 0 ; p < FM_MAX_PORTS ; p++ )
+	{
+		for ( i = 0 ; i <= FM_MAX_NUM_LD ; i++ )
+		{
+			free(c->img[p][i]);
+			c->img[p][i] = NULL;
+		}
+	}
+}
+
+/**
+ * Read configuration space bytes through a cache
+ *
+ * @param[in] c struct fmapi_cfg_cache*
+ * @param[in] ppid int Physical port of the PPB or MLD
+ * @param[in] ldid int Target LD ID, or -1 for the PPB itself
+ * @param[in] off unsigned Byte offset of the first byte
+ * @param[in] len unsigned Number of bytes to read
+ * @param[out] buf void* Receives len bytes
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+int fmapi_cfg_cache_read(struct fmapi_cfg_cache *c, int ppid, int ldid, unsigned off, unsigned len, void *buf)
+{
+	struct fmapi_cfg_read op;
+	struct fmapi_cfg_image *img;
+	unsigned dw;
+	int rv;
+
+	// Validate Inputs
+	if ( (c == NULL) || (buf == NULL) || (ppid < 0) || (ppid >= FM_MAX_PORTS) )
+		return -FMER_INVALID;
+	if ( (ldid < -1) || (ldid >= FM_MAX_NUM_LD) )
+		return -FMER_INVALID;
+	if ( (off > FM_CFG_SPACE_LEN) || (len > FM_CFG_SPACE_LEN - off) )
+		return -FMER_INVALID;
+
+	img = c->img[ppid][ldid + 1];
+	if (img == NULL)
+	{
+		img = calloc(1, sizeof(struct fmapi_cfg_image));
+		if (img == NULL)
+			return -FMER_OVERFLOW;
+		c->img[ppid][ldid + 1] = img;
+	}
+
+	// Count the DWords found in the cache
+	for ( dw = off / 4 ; dw * 4 < off + len ; dw++ )
+	{
+		if (FMCF_TEST(img->valid, dw))
+			c->hits++;
+		else
+			c->misses++;
+	}
+
+	memset(&op, 0, sizeof(op));
+	op.s = c->s;
+	op.ppid = ppid;
+	op.ldid = ldid;
+	op.img = img;
+	op.gen = &c->gen[ppid];
+	op.gen0 = c->gen[ppid];
+
+	rv = fmapi_pipe_init(&op.p, c->s, 0, sizeof(struct fmapi_cfg_slot), fmapi_cfg_next, &op);
+	if (rv != 0)
+		return rv;
+
+	rv = fmapi_cfg_fetch_range(&op, off, len);
+	if (rv == 0)
+		memcpy(buf, &img->data[off], len);
+
+	fmapi_pipe_free(&op.p);
+
+	return rv;
+}
+
+/**
+ * Write a configuration space DWord through a cache
+ *
+ * @param[in] c struct fmapi_cfg_cache*
+ * @param[in] ppid int Physical port of the PPB or MLD
+ * @param[in] ldid int Target LD ID, or -1 for the PPB itself
+ * @param[in] off unsigned Byte offset of the DWord
+ * @param[in] fdbe int Byte Enables of the bytes to write
+ * @param[in] val __u32 Value to write
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+int fmapi_cfg_cache_write(struct fmapi_cfg_cache *c, int ppid, int ldid, unsigned off, int fdbe, __u32 val)
+{
+	struct fmapi_cfg_image *img;
+	struct fmapi_msg req;
+	__u8 data[4];
+	int rv;
+
+	// Validate Inputs
+	if ( (c == NULL) || (ppid < 0) || (ppid >= FM_MAX_PORTS) )
+		return -FMER_INVALID;
+	if ( (ldid < -1) || (ldid >= FM_MAX_NUM_LD) || (off >= FM_CFG_SPACE_LEN) || (off & 3) )
+		return -FMER_INVALID;
+
+	fmapi_put_le32(data, val);
+	if (ldid < 0)
+		fmapi_fill_psc_cfg(&req, ppid, off & 0xFF, (off >> 8) & 0x0F, fdbe & 0x0F, FMCT_WRITE, data);
+	else
+		fmapi_fill_mpc_cfg(&req, ppid, ldid, off & 0xFF, (off >> 8) & 0x0F, fdbe & 0x0F, FMCT_WRITE, data);
+
+	// Reads of this DWord that complete from now on are not cached
+	c->gen[ppid]++;
+	img = c->img[ppid][ldid + 1];
+	if (img != NULL)
+		img->valid[(off / 4) >> 3] &= ~(1 << ((off / 4) & 7));
+
+	rv = fmapi_session_call(c->s, &req, NULL, NULL);
+
+	return rv;
+}
+
+/**
+ * Drop the cached DWords of a port
+ *
+ * @param[in] c struct fmapi_cfg_cache*
+ * @param[in] ppid int Physical port, or -1 for every port
+ */
+void fmapi_cfg_cache_invalidate(struct fmapi_cfg_cache *c, int ppid)
+{
+	int p;
+
+	if ( (c == NULL) || (ppid >= FM_MAX_PORTS) )
+		return;
+
+	if (ppid >= 0)
+	{
+		fmapi_cfg_cache_drop(c, ppid);
+		return;
+	}
+
+	for ( p = 0 ; p < FM_MAX_PORTS ; p++ )
+		fmapi_cfg_cache_drop(c, p);
+}
+
+/**
+ * Drop the cached DWords a request may change
+ *
+ * Physical Port Control drops its port. Bind drops the bound port. Unbind
+ * names a vPPB rather than a port and drops every port.
+ *
+ * @param[in] c struct fmapi_cfg_cache*
+ * @param[in] m struct fmapi_msg* Request sent, or about to be sent
+ */
+void fmapi_cfg_cache_note(struct fmapi_cfg_cache *c, struct fmapi_msg *m)
+{
+	if ( (c == NULL) || (m == NULL) )
+		return;
+
+	switch (m->hdr.opcode)
+	{
+		case FMOP_PSC_PORT_CTRL:
+			fmapi_cfg_cache_invalidate(c, m->obj.psc_port_ctrl_req.ppid);
+			break;
+
+		case FMOP_VSC_BIND:
+			fmapi_cfg_cache_invalidate(c, m->obj.vsc_bind_req.ppid);
+			break;
+
+		case FMOP_VSC_UNBIND:
+			// The request carries the VCS ID, vPPB ID and unbind option but
+			// no PPB ID, and the cache does not track which port each vPPB
+			// is bound to, so the unbound port cannot be singled out
+			fmapi_cfg_cache_invalidate(c, -1);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+ * Send a request and wait for its response, keeping a cache coherent
+ *
+ * The cached DWords the request may change are dropped when it is sent and
+ * again when it completes, so reads that raced with it are not kept.
+ *
+ * @param[in] c struct fmapi_cfg_cache*
+ * @param[in] req struct fmapi_msg* Request to send
+ * @param[out] rsp struct fmapi_msg* to decode the response into. May be NULL
+ * @param[in] param void * passed to fmapi_msg_decode() for the response
+ * @return Response return code [FMRC], or a negative enum _FMER upon error
+ */
+int fmapi_cfg_cache_call(struct fmapi_cfg_cache *c, struct fmapi_msg *req, struct fmapi_msg *rsp, void *param)
+{
+	int rv;
+
+	// Validate Inputs
+	if ( (c == NULL) || (req == NULL) )
+		return -FMER_INVALID;
+
+	fmapi_cfg_cache_note(c, req);
+	rv = fmapi_session_call(c->s, req, rsp, param);
+	fmapi_cfg_cache_note(c, req);
+
+	return rv;
+}
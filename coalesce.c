@@ -0,0 +1,434 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		coalesce.c
+ *
+ * @brief 		Code file for coalescing CXL FM API Get Physical Port State
+ * 				queries
+ *
+ * @details 	Queries for single ports are merged into one FMOP_PSC_PORT
+ * 				request and the returned port info blocks are handed back to
+ * 				each query.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2026
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* INT_MAX
+ */
+#include <limits.h>
+
+/* calloc(), free()
+ */
+#include <stdlib.h>
+
+/* memset()
+ */
+#include <string.h>
+
+#include "main.h"
+
+/* MACROS ====================================================================*/
+
+/**
+ * Test / set a port in a port bitmask
+ */
+#define FMPQ_TEST(map, p) 	((map)[(p) >> 3] & (1 << ((p) & 7)))
+#define FMPQ_SET(map, p) 	((map)[(p) >> 3] |= (1 << ((p) & 7)))
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * Batch of port queries sent as one Get Physical Port State request
+ */
+struct fmapi_port_batch
+{
+	struct fmapi_xfer x;				//!< Exchange of the request
+	struct fmapi_msg req;				//!< Get Physical Port State request
+	struct fmapi_msg rsp;				//!< Get Physical Port State response
+	struct fmapi_port_query *head;		//!< Queries answered by this request
+	struct fmapi_port_coalescer *c;		//!< Owner
+	struct fmapi_port_batch *next;		//!< Next idle batch
+};
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Number of ports whose info blocks fit in one response of the session
+ */
+static unsigned fmapi_port_coalescer_max(struct fmapi_port_coalescer *c)
+{
+	return fmapi_session_list_max(c->s, FMLN_PSC_GET_PHY_PORT_RESP, FMLN_PSC_GET_PHY_PORT_INFO);
+}
+
+/**
+ * Hand the response of a batch to each of its queries
+ *
+ * @param[in] x struct fmapi_xfer* of a struct fmapi_port_batch
+ */
+static void fmapi_port_batch_done(struct fmapi_xfer *x)
+{
+	struct fmapi_port_batch *b = (struct fmapi_port_batch*) x->arg;
+	struct fmapi_port_coalescer *c = b->c;
+	struct fmapi_psc_port_rsp *r = &b->rsp.obj.psc_port_rsp;
+	struct fmapi_port_query *q, *next;
+	short idx[FM_MAX_PORTS];
+	unsigned i;
+
+	// Index the returned info blocks by port
+	if (x->status == 0)
+	{
+		memset(idx, 0xFF, sizeof(idx));
+		for ( i = 0 ; i < r->num ; i++ )
+			idx[r->list[i].ppid] = i;
+	}
+
+	// Detach the queries first so callbacks may submit new ones
+	q = b->head;
+	b->head = NULL;
+	b->next = c->idle;
+	c->idle = b;
+
+	for ( ; q != NULL ; q = next )
+	{
+		next = q->next;
+		q->next = NULL;
+		q->x = NULL;
+
+		q->status = x->status;
+		if (x->status == 0)
+		{
+			if (idx[q->ppid] < 0)
+				q->status = -FMER_INVALID;
+			else
+				q->info = r->list[idx[q->ppid]];
+		}
+
+		q->done = 1;
+		c->queries++;
+		if (q->cb != NULL)
+			q->cb(q);
+	}
+}
+
+/**
+ * Move up to one request worth of pending queries into an idle batch and send it
+ *
+ * @param[in] c struct fmapi_port_coalescer* with queries pending
+ * @return 1 upon success, -FMER_BUSY if no batch or tag is free, or another
+ * 			negative enum _FMER upon error
+ */
+static int fmapi_port_coalescer_send(struct fmapi_port_coalescer *c)
+{
+	struct fmapi_port_query *q, *next, *head, *tail, **bt;
+	struct fmapi_port_batch *b;
+	__u8 map[FM_MAX_PORTS/8];
+	__u8 ports[FM_MAX_LIST];
+	unsigned max, num;
+	int rv;
+
+	if ( (c->idle == NULL) || (c->s->inflight >= c->s->window) )
+		return -FMER_BUSY;
+
+	b = c->idle;
+	max = fmapi_port_coalescer_max(c);
+
+	// Take the oldest ports that fit, along with every query for the same port
+	memset(map, 0, sizeof(map));
+	memset(c->map, 0, sizeof(c->map));
+	c->num = 0;
+	num = 0;
+	head = tail = NULL;
+	bt = &b->head;
+	for ( q = c->head ; q != NULL ; q = next )
+	{
+		next = q->next;
+		q->next = NULL;
+
+		if (!FMPQ_TEST(map, q->ppid) && (num < max))
+		{
+			FMPQ_SET(map, q->ppid);
+			ports[num++] = q->ppid;
+		}
+
+		if (FMPQ_TEST(map, q->ppid))
+		{
+			q->x = &b->x;
+			*bt = q;
+			bt = &q->next;
+			continue;
+		}
+
+		// Keep the rest pending in order
+		if (!FMPQ_TEST(c->map, q->ppid))
+		{
+			FMPQ_SET(c->map, q->ppid);
+			c->num++;
+		}
+		if (tail == NULL)
+			head = q;
+		else
+			tail->next = q;
+		tail = q;
+	}
+
+	// Queries left behind have waited long enough already
+	c->head = head;
+	c->tail = tail;
+	if (head != NULL)
+		c->deadline = fmapi_now_ms();
+
+	fmapi_fill_psc_get_ports(&b->req, num, ports);
+	memset(&b->x, 0, sizeof(b->x));
+	b->x.req = &b->req;
+	b->x.rsp = &b->rsp;
+	b->x.cb = fmapi_port_batch_done;
+	b->x.arg = b;
+	c->idle = b->next;
+
+	rv = fmapi_session_submit(c->s, &b->x);
+	if (rv < 0)
+	{
+		// Fail the queries of the batch rather than reordering them
+		b->x.status = rv;
+		fmapi_port_batch_done(&b->x);
+		return rv;
+	}
+
+	c->requests++;
+	return 1;
+}
+
+/**
+ * Initialize a port query coalescer
+ *
+ * @param[out] c struct fmapi_port_coalescer* to initialize
+ * @param[in] s struct fmapi_session* to send requests on
+ * @param[in] hold_ms unsigned Longest time a query waits for others
+ * @param[in] nbatch unsigned Maximum number of requests in flight. 0 selects 1
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_port_coalescer_init(struct fmapi_port_coalescer *c, struct fmapi_session *s, unsigned hold_ms, unsigned nbatch)
+{
+	unsigned i;
+
+	// Validate Inputs
+	if ( (c == NULL) || (s == NULL) || (nbatch > FM_MAX_TAGS) )
+		return -FMER_INVALID;
+
+	memset(c, 0, sizeof(*c));
+	c->s = s;
+	c->hold_ms = hold_ms;
+	c->nbatch = (nbatch == 0) ? 1 : nbatch;
+
+	c->batch = calloc(c->nbatch, sizeof(struct fmapi_port_batch));
+	if (c->batch == NULL)
+		return -FMER_OVERFLOW;
+
+	for ( i = 0 ; i < c->nbatch ; i++ )
+	{
+		c->batch[i].c = c;
+		c->batch[i].next = c->idle;
+		c->idle = &c->batch[i];
+	}
+
+	return 0;
+}
+
+/**
+ * Release the batches of a coalescer
+ *
+ * @param[in] c struct fmapi_port_coalescer*
+ */
+void fmapi_port_coalescer_free(struct fmapi_port_coalescer *c)
+{
+	if (c == NULL)
+		return;
+
+	free(c->batch);
+	c->batch = NULL;
+	c->idle = NULL;
+	c->nbatch = 0;
+}
+
+/**
+ * Queue a Get Physical Port State query
+ *
+ * @param[in] c struct fmapi_port_coalescer*
+ * @param[in,out] q struct fmapi_port_query* with ppid set
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_port_query_submit(struct fmapi_port_coalescer *c, struct fmapi_port_query *q)
+{
+	int rv;
+
+	// Validate Inputs
+	if ( (c == NULL) || (q == NULL) )
+		return -FMER_INVALID;
+
+	q->status = 0;
+	q->done = 0;
+	q->x = NULL;
+	q->next = NULL;
+
+	if (c->head == NULL)
+	{
+		c->head = q;
+		c->deadline = fmapi_now_ms() + c->hold_ms;
+	}
+	else
+		c->tail->next = q;
+	c->tail = q;
+
+	if (!FMPQ_TEST(c->map, q->ppid))
+	{
+		FMPQ_SET(c->map, q->ppid);
+		c->num++;
+	}
+
+	// Send as soon as a request is full. A busy session sends it later
+	if (c->num >= fmapi_port_coalescer_max(c))
+	{
+		rv = fmapi_port_coalescer_send(c);
+		if ( (rv < 0) && (rv != -FMER_BUSY) )
+			return rv;
+	}
+
+	return 0;
+}
+
+/**
+ * Send every pending query
+ *
+ * @param[in] c struct fmapi_port_coalescer*
+ * @return number of requests sent, -FMER_BUSY if queries remain pending, or
+ * 			another negative enum _FMER upon error
+ */
+int fmapi_port_coalescer_flush(struct fmapi_port_coalescer *c)
+{
+	int rv, sent;
+
+	if (c == NULL)
+		return -FMER_INVALID;
+
+	sent = 0;
+	while (c->head != NULL)
+	{
+		rv = fmapi_port_coalescer_send(c);
+		if (rv < 0)
+			return rv;
+		sent++;
+	}
+
+	return sent;
+}
+
+/**
+ * Send the pending queries if they were held for hold_ms
+ *
+ * @param[in] c struct fmapi_port_coalescer*
+ * @return number of requests sent, or a negative enum _FMER upon error
+ */
+int fmapi_port_coalescer_expire(struct fmapi_port_coalescer *c)
+{
+	int rv;
+
+	if ( (c == NULL) || (c->head == NULL) || (fmapi_now_ms() < c->deadline) )
+		return 0;
+
+	rv = fmapi_port_coalescer_flush(c);
+	if (rv == -FMER_BUSY)
+		return 0;
+
+	return rv;
+}
+
+/**
+ * Milliseconds until the pending queries must be sent
+ *
+ * @param[in] c struct fmapi_port_coalescer*
+ * @return milliseconds, or -1 if no query is pending
+ */
+int fmapi_port_coalescer_timeout(struct fmapi_port_coalescer *c)
+{
+	__u64 now;
+
+	if ( (c == NULL) || (c->head == NULL) )
+		return -1;
+
+	now = fmapi_now_ms();
+	if (c->deadline <= now)
+		return 0;
+	if (c->deadline - now > INT_MAX)
+		return INT_MAX;
+
+	return c->deadline - now;
+}
+
+/**
+ * Wait for a query to complete
+ *
+ * @param[in] c struct fmapi_port_coalescer*
+ * @param[in] q struct fmapi_port_query* submitted on c
+ * @return q->status
+ */
+int fmapi_port_query_wait(struct fmapi_port_coalescer *c, struct fmapi_port_query *q)
+{
+	int rv;
+
+	if ( (c == NULL) || (q == NULL) )
+		return -FMER_INVALID;
+
+	while (!q->done)
+	{
+		// Send what is pending, then make progress on what is in flight
+		if (c->head != NULL)
+		{
+			rv = fmapi_port_coalescer_flush(c);
+			if ( (rv < 0) && (rv != -FMER_BUSY) )
+				return rv;
+			if (q->done)
+				break;
+		}
+
+		rv = fmapi_session_step(c->s);
+		if (rv < 0)
+			fmapi_session_fail(c->s, rv);
+	}
+
+	return q->status;
+}
+
+/**
+ * Query the state of several ports and wait for all of them
+ *
+ * @param[in] c struct fmapi_port_coalescer*
+ * @param[in,out] q struct fmapi_port_query* Array with ppid set in each entry
+ * @param[in] num unsigned Number of entries in q
+ * @return 0 upon success, or the first non zero status of q
+ */
+int fmapi_port_query_all(struct fmapi_port_coalescer *c, struct fmapi_port_query *q, unsigned num)
+{
+	unsigned i;
+	int rv;
+
+	if ( (c == NULL) || (q == NULL) )
+		return -FMER_INVALID;
+
+	for ( i = 0 ; i < num ; i++ )
+	{
+		rv = fmapi_port_query_submit(c, &q[i]);
+		if (rv < 0)
+			return rv;
+	}
+
+	rv = 0;
+	for ( i = 0 ; i < num ; i++ )
+		if ( (fmapi_port_query_wait(c, &q[i]) != 0) && (rv == 0) )
+			rv = q[i].status;
+
+	return rv;
+}
@@ -0,0 +1,279 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		ldmem.c
+ *
+ * @brief 		Code file for bulk reads and writes of LD memory through the
+ * 				CXL FM API Send LD CXL.io Memory Request
+ *
+ * @details 	A transfer of any offset and length is split into requests
+ * 				that do not cross a 4 KB boundary and fit the message limits
+ * 				of the session. Each request covers whole
+ * 				DWords and masks the bytes outside the transfer with the
+ * 				First / Last DWord Byte Enables. A window of requests is kept
+ * 				in flight on a session.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2026
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* memset(), memcpy()
+ */
+#include <string.h>
+
+#include "main.h"
+
+/* MACROS ====================================================================*/
+
+/**
+ * Byte enables of the bytes of a DWord at and after / before a byte offset
+ */
+#define FMLM_BE_FROM(n) 	((0xF << ((n) & 3)) & 0xF)
+#define FMLM_BE_UPTO(n) 	(((n) & 3) ? ((1 << ((n) & 3)) - 1) : 0xF)
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * One Send LD CXL.io Memory Request in flight
+ */
+struct fmapi_ld_mem_slot
+{
+	struct fmapi_pipe_slot ps;			//!< Slot of the pipe. Must be first
+	struct fmapi_msg req;				//!< Request
+	__u8 *dst;							//!< Caller buffer for read data
+	unsigned skip;						//!< Bytes of the first DWord before the transfer
+	unsigned num;						//!< Bytes of the transfer carried by this request
+};
+
+/**
+ * State of a bulk transfer
+ */
+struct fmapi_ld_mem
+{
+	struct fmapi_session *s;			//!< Session the requests are sent on
+	int ppid;							//!< Physical port of the MLD
+	int ldid;							//!< Target LD ID
+	int type;							//!< Read or write [FMCT]
+	__u64 pos;							//!< Offset of the next byte to request
+	__u64 end;							//!< Offset one past the last byte
+	__u8 *buf;							//!< Caller buffer, matching offset start
+	__u64 start;						//!< Offset of buf[0]
+	unsigned max;						//!< Most bytes one request may cover. Whole DWords
+};
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Consume a Send LD CXL.io Memory response
+ *
+ * Read data is copied from the received frame straight into the caller
+ * buffer. A response that transferred fewer bytes than requested is an error.
+ *
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+static int fmapi_ld_mem_decode(struct fmapi_xfer *x, __u8 *frame, size_t len)
+{
+	struct fmapi_ld_mem_slot *sl = (struct fmapi_ld_mem_slot*) x->arg;
+	struct fmapi_ld_mem *op = (struct fmapi_ld_mem*) sl->ps.pipe->arg;
+	struct fmapi_mpc_mem_rsp_view r;
+	unsigned n;
+
+	if (len < FMLN_HDR + FMLN_MPC_LD_MEM_RESP)
+		return -FMER_TRUNCATED;
+
+	r = fmapi_mpc_mem_rsp_view(&frame[FMLN_HDR]);
+	n = fmapi_mpc_mem_rsp_view_len(r);
+	if (n < sl->req.obj.mpc_mem_req.len)
+		return -FMER_TRUNCATED;
+
+	if (op->type == FMCT_READ)
+	{
+		if (len < FMLN_HDR + FMLN_MPC_LD_MEM_RESP + sl->skip + sl->num)
+			return -FMER_TRUNCATED;
+		memcpy(sl->dst, fmapi_mpc_mem_rsp_view_data(r) + sl->skip, sl->num);
+	}
+
+	return 0;
+}
+
+/**
+ * Most bytes one request may cover on a session
+ *
+ * The codec carries len bytes of data in both the request and the response,
+ * so both limits apply. Rounded down to whole DWords, and never below one.
+ */
+static unsigned fmapi_ld_mem_max(struct fmapi_session *s)
+{
+	unsigned max;
+
+	max = FM_LD_MEM_REQ_LEN;
+	if (s->req_limit < FMLN_MPC_LD_MEM_REQ + max)
+		max = (s->req_limit > FMLN_MPC_LD_MEM_REQ) ? s->req_limit - FMLN_MPC_LD_MEM_REQ : 0;
+	if (s->rsp_limit < FMLN_MPC_LD_MEM_RESP + max)
+		max = (s->rsp_limit > FMLN_MPC_LD_MEM_RESP) ? s->rsp_limit - FMLN_MPC_LD_MEM_RESP : 0;
+	max &= ~3U;
+
+	return (max < 4) ? 4 : max;
+}
+
+/**
+ * Prepare the request for the next chunk of a transfer
+ *
+ * A chunk ends at the transfer end, at the next 4 KB boundary or where its
+ * DWords would exceed op->max bytes, whichever comes first, and is widened
+ * to whole DWords. A chunk cut at op->max ends on a DWord boundary, so the
+ * next one starts with every byte enabled.
+ *
+ * STEPS
+ * 1: Find the byte range of the chunk and the DWords covering it
+ * 2: Derive the byte enables of the first and last DWord
+ * 3: Fill the request, copying write data into place
+ *
+ * @return 1 if a request was filled, 0 once the transfer is fully sent
+ */
+static int fmapi_ld_mem_next(struct fmapi_pipe *p, struct fmapi_pipe_slot *ps)
+{
+	struct fmapi_ld_mem *op = (struct fmapi_ld_mem*) p->arg;
+	struct fmapi_ld_mem_slot *sl = (struct fmapi_ld_mem_slot*) ps;
+	__u64 a, e, first, last;
+	int fdbe, ldbe;
+	__u8 *data;
+
+	if (op->pos >= op->end)
+		return 0;
+
+	// STEP 1: Find the byte range of the chunk and the DWords covering it
+	first = op->pos;
+	a = first & ~3ULL;
+	last = (first | (FM_LD_MEM_REQ_LEN - 1)) + 1;
+	if (last > a + op->max)
+		last = a + op->max;
+	if (last > op->end)
+		last = op->end;
+	e = (last + 3) & ~3ULL;
+
+	// STEP 2: Derive the byte enables of the first and last DWord
+	fdbe = FMLM_BE_FROM(first);
+	ldbe = FMLM_BE_UPTO(last);
+	if (e - a == 4)
+	{
+		// A single DWord request uses only the First DWord Byte Enable
+		fdbe &= ldbe;
+		ldbe = 0;
+	}
+
+	sl->skip = first - a;
+	sl->num = last - first;
+	sl->dst = op->buf + (first - op->start);
+
+	// STEP 3: Fill the request, copying write data into place
+	fmapi_fill_mpc_mem(&sl->req, op->ppid, op->ldid, a, e - a, fdbe, ldbe, op->type, NULL);
+	if (op->type == FMCT_WRITE)
+	{
+		data = sl->req.obj.mpc_mem_req.data;
+		memset(data, 0, 4);
+		memset(data + ((e - a) - 4), 0, 4);
+		memcpy(data + sl->skip, sl->dst, sl->num);
+	}
+
+	sl->ps.x.req = &sl->req;
+	sl->ps.x.decode = fmapi_ld_mem_decode;
+
+	op->pos = last;
+
+	return 1;
+}
+
+/**
+ * Run a bulk transfer to completion
+ *
+ * @param[in] op struct fmapi_ld_mem* describing the transfer
+ * @param[in] depth unsigned Maximum number of requests in flight
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+static int fmapi_ld_mem_run(struct fmapi_ld_mem *op, unsigned depth)
+{
+	struct fmapi_pipe p;
+	int rv;
+
+	op->max = fmapi_ld_mem_max(op->s);
+
+	rv = fmapi_pipe_init(&p, op->s, depth, sizeof(struct fmapi_ld_mem_slot), fmapi_ld_mem_next, op);
+	if (rv != 0)
+		return rv;
+
+	rv = fmapi_pipe_run(&p);
+	fmapi_pipe_free(&p);
+
+	return rv;
+}
+
+/**
+ * Read LD memory into a buffer
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] ppid int Physical port of the MLD
+ * @param[in] ldid int Target LD ID
+ * @param[in] offset __u64 Offset of the first byte in the memory space of the LD
+ * @param[in] len size_t Number of bytes to read
+ * @param[out] buf void* Receives len bytes
+ * @param[in] depth unsigned Maximum number of requests in flight. 0 selects a default
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+int fmapi_ld_mem_read(struct fmapi_session *s, int ppid, int ldid, __u64 offset, size_t len, void *buf, unsigned depth)
+{
+	struct fmapi_ld_mem op;
+
+	// Validate Inputs
+	if ( (s == NULL) || ((buf == NULL) && (len > 0)) || (offset + len < offset) )
+		return -FMER_INVALID;
+
+	memset(&op, 0, sizeof(op));
+	op.s = s;
+	op.ppid = ppid;
+	op.ldid = ldid;
+	op.type = FMCT_READ;
+	op.pos = op.start = offset;
+	op.end = offset + len;
+	op.buf = (__u8*) buf;
+
+	return fmapi_ld_mem_run(&op, depth);
+}
+
+/**
+ * Write a buffer to LD memory
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] ppid int Physical port of the MLD
+ * @param[in] ldid int Target LD ID
+ * @param[in] offset __u64 Offset of the first byte in the memory space of the LD
+ * @param[in] len size_t Number of bytes to write
+ * @param[in] buf const void* Data to write
+ * @param[in] depth unsigned Maximum number of requests in flight. 0 selects a default
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+int fmapi_ld_mem_write(struct fmapi_session *s, int ppid, int ldid, __u64 offset, size_t len, const void *buf, unsigned depth)
+{
+	struct fmapi_ld_mem op;
+
+	// Validate Inputs
+	if ( (s == NULL) || ((buf == NULL) && (len > 0)) || (offset + len < offset) )
+		return -FMER_INVALID;
+
+	memset(&op, 0, sizeof(op));
+	op.s = s;
+	op.ppid = ppid;
+	op.ldid = ldid;
+	op.type = FMCT_WRITE;
+	op.pos = op.start = offset;
+	op.end = offset + len;
+	op.buf = (__u8*) buf;
+
+	return fmapi_ld_mem_run(&op, depth);
+}
@@ -26,59 +26,166 @@
  */
 #include <string.h>
 
+/* calloc(), free()
+ */
+#include <stdlib.h>
+
+/* pthread_key_create() for the per thread caches of struct fmapi_msg_pool
+ */
+#include <pthread.h>
+
+/* SIMD intrinsics for fmapi_deserialize_port_table()
+ */
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include "main.h"
 
 /* MACROS ====================================================================*/
 
 #define MCMT_CXLCCI 	0x08
 
+/**
+ * Layout of one object of a struct fmapi_msg_pool (PL)
+ *
+ * The struct fmapi_msg is followed by its struct fmapi_buf, each starting on 
+ * a cache line 
+ */
+#define FMPL_ALIGN 		64
+#define FMPL_BATCH 		32
+#define FMPL_ROUND(x) 	( ((x) + FMPL_ALIGN - 1) & ~((size_t) FMPL_ALIGN - 1) )
+#define FMPL_BUF 		FMPL_ROUND(sizeof(struct fmapi_msg))
+#define FMPL_STRIDE 	FMPL_ROUND(FMPL_BUF + sizeof(struct fmapi_buf))
+
 /* ENUMERATIONS ==============================================================*/
 
+/**
+ * Kinds of wire format field descriptors (FK)
+ */
+enum _FMFK 
+{
+	FMFK_INT 		= 0,	//!< Little endian integer of width bytes 
+	FMFK_BITS		= 1,	//!< Bit field of a single byte: (src >> shift) & mask 
+	FMFK_BYTES 		= 2,	//!< Fixed length byte array copied as is 
+	FMFK_MAX
+};
+
 /* STRUCTS ===================================================================*/
 
-/* GLOBAL VARIABLES ==========================================================*/
+/**
+ * Size of a deserialized FM API Object [FMOB]
+ *
+ * For objects that end in a variable length list, list is the offset of that 
+ * list and elem is the size of one entry. An object holding num entries needs 
+ * list + num * elem bytes. Only objects that are never decoded into by a 
+ * requester may be trimmed, as the decoders fill as many list entries as the 
+ * count field on the wire says.
+ */
+struct fmapi_obj_size 
+{
+	size_t size;		//!< sizeof() the full object 
+	size_t list;		//!< Offset of the trailing variable length list. 0 if none
+	size_t elem;		//!< Size of one entry in the trailing list 
+	int trim;			//!< The list may be trimmed to fewer than its full capacity
+};
 
 /**
- * String representations of FM API Command Message types (MT)
- * 
- * CXL 2.0 v1.0 Table 84
+ * Wire format descriptor of one field of an FM API Object [FMOB]
  */
-const char *STR_FMMT[] = {
-	"Request",		// FMMT_REQ		= 0
-	"Response",		// FMMT_RESP	= 1
+struct fmapi_field 
+{
+	__u8 kind;			//!< Kind of field [FMFK]
+	__u8 width;			//!< Width in bytes of the field in the object and on the wire
+	__u8 shift;			//!< FMFK_BITS: Bit position of the field in the wire byte 
+	__u8 mask;			//!< FMFK_BITS: Mask of the field after shifting 
+	__u16 off;			//!< Byte offset of the field on the wire 
+	__u16 obj;			//!< Byte offset of the field in the deserialized object 
+};
+
+/**
+ * Wire format layout of an FM API Object [FMOB]
+ *
+ * The fixed portion of the object is described by fields. Objects that end in 
+ * a variable length list also name the field holding the entry count and the 
+ * type of each entry. The list starts right after the fixed portion. 
+ */
+struct fmapi_layout 
+{
+	const struct fmapi_field *fields;	//!< Fields of the fixed portion
+	__u8 num;			//!< Number of entries in fields 
+	__u8 cnt_width;		//!< Width of the list count field. 0 if no list 
+	__u16 cnt;			//!< Offset in the object of the list count field 
+	__u16 list;			//!< Offset in the object of the list 
+	__u16 stride;		//!< Size of one list entry in the object 
+	__u8 elem;			//!< Type of each list entry [FMOB]. FMOB_NULL for bytes
+	__u8 flat;			//!< On little endian hosts the object is identical to its wire format
 };
 
-const char *STR_FMOP_1[] = {
-	"Identify Switch Device",					// FMOP_PSC_ID					= 0x5100,
-	"Get Physical Port State",					// FMOP_PSC_PORT				= 0x5101,
-	"Physical Port Control",					// FMOP_PSC_PORT_CTRL			= 0x5102,
-	"Send PPB CXL.io Configuration Request"		// FMOP_PSC_CFG					= 0x5103,
+/**
+ * Free list link of one object of a struct fmapi_msg_pool
+ *
+ * Links hold an object index + 1 so that 0 ends a chain. The first object of 
+ * a chain on the depot also holds the length of its chain and the next chain. 
+ */
+struct fmapi_pool_link
+{
+	__u32 next;			//!< Next free object in the same chain
+	__u32 batch;		//!< Depot: First object of the next chain
+	__u32 num;			//!< Depot: Number of objects in this chain
 };
 
-const char *STR_FMOP_2[] = {
-	"Get Virtual CXL Switch Info",				// FMOP_VSC_INFO				= 0x5200,
-	"Bind vPPB",								// FMOP_VSC_BIND				= 0x5201,
-	"Unbind vPPB",								// FMOP_VSC_UNBIND				= 0x5202,
-	"Generate AER Event"						// FMOP_VSC_AER					= 0x5203,
+/**
+ * Per thread cache of free objects of a struct fmapi_msg_pool 
+ *
+ * Objects are taken from and returned to cur. When cur is full it becomes 
+ * spare, and a full spare is pushed to the depot first. Caches of exited 
+ * threads stay on the pool list and are reused by new threads. 
+ */
+struct fmapi_pool_cache
+{
+	struct fmapi_pool_cache *next;	//!< Next cache of the same pool
+	struct fmapi_msg_pool *pool;	//!< Pool this cache belongs to 
+	int used;			//!< Set while the cache is owned by a thread 
+	__u32 cur;			//!< First object of the current chain 
+	__u32 ncur;			//!< Number of objects in cur 
+	__u32 spare;		//!< First object of the spare chain 
+	__u32 nspare;		//!< Number of objects in spare
 };
 
-const char *STR_FMOP_3[] = {
-	"Tunnel Management Command",				// FMOP_MPC_TMC					= 0x5300,
-	"Send LD CXL.io Configuration Request",		// FMOP_MPC_CFG					= 0x5301,
-	"Send LD CXL.io Memory Request"				// FMOP_MPC_MEM					= 0x5302,
+/**
+ * Pool of preallocated struct fmapi_msg objects 
+ *
+ * The depot is a lock free stack of chains of free objects. The low 32 bits 
+ * hold the first object of the top chain and the high 32 bits are a tag that 
+ * changes on every update so a compare and swap cannot succeed on a stale 
+ * value (ABA). It sits on its own cache line as it is written by all threads.
+ */
+struct fmapi_msg_pool
+{
+	_Alignas(FMPL_ALIGN) __u64 depot;	//!< Tag and first object of the top chain 
+	_Alignas(FMPL_ALIGN) struct fmapi_pool_cache *caches; //!< All thread caches
+	__u8 *base;			//!< Storage of all objects 
+	struct fmapi_pool_link *link; 	//!< Free list links, one per object 
+	unsigned num;		//!< Number of objects 
+	unsigned batch;		//!< Capacity of a thread cache chain 
+	pthread_key_t key;	//!< Thread specific struct fmapi_pool_cache
 };
 
-const char *STR_FMOP_4[] = {
-	"Get LD Info",								// FMOP_MCC_INFO				= 0x5400,
-	"Get LD Allocations",						// FMOP_MCC_ALLOC_GET			= 0x5401,
-	"Set LD Allocations",						// FMOP_MCC_ALLOC_SET			= 0x5402,
-	"Get QOS Control",							// FMOP_MCC_QOS_CTRL_GE			= 0x5403,
-	"Set QOS Control",							// FMOP_MCC_QOS_CTRL_SE			= 0x5404,
-	"Get QOS Status",							// FMOP_MCC_QOS_STAT			= 0x5405,
-	"Get QOS Allocated BW",						// FMOP_MCC_QOS_BW_ALLOC_GET	= 0x5406,
-	"Set QOS Allocated BW",						// FMOP_MCC_QOS_BW_ALLOC_SET	= 0x5407,
-	"Get QOS BW Limit",							// FMOP_MCC_QOS_BW_LIMIT_GET	= 0x5408,
-	"Set QOS BW Limit"							// FMOP_MCC_QOS_BW_LIMIT_SET	= 0x5409,
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * String representations of FM API Command Message types (MT)
+ * 
+ * CXL 2.0 v1.0 Table 84
+ */
+const char *STR_FMMT[] = {
+	"Request",		// FMMT_REQ		= 0
+	"Response",		// FMMT_RESP	= 1
 };
 
 /**
@@ -365,8 +472,467 @@ const char *STR_FMCT[] = {
 	"Write"	// FMCT_WRITE 	= 1
 };
 
+/**
+ * String representation of FM API Command Sets (CS)
+ *
+ * CXL 2.0 v1.0 Table 205
+ */
+const char *STR_FMCS[] = {
+	"Information and Status",	// FMCS_ISC 	= 0,
+	"Physical Switch",			// FMCS_PSC 	= 1,
+	"Virtual Switch",			// FMCS_VSC 	= 2,
+	"MLD Port",					// FMCS_MPC 	= 3,
+	"MLD Component"				// FMCS_MCC 	= 4,
+};
+
+/**
+ * String representation of Length-aware Decode Errors (ER)
+ */
+const char *STR_FMER[] = {
+	"Success",				// FMER_SUCCESS 	= 0,
+	"Invalid",				// FMER_INVALID 	= 1,
+	"Truncated",			// FMER_TRUNCATED 	= 2,
+	"Overflow",				// FMER_OVERFLOW 	= 3,
+	"Missing parameter",	// FMER_PARAM 		= 4,
+	"I/O error",			// FMER_IO 			= 5,
+	"Connection closed",	// FMER_CLOSED 		= 6,
+	"Busy",					// FMER_BUSY 		= 7,
+	"Timeout"				// FMER_TIMEOUT 	= 8,
+};
+
+/**
+ * Serialized length in bytes of the fixed portion of each FM API Object [FMOB]
+ *
+ * This length excludes any variable length data that comes after the object
+ */
+static const unsigned FMLN_FMOB[FMOB_MAX] = {
+	[FMOB_NULL]						= 0,
+	[FMOB_HDR]						= FMLN_HDR,
+	[FMOB_PSC_ID_RSP]				= FMLN_PSC_IDENTIFY_SWITCH,
+	[FMOB_PSC_PORT_REQ]				= FMLN_PSC_GET_PHY_PORT_REQ,
+	[FMOB_PSC_PORT_INFO]			= FMLN_PSC_GET_PHY_PORT_INFO,
+	[FMOB_PSC_PORT_RSP]				= FMLN_PSC_GET_PHY_PORT_RESP,
+	[FMOB_PSC_PORT_CTRL_REQ]		= FMLN_PSC_PHY_PORT_CTRL,
+	[FMOB_PSC_CFG_REQ]				= FMLN_PSC_PPB_IO_CFG_REQ,
+	[FMOB_PSC_CFG_RSP]				= FMLN_PSC_PPB_IO_CFG_RESP,
+	[FMOB_VSC_INFO_REQ]				= FMLN_VSC_GET_INFO_REQ,
+	[FMOB_VSC_PPB_STAT_BLK]			= FMLN_VSC_PPB_STATUS,
+	[FMOB_VSC_INFO_BLK]				= FMLN_VSC_INFO,
+	[FMOB_VSC_INFO_RSP]				= FMLN_VSC_GET_INFO_RESP,
+	[FMOB_VSC_BIND_REQ]				= FMLN_VSC_BIND,
+	[FMOB_VSC_UNBIND_REQ]			= FMLN_VSC_UNBIND,
+	[FMOB_VSC_AER_REQ]				= FMLN_VSC_GEN_AER,
+	[FMOB_MPC_TMC_REQ]				= FMLN_MPC_TUNNEL_CMD_REQ,
+	[FMOB_MPC_TMC_RSP]				= FMLN_MPC_TUNNEL_CMD_RESP,
+	[FMOB_MPC_CFG_REQ]				= FMLN_MPC_LD_IO_CFG_REQ,
+	[FMOB_MPC_CFG_RSP]				= FMLN_MPC_LD_IO_CFG_RESP,
+	[FMOB_MPC_MEM_REQ]				= FMLN_MPC_LD_MEM_REQ,
+	[FMOB_MPC_MEM_RSP]				= FMLN_MPC_LD_MEM_RESP,
+	[FMOB_MCC_INFO_RSP]				= FMLN_MCC_GET_LD_INFO,
+	[FMOB_MCC_ALLOC_BLK]			= FMLN_MCC_LD_ALLOC_ENTRY,
+	[FMOB_MCC_ALLOC_GET_REQ]		= FMLN_MCC_GET_LD_ALLOC_REQ,
+	[FMOB_MCC_ALLOC_GET_RSP]		= FMLN_MCC_GET_LD_ALLOC_RSP,
+	[FMOB_MCC_ALLOC_SET_REQ]		= FMLN_MCC_SET_LD_ALLOC_REQ,
+	[FMOB_MCC_ALLOC_SET_RSP]		= FMLN_MCC_SET_LD_ALLOC_RSP,
+	[FMOB_MCC_QOS_CTRL]				= FMLN_MCC_QOS_CTRL,
+	[FMOB_MCC_QOS_STAT_RSP]			= FMLN_MCC_QOS_STATUS,
+	[FMOB_MCC_QOS_BW_GET_REQ]		= FMLN_MCC_GET_QOS_BW_REQ,
+	[FMOB_MCC_QOS_BW_ALLOC]			= FMLN_MCC_QOS_BW_ALLOC,
+	[FMOB_MCC_QOS_BW_LIMIT_GET_REQ]	= FMLN_MCC_GET_QOS_BW_LIMIT_REQ,
+	[FMOB_MCC_QOS_BW_LIMIT]			= FMLN_MCC_QOS_BW_LIMIT,
+	[FMOB_ISC_ID_RSP]				= FMLN_ISC_ID_RSP,
+	[FMOB_ISC_MSG_LIMIT]			= FMLN_ISC_MSG_LIMIT,
+	[FMOB_ISC_BOS]					= FMLN_ISC_BOS,
+};
+
+/**
+ * Size of each deserialized FM API Object [FMOB]
+ */
+#define FMSZ(s) 		{ sizeof(struct s), 0, 0, 0 }
+#define FMSZ_LIST(s, f)	{ sizeof(struct s), offsetof(struct s, f), sizeof(((struct s*)0)->f[0]), 0 }
+#define FMSZ_REQ(s, f)	{ sizeof(struct s), offsetof(struct s, f), sizeof(((struct s*)0)->f[0]), 1 }
+static const struct fmapi_obj_size FMSZ_FMOB[FMOB_MAX] = {
+	[FMOB_NULL]						= { 0, 0, 0, 0 },
+	[FMOB_HDR]						= FMSZ(fmapi_hdr),
+	[FMOB_PSC_ID_RSP]				= FMSZ(fmapi_psc_id_rsp),
+	[FMOB_PSC_PORT_REQ]				= FMSZ_REQ(fmapi_psc_port_req, ports),
+	[FMOB_PSC_PORT_INFO]			= FMSZ(fmapi_psc_port_info),
+	[FMOB_PSC_PORT_RSP]				= FMSZ_LIST(fmapi_psc_port_rsp, list),
+	[FMOB_PSC_PORT_CTRL_REQ]		= FMSZ(fmapi_psc_port_ctrl_req),
+	[FMOB_PSC_CFG_REQ]				= FMSZ(fmapi_psc_cfg_req),
+	[FMOB_PSC_CFG_RSP]				= FMSZ(fmapi_psc_cfg_rsp),
+	[FMOB_VSC_INFO_REQ]				= FMSZ_REQ(fmapi_vsc_info_req, vcss),
+	[FMOB_VSC_PPB_STAT_BLK]			= FMSZ(fmapi_vsc_ppb_stat_blk),
+	[FMOB_VSC_INFO_BLK]				= FMSZ_LIST(fmapi_vsc_info_blk, list),
+	[FMOB_VSC_INFO_RSP]				= FMSZ_LIST(fmapi_vsc_info_rsp, list),
+	[FMOB_VSC_BIND_REQ]				= FMSZ(fmapi_vsc_bind_req),
+	[FMOB_VSC_UNBIND_REQ]			= FMSZ(fmapi_vsc_unbind_req),
+	[FMOB_VSC_AER_REQ]				= FMSZ(fmapi_vsc_aer_req),
+	[FMOB_MPC_TMC_REQ]				= FMSZ_REQ(fmapi_mpc_tmc_req, msg),
+	[FMOB_MPC_TMC_RSP]				= FMSZ_LIST(fmapi_mpc_tmc_rsp, msg),
+	[FMOB_MPC_CFG_REQ]				= FMSZ(fmapi_mpc_cfg_req),
+	[FMOB_MPC_CFG_RSP]				= FMSZ(fmapi_mpc_cfg_rsp),
+	[FMOB_MPC_MEM_REQ]				= FMSZ_REQ(fmapi_mpc_mem_req, data),
+	[FMOB_MPC_MEM_RSP]				= FMSZ_LIST(fmapi_mpc_mem_rsp, data),
+	[FMOB_MCC_INFO_RSP]				= FMSZ(fmapi_mcc_info_rsp),
+	[FMOB_MCC_ALLOC_BLK]			= FMSZ(fmapi_mcc_alloc_blk),
+	[FMOB_MCC_ALLOC_GET_REQ]		= FMSZ(fmapi_mcc_alloc_get_req),
+	[FMOB_MCC_ALLOC_GET_RSP]		= FMSZ_LIST(fmapi_mcc_alloc_get_rsp, list),
+	[FMOB_MCC_ALLOC_SET_REQ]		= FMSZ_REQ(fmapi_mcc_alloc_set_req, list),
+	[FMOB_MCC_ALLOC_SET_RSP]		= FMSZ_LIST(fmapi_mcc_alloc_set_rsp, list),
+	[FMOB_MCC_QOS_CTRL]				= FMSZ(fmapi_mcc_qos_ctrl),
+	[FMOB_MCC_QOS_STAT_RSP]			= FMSZ(fmapi_mcc_qos_stat_rsp),
+	[FMOB_MCC_QOS_BW_GET_REQ]		= FMSZ(fmapi_mcc_qos_bw_alloc_get_req),
+	[FMOB_MCC_QOS_BW_ALLOC]			= FMSZ_LIST(fmapi_mcc_qos_bw_alloc, list),
+	[FMOB_MCC_QOS_BW_LIMIT_GET_REQ]	= FMSZ(fmapi_mcc_qos_bw_limit_get_req),
+	[FMOB_MCC_QOS_BW_LIMIT]			= FMSZ_LIST(fmapi_mcc_qos_bw_limit, list),
+	[FMOB_ISC_ID_RSP]				= FMSZ(fmapi_isc_id_rsp),
+	[FMOB_ISC_MSG_LIMIT]			= FMSZ(fmapi_isc_msg_limit),
+	[FMOB_ISC_BOS]					= FMSZ(fmapi_isc_bos),
+};
+
+/**
+ * Field descriptor helpers 
+ */
+#define FMFD_INT(s, f, o)			{ FMFK_INT,   sizeof(((struct s*)0)->f), 0, 0, o, offsetof(struct s, f) }
+#define FMFD_BITS(s, f, o, sh, m)	{ FMFK_BITS,  1, sh, m, o, offsetof(struct s, f) }
+#define FMFD_BYTES(s, f, o)			{ FMFK_BYTES, sizeof(((struct s*)0)->f), 0, 0, o, offsetof(struct s, f) }
+
+static const struct fmapi_field FMFD_ISC_BOS[] = {
+	FMFD_BITS (fmapi_isc_bos, running, 		0, 0, 0x01),
+	FMFD_BITS (fmapi_isc_bos, pcnt, 		0, 1, 0x7F),
+	FMFD_INT  (fmapi_isc_bos, opcode, 		2),
+	FMFD_INT  (fmapi_isc_bos, rc, 			4),
+	FMFD_INT  (fmapi_isc_bos, ext, 			6),
+};
+
+static const struct fmapi_field FMFD_ISC_ID_RSP[] = {
+	FMFD_INT  (fmapi_isc_id_rsp, vid, 		0),
+	FMFD_INT  (fmapi_isc_id_rsp, did, 		2),
+	FMFD_INT  (fmapi_isc_id_rsp, svid, 		4),
+	FMFD_INT  (fmapi_isc_id_rsp, ssid, 		6),
+	FMFD_INT  (fmapi_isc_id_rsp, sn, 		8),
+	FMFD_INT  (fmapi_isc_id_rsp, size, 		16),
+};
+
+static const struct fmapi_field FMFD_ISC_MSG_LIMIT[] = {
+	FMFD_INT  (fmapi_isc_msg_limit, limit, 	0),
+};
+
+static const struct fmapi_field FMFD_PSC_ID_RSP[] = {
+	FMFD_INT  (fmapi_psc_id_rsp, ingress_port, 	0),
+	FMFD_INT  (fmapi_psc_id_rsp, num_ports, 	2),
+	FMFD_INT  (fmapi_psc_id_rsp, num_vcss, 		3),
+	FMFD_BYTES(fmapi_psc_id_rsp, active_ports, 	4),
+	FMFD_BYTES(fmapi_psc_id_rsp, active_vcss, 	36),
+	FMFD_INT  (fmapi_psc_id_rsp, num_vppbs, 	68),
+	FMFD_INT  (fmapi_psc_id_rsp, active_vppbs, 	70),
+	FMFD_INT  (fmapi_psc_id_rsp, num_decoders, 	72),
+};
+
+static const struct fmapi_field FMFD_PSC_PORT_REQ[] = {
+	FMFD_INT  (fmapi_psc_port_req, num, 	0),
+};
+
+static const struct fmapi_field FMFD_PSC_PORT_INFO[] = {
+	FMFD_INT  (fmapi_psc_port_info, ppid, 	0),
+	FMFD_INT  (fmapi_psc_port_info, state, 	1),
+	FMFD_INT  (fmapi_psc_port_info, dv, 	2),
+	FMFD_INT  (fmapi_psc_port_info, dt, 	4),
+	FMFD_INT  (fmapi_psc_port_info, cv, 	5),
+	FMFD_INT  (fmapi_psc_port_info, mlw, 	6),
+	FMFD_INT  (fmapi_psc_port_info, nlw, 	7),
+	FMFD_INT  (fmapi_psc_port_info, speeds, 8),
+	FMFD_INT  (fmapi_psc_port_info, mls, 	9),
+	FMFD_INT  (fmapi_psc_port_info, cls, 	10),
+	FMFD_INT  (fmapi_psc_port_info, ltssm, 	11),
+	FMFD_INT  (fmapi_psc_port_info, lane, 	12),
+	FMFD_BITS (fmapi_psc_port_info, lane_rev, 	13, FMLF_LANE_REVERSAL_BIT, 0x01),
+	FMFD_BITS (fmapi_psc_port_info, perst, 		13, FMLF_PERST_STATE_BIT, 	0x01),
+	FMFD_BITS (fmapi_psc_port_info, prsnt, 		13, FMLF_PRSNT_STATE_BIT, 	0x01),
+	FMFD_BITS (fmapi_psc_port_info, pwrctrl, 	13, FMLF_PWRCTL_STATE_BIT, 	0x01),
+	FMFD_INT  (fmapi_psc_port_info, num_ld, 15),
+};
+
+static const struct fmapi_field FMFD_PSC_PORT_RSP[] = {
+	FMFD_INT  (fmapi_psc_port_rsp, num, 	0),
+};
+
+static const struct fmapi_field FMFD_PSC_PORT_CTRL_REQ[] = {
+	FMFD_INT  (fmapi_psc_port_ctrl_req, ppid, 	0),
+	FMFD_INT  (fmapi_psc_port_ctrl_req, opcode, 1),
+};
+
+static const struct fmapi_field FMFD_PSC_CFG_RSP[] = {
+	FMFD_BYTES(fmapi_psc_cfg_rsp, data, 	0),
+};
+
+static const struct fmapi_field FMFD_VSC_INFO_REQ[] = {
+	FMFD_INT  (fmapi_vsc_info_req, vppbid_start, 	0),
+	FMFD_INT  (fmapi_vsc_info_req, vppbid_limit, 	1),
+	FMFD_INT  (fmapi_vsc_info_req, num, 			2),
+};
+
+static const struct fmapi_field FMFD_VSC_PPB_STAT_BLK[] = {
+	FMFD_INT  (fmapi_vsc_ppb_stat_blk, status, 	0),
+	FMFD_INT  (fmapi_vsc_ppb_stat_blk, ppid, 	1),
+	FMFD_INT  (fmapi_vsc_ppb_stat_blk, ldid, 	2),
+};
+
+static const struct fmapi_field FMFD_VSC_BIND_REQ[] = {
+	FMFD_INT  (fmapi_vsc_bind_req, vcsid, 	0),
+	FMFD_INT  (fmapi_vsc_bind_req, vppbid, 	1),
+	FMFD_INT  (fmapi_vsc_bind_req, ppid, 	2),
+	FMFD_INT  (fmapi_vsc_bind_req, ldid, 	4),
+};
+
+static const struct fmapi_field FMFD_VSC_AER_REQ[] = {
+	FMFD_INT  (fmapi_vsc_aer_req, vcsid, 		0),
+	FMFD_INT  (fmapi_vsc_aer_req, vppbid, 		1),
+	FMFD_INT  (fmapi_vsc_aer_req, error_type, 	4),
+	FMFD_BYTES(fmapi_vsc_aer_req, header, 		8),
+};
+
+static const struct fmapi_field FMFD_MPC_CFG_RSP[] = {
+	FMFD_BYTES(fmapi_mpc_cfg_rsp, data, 	0),
+};
+
+static const struct fmapi_field FMFD_MPC_MEM_RSP[] = {
+	FMFD_INT  (fmapi_mpc_mem_rsp, len, 		0),
+};
+
+static const struct fmapi_field FMFD_MCC_INFO_RSP[] = {
+	FMFD_INT  (fmapi_mcc_info_rsp, size, 	0),
+	FMFD_INT  (fmapi_mcc_info_rsp, num, 	8),
+	FMFD_BITS (fmapi_mcc_info_rsp, epc, 	10, FMQT_EGRESS_PORT_CONGESTION_BIT, 	0x01),
+	FMFD_BITS (fmapi_mcc_info_rsp, ttr, 	10, FMQT_TEMP_THROUGHPUT_REDUCTION_BIT, 0x01),
+};
+
+static const struct fmapi_field FMFD_MCC_ALLOC_BLK[] = {
+	FMFD_INT  (fmapi_mcc_alloc_blk, rng1, 	0),
+	FMFD_INT  (fmapi_mcc_alloc_blk, rng2, 	8),
+};
+
+static const struct fmapi_field FMFD_MCC_ALLOC_GET_REQ[] = {
+	FMFD_INT  (fmapi_mcc_alloc_get_req, start, 	0),
+	FMFD_INT  (fmapi_mcc_alloc_get_req, limit, 	1),
+};
+
+static const struct fmapi_field FMFD_MCC_ALLOC_GET_RSP[] = {
+	FMFD_INT  (fmapi_mcc_alloc_get_rsp, total, 			0),
+	FMFD_INT  (fmapi_mcc_alloc_get_rsp, granularity, 	1),
+	FMFD_INT  (fmapi_mcc_alloc_get_rsp, start, 			2),
+	FMFD_INT  (fmapi_mcc_alloc_get_rsp, num, 			3),
+};
+
+static const struct fmapi_field FMFD_MCC_ALLOC_SET_REQ[] = {
+	FMFD_INT  (fmapi_mcc_alloc_set_req, num, 	0),
+	FMFD_INT  (fmapi_mcc_alloc_set_req, start, 	1),
+};
+
+static const struct fmapi_field FMFD_MCC_ALLOC_SET_RSP[] = {
+	FMFD_INT  (fmapi_mcc_alloc_set_rsp, num, 	0),
+	FMFD_INT  (fmapi_mcc_alloc_set_rsp, start, 	1),
+};
+
+static const struct fmapi_field FMFD_MCC_QOS_CTRL[] = {
+	FMFD_BITS (fmapi_mcc_qos_ctrl, epc_en, 			0, FMQT_EGRESS_PORT_CONGESTION_BIT, 	0x01),
+	FMFD_BITS (fmapi_mcc_qos_ctrl, ttr_en, 			0, FMQT_TEMP_THROUGHPUT_REDUCTION_BIT, 	0x01),
+	FMFD_INT  (fmapi_mcc_qos_ctrl, egress_mod_pcnt, 1),
+	FMFD_INT  (fmapi_mcc_qos_ctrl, egress_sev_pcnt, 2),
+	FMFD_INT  (fmapi_mcc_qos_ctrl, sample_interval, 3),
+	FMFD_INT  (fmapi_mcc_qos_ctrl, rcb, 			4),
+	FMFD_INT  (fmapi_mcc_qos_ctrl, comp_interval, 	6),
+};
+
+static const struct fmapi_field FMFD_MCC_QOS_STAT_RSP[] = {
+	FMFD_INT  (fmapi_mcc_qos_stat_rsp, bp_avg_pcnt, 0),
+};
+
+static const struct fmapi_field FMFD_MCC_QOS_BW_GET_REQ[] = {
+	FMFD_INT  (fmapi_mcc_qos_bw_alloc_get_req, num, 	0),
+	FMFD_INT  (fmapi_mcc_qos_bw_alloc_get_req, start, 	1),
+};
+
+static const struct fmapi_field FMFD_MCC_QOS_BW_ALLOC[] = {
+	FMFD_INT  (fmapi_mcc_qos_bw_alloc, num, 	0),
+	FMFD_INT  (fmapi_mcc_qos_bw_alloc, start, 	1),
+};
+
+static const struct fmapi_field FMFD_MCC_QOS_BW_LIMIT_GET_REQ[] = {
+	FMFD_INT  (fmapi_mcc_qos_bw_limit_get_req, num, 	0),
+	FMFD_INT  (fmapi_mcc_qos_bw_limit_get_req, start, 	1),
+};
+
+static const struct fmapi_field FMFD_MCC_QOS_BW_LIMIT[] = {
+	FMFD_INT  (fmapi_mcc_qos_bw_limit, num, 	0),
+	FMFD_INT  (fmapi_mcc_qos_bw_limit, start, 	1),
+};
+
+/**
+ * Wire format layout of each FM API Object [FMOB]
+ *
+ * Objects with bit-field members or whose decode depends on a param (e.g. 
+ * FMOB_HDR, FMOB_VSC_INFO_BLK, FMOB_MPC_TMC_REQ) have no layout and are 
+ * handled by the switch in fmapi_serialize() and fmapi_deserialize()
+ */
+#define FMLT(f) 							{ f, sizeof(f)/sizeof(f[0]), 0, 0, 0, 0, 0, 0 }
+#define FMLT_FLAT(f) 						{ f, sizeof(f)/sizeof(f[0]), 0, 0, 0, 0, 0, 1 }
+_Static_assert(sizeof(struct fmapi_mcc_alloc_blk) == FMLN_MCC_LD_ALLOC_ENTRY, "fmapi_mcc_alloc_blk is not flat");
+#define FMLT_LIST(f, s, c, l, e) 			{ f, sizeof(f)/sizeof(f[0]), sizeof(((struct s*)0)->c), offsetof(struct s, c), offsetof(struct s, l), sizeof(((struct s*)0)->l[0]), e, 0 }
+static const struct fmapi_layout FMLT_FMOB[FMOB_MAX] = {
+	[FMOB_ISC_BOS]					= FMLT(FMFD_ISC_BOS),
+	[FMOB_ISC_ID_RSP]				= FMLT(FMFD_ISC_ID_RSP),
+	[FMOB_ISC_MSG_LIMIT]			= FMLT(FMFD_ISC_MSG_LIMIT),
+	[FMOB_PSC_ID_RSP]				= FMLT(FMFD_PSC_ID_RSP),
+	[FMOB_PSC_PORT_REQ]				= FMLT_LIST(FMFD_PSC_PORT_REQ, fmapi_psc_port_req, num, ports, FMOB_NULL),
+	[FMOB_PSC_PORT_INFO]			= FMLT(FMFD_PSC_PORT_INFO),
+	[FMOB_PSC_PORT_RSP]				= FMLT_LIST(FMFD_PSC_PORT_RSP, fmapi_psc_port_rsp, num, list, FMOB_PSC_PORT_INFO),
+	[FMOB_PSC_PORT_CTRL_REQ]		= FMLT(FMFD_PSC_PORT_CTRL_REQ),
+	[FMOB_PSC_CFG_RSP]				= FMLT(FMFD_PSC_CFG_RSP),
+	[FMOB_VSC_INFO_REQ]				= FMLT_LIST(FMFD_VSC_INFO_REQ, fmapi_vsc_info_req, num, vcss, FMOB_NULL),
+	[FMOB_VSC_PPB_STAT_BLK]			= FMLT(FMFD_VSC_PPB_STAT_BLK),
+	[FMOB_VSC_BIND_REQ]				= FMLT(FMFD_VSC_BIND_REQ),
+	[FMOB_VSC_AER_REQ]				= FMLT(FMFD_VSC_AER_REQ),
+	[FMOB_MPC_CFG_RSP]				= FMLT(FMFD_MPC_CFG_RSP),
+	[FMOB_MPC_MEM_RSP]				= FMLT_LIST(FMFD_MPC_MEM_RSP, fmapi_mpc_mem_rsp, len, data, FMOB_NULL),
+	[FMOB_MCC_INFO_RSP]				= FMLT(FMFD_MCC_INFO_RSP),
+	[FMOB_MCC_ALLOC_BLK]			= FMLT_FLAT(FMFD_MCC_ALLOC_BLK),
+	[FMOB_MCC_ALLOC_GET_REQ]		= FMLT(FMFD_MCC_ALLOC_GET_REQ),
+	[FMOB_MCC_ALLOC_GET_RSP]		= FMLT_LIST(FMFD_MCC_ALLOC_GET_RSP, fmapi_mcc_alloc_get_rsp, num, list, FMOB_MCC_ALLOC_BLK),
+	[FMOB_MCC_ALLOC_SET_REQ]		= FMLT_LIST(FMFD_MCC_ALLOC_SET_REQ, fmapi_mcc_alloc_set_req, num, list, FMOB_MCC_ALLOC_BLK),
+	[FMOB_MCC_ALLOC_SET_RSP]		= FMLT_LIST(FMFD_MCC_ALLOC_SET_RSP, fmapi_mcc_alloc_set_rsp, num, list, FMOB_MCC_ALLOC_BLK),
+	[FMOB_MCC_QOS_CTRL]				= FMLT(FMFD_MCC_QOS_CTRL),
+	[FMOB_MCC_QOS_STAT_RSP]			= FMLT(FMFD_MCC_QOS_STAT_RSP),
+	[FMOB_MCC_QOS_BW_GET_REQ]		= FMLT(FMFD_MCC_QOS_BW_GET_REQ),
+	[FMOB_MCC_QOS_BW_ALLOC]			= FMLT_LIST(FMFD_MCC_QOS_BW_ALLOC, fmapi_mcc_qos_bw_alloc, num, list, FMOB_NULL),
+	[FMOB_MCC_QOS_BW_LIMIT_GET_REQ]	= FMLT(FMFD_MCC_QOS_BW_LIMIT_GET_REQ),
+	[FMOB_MCC_QOS_BW_LIMIT]			= FMLT_LIST(FMFD_MCC_QOS_BW_LIMIT, fmapi_mcc_qos_bw_limit, num, list, FMOB_NULL),
+};
+
+/**
+ * Opcode registry indexed by a perfect hash of the FM API Opcode [FMOP]
+ *
+ * Bits [10:8] of the opcode select the command set and bits [3:0] select the 
+ * command within the set, which is collision free for every opcode in CXL 2.0 
+ * Table 205. Unused slots have a NULL name.
+ */
+#define FMOI_HASH(op) 		( (((op) >> 4) & 0x70) | ((op) & 0x0F) )
+#define FMOI_SIZE 			128
+#define FMOI(op, cs, bg, req, rqmin, rqmax, rsp, rsmin, rsmax, name) \
+	[FMOI_HASH(op)] = { op, cs, bg, req, rsp, rqmin, rqmax, rsmin, rsmax, name }
+static const struct fmapi_opcode_info FMOI_FMOP[FMOI_SIZE] = {
+	FMOI(FMOP_ISC_ID, FMCS_ISC, 0,
+		FMOB_NULL, 0, 0, 
+		FMOB_ISC_ID_RSP, FMLN_ISC_ID_RSP, FMLN_ISC_ID_RSP, 
+		"Identify"),
+	FMOI(FMOP_ISC_BOS, FMCS_ISC, 0,
+		FMOB_NULL, 0, 0, 
+		FMOB_ISC_BOS, FMLN_ISC_BOS, FMLN_ISC_BOS, 
+		"Background Operation Status"),
+	FMOI(FMOP_ISC_MSG_LIMIT_GET, FMCS_ISC, 0,
+		FMOB_NULL, 0, 0, 
+		FMOB_ISC_MSG_LIMIT, FMLN_ISC_MSG_LIMIT, FMLN_ISC_MSG_LIMIT, 
+		"Get Response Message Limit"),
+	FMOI(FMOP_ISC_MSG_LIMIT_SET, FMCS_ISC, 0,
+		FMOB_ISC_MSG_LIMIT, FMLN_ISC_MSG_LIMIT, FMLN_ISC_MSG_LIMIT, 
+		FMOB_ISC_MSG_LIMIT, FMLN_ISC_MSG_LIMIT, FMLN_ISC_MSG_LIMIT, 
+		"Set Response Message Limit"),
+	FMOI(FMOP_PSC_ID, FMCS_PSC, 0,
+		FMOB_NULL, 0, 0, 
+		FMOB_PSC_ID_RSP, FMLN_PSC_IDENTIFY_SWITCH, FMLN_PSC_IDENTIFY_SWITCH, 
+		"Identify Switch Device"),
+	FMOI(FMOP_PSC_PORT, FMCS_PSC, 0,
+		FMOB_PSC_PORT_REQ, FMLN_PSC_GET_PHY_PORT_REQ, FMLN_PSC_GET_PHY_PORT_REQ + FM_MAX_PORTS, 
+		FMOB_PSC_PORT_RSP, FMLN_PSC_GET_PHY_PORT_RESP, FMLN_PSC_GET_PHY_PORT_RESP + FM_MAX_PORTS * FMLN_PSC_GET_PHY_PORT_INFO, 
+		"Get Physical Port State"),
+	FMOI(FMOP_PSC_PORT_CTRL, FMCS_PSC, 0,
+		FMOB_PSC_PORT_CTRL_REQ, FMLN_PSC_PHY_PORT_CTRL, FMLN_PSC_PHY_PORT_CTRL, 
+		FMOB_NULL, 0, 0, 
+		"Physical Port Control"),
+	FMOI(FMOP_PSC_CFG, FMCS_PSC, 0,
+		FMOB_PSC_CFG_REQ, FMLN_PSC_PPB_IO_CFG_REQ, FMLN_PSC_PPB_IO_CFG_REQ, 
+		FMOB_PSC_CFG_RSP, FMLN_PSC_PPB_IO_CFG_RESP, FMLN_PSC_PPB_IO_CFG_RESP, 
+		"Send PPB CXL.io Configuration Request"),
+	FMOI(FMOP_VSC_INFO, FMCS_VSC, 0,
+		FMOB_VSC_INFO_REQ, FMLN_VSC_GET_INFO_REQ, FMLN_VSC_GET_INFO_REQ + FM_MAX_VCS, 
+		FMOB_VSC_INFO_RSP, FMLN_VSC_GET_INFO_RESP, FMLN_VSC_GET_INFO_RESP + FM_MAX_VCS_PER_RSP * (FMLN_VSC_INFO + FM_MAX_VPPBS * FMLN_VSC_PPB_STATUS), 
+		"Get Virtual CXL Switch Info"),
+	FMOI(FMOP_VSC_BIND, FMCS_VSC, 1,
+		FMOB_VSC_BIND_REQ, FMLN_VSC_BIND, FMLN_VSC_BIND, 
+		FMOB_NULL, 0, 0, 
+		"Bind vPPB"),
+	FMOI(FMOP_VSC_UNBIND, FMCS_VSC, 1,
+		FMOB_VSC_UNBIND_REQ, FMLN_VSC_UNBIND, FMLN_VSC_UNBIND, 
+		FMOB_NULL, 0, 0, 
+		"Unbind vPPB"),
+	FMOI(FMOP_VSC_AER, FMCS_VSC, 0,
+		FMOB_VSC_AER_REQ, FMLN_VSC_GEN_AER, FMLN_VSC_GEN_AER, 
+		FMOB_NULL, 0, 0, 
+		"Generate AER Event"),
+	FMOI(FMOP_MPC_TMC, FMCS_MPC, 0,
+		FMOB_MPC_TMC_REQ, FMLN_MPC_TUNNEL_CMD_REQ, FMLN_PAYLOAD, 
+		FMOB_MPC_TMC_RSP, FMLN_MPC_TUNNEL_CMD_RESP, FMLN_PAYLOAD, 
+		"Tunnel Management Command"),
+	FMOI(FMOP_MPC_CFG, FMCS_MPC, 0,
+		FMOB_MPC_CFG_REQ, FMLN_MPC_LD_IO_CFG_REQ, FMLN_MPC_LD_IO_CFG_REQ, 
+		FMOB_MPC_CFG_RSP, FMLN_MPC_LD_IO_CFG_RESP, FMLN_MPC_LD_IO_CFG_RESP, 
+		"Send LD CXL.io Configuration Request"),
+	FMOI(FMOP_MPC_MEM, FMCS_MPC, 0,
+		FMOB_MPC_MEM_REQ, FMLN_MPC_LD_MEM_REQ, FMLN_MPC_LD_MEM_REQ + FM_LD_MEM_REQ_LEN, 
+		FMOB_MPC_MEM_RSP, FMLN_MPC_LD_MEM_RESP, FMLN_MPC_LD_MEM_RESP + FM_LD_MEM_REQ_LEN, 
+		"Send LD CXL.io Memory Request"),
+	FMOI(FMOP_MCC_INFO, FMCS_MCC, 0,
+		FMOB_NULL, 0, 0, 
+		FMOB_MCC_INFO_RSP, FMLN_MCC_GET_LD_INFO, FMLN_MCC_GET_LD_INFO, 
+		"Get LD Info"),
+	FMOI(FMOP_MCC_ALLOC_GET, FMCS_MCC, 0,
+		FMOB_MCC_ALLOC_GET_REQ, FMLN_MCC_GET_LD_ALLOC_REQ, FMLN_MCC_GET_LD_ALLOC_REQ, 
+		FMOB_MCC_ALLOC_GET_RSP, FMLN_MCC_GET_LD_ALLOC_RSP, FMLN_MCC_GET_LD_ALLOC_RSP + FM_MAX_NUM_LD * FMLN_MCC_LD_ALLOC_ENTRY, 
+		"Get LD Allocations"),
+	FMOI(FMOP_MCC_ALLOC_SET, FMCS_MCC, 0,
+		FMOB_MCC_ALLOC_SET_REQ, FMLN_MCC_SET_LD_ALLOC_REQ, FMLN_MCC_SET_LD_ALLOC_REQ + FM_MAX_NUM_LD * FMLN_MCC_LD_ALLOC_ENTRY, 
+		FMOB_MCC_ALLOC_SET_RSP, FMLN_MCC_SET_LD_ALLOC_RSP, FMLN_MCC_SET_LD_ALLOC_RSP + FM_MAX_NUM_LD * FMLN_MCC_LD_ALLOC_ENTRY, 
+		"Set LD Allocations"),
+	FMOI(FMOP_MCC_QOS_CTRL_GET, FMCS_MCC, 0,
+		FMOB_NULL, 0, 0, 
+		FMOB_MCC_QOS_CTRL, FMLN_MCC_QOS_CTRL, FMLN_MCC_QOS_CTRL, 
+		"Get QOS Control"),
+	FMOI(FMOP_MCC_QOS_CTRL_SET, FMCS_MCC, 0,
+		FMOB_MCC_QOS_CTRL, FMLN_MCC_QOS_CTRL, FMLN_MCC_QOS_CTRL, 
+		FMOB_MCC_QOS_CTRL, FMLN_MCC_QOS_CTRL, FMLN_MCC_QOS_CTRL, 
+		"Set QOS Control"),
+	FMOI(FMOP_MCC_QOS_STAT, FMCS_MCC, 0,
+		FMOB_NULL, 0, 0, 
+		FMOB_MCC_QOS_STAT_RSP, FMLN_MCC_QOS_STATUS, FMLN_MCC_QOS_STATUS, 
+		"Get QOS Status"),
+	FMOI(FMOP_MCC_QOS_BW_ALLOC_GET, FMCS_MCC, 0,
+		FMOB_MCC_QOS_BW_GET_REQ, FMLN_MCC_GET_QOS_BW_REQ, FMLN_MCC_GET_QOS_BW_REQ, 
+		FMOB_MCC_QOS_BW_ALLOC, FMLN_MCC_QOS_BW_ALLOC, FMLN_MCC_QOS_BW_ALLOC + FM_MAX_NUM_LD, 
+		"Get QOS Allocated BW"),
+	FMOI(FMOP_MCC_QOS_BW_ALLOC_SET, FMCS_MCC, 0,
+		FMOB_MCC_QOS_BW_ALLOC, FMLN_MCC_QOS_BW_ALLOC, FMLN_MCC_QOS_BW_ALLOC + FM_MAX_NUM_LD, 
+		FMOB_MCC_QOS_BW_ALLOC, FMLN_MCC_QOS_BW_ALLOC, FMLN_MCC_QOS_BW_ALLOC + FM_MAX_NUM_LD, 
+		"Set QOS Allocated BW"),
+	FMOI(FMOP_MCC_QOS_BW_LIMIT_GET, FMCS_MCC, 0,
+		FMOB_MCC_QOS_BW_LIMIT_GET_REQ, FMLN_MCC_GET_QOS_BW_LIMIT_REQ, FMLN_MCC_GET_QOS_BW_LIMIT_REQ, 
+		FMOB_MCC_QOS_BW_LIMIT, FMLN_MCC_QOS_BW_LIMIT, FMLN_MCC_QOS_BW_LIMIT + FM_MAX_NUM_LD, 
+		"Get QOS BW Limit"),
+	FMOI(FMOP_MCC_QOS_BW_LIMIT_SET, FMCS_MCC, 0,
+		FMOB_MCC_QOS_BW_LIMIT, FMLN_MCC_QOS_BW_LIMIT, FMLN_MCC_QOS_BW_LIMIT + FM_MAX_NUM_LD, 
+		FMOB_MCC_QOS_BW_LIMIT, FMLN_MCC_QOS_BW_LIMIT, FMLN_MCC_QOS_BW_LIMIT + FM_MAX_NUM_LD, 
+		"Set QOS BW Limit"),
+};
+
 /* PROTOTYPES ================================================================*/
 
+static int fmapi_decode_layout(void *dst, __u8 *src, unsigned type);
+static int fmapi_encode_layout(__u8 *dst, void *src, unsigned type);
+static int fmapi_serialize_fixed(__u8 *dst, void *src, unsigned type);
+static void fmapi_patch_len(__u8 *hdr, __u32 len);
+static size_t fmapi_frame_len(const __u8 *hdr);
+static int fmapi_msg_bare(struct fmapi_hdr *hdr);
+
 void fmapi_prnt_hdr(void *ptr);
 void fmapi_prnt_isc_bos(void *ptr);
 void fmapi_prnt_isc_id_rsp(void *ptr);
@@ -406,6 +972,78 @@ void fmapi_prnt_mcc_qos_bw_limit(void *ptr);
 
 /* FUNCTIONS =================================================================*/
 
+/**
+ * Decode an object described by a wire format layout [FMLT]
+ *
+ * @param[out] dst void Pointer to destination struct
+ * @param[in] src void Pointer to unsigned char array
+ * @param[in] type unsigned enum _FMOB with a non NULL entry in FMLT_FMOB
+ * @return number of bytes consumed
+ */
+static int fmapi_decode_layout(void *dst, __u8 *src, unsigned type)
+{
+	const struct fmapi_layout *l;
+	const struct fmapi_field *f, *end;
+	__u8 *o;
+	unsigned num;
+	int rv;
+
+	l = &FMLT_FMOB[type];
+	o = (__u8*) dst;
+
+	for ( f = l->fields, end = f + l->num ; f < end ; f++ )
+	{
+		switch (f->kind)
+		{
+			case FMFK_INT:
+				switch (f->width)
+				{
+					case 1: o[f->obj] = src[f->off]; 								break;
+					case 2: *(__u16*) &o[f->obj] = fmapi_get_le16(&src[f->off]);	break;
+					case 4: *(__u32*) &o[f->obj] = fmapi_get_le32(&src[f->off]);	break;
+					case 8: *(__u64*) &o[f->obj] = fmapi_get_le64(&src[f->off]);	break;
+				}
+				break;
+
+			case FMFK_BITS:
+				o[f->obj] = (src[f->off] >> f->shift) & f->mask;
+				break;
+
+			case FMFK_BYTES:
+				memcpy(&o[f->obj], &src[f->off], f->width);
+				break;
+		}
+	}
+
+	rv = FMLN_FMOB[type];
+	if (l->cnt_width == 0)
+		return rv;
+
+	// Trailing variable length list 
+	if (l->cnt_width == 1)
+		num = o[l->cnt];
+	else 
+		num = *(__u16*) &o[l->cnt];
+
+	if (l->elem == FMOB_NULL) 
+	{
+		memcpy(&o[l->list], &src[rv], num);
+		rv += num;
+	}
+	else if (FMAPI_LE_HOST && FMLT_FMOB[l->elem].flat)
+	{
+		memcpy(&o[l->list], &src[rv], num * l->stride);
+		rv += num * l->stride;
+	}
+	else 
+	{
+		for ( unsigned i = 0 ; i < num ; i++ )
+			rv += fmapi_decode_layout(&o[l->list + i * l->stride], &src[rv], l->elem);
+	}
+
+	return rv;
+}
+
 /**
  * @brief Convert from a Little Endian byte array to a struct
  * 
@@ -425,6 +1063,9 @@ int fmapi_deserialize(void *dst, __u8 *src, unsigned type, void *param)
 	if ( (dst == NULL) || (type >= FMOB_MAX) )
 		return -1;
 
+	if (FMLT_FMOB[type].fields != NULL)
+		return fmapi_decode_layout(dst, src, type);
+
 	switch(type)
 	{
 		case FMOB_NULL:
@@ -436,122 +1077,15 @@ int fmapi_deserialize(void *dst, __u8 *src, unsigned type, void *param)
 			struct fmapi_hdr *o = (struct fmapi_hdr*) dst;
 			o->category 	= (src[0] >> 4) & 0x0F;	
 			o->tag 			= (src[1]); 
-			o->opcode 		= (src[4] << 8)  | src[3];
+			o->opcode 		= fmapi_get_le16(&src[3]);
 			o->len 			= ((src[7] & 0x00F8) << 13) | (src[6] << 8) | src[5] ;
 			o->background 	= (src[7] & 0x01);
-			o->return_code 	= (src[9] << 8)  | (src[8]);
-			o->ext_status 	= (src[11] << 8) | (src[10]);
+			o->return_code 	= fmapi_get_le16(&src[8]);
+			o->ext_status 	= fmapi_get_le16(&src[10]);
 			rv = FMLN_HDR;
 		}
 			break;
 
-		case FMOB_ISC_BOS: //!< struct fmapi_isc_bos
-		{
-			struct fmapi_isc_bos *o = (struct fmapi_isc_bos*) dst;
-			o->running =  src[0]        & 0x01;
-			o->pcnt    = (src[0] >> 1 ) & 0x7F;
-			o->opcode  = (src[3] << 8 ) | (src[2] & 0x00FF);
-			o->rc      = (src[5] << 8 ) | (src[4] & 0x00FF);
-			o->ext     = (src[7] << 8 ) | (src[6] & 0x00FF);
-			rv = FMLN_ISC_BOS;
-		}
-			break;
-
-		case FMOB_ISC_ID_RSP: //!< struct fmapi_isc_id_rsp
-		{
-			struct fmapi_isc_id_rsp *o = (struct fmapi_isc_id_rsp*) dst;
-			o->vid  = (src[1] << 8) | src[0];
-			o->did  = (src[3] << 8) | src[2];
-			o->svid = (src[5] << 8) | src[4];
-			o->ssid = (src[7] << 8) | src[6];
-			o->sn   = 	((__u64)src[15] << 56) | 
-						((__u64)src[14] << 48) |
-						((__u64)src[13] << 40) | 
-						((__u64)src[12] << 32) | 
-						((__u64)src[11] << 24) |
-						((__u64)src[10] << 16) | 
-						((__u64)src[ 9] << 8 ) | 
-						((__u64)src[ 8]      );
-			o->size = src[16];
-			rv = FMLN_ISC_ID_RSP;
-		}
-			break;
-
-		case FMOB_ISC_MSG_LIMIT: //!< struct fmapi_isc_msg_limit
-		{
-			struct fmapi_isc_msg_limit *o = (struct fmapi_isc_msg_limit*) dst;
-			o->limit = src[0];
-			rv = FMLN_ISC_MSG_LIMIT;
-		}
-			break;
-
-		case FMOB_PSC_ID_RSP: //!< struct fmapi_psc_id_rsp
-		{
-			struct fmapi_psc_id_rsp *o = (struct fmapi_psc_id_rsp*) dst;
-			o->ingress_port 	=  src[0];
-			o->num_ports 		=  src[2];
-			o->num_vcss 		=  src[3];
-			memcpy(o->active_ports, &src[4],  32);
-			memcpy(o->active_vcss,  &src[36], 32);
-			o->num_vppbs 		= (src[69] << 8) | src[68];
-			o->active_vppbs 	= (src[71] << 8) | src[70];
-			o->num_decoders 	=  src[72];
-			rv = FMLN_PSC_IDENTIFY_SWITCH;
-		}
-			break;
-
-		case FMOB_PSC_PORT_REQ: //!< struct fmapi_psc_port_req
-		{
-			struct fmapi_psc_port_req *o = (struct fmapi_psc_port_req*) dst;
-			o->num = src[0];
-			memcpy(o->ports, &src[1], o->num);
-			rv = FMLN_PSC_GET_PHY_PORT_REQ + o->num;
-		}
-			break;
-
-		case FMOB_PSC_PORT_INFO: //!< struct fmapi_psc_port_info
-		{
-			struct fmapi_psc_port_info *o = (struct fmapi_psc_port_info*) dst;
-			o->ppid		= src[0];
-			o->state	= src[1];
-			o->dv		= src[2];
-			o->dt		= src[4];
-			o->cv		= src[5];
-			o->mlw		= src[6];
-			o->nlw		= src[7];
-			o->speeds	= src[8];
-			o->mls		= src[9];
-			o->cls		= src[10];
-			o->ltssm	= src[11];
-			o->lane		= src[12];
-			o->lane_rev = (src[13] >> FMLF_LANE_REVERSAL_BIT) & 0x01;
-			o->perst    = (src[13] >> FMLF_PERST_STATE_BIT  ) & 0x01;
-			o->prsnt    = (src[13] >> FMLF_PRSNT_STATE_BIT  ) & 0x01;
-			o->pwrctrl  = (src[13] >> FMLF_PWRCTL_STATE_BIT ) & 0x01;
-			o->num_ld	= src[15];
-			rv = FMLN_PSC_GET_PHY_PORT_INFO;
-		}
-			break;
-
-		case FMOB_PSC_PORT_RSP: //!< struct fmapi_psc_port_rsp
-		{
-			struct fmapi_psc_port_rsp *o = (struct fmapi_psc_port_rsp*) dst;	
-			o->num = src[0];
-			rv = FMLN_PSC_GET_PHY_PORT_RESP;
-			for ( int i = 0 ; i < o->num ; i++) 
-				rv += fmapi_deserialize(&o->list[i], &src[rv], FMOB_PSC_PORT_INFO, NULL);
-		}
-			break;
-
-		case FMOB_PSC_PORT_CTRL_REQ: //!< struct fmapi_psc_port_ctrl_req
-		{
-			struct fmapi_psc_port_ctrl_req *o = (struct fmapi_psc_port_ctrl_req*) dst;
-			o->ppid   = src[0];
-			o->opcode = src[1];
-			rv = FMLN_PSC_PHY_PORT_CTRL;
-		}
-			break;
-
 		case FMOB_PSC_CFG_REQ: //!< struct fmapi_psc_cfg_req
 		{
 			struct fmapi_psc_cfg_req *o = (struct fmapi_psc_cfg_req*) dst;
@@ -568,39 +1102,6 @@ int fmapi_deserialize(void *dst, __u8 *src, unsigned type, void *param)
 		}
 			break;
 
-		case FMOB_PSC_CFG_RSP: //!< struct fmapi_psc_cfg_rsp 
-		{
-			struct fmapi_psc_cfg_rsp *o = (struct fmapi_psc_cfg_rsp*) dst;
-			o->data[0] 	= src[0];
-			o->data[1] 	= src[1];
-			o->data[2] 	= src[2];
-			o->data[3] 	= src[3];
-			rv = FMLN_PSC_PPB_IO_CFG_RESP;
-		}
-			break;
-
-		case FMOB_VSC_INFO_REQ: //!< struct fmapi_vsc_info_req
-		{
-			struct fmapi_vsc_info_req *o = (struct fmapi_vsc_info_req*) dst;
-
-			o->vppbid_start = src[0];
-			o->vppbid_limit = src[1];
-			o->num          = src[2];
-			memcpy(o->vcss, &src[3], o->num);
-			rv = FMLN_VSC_GET_INFO_REQ + o->num;
-		}
-			break;
-
-		case FMOB_VSC_PPB_STAT_BLK: //!< struct fmapi_vsc_ppb_stat_blk
-		{
-			struct fmapi_vsc_ppb_stat_blk *o = (struct fmapi_vsc_ppb_stat_blk*) dst;
-			o->status 	= src[0];
-			o->ppid 	= src[1];
-			o->ldid 	= src[2];
-			rv = FMLN_VSC_PPB_STATUS;
-		}
-			break;
-
 		case FMOB_VSC_INFO_BLK: //!< struct fmapi_vsc_info_blk
 		{
 			struct fmapi_vsc_info_blk *o = (struct fmapi_vsc_info_blk*) dst;
@@ -641,17 +1142,6 @@ int fmapi_deserialize(void *dst, __u8 *src, unsigned type, void *param)
 		}
 			break;
 
-		case FMOB_VSC_BIND_REQ: //!< struct fmapi_vsc_bind_req
-		{
-			struct fmapi_vsc_bind_req *o = (struct fmapi_vsc_bind_req*) dst;
-			o->vcsid  = src[0];
-			o->vppbid = src[1];
-			o->ppid   = src[2];
-			o->ldid   = (src[5] << 8) | src[4];
-			rv = FMLN_VSC_BIND;
-		}
-			break;
-
 		case FMOB_VSC_UNBIND_REQ: //!< struct fmapi_vsc_unbind_req
 		{
 			struct fmapi_vsc_unbind_req *o = (struct fmapi_vsc_unbind_req*) dst;
@@ -662,22 +1152,11 @@ int fmapi_deserialize(void *dst, __u8 *src, unsigned type, void *param)
 		}
 			break;
 
-		case FMOB_VSC_AER_REQ: //!< struct fmapi_vsc_aer_req
-		{
-			struct fmapi_vsc_aer_req *o = (struct fmapi_vsc_aer_req*) dst;
-			o->vcsid  = src[0];
-			o->vppbid = src[1];
-			o->error_type = (src[7] << 24) |  (src[6] << 16) | (src[5] << 8) | src[4];
-			memcpy(o->header, &src[8], 32);
-			rv = FMLN_VSC_GEN_AER;
-		}
-			break;
-
 		case FMOB_MPC_TMC_REQ: //!< struct fmapi_mpc_tmc_req
 		{
 			struct fmapi_mpc_tmc_req *o = (struct fmapi_mpc_tmc_req*) dst;
 			o->ppid   = src[0];
-			o->len    = ((src[3] << 8 ) | src[2])-1;
+			o->len    = fmapi_get_le16(&src[2]) - 1;
 			o->type   = src[4];
 			memcpy(o->msg, &src[FMLN_MPC_TUNNEL_CMD_REQ], o->len);
 			rv = FMLN_MPC_TUNNEL_CMD_REQ + o->len;
@@ -687,7 +1166,7 @@ int fmapi_deserialize(void *dst, __u8 *src, unsigned type, void *param)
 		case FMOB_MPC_TMC_RSP: //!< struct fmapi_mpc_tmc_rsp
 		{
 			struct fmapi_mpc_tmc_rsp *o = (struct fmapi_mpc_tmc_rsp*) dst;
-			o->len  = ((src[1] << 8) | src[0]) - 1;
+			o->len  = fmapi_get_le16(&src[0]) - 1;
 			o->type = src[4];
 			memcpy(o->msg, &src[FMLN_MPC_TUNNEL_CMD_REQ], o->len);
 			rv = FMLN_MPC_TUNNEL_CMD_RESP + o->len;
@@ -702,7 +1181,7 @@ int fmapi_deserialize(void *dst, __u8 *src, unsigned type, void *param)
 			o->ext 		= src[2] & 0x0F;
 			o->fdbe		= (src[2] >> 4 ) & 0x0F;
 			o->type     = (src[3] >> 7 ) & 0x01;
-			o->ldid		= (src[5] << 8) | src[4];
+			o->ldid		= fmapi_get_le16(&src[4]);
 			o->data[0]	= src[8];
 			o->data[1]  = src[9];
 			o->data[2]  = src[10];
@@ -711,17 +1190,6 @@ int fmapi_deserialize(void *dst, __u8 *src, unsigned type, void *param)
 		}
 			break;
 
-		case FMOB_MPC_CFG_RSP: //!< struct fmapi_mpc_cfg_rsp
-		{
-			struct fmapi_mpc_cfg_rsp *o = (struct fmapi_mpc_cfg_rsp*) dst;
-			o->data[0] = src[0];
-			o->data[1] = src[1];
-			o->data[2] = src[2];
-			o->data[3] = src[3];
-			rv = FMLN_MPC_LD_IO_CFG_RESP;
-		}
-			break;
-
 		case FMOB_MPC_MEM_REQ: //!< struct fmapi_mpc_mem_req
 		{
 			struct fmapi_mpc_mem_req *o = (struct fmapi_mpc_mem_req*) dst;
@@ -729,188 +1197,407 @@ int fmapi_deserialize(void *dst, __u8 *src, unsigned type, void *param)
 			o->fdbe 	= (src[2] >> 4 ) & 0x000F;		
 			o->ldbe		= (src[3]      ) & 0x000F;
 			o->type 	= (src[3] >> 7 ) & 0x0001;
-			o->ldid 	= (src[5] << 8) | src[4];
-			o->len  	= (src[7] << 8) | src[6];
-			o->offset 	= 	((__u64)src[15] << 56) | 
-							((__u64)src[14] << 48) |
-							((__u64)src[13] << 40) | 
-							((__u64)src[12] << 32) | 
-							((__u64)src[11] << 24) |
-							((__u64)src[10] << 16) | 
-							((__u64)src[ 9] << 8 ) | 
-							((__u64)src[ 8]      );
+			o->ldid 	= fmapi_get_le16(&src[4]);
+			o->len  	= fmapi_get_le16(&src[6]);
+			o->offset 	= fmapi_get_le64(&src[8]);
 			memcpy(o->data, &src[FMLN_MPC_LD_MEM_REQ], o->len);
 			rv = FMLN_MPC_LD_MEM_REQ + o->len;
 		}
 			break;
 
-		case FMOB_MPC_MEM_RSP: //!< struct fmapi_mpc_mem_rsp
-		{
-			struct fmapi_mpc_mem_rsp *o = (struct fmapi_mpc_mem_rsp*) dst;
-			o->len = (src[1] << 8) | src[0];
-			memcpy(o->data, &src[FMLN_MPC_LD_MEM_RESP], o->len);
-			rv = FMLN_MPC_LD_MEM_RESP + o->len;
-		}
-			break;
-
-		case FMOB_MCC_INFO_RSP: //!< struct fmapi_mcc_info_rsp
-		{
-			struct fmapi_mcc_info_rsp *o = (struct fmapi_mcc_info_rsp*) dst;
-			o->size = 	((__u64)src[7] << 56) | 
-						((__u64)src[6] << 48) |
-						((__u64)src[5] << 40) | 
-						((__u64)src[4] << 32) | 
-						((__u64)src[3] << 24) |
-						((__u64)src[2] << 16) | 
-						((__u64)src[1] << 8 ) | 
-						((__u64)src[0]      );
-			o->num = (src[9] << 8) | src[8];
-			o->epc = (src[10] >> FMQT_EGRESS_PORT_CONGESTION_BIT   ) & 0x01;
-			o->ttr = (src[10] >> FMQT_TEMP_THROUGHPUT_REDUCTION_BIT) & 0x01;
-			rv = FMLN_MCC_GET_LD_INFO;
-		}
+		default:
+			rv = 0;
 			break;
+	}
 
-		case FMOB_MCC_ALLOC_BLK: //!< struct fmapi_mcc_ldalloc_entry
-		{
-			struct fmapi_mcc_alloc_blk *o = (struct fmapi_mcc_alloc_blk*) dst;
-			o->rng1 = 	((__u64)src[7] << 56) | 
-						((__u64)src[6] << 48) |
-						((__u64)src[5] << 40) | 
-						((__u64)src[4] << 32) | 
-						((__u64)src[3] << 24) |
-						((__u64)src[2] << 16) | 
-						((__u64)src[1] << 8 ) | 
-						((__u64)src[0]      );
-			o->rng2 = 	((__u64)src[15] << 56) | 
-						((__u64)src[14] << 48) |
-						((__u64)src[13] << 40) | 
-						((__u64)src[12] << 32) | 
-						((__u64)src[11] << 24) |
-						((__u64)src[10] << 16) | 
-						((__u64)src[9] << 8 ) | 
-						((__u64)src[8]      );
-			rv = FMLN_MCC_LD_ALLOC_ENTRY;
-		}
-			break;
+	return rv;
+}
 
-		
-		case FMOB_MCC_ALLOC_GET_REQ: //!< struct fmapi_mcc_alloc_get_req
-		{
-			struct fmapi_mcc_alloc_get_req *o = (struct fmapi_mcc_alloc_get_req*) dst;
-			o->start = src[0];
-			o->limit = src[1];
-			rv = FMLN_MCC_GET_LD_ALLOC_REQ;
-		}
+/**
+ * @brief Compute the serialized length of an object in a bounded byte array
+ *
+ * Every count field read from the source (e.g. psc_port_req.num or 
+ * mpc_mem_req.len) is checked against both the remaining source length and 
+ * the capacity of the destination object. No data is copied.
+ * 
+ * @param[in] src void Pointer to unsigned char array
+ * @param[in] len size_t Number of valid bytes in src
+ * @param[in] type unsigned enum _FMOB representing type of object to check 
+ * @param[in] param void * to data needed to deserialize the byte stream 
+ * @return serialized length of the object, or a negative enum _FMER upon error
+ */
+int fmapi_check_len(__u8 *src, size_t len, unsigned type, void *param)
+{
+	size_t need;
+	unsigned num;
+
+	// Validate Inputs 
+	if (type >= FMOB_MAX)
+		return -FMER_INVALID;
+
+	if (type == FMOB_NULL)
+		return 0;
+
+	if (src == NULL)
+		return -FMER_INVALID;
+
+	// Every object has a fixed portion that must be present
+	need = FMLN_FMOB[type];
+	if (len < need)
+		return -FMER_TRUNCATED;
+
+	// Add the variable length portion described by the count fields
+	switch(type)
+	{
+		case FMOB_PSC_PORT_REQ: //!< struct fmapi_psc_port_req
+			need += src[0];
 			break;
 
-		case FMOB_MCC_ALLOC_GET_RSP: //!< struct fmapi_mcc_alloc_get_rsp
-		{
-			struct fmapi_mcc_alloc_get_rsp *o = (struct fmapi_mcc_alloc_get_rsp*) dst;
-			o->total 		= src[0];
-			o->granularity 	= src[1];
-			o->start		= src[2];
-			o->num 			= src[3];
-			rv = FMLN_MCC_GET_LD_ALLOC_RSP;
-			for ( int i = 0 ; i < o->num ; i++ )
-				rv += fmapi_deserialize(&o->list[i], &src[rv], FMOB_MCC_ALLOC_BLK, NULL);
-		}
+		case FMOB_PSC_PORT_RSP: //!< struct fmapi_psc_port_rsp
+			need += src[0] * FMLN_PSC_GET_PHY_PORT_INFO;
 			break;
 
-		case FMOB_MCC_ALLOC_SET_REQ: //!< struct fmapi_mcc_alloc_set_req
+		case FMOB_VSC_INFO_REQ: //!< struct fmapi_vsc_info_req
+			need += src[2];
+			break;
+
+		case FMOB_VSC_INFO_BLK: //!< struct fmapi_vsc_info_blk
 		{
-			struct fmapi_mcc_alloc_set_req *o = (struct fmapi_mcc_alloc_set_req*) dst;
-			o->num   = src[0];
-			o->start = src[1];
-			rv = FMLN_MCC_SET_LD_ALLOC_REQ;
-			for ( int i = 0 ; i < o->num ; i++ )
-				rv += fmapi_deserialize(&o->list[i], &src[rv], FMOB_MCC_ALLOC_BLK, NULL);
+			struct fmapi_vsc_info_req *r = (struct fmapi_vsc_info_req*) param;
+			int n;
+
+			// We must have a pointer to the request to deserialize the response 
+			if (r == NULL)
+				return -FMER_PARAM;
+
+			// Compute number of vPPB blk entries from fields in request 
+			n = src[3] - r->vppbid_start;
+			if (n < 0)
+				n = 0;
+			if (r->vppbid_limit < n)
+				n = r->vppbid_limit;
+
+			need += n * FMLN_VSC_PPB_STATUS;
 		}
 			break;
 
-		case FMOB_MCC_ALLOC_SET_RSP: //!< struct fmapi_mcc_alloc_set_rsp
+		case FMOB_VSC_INFO_RSP: //!< struct fmapi_vsc_info_rsp
 		{
-			struct fmapi_mcc_alloc_set_rsp *o = (struct fmapi_mcc_alloc_set_rsp*) dst;
-			o->num   = src[0];
-			o->start = src[1];
-			rv = FMLN_MCC_SET_LD_ALLOC_RSP;
-			for ( int i = 0 ; i < o->num ; i++ )
-				rv += fmapi_deserialize(&o->list[i], &src[rv], FMOB_MCC_ALLOC_BLK, NULL);
+			if (src[0] > FM_MAX_VCS_PER_RSP)
+				return -FMER_OVERFLOW;
+
+			// Each block is variable length so walk them with the remaining length
+			for (int i = 0 ; i < src[0] ; i++)
+			{
+				int n = fmapi_check_len(&src[need], len - need, FMOB_VSC_INFO_BLK, param);
+				if (n < 0)
+					return n;
+				need += n;
+			}
 		}
 			break;
 
-		case FMOB_MCC_QOS_CTRL: //!< struct fmapi_mcc_qos_ctrl
+		case FMOB_MPC_TMC_REQ: //!< struct fmapi_mpc_tmc_req
+		case FMOB_MPC_TMC_RSP: //!< struct fmapi_mpc_tmc_rsp
 		{
-			struct fmapi_mcc_qos_ctrl *o = (struct fmapi_mcc_qos_ctrl*) dst;
-			o->epc_en       = (src[0] >> FMQT_EGRESS_PORT_CONGESTION_BIT   ) & 0x01;
-			o->ttr_en = (src[0] >> FMQT_TEMP_THROUGHPUT_REDUCTION_BIT) & 0x01;
-			o->egress_mod_pcnt 	= src[1];
-			o->egress_sev_pcnt 	= src[2];
-			o->sample_interval 	= src[3];
-			o->rcb 	= (src[5] << 8 ) | src[4];
-			o->comp_interval  	= src[6];
-			rv = FMLN_MCC_QOS_CTRL;
+			// Command size on the wire includes the MCTP Type byte
+			if (type == FMOB_MPC_TMC_REQ)
+				num = (src[3] << 8) | src[2];
+			else 
+				num = (src[1] << 8) | src[0];
+
+			if (num == 0)
+				return -FMER_INVALID;
+			if (num - 1 > FMLN_MPC_TUNNEL_PAYLOAD)
+				return -FMER_OVERFLOW;
+			need += num - 1;
 		}
 			break;
 
-		case FMOB_MCC_QOS_STAT_RSP: //!< struct fmapi_mcc_qos_stat_rsp
+		case FMOB_MPC_MEM_REQ: //!< struct fmapi_mpc_mem_req
+		case FMOB_MPC_MEM_RSP: //!< struct fmapi_mpc_mem_rsp
 		{
-			struct fmapi_mcc_qos_stat_rsp *o = (struct fmapi_mcc_qos_stat_rsp*) dst;
-			o->bp_avg_pcnt = src[0];
-			rv = FMLN_MCC_QOS_STATUS;
+			if (type == FMOB_MPC_MEM_REQ)
+				num = (src[7] << 8) | src[6];
+			else 
+				num = (src[1] << 8) | src[0];
+
+			if (num > FM_LD_MEM_REQ_LEN)
+				return -FMER_OVERFLOW;
+			need += num;
 		}
 			break;
 
-		case FMOB_MCC_QOS_BW_GET_REQ:
+		case FMOB_MCC_ALLOC_GET_RSP: //!< struct fmapi_mcc_alloc_get_rsp
+		case FMOB_MCC_ALLOC_SET_REQ: //!< struct fmapi_mcc_alloc_set_req
+		case FMOB_MCC_ALLOC_SET_RSP: //!< struct fmapi_mcc_alloc_set_rsp
 		{
-			struct fmapi_mcc_qos_bw_alloc_get_req *o = (struct fmapi_mcc_qos_bw_alloc_get_req*) dst;
-			o->num 		= src[0];
-			o->start 	= src[1];
-			rv = FMLN_MCC_GET_QOS_BW_REQ;
+			num = (type == FMOB_MCC_ALLOC_GET_RSP) ? src[3] : src[0];
+			if (num > FM_MAX_NUM_LD)
+				return -FMER_OVERFLOW;
+			need += num * FMLN_MCC_LD_ALLOC_ENTRY;
 		}
 			break;
 
 		case FMOB_MCC_QOS_BW_ALLOC: //!< struct fmapi_mcc_qos_bw_alloc
+		case FMOB_MCC_QOS_BW_LIMIT: //!< struct fmapi_mcc_qos_bw_limit
 		{
-			struct fmapi_mcc_qos_bw_alloc *o = (struct fmapi_mcc_qos_bw_alloc*) dst;
-			o->num 	 = src[0];
-			o->start = src[1];
-			rv = FMLN_MCC_QOS_BW_ALLOC;
-			for ( int i = 0 ; i < o->num ; i++ )
-				o->list[i] = src[rv + i];
-			rv += o->num;
+			if (src[0] > FM_MAX_NUM_LD)
+				return -FMER_OVERFLOW;
+			need += src[0];
 		}
 			break;
 
-		case FMOB_MCC_QOS_BW_LIMIT_GET_REQ: //!< struct fmapi_mcc_qos_bw_limit_get_req 
+		default:
+			break;
+	}
+
+	if (len < need)
+		return -FMER_TRUNCATED;
+
+	return need;
+}
+
+/**
+ * @brief Convert from a Little Endian byte array to a struct, bounded by len
+ *
+ * The source is validated with fmapi_check_len() before any data is copied.
+ * 
+ * @param[out] dst void Pointer to destination struct
+ * @param[in] src void Pointer to unsigned char array
+ * @param[in] len size_t Number of valid bytes in src
+ * @param[in] type unsigned enum _FMOB representing type of object to deserialize
+ * @param[in] param void * to data needed to deserialize the byte stream 
+ * @return number of bytes consumed, or a negative enum _FMER upon error
+ */
+int fmapi_deserialize_len(void *dst, __u8 *src, size_t len, unsigned type, void *param)
+{
+	int rv;
+
+	// Validate Inputs 
+	if (dst == NULL)
+		return -FMER_INVALID;
+
+	rv = fmapi_check_len(src, len, type, param);
+	if (rv <= 0)
+		return rv;
+
+	switch(type)
+	{
+		// The number of vPPB entries is derived from the request. Decode these 
+		// here so the count is clamped exactly as fmapi_check_len() computed it
+		case FMOB_VSC_INFO_BLK: //!< struct fmapi_vsc_info_blk
 		{
-			struct fmapi_mcc_qos_bw_limit_get_req *o = (struct fmapi_mcc_qos_bw_limit_get_req*) dst;
-			o->num = src[0];
-			o->start = src[1];
-			rv = FMLN_MCC_GET_QOS_BW_LIMIT_REQ;
+			struct fmapi_vsc_info_blk *o = (struct fmapi_vsc_info_blk*) dst;
+
+			o->vcsid = src[0];
+			o->state = src[1];
+			o->uspid = src[2];
+			o->total = src[3];
+			o->num   = (rv - FMLN_VSC_INFO) / FMLN_VSC_PPB_STATUS;
+
+			rv = FMLN_VSC_INFO;
+			for (int i = 0 ; i < o->num ; i++)
+				rv += fmapi_deserialize(&o->list[i], &src[rv], FMOB_VSC_PPB_STAT_BLK, NULL);
 		}
 			break;
 
-		case FMOB_MCC_QOS_BW_LIMIT: //!< struct fmapi_mcc_qos_bw_limit
+		case FMOB_VSC_INFO_RSP: //!< struct fmapi_vsc_info_rsp
 		{
-			struct fmapi_mcc_qos_bw_limit *o = (struct fmapi_mcc_qos_bw_limit*) dst;
-			o->num 	 = src[0];
-			o->start = src[1];
-			rv = FMLN_MCC_QOS_BW_LIMIT;
-			for ( int i = 0 ; i < o->num ; i++ )
-				o->list[i] = src[rv + i];
-			rv += o->num;
+			struct fmapi_vsc_info_rsp *o = (struct fmapi_vsc_info_rsp*) dst;
+
+			o->num = src[0];
+
+			rv = FMLN_VSC_GET_INFO_RESP;
+			for (int i = 0 ; i < o->num ; i++)
+				rv += fmapi_deserialize_len(&o->list[i], &src[rv], len - rv, FMOB_VSC_INFO_BLK, param);
 		}
 			break;
 
 		default:
-			rv = 0;
+			rv = fmapi_deserialize(dst, src, type, param);
 			break;
 	}
 
 	return rv;
 }
 
+/**
+ * Column of struct fmapi_psc_port_table for each byte of a port info block 
+ *
+ * NULL for reserved bytes 
+ */
+static void fmapi_port_table_cols(struct fmapi_psc_port_table *t, __u8 **col)
+{
+	col[0]  = t->ppid;
+	col[1]  = t->state;
+	col[2]  = t->dv;
+	col[3]  = NULL;
+	col[4]  = t->dt;
+	col[5]  = t->cv;
+	col[6]  = t->mlw;
+	col[7]  = t->nlw;
+	col[8]  = t->speeds;
+	col[9]  = t->mls;
+	col[10] = t->cls;
+	col[11] = t->ltssm;
+	col[12] = t->lane;
+	col[13] = t->flags;
+	col[14] = NULL;
+	col[15] = t->num_ld;
+}
+
+/**
+ * @brief Decode a Get Physical Port State Response into a table of columns
+ *
+ * The port info blocks form a num x 16 byte matrix that is transposed into 
+ * the 16 columns of the table, 16 (SSE2, NEON) or 32 (AVX2) ports per step 
+ * using four rounds of byte interleaves. Remaining ports are copied one at a 
+ * time. The Link State Flags are then unpacked a vector at a time. 
+ *
+ * @param[out] t struct fmapi_psc_port_table* to fill 
+ * @param[in] src __u8* Serialized FMOB_PSC_PORT_RSP payload 
+ * @param[in] len size_t Number of valid bytes in src
+ * @return number of bytes consumed, or a negative enum _FMER upon error
+ */
+int fmapi_deserialize_port_table(struct fmapi_psc_port_table *t, __u8 *src, size_t len)
+{
+	__u8 *col[FMLN_PSC_GET_PHY_PORT_INFO];
+	__u8 *blk;
+	unsigned i, num;
+	int rv;
+
+	// Validate Inputs 
+	if (t == NULL)
+		return -FMER_INVALID;
+
+	rv = fmapi_check_len(src, len, FMOB_PSC_PORT_RSP, NULL);
+	if (rv <= 0)
+		return rv;
+
+	num = src[0];
+	blk = &src[FMLN_PSC_GET_PHY_PORT_RESP];
+	t->num = num;
+	fmapi_port_table_cols(t, col);
+	i = 0;
+
+#if defined(__AVX2__)
+	// Transpose 32 ports: ports i..i+15 in the low lane, i+16..i+31 in the high lane
+	for ( ; i + 32 <= num ; i += 32 )
+	{
+		__m256i a[16], b[16];
+
+		for ( int r = 0 ; r < 16 ; r++ )
+			a[r] = _mm256_inserti128_si256(
+				_mm256_castsi128_si256(_mm_loadu_si128((__m128i*) &blk[(i + r) * FMLN_PSC_GET_PHY_PORT_INFO])),
+				_mm_loadu_si128((__m128i*) &blk[(i + r + 16) * FMLN_PSC_GET_PHY_PORT_INFO]), 1);
+
+		for ( int round = 0 ; round < 4 ; round++ )
+		{
+			for ( int k = 0 ; k < 8 ; k++ )
+			{
+				b[2*k]   = _mm256_unpacklo_epi8(a[k], a[k+8]);
+				b[2*k+1] = _mm256_unpackhi_epi8(a[k], a[k+8]);
+			}
+			memcpy(a, b, sizeof(a));
+		}
+
+		for ( int c = 0 ; c < 16 ; c++ )
+			if (col[c] != NULL)
+				_mm256_storeu_si256((__m256i*) &col[c][i], a[c]);
+	}
+#endif
+
+#if defined(__SSE2__)
+	// Transpose 16 ports 
+	for ( ; i + 16 <= num ; i += 16 )
+	{
+		__m128i a[16], b[16];
+
+		for ( int r = 0 ; r < 16 ; r++ )
+			a[r] = _mm_loadu_si128((__m128i*) &blk[(i + r) * FMLN_PSC_GET_PHY_PORT_INFO]);
+
+		for ( int round = 0 ; round < 4 ; round++ )
+		{
+			for ( int k = 0 ; k < 8 ; k++ )
+			{
+				b[2*k]   = _mm_unpacklo_epi8(a[k], a[k+8]);
+				b[2*k+1] = _mm_unpackhi_epi8(a[k], a[k+8]);
+			}
+			memcpy(a, b, sizeof(a));
+		}
+
+		for ( int c = 0 ; c < 16 ; c++ )
+			if (col[c] != NULL)
+				_mm_storeu_si128((__m128i*) &col[c][i], a[c]);
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	// Transpose 16 ports 
+	for ( ; i + 16 <= num ; i += 16 )
+	{
+		uint8x16_t a[16], b[16];
+
+		for ( int r = 0 ; r < 16 ; r++ )
+			a[r] = vld1q_u8(&blk[(i + r) * FMLN_PSC_GET_PHY_PORT_INFO]);
+
+		for ( int round = 0 ; round < 4 ; round++ )
+		{
+			for ( int k = 0 ; k < 8 ; k++ )
+			{
+				b[2*k]   = vzip1q_u8(a[k], a[k+8]);
+				b[2*k+1] = vzip2q_u8(a[k], a[k+8]);
+			}
+			memcpy(a, b, sizeof(a));
+		}
+
+		for ( int c = 0 ; c < 16 ; c++ )
+			if (col[c] != NULL)
+				vst1q_u8(&col[c][i], a[c]);
+	}
+#endif
+
+	// Remaining ports 
+	for ( ; i < num ; i++ )
+		for ( int c = 0 ; c < 16 ; c++ )
+			if (col[c] != NULL)
+				col[c][i] = blk[i * FMLN_PSC_GET_PHY_PORT_INFO + c];
+
+	// Unpack Link State Flags 
+	i = 0;
+#if defined(__SSE2__)
+	for ( ; i + 16 <= num ; i += 16 )
+	{
+		__m128i f = _mm_loadu_si128((__m128i*) &t->flags[i]);
+		__m128i one = _mm_set1_epi8(1);
+
+		_mm_storeu_si128((__m128i*) &t->lane_rev[i], _mm_and_si128(_mm_srli_epi16(f, FMLF_LANE_REVERSAL_BIT), one));
+		_mm_storeu_si128((__m128i*) &t->perst[i],    _mm_and_si128(_mm_srli_epi16(f, FMLF_PERST_STATE_BIT), one));
+		_mm_storeu_si128((__m128i*) &t->prsnt[i],    _mm_and_si128(_mm_srli_epi16(f, FMLF_PRSNT_STATE_BIT), one));
+		_mm_storeu_si128((__m128i*) &t->pwrctrl[i],  _mm_and_si128(_mm_srli_epi16(f, FMLF_PWRCTL_STATE_BIT), one));
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	for ( ; i + 16 <= num ; i += 16 )
+	{
+		uint8x16_t f = vld1q_u8(&t->flags[i]);
+		uint8x16_t one = vdupq_n_u8(1);
+
+		vst1q_u8(&t->lane_rev[i], vandq_u8(vtstq_u8(f, vdupq_n_u8(1 << FMLF_LANE_REVERSAL_BIT)), one));
+		vst1q_u8(&t->perst[i],    vandq_u8(vtstq_u8(f, vdupq_n_u8(1 << FMLF_PERST_STATE_BIT)), one));
+		vst1q_u8(&t->prsnt[i],    vandq_u8(vtstq_u8(f, vdupq_n_u8(1 << FMLF_PRSNT_STATE_BIT)), one));
+		vst1q_u8(&t->pwrctrl[i],  vandq_u8(vtstq_u8(f, vdupq_n_u8(1 << FMLF_PWRCTL_STATE_BIT)), one));
+	}
+#endif
+	for ( ; i < num ; i++ )
+	{
+		t->lane_rev[i] = (t->flags[i] >> FMLF_LANE_REVERSAL_BIT) & 0x01;
+		t->perst[i]    = (t->flags[i] >> FMLF_PERST_STATE_BIT  ) & 0x01;
+		t->prsnt[i]    = (t->flags[i] >> FMLF_PRSNT_STATE_BIT  ) & 0x01;
+		t->pwrctrl[i]  = (t->flags[i] >> FMLF_PWRCTL_STATE_BIT ) & 0x01;
+	}
+
+	return rv;
+}
+
 /** 
  * Prepare an FM API Message - ISC Background Operation Status
  *
@@ -1466,7 +2153,8 @@ int fmapi_fill_mpc_mem(struct fmapi_msg *m, int ppid, int ldid, __u64 offset, in
 	m->obj.mpc_mem_req.fdbe   = fdbe;
 	m->obj.mpc_mem_req.ldbe   = ldbe;
 	m->obj.mpc_mem_req.type   = type;
-	memcpy(m->obj.mpc_mem_req.data, data, len);
+	if (data != NULL)
+		memcpy(m->obj.mpc_mem_req.data, data, len);
 
 	rv = 0;
 
@@ -1488,12 +2176,13 @@ int fmapi_fill_mpc_tmc(struct fmapi_msg *m, int ppid, int type, struct fmapi_msg
 	// Initialize variables
 	rv = 1;
 	len = 0;
-	sub->buf = (struct fmapi_buf*) m->obj.mpc_tmc_req.msg;
 
 	// Validate Inputs 
-	if (m == NULL)
+	if ( (m == NULL) || (sub == NULL) )
 		goto end;
 
+	sub->buf = (struct fmapi_buf*) m->obj.mpc_tmc_req.msg;
+
 	// Clear Header
 	memset(&m->hdr, 0, sizeof(struct fmapi_hdr));
 
@@ -1502,16 +2191,11 @@ int fmapi_fill_mpc_tmc(struct fmapi_msg *m, int ppid, int type, struct fmapi_msg
 
 	// Set object
 	{
-		// Fill Sub Object 
-
-		// Serialize Sub Object 
-		len = fmapi_serialize(sub->buf->payload, &sub->obj, fmapi_fmob_req(sub->hdr.opcode));
-
-		// Fill Sub Header
-		m->obj.mpc_tmc_req.len = fmapi_fill_hdr(&sub->hdr, FMMT_REQ, 0, sub->hdr.opcode, 0, len, 0, 0);
-	
-		// Serialize Sub Header 
-		fmapi_serialize((__u8*)&sub->buf->hdr, &sub->hdr, FMOB_HDR);
+		// Serialize Sub Header and Sub Object 
+		len = fmapi_msg_encode(sub, m->obj.mpc_tmc_req.msg, FMLN_MPC_TUNNEL_PAYLOAD, FMMT_REQ, 0);
+		if (len < 0)
+			goto end;
+		m->obj.mpc_tmc_req.len = len;
 
 		// Set TMC Object Type 
 		m->obj.mpc_tmc_req.type = type;
@@ -1920,6 +2604,22 @@ int fmapi_fill_hdr
 	return FMLN_HDR + len;
 }
 
+/**
+ * Look up the static description of an FM API Message Opcode [FMOP]
+ *
+ * @param	opcode 	This is an FM API Opcode [FMOP]
+ * @return	struct fmapi_opcode_info* for the opcode, or NULL if the opcode is unknown
+ */
+const struct fmapi_opcode_info *fmapi_opcode_info(unsigned int opcode)
+{
+	const struct fmapi_opcode_info *info = &FMOI_FMOP[FMOI_HASH(opcode)];
+
+	if ( (info->name == NULL) || (info->opcode != opcode) )
+		return NULL;
+
+	return info;
+}
+
 /**
  * Determine the Request Object Identifier [FMOB] for an FM API Message Opcode [FMOP]
  *
@@ -1928,35 +2628,10 @@ int fmapi_fill_hdr
  */
 int fmapi_fmob_req(unsigned int opcode)
 {
-	switch (opcode)
-	{
-		case FMOP_PSC_ID:				return FMOB_NULL;
-		case FMOP_PSC_PORT:				return FMOB_PSC_PORT_REQ;
-		case FMOP_PSC_PORT_CTRL:		return FMOB_PSC_PORT_CTRL_REQ;
-		case FMOP_PSC_CFG:				return FMOB_PSC_CFG_REQ;
-		case FMOP_VSC_INFO:				return FMOB_VSC_INFO_REQ;
-		case FMOP_VSC_BIND:				return FMOB_VSC_BIND_REQ;;
-		case FMOP_VSC_UNBIND:			return FMOB_VSC_UNBIND_REQ;
-		case FMOP_VSC_AER:				return FMOB_VSC_AER_REQ;
-		case FMOP_MPC_TMC:				return FMOB_MPC_TMC_REQ;
-		case FMOP_MPC_CFG:				return FMOB_MPC_CFG_REQ;
-		case FMOP_MPC_MEM:				return FMOB_MPC_MEM_REQ;
-		case FMOP_MCC_INFO:				return FMOB_NULL;
-		case FMOP_MCC_ALLOC_GET:		return FMOB_MCC_ALLOC_GET_REQ;
-		case FMOP_MCC_ALLOC_SET:		return FMOB_MCC_ALLOC_SET_REQ;
-		case FMOP_MCC_QOS_CTRL_GET:		return FMOB_NULL;
-		case FMOP_MCC_QOS_CTRL_SET:		return FMOB_MCC_QOS_CTRL;
-		case FMOP_MCC_QOS_STAT:			return FMOB_NULL;
-		case FMOP_MCC_QOS_BW_ALLOC_GET:	return FMOB_MCC_QOS_BW_GET_REQ;
-		case FMOP_MCC_QOS_BW_ALLOC_SET:	return FMOB_MCC_QOS_BW_ALLOC;
-		case FMOP_MCC_QOS_BW_LIMIT_GET:	return FMOB_MCC_QOS_BW_LIMIT_GET_REQ;
-		case FMOP_MCC_QOS_BW_LIMIT_SET:	return FMOB_MCC_QOS_BW_LIMIT;
-		case FMOP_ISC_ID:				return FMOB_NULL;
-		case FMOP_ISC_BOS:				return FMOB_NULL;
-		case FMOP_ISC_MSG_LIMIT_GET:	return FMOB_NULL;
-		case FMOP_ISC_MSG_LIMIT_SET:	return FMOB_ISC_MSG_LIMIT;
-		default: 						return FMOB_NULL;
-	}
+	const struct fmapi_opcode_info *info = fmapi_opcode_info(opcode);
+
+	if (info == NULL) 	return FMOB_NULL;
+	else 				return info->req;
 }
 
 /**
@@ -1967,546 +2642,1683 @@ int fmapi_fmob_req(unsigned int opcode)
  */
 int fmapi_fmob_rsp(unsigned int opcode)
 {
-	switch (opcode)
-	{
-		case FMOP_PSC_ID:				return FMOB_PSC_ID_RSP;
-		case FMOP_PSC_PORT:				return FMOB_PSC_PORT_RSP;
-		case FMOP_PSC_PORT_CTRL:		return FMOB_NULL;
-		case FMOP_PSC_CFG:				return FMOB_PSC_CFG_RSP;
-		case FMOP_VSC_INFO:				return FMOB_VSC_INFO_RSP;
-		case FMOP_VSC_BIND:				return FMOB_NULL;
-		case FMOP_VSC_UNBIND:			return FMOB_NULL;
-		case FMOP_VSC_AER:				return FMOB_NULL;
-		case FMOP_MPC_TMC:				return FMOB_MPC_TMC_RSP;
-		case FMOP_MPC_CFG:				return FMOB_MPC_CFG_RSP;
-		case FMOP_MPC_MEM:				return FMOB_MPC_MEM_RSP;
-		case FMOP_MCC_INFO:				return FMOB_MCC_INFO_RSP;
-		case FMOP_MCC_ALLOC_GET:		return FMOB_MCC_ALLOC_GET_RSP;
-		case FMOP_MCC_ALLOC_SET:		return FMOB_MCC_ALLOC_SET_RSP;
-		case FMOP_MCC_QOS_CTRL_GET:		return FMOB_MCC_QOS_CTRL;
-		case FMOP_MCC_QOS_CTRL_SET:		return FMOB_MCC_QOS_CTRL;
-		case FMOP_MCC_QOS_STAT:			return FMOB_MCC_QOS_STAT_RSP;
-		case FMOP_MCC_QOS_BW_ALLOC_GET:	return FMOB_MCC_QOS_BW_ALLOC;
-		case FMOP_MCC_QOS_BW_ALLOC_SET:	return FMOB_MCC_QOS_BW_ALLOC;
-		case FMOP_MCC_QOS_BW_LIMIT_GET:	return FMOB_MCC_QOS_BW_LIMIT;
-		case FMOP_MCC_QOS_BW_LIMIT_SET:	return FMOB_MCC_QOS_BW_LIMIT;
-		case FMOP_ISC_ID:				return FMOB_ISC_ID_RSP;
-		case FMOP_ISC_BOS:				return FMOB_ISC_BOS;
-		case FMOP_ISC_MSG_LIMIT_GET:	return FMOB_ISC_MSG_LIMIT;
-		case FMOP_ISC_MSG_LIMIT_SET:	return FMOB_ISC_MSG_LIMIT;
-		default: 						return FMOB_NULL;
-	}
+	const struct fmapi_opcode_info *info = fmapi_opcode_info(opcode);
+
+	if (info == NULL) 	return FMOB_NULL;
+	else 				return info->rsp;
 }
 
 /**
- * @brief Convert an object into Little Endian byte array format
- * 
- * @param[out] dst void Pointer to destination unsigned char array
- * @param[in] src void Pointer to object to serialize
- * @param[in] type unsigned enum _FMOB representing type of object to serialize
- * @return number of serialized bytes, 0 if error 
+ * Size in bytes of a right sized struct fmapi_msg holding an object [FMOB]
+ *
+ * num only trims the list of request objects, which a requester encodes but 
+ * never decodes into. Every other object is sized to its full capacity. 
+ *
+ * @param	type 	enum _FMOB of the object the message will hold, or FMOB_MAX 
+ * 					for a full struct fmapi_msg that can hold any object
+ * @param	num 	Number of entries in the trailing variable length list of a 
+ * 					request object. 0 sizes the list to its full capacity
+ * @return	size_t	Size in bytes. 0 if type is invalid 
  */
-int fmapi_serialize(__u8 *dst, void *src, unsigned type)
+size_t fmapi_msg_size(unsigned type, unsigned num)
 {
-	int rv;
+	const struct fmapi_obj_size *o;
+	size_t size;
 
-	// Initialize variables 
-	rv = 0;
+	if (type == FMOB_MAX)
+		return sizeof(struct fmapi_msg);
 
-	// Validate Inputs 
-	if ( (type == FMOB_NULL) || (type >= FMOB_MAX) )
+	if (type > FMOB_MAX)
 		return 0;
 
-	switch(type)
-	{
-		case FMOB_HDR: //!< struct fmapi_hdr
-		{
-			struct fmapi_hdr *o = (struct fmapi_hdr*) src;
-			dst[0] = (o->category << 4) & 0xF0;
-			dst[1] = o->tag;
-			dst[3] = (o->opcode & 0x00FF);
-			dst[4] = ((o->opcode >> 8) & 0x00FF);
-			dst[5] = (o->len         ) & 0x00FF;
-			dst[6] = ( o->len >> 8   ) & 0x00FF;
-			dst[7] = ((o->len >> 13  ) & 0x00F8) | (o->background & 0x01);
-			dst[8] = (o->return_code     ) & 0x00FF; 
-			dst[9] = (o->return_code >> 8) & 0x00FF;
-			dst[10]= (o->ext_status     ) & 0x00FF;
-			dst[11]= (o->ext_status >> 8) & 0x00FF;
-			rv = FMLN_HDR;
-		}
-			break;
+	o = &FMSZ_FMOB[type];
+	size = o->size;
+	if ( (num > 0) && o->trim && (o->list + num * o->elem < size) )
+		size = o->list + num * o->elem;
 
-		case FMOB_ISC_BOS: //!< struct fmapi_isc_bos
-		{
-			struct fmapi_isc_bos *o = (struct fmapi_isc_bos*) src;
-			dst[ 0] = (o->pcnt << 1) | (o->running & 0x01);
-			dst[ 1] = 0;
-			dst[ 2] =  o->opcode        & 0x00FF;
-			dst[ 3] = (o->opcode >> 8 ) & 0x00FF;
-			dst[ 4] =  o->rc            & 0x00FF;
-			dst[ 5] = (o->rc     >> 8 ) & 0x00FF;
-			dst[ 6] =  o->ext           & 0x00FF;
-			dst[ 7] = (o->ext    >> 8 ) & 0x00FF;
-			rv = FMLN_ISC_BOS;
-		}
-			break;
+	return offsetof(struct fmapi_msg, obj) + size;
+}
 
-		case FMOB_ISC_ID_RSP: //!< struct fmapi_isc_id_rsp
-		{
-			struct fmapi_isc_id_rsp *o = (struct fmapi_isc_id_rsp*) src;
-			dst[ 0] = (o->vid       ) & 0x00FF;
-			dst[ 1] = (o->vid  >>  8) & 0x00FF;
-			dst[ 2] = (o->did       ) & 0x00FF;
-			dst[ 3] = (o->did  >>  8) & 0x00FF;
-			dst[ 4] = (o->svid      ) & 0x00FF;
-			dst[ 5] = (o->svid >>  8) & 0x00FF;
-			dst[ 6] = (o->ssid      ) & 0x00FF;
-			dst[ 7] = (o->ssid >>  8) & 0x00FF;
-			dst[ 8] = (o->sn        ) & 0x00FF;	
-			dst[ 9] = (o->sn   >>  8) & 0x00FF;	
-			dst[10] = (o->sn   >> 16) & 0x00FF;	
-			dst[11] = (o->sn   >> 24) & 0x00FF;	
-			dst[12] = (o->sn   >> 32) & 0x00FF;	
-			dst[13] = (o->sn   >> 40) & 0x00FF;	
-			dst[14] = (o->sn   >> 48) & 0x00FF;	
-			dst[15] = (o->sn   >> 56) & 0x00FF;	
-			dst[16] =  o->size;
-			rv = FMLN_ISC_ID_RSP;
-		}
-			break;
+/**
+ * Allocate a struct fmapi_msg sized for one FM API Object [FMOB]
+ *
+ * Only the hdr, buf and the obj union member for the requested type are 
+ * valid in the returned message. The message can be passed to the 
+ * fmapi_fill_*() helper for that object and to fmapi_serialize() / 
+ * fmapi_deserialize() with &m->obj. When num is non zero the caller must not 
+ * store more than num entries in the trailing list of the object. 
+ *
+ * fmapi_msg_decode() and the transport and session receive paths decode the 
+ * object named by the opcode of the frame, so a message they decode into must 
+ * be allocated with type FMOB_MAX. 
+ *
+ * @param	type 	enum _FMOB of the object the message will hold, or FMOB_MAX
+ * @param	num 	Number of entries in the trailing variable length list of a 
+ * 					request object. 0 sizes the list to its full capacity
+ * @return	struct fmapi_msg* Zeroed message, NULL upon error. Free with fmapi_msg_free()
+ */
+struct fmapi_msg *fmapi_msg_alloc(unsigned type, unsigned num)
+{
+	size_t size;
 
-		case FMOB_ISC_MSG_LIMIT: //!< struct fmapi_isc_msg_limit
-		{
-			struct fmapi_isc_msg_limit *o = (struct fmapi_isc_msg_limit*) src;
-			dst[0] =  o->limit;
-			rv = FMLN_ISC_MSG_LIMIT;
-		}
-			break;
+	size = fmapi_msg_size(type, num);
+	if (size == 0)
+		return NULL;
 
-		case FMOB_PSC_ID_RSP: //!< struct fmapi_psc_id_rsp
-		{
-			struct fmapi_psc_id_rsp *o = (struct fmapi_psc_id_rsp*) src;
-			dst[0]  = o->ingress_port;	
-			dst[1]  = 0;  //rsvd
-			dst[2]  = o->num_ports;	
-			dst[3]  = o->num_vcss;
-			memcpy(&dst[4], o->active_ports, 32);
-			memcpy(&dst[36], o->active_vcss, 32);
-			dst[68] = (o->num_vppbs         ) & 0x00FF;
-			dst[69] = (o->num_vppbs    >>  8) & 0x00FF;
-			dst[70] = (o->active_vppbs      ) & 0x00FF;
-			dst[71] = (o->active_vppbs >>  8) & 0x00FF;
-			dst[72] = o->num_decoders;
-			rv = FMLN_PSC_IDENTIFY_SWITCH;
-		}
-			break;
+	return (struct fmapi_msg*) calloc(1, size);
+}
 
-		case FMOB_PSC_PORT_REQ: //!< struct fmapi_psc_port_req
-		{
-			struct fmapi_psc_port_req *o = (struct fmapi_psc_port_req*) src;
-			dst[0] = o->num;
-			memcpy(&dst[1], o->ports, o->num);
-			rv = FMLN_PSC_GET_PHY_PORT_REQ + o->num;
-		}
-			break;
+/**
+ * Allocate a struct fmapi_msg sized for the payload of an FM API Opcode [FMOP]
+ *
+ * A response is decoded into and is always allocated as a full struct 
+ * fmapi_msg, so num only trims requests. 
+ *
+ * @param	opcode 		FM API Opcode [FMOP]
+ * @param	category 	Request or Response [FMMT]
+ * @param	num 		Number of entries in the trailing variable length list of 
+ * 						a request. 0 sizes the list to its full capacity
+ * @return	struct fmapi_msg* Zeroed message with hdr.opcode and hdr.category set.
+ * 						NULL upon error. Free with fmapi_msg_free()
+ */
+struct fmapi_msg *fmapi_msg_alloc_op(unsigned opcode, unsigned category, unsigned num)
+{
+	struct fmapi_msg *m;
+	unsigned type;
 
-		case FMOB_PSC_PORT_INFO: //!< struct fmapi_psc_port_info
-		{
-			struct fmapi_psc_port_info *o = (struct fmapi_psc_port_info*) src;
-			dst[0]  =  o->ppid;
-			dst[1]  =  o->state;
-			dst[2]  =  o->dv;
-			dst[4]  =  o->dt;
-			dst[5]  =  o->cv;
-			dst[6]  =  o->mlw;
-			dst[7]  =  o->nlw;
-			dst[8]  =  o->speeds;
-			dst[9]  =  o->mls;
-			dst[10] =  o->cls;
-			dst[11] =  o->ltssm;
-			dst[12] =  o->lane;
-			dst[13] = 0;
-			dst[13] |= (o->lane_rev & 0x01) << FMLF_LANE_REVERSAL_BIT; 
-			dst[13] |= (o->perst    & 0x01) << FMLF_PERST_STATE_BIT; 
-			dst[13] |= (o->prsnt    & 0x01) << FMLF_PRSNT_STATE_BIT; 
-			dst[13] |= (o->pwrctrl  & 0x01) << FMLF_PWRCTL_STATE_BIT; 
-			dst[14] = 0;
-			dst[15] =  o->num_ld;
-			rv = FMLN_PSC_GET_PHY_PORT_INFO;
-		}
-			break;
+	if (category >= FMMT_MAX)
+		return NULL;
 
-		case FMOB_PSC_PORT_RSP: //!< struct fmapi_psc_port_rsp
-		{
-			struct fmapi_psc_port_rsp *o = (struct fmapi_psc_port_rsp*) src;	
-			dst[0]  =  o->num;
-			rv = FMLN_PSC_GET_PHY_PORT_RESP;
-			for ( int i = 0 ; i < o->num ; i++) 
-				rv += fmapi_serialize(&dst[rv], &o->list[i], FMOB_PSC_PORT_INFO);
-		}
-			break;
+	if (category == FMMT_REQ)
+		type = fmapi_fmob_req(opcode);
+	else if (fmapi_opcode_info(opcode) != NULL)
+		type = FMOB_MAX;
+	else 
+		return NULL;
 
-		case FMOB_PSC_PORT_CTRL_REQ: //!< struct fmapi_psc_port_ctrl_req
-		{
-			struct fmapi_psc_port_ctrl_req *o = (struct fmapi_psc_port_ctrl_req*) src;
-			dst[0] = o->ppid;
-			dst[1] = o->opcode;;
-			rv = FMLN_PSC_PHY_PORT_CTRL;
-		}
-			break;
+	m = fmapi_msg_alloc(type, num);
+	if (m == NULL)
+		return NULL;
 
-		case FMOB_PSC_CFG_REQ: //!< struct fmapi_psc_cfg_req
-		{
-			struct fmapi_psc_cfg_req *o = (struct fmapi_psc_cfg_req*) src;
-			dst[0] = o->ppid;
-			dst[1] = o->reg;
-			dst[2] = ((o->fdbe << 4) & 0xF0) | (o->ext & 0x0F);
-			dst[3] = ( o->type << 7) & 0x80;
-			dst[4] = o->data[0];
-			dst[5] = o->data[1];
-			dst[6] = o->data[2];
-			dst[7] = o->data[3];
-			rv = FMLN_PSC_PPB_IO_CFG_REQ;
-		}
-			break;
+	m->hdr.opcode = opcode;
+	m->hdr.category = category;
 
-		case FMOB_PSC_CFG_RSP: //!< struct fmapi_psc_cfg_rsp 
-		{
-			struct fmapi_psc_cfg_rsp *o = (struct fmapi_psc_cfg_rsp*) src;
-			dst[0] = o->data[0];
-			dst[1] = o->data[1];
-			dst[2] = o->data[2];
-			dst[3] = o->data[3];
-			rv = FMLN_PSC_PPB_IO_CFG_RESP;
-		}
-			break;
+	return m;
+}
 
-		case FMOB_VSC_INFO_REQ: //!< struct fmapi_vsc_info_req
-		{
-			struct fmapi_vsc_info_req *o = (struct fmapi_vsc_info_req*) src;
-			dst[0] = o->vppbid_start;
-			dst[1] = o->vppbid_limit;
-			dst[2] = o->num;
-			memcpy(&dst[3], o->vcss, o->num);
-			rv = FMLN_VSC_GET_INFO_REQ + o->num;
-		}
-		break;
+/**
+ * Free a message allocated with fmapi_msg_alloc() or fmapi_msg_alloc_op()
+ *
+ * @param	m 	struct fmapi_msg* to free. May be NULL
+ */
+void fmapi_msg_free(struct fmapi_msg *m)
+{
+	free(m);
+}
+
+/**
+ * Push a chain of free objects onto the depot of a message pool 
+ *
+ * @param	p 		struct fmapi_msg_pool* 
+ * @param	head 	First object of the chain (index + 1)
+ * @param	num 	Number of objects in the chain 
+ */
+static void fmapi_pool_push(struct fmapi_msg_pool *p, __u32 head, __u32 num)
+{
+	__u64 old, new;
+
+	p->link[head - 1].num = num;
+
+	old = __atomic_load_n(&p->depot, __ATOMIC_RELAXED);
+	do 
+	{
+		__atomic_store_n(&p->link[head - 1].batch, (__u32) old, __ATOMIC_RELAXED);
+		new = ((old >> 32) + 1) << 32 | head;
+	} 
+	while (!__atomic_compare_exchange_n(&p->depot, &old, new, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * Pop a chain of free objects from the depot of a message pool 
+ *
+ * @param	p 		struct fmapi_msg_pool* 
+ * @param[out] num 	Number of objects in the returned chain 
+ * @return	First object of the chain (index + 1), 0 if the depot is empty 
+ */
+static __u32 fmapi_pool_pop(struct fmapi_msg_pool *p, __u32 *num)
+{
+	__u64 old, new;
+	__u32 head, next;
+
+	old = __atomic_load_n(&p->depot, __ATOMIC_ACQUIRE);
+	do 
+	{
+		head = (__u32) old;
+		if (head == 0)
+			return 0;
+
+		next = __atomic_load_n(&p->link[head - 1].batch, __ATOMIC_RELAXED);
+		new = ((old >> 32) + 1) << 32 | next;
+	} 
+	while (!__atomic_compare_exchange_n(&p->depot, &old, new, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+	*num = p->link[head - 1].num;
+	return head;
+}
+
+/**
+ * Hand the objects of an exiting thread's cache back to the depot
+ *
+ * Registered as the destructor of the thread specific key of the pool 
+ *
+ * @param	arg 	struct fmapi_pool_cache* of the exiting thread
+ */
+static void fmapi_pool_cache_release(void *arg)
+{
+	struct fmapi_pool_cache *c = (struct fmapi_pool_cache*) arg;
+
+	if (c->ncur > 0)
+		fmapi_pool_push(c->pool, c->cur, c->ncur);
+	if (c->nspare > 0)
+		fmapi_pool_push(c->pool, c->spare, c->nspare);
+
+	c->cur = c->ncur = 0;
+	c->spare = c->nspare = 0;
+	__atomic_store_n(&c->used, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Find the cache of the calling thread, claiming or creating one if needed
+ *
+ * @param	p 	struct fmapi_msg_pool* 
+ * @return	struct fmapi_pool_cache* upon success, NULL upon error
+ */
+static struct fmapi_pool_cache *fmapi_pool_cache(struct fmapi_msg_pool *p)
+{
+	struct fmapi_pool_cache *c;
+	int unused;
+
+	c = (struct fmapi_pool_cache*) pthread_getspecific(p->key);
+	if (c != NULL)
+		return c;
+
+	// Reuse the cache of a thread that has exited 
+	for ( c = __atomic_load_n(&p->caches, __ATOMIC_ACQUIRE) ; c != NULL ; c = c->next )
+	{
+		unused = 0;
+		if (__atomic_compare_exchange_n(&c->used, &unused, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			break;
+	}
+
+	if (c == NULL)
+	{
+		c = (struct fmapi_pool_cache*) calloc(1, sizeof(*c));
+		if (c == NULL)
+			return NULL;
+
+		c->pool = p;
+		c->used = 1;
+		c->next = __atomic_load_n(&p->caches, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&p->caches, &c->next, c, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	}
+
+	if (pthread_setspecific(p->key, c) != 0)
+	{
+		__atomic_store_n(&c->used, 0, __ATOMIC_RELEASE);
+		return NULL;
+	}
+
+	return c;
+}
+
+/**
+ * Create a pool of preallocated messages 
+ *
+ * @param	num 	Number of messages in the pool 
+ * @param	batch 	Number of messages moved between a thread cache and the depot 
+ * 					at once. 0 selects a default
+ * @return	struct fmapi_msg_pool* upon success, NULL upon error
+ */
+struct fmapi_msg_pool *fmapi_msg_pool_create(unsigned num, unsigned batch)
+{
+	struct fmapi_msg_pool *p;
+	struct fmapi_msg *m;
+	unsigned i, n;
+
+	// Validate Inputs 
+	if ( (num == 0) || (num >= 0xFFFFFFFF) )
+		return NULL;
+
+	if (batch == 0)
+		batch = FMPL_BATCH;
+	if (batch > num)
+		batch = num;
+
+	p = (struct fmapi_msg_pool*) aligned_alloc(FMPL_ALIGN, FMPL_ROUND(sizeof(*p)));
+	if (p == NULL)
+		return NULL;
+	memset(p, 0, sizeof(*p));
+
+	p->num = num;
+	p->batch = batch;
+	p->base = (__u8*) aligned_alloc(FMPL_ALIGN, (size_t) num * FMPL_STRIDE);
+	p->link = (struct fmapi_pool_link*) calloc(num, sizeof(struct fmapi_pool_link));
+	if ( (p->base == NULL) || (p->link == NULL) )
+		goto fail;
+
+	if (pthread_key_create(&p->key, fmapi_pool_cache_release) != 0)
+		goto fail;
+
+	// Chain the objects into batches and stock the depot 
+	for ( i = 0 ; i < num ; i += n )
+	{
+		n = (num - i < batch) ? num - i : batch;
+		for ( unsigned k = i ; k < i + n ; k++ )
+		{
+			m = (struct fmapi_msg*) (p->base + (size_t) k * FMPL_STRIDE);
+			m->buf = (struct fmapi_buf*) ((__u8*) m + FMPL_BUF);
+			p->link[k].next = (k + 1 < i + n) ? k + 2 : 0;
+		}
+		fmapi_pool_push(p, i + 1, n);
+	}
+
+	return p;
+
+fail:
+	free(p->link);
+	free(p->base);
+	free(p);
+	return NULL;
+}
+
+/**
+ * Free a message pool and all of its messages 
+ *
+ * @param	p 	struct fmapi_msg_pool* to free. May be NULL
+ */
+void fmapi_msg_pool_free(struct fmapi_msg_pool *p)
+{
+	struct fmapi_pool_cache *c, *next;
+
+	if (p == NULL)
+		return;
+
+	pthread_key_delete(p->key);
+
+	for ( c = p->caches ; c != NULL ; c = next )
+	{
+		next = c->next;
+		free(c);
+	}
+
+	free(p->link);
+	free(p->base);
+	free(p);
+}
+
+/**
+ * Get a message from a pool 
+ *
+ * @param	p 	struct fmapi_msg_pool* to get the message from
+ * @return	struct fmapi_msg* upon success, NULL if the pool is exhausted 
+ */
+struct fmapi_msg *fmapi_msg_get(struct fmapi_msg_pool *p)
+{
+	struct fmapi_pool_cache *c;
+	struct fmapi_msg *m;
+	__u32 i;
+
+	if (p == NULL)
+		return NULL;
+
+	c = fmapi_pool_cache(p);
+	if (c == NULL)
+		return NULL;
+
+	if (c->ncur == 0)
+	{
+		if (c->nspare > 0)
+		{
+			c->cur = c->spare;
+			c->ncur = c->nspare;
+			c->spare = c->nspare = 0;
+		}
+		else 
+		{
+			c->cur = fmapi_pool_pop(p, &c->ncur);
+			if (c->cur == 0)
+				return NULL;
+		}
+	}
+
+	i = c->cur - 1;
+	c->cur = p->link[i].next;
+	c->ncur--;
+
+	m = (struct fmapi_msg*) (p->base + (size_t) i * FMPL_STRIDE);
+	memset(&m->hdr, 0, sizeof(m->hdr));
+	m->buf = (struct fmapi_buf*) ((__u8*) m + FMPL_BUF);
+
+	return m;
+}
+
+/**
+ * Return a message obtained with fmapi_msg_get() to its pool 
+ *
+ * Pointers that do not belong to the pool are ignored 
+ *
+ * @param	p 	struct fmapi_msg_pool* the message was taken from
+ * @param	m 	struct fmapi_msg* to return. May be NULL
+ */
+void fmapi_msg_put(struct fmapi_msg_pool *p, struct fmapi_msg *m)
+{
+	struct fmapi_pool_cache *c;
+	size_t off;
+	__u32 i;
+
+	if ( (p == NULL) || (m == NULL) || ((__u8*) m < p->base) )
+		return;
+
+	off = (__u8*) m - p->base;
+	if ( (off >= (size_t) p->num * FMPL_STRIDE) || (off % FMPL_STRIDE != 0) )
+		return;
+
+	i = off / FMPL_STRIDE;
+
+	// Without a thread cache hand the object straight to the depot 
+	c = fmapi_pool_cache(p);
+	if (c == NULL)
+	{
+		p->link[i].next = 0;
+		fmapi_pool_push(p, i + 1, 1);
+		return;
+	}
+
+	if (c->ncur == p->batch)
+	{
+		if (c->nspare > 0)
+			fmapi_pool_push(p, c->spare, c->nspare);
+		c->spare = c->cur;
+		c->nspare = c->ncur;
+		c->cur = c->ncur = 0;
+	}
+
+	p->link[i].next = c->cur;
+	c->cur = i + 1;
+	c->ncur++;
+}
+
+/**
+ * Initialize a transaction arena 
+ *
+ * @param	a 		struct fmapi_arena* to initialize
+ * @param	buf 	Backing storage for the arena. NULL to allocate cap bytes 
+ * @param	cap 	Size of buf in bytes 
+ * @return	0 upon success, negative enum _FMER upon error
+ */
+int fmapi_arena_init(struct fmapi_arena *a, void *buf, size_t cap)
+{
+	// Validate Inputs 
+	if ( (a == NULL) || (cap == 0) )
+		return -FMER_INVALID;
+
+	a->owned = (buf == NULL);
+	if (a->owned)
+	{
+		cap = FMPL_ROUND(cap);
+		buf = aligned_alloc(FMPL_ALIGN, cap);
+		if (buf == NULL)
+			return -FMER_OVERFLOW;
+	}
+
+	a->base = (__u8*) buf;
+	a->cap = cap;
+	a->off = 0;
+
+	return 0;
+}
+
+/**
+ * Release the storage of an arena allocated by fmapi_arena_init()
+ *
+ * @param	a 	struct fmapi_arena* to free. May be NULL
+ */
+void fmapi_arena_free(struct fmapi_arena *a)
+{
+	if (a == NULL)
+		return;
+
+	if (a->owned)
+		free(a->base);
+
+	memset(a, 0, sizeof(*a));
+}
+
+/**
+ * Release every object of an arena at once 
+ *
+ * @param	a 	struct fmapi_arena* to reset
+ */
+void fmapi_arena_reset(struct fmapi_arena *a)
+{
+	if (a != NULL)
+		a->off = 0;
+}
+
+/**
+ * Carve a cache line aligned block from an arena
+ *
+ * Caller provided storage need not be aligned, so alignment is computed 
+ * from the address rather than the offset 
+ *
+ * @param	a 		struct fmapi_arena* to allocate from
+ * @param	size 	Number of bytes 
+ * @return	void* to the block, NULL if the arena is exhausted. Not cleared
+ */
+void *fmapi_arena_alloc(struct fmapi_arena *a, size_t size)
+{
+	size_t off;
+
+	if ( (a == NULL) || (a->base == NULL) )
+		return NULL;
+
+	off = FMPL_ROUND((size_t) a->base + a->off) - (size_t) a->base;
+	if ( (off > a->cap) || (size > a->cap - off) )
+		return NULL;
+
+	a->off = off + size;
+
+	return a->base + off;
+}
+
+/**
+ * Carve a right sized struct fmapi_msg from an arena 
+ *
+ * @param	a 		struct fmapi_arena* to allocate from
+ * @param	type 	enum _FMOB of the object the message will hold, or FMOB_MAX
+ * @param	num 	Number of entries in the trailing variable length list of a 
+ * 					request object. 0 sizes the list to its full capacity
+ * @param	buf 	Non zero to also carve a struct fmapi_buf and point m->buf at it
+ * @return	struct fmapi_msg* Zeroed message, NULL upon error 
+ */
+struct fmapi_msg *fmapi_arena_msg(struct fmapi_arena *a, unsigned type, unsigned num, int buf)
+{
+	struct fmapi_msg *m;
+	size_t size, off;
+
+	size = fmapi_msg_size(type, num);
+	if (size == 0)
+		return NULL;
+
+	if (a == NULL)
+		return NULL;
+	off = a->off;
+
+	m = (struct fmapi_msg*) fmapi_arena_alloc(a, size);
+	if (m == NULL)
+		return NULL;
+	memset(m, 0, size);
+
+	if (buf)
+	{
+		m->buf = (struct fmapi_buf*) fmapi_arena_alloc(a, sizeof(struct fmapi_buf));
+		if (m->buf == NULL)
+		{
+			a->off = off;
+			return NULL;
+		}
+	}
+
+	return m;
+}
+
+/**
+ * Carve a right sized struct fmapi_msg for an FM API Opcode [FMOP] from an arena 
+ *
+ * A response is decoded into and is always carved as a full struct fmapi_msg, 
+ * so num only trims requests. 
+ *
+ * @param	a 			struct fmapi_arena* to allocate from
+ * @param	opcode 		FM API Opcode [FMOP]
+ * @param	category 	Request or Response [FMMT]
+ * @param	num 		Number of entries in the trailing variable length list of 
+ * 						a request. 0 sizes the list to its full capacity
+ * @param	buf 		Non zero to also carve a struct fmapi_buf and point m->buf at it
+ * @return	struct fmapi_msg* Zeroed message with hdr.opcode and hdr.category set.
+ * 						NULL upon error
+ */
+struct fmapi_msg *fmapi_arena_msg_op(struct fmapi_arena *a, unsigned opcode, unsigned category, unsigned num, int buf)
+{
+	struct fmapi_msg *m;
+	unsigned type;
+
+	if (category >= FMMT_MAX)
+		return NULL;
+
+	if (category == FMMT_REQ)
+		type = fmapi_fmob_req(opcode);
+	else if (fmapi_opcode_info(opcode) != NULL)
+		type = FMOB_MAX;
+	else 
+		return NULL;
+
+	m = fmapi_arena_msg(a, type, num, buf);
+	if (m == NULL)
+		return NULL;
+
+	m->hdr.opcode = opcode;
+	m->hdr.category = category;
+
+	return m;
+}
+
+/**
+ * Encode an object described by a wire format layout [FMLT]
+ *
+ * Reserved bytes in the fixed portion of the object are cleared
+ *
+ * @param[out] dst __u8* Pointer to destination unsigned char array 
+ * @param[in] src void Pointer to object to serialize
+ * @param[in] type unsigned enum _FMOB with a non NULL entry in FMLT_FMOB
+ * @return number of serialized bytes
+ */
+static int fmapi_encode_layout(__u8 *dst, void *src, unsigned type)
+{
+	const struct fmapi_layout *l;
+	const struct fmapi_field *f, *end;
+	__u8 *o;
+	unsigned num;
+	int rv;
+
+	l = &FMLT_FMOB[type];
+	o = (__u8*) src;
+	rv = FMLN_FMOB[type];
+
+	memset(dst, 0, rv);
+
+	for ( f = l->fields, end = f + l->num ; f < end ; f++ )
+	{
+		switch (f->kind)
+		{
+			case FMFK_INT:
+				switch (f->width)
+				{
+					case 1: dst[f->off] = o[f->obj];								break;
+					case 2: fmapi_put_le16(&dst[f->off], *(__u16*) &o[f->obj]);		break;
+					case 4: fmapi_put_le32(&dst[f->off], *(__u32*) &o[f->obj]);		break;
+					case 8: fmapi_put_le64(&dst[f->off], *(__u64*) &o[f->obj]);		break;
+				}
+				break;
+
+			case FMFK_BITS:
+				dst[f->off] |= (o[f->obj] & f->mask) << f->shift;
+				break;
+
+			case FMFK_BYTES:
+				memcpy(&dst[f->off], &o[f->obj], f->width);
+				break;
+		}
+	}
+
+	if (l->cnt_width == 0)
+		return rv;
+
+	// Trailing variable length list 
+	if (l->cnt_width == 1)
+		num = o[l->cnt];
+	else 
+		num = *(__u16*) &o[l->cnt];
+
+	if (l->elem == FMOB_NULL) 
+	{
+		memcpy(&dst[rv], &o[l->list], num);
+		rv += num;
+	}
+	else if (FMAPI_LE_HOST && FMLT_FMOB[l->elem].flat)
+	{
+		memcpy(&dst[rv], &o[l->list], num * l->stride);
+		rv += num * l->stride;
+	}
+	else 
+	{
+		for ( unsigned i = 0 ; i < num ; i++ )
+			rv += fmapi_encode_layout(&dst[rv], &o[l->list + i * l->stride], l->elem);
+	}
+
+	return rv;
+}
+
+/**
+ * Serialize the fixed portion of an object that carries a bulk data block
+ *
+ * The bulk block itself (mpc_tmc_req.msg, mpc_tmc_rsp.msg, mpc_mem_req.data, 
+ * mpc_mem_rsp.data) is not copied. It follows the fixed portion on the wire.
+ *
+ * @param[out] dst __u8* Pointer to destination unsigned char array 
+ * @param[in] src void Pointer to object to serialize
+ * @param[in] type unsigned enum _FMOB representing type of object to serialize
+ * @return number of serialized bytes, 0 if type has no bulk data block
+ */
+static int fmapi_serialize_fixed(__u8 *dst, void *src, unsigned type)
+{
+	int rv;
+
+	rv = 0;
+
+	switch(type)
+	{
+		case FMOB_MPC_TMC_REQ: //!< struct fmapi_mpc_tmc_req
+		{
+			struct fmapi_mpc_tmc_req *o = (struct fmapi_mpc_tmc_req*) src;
+			dst[0] = o->ppid;
+			dst[1] = 0;
+			fmapi_put_le16(&dst[2], o->len + 1);
+			dst[4] = o->type;
+			rv = FMLN_MPC_TUNNEL_CMD_REQ;
+		}
+			break;
+
+		case FMOB_MPC_TMC_RSP: //!< struct fmapi_mpc_tmc_rsp
+		{
+			struct fmapi_mpc_tmc_rsp *o = (struct fmapi_mpc_tmc_rsp*) src;
+			fmapi_put_le16(&dst[0], o->len + 1);
+			dst[2] = 0;
+			dst[3] = 0;
+			dst[4] = o->type;
+			rv = FMLN_MPC_TUNNEL_CMD_RESP;
+		}
+			break;
+
+		case FMOB_MPC_MEM_REQ: //!< struct fmapi_mpc_mem_req
+		{
+			struct fmapi_mpc_mem_req *o = (struct fmapi_mpc_mem_req*) src;
+			dst[ 0] =   o->ppid;
+			dst[ 1] = 0;
+			dst[ 2] =  (o->fdbe   << 4 ) & 0x00F0; 		
+			dst[ 3] = ((o->type   << 7 ) & 0x0080) | (o->ldbe & 0x000F); 	
+			fmapi_put_le16(&dst[4], o->ldid);
+			fmapi_put_le16(&dst[6], o->len);
+			fmapi_put_le64(&dst[8], o->offset);
+			rv = FMLN_MPC_LD_MEM_REQ;
+		}
+			break;
+
+		case FMOB_MPC_MEM_RSP: //!< struct fmapi_mpc_mem_rsp
+		{
+			struct fmapi_mpc_mem_rsp *o = (struct fmapi_mpc_mem_rsp*) src;
+			fmapi_put_le16(&dst[0], o->len);
+			dst[2] = 0;
+			dst[3] = 0;
+			rv = FMLN_MPC_LD_MEM_RESP;
+		}
+			break;
+
+		default:
+			rv = 0;
+			break;
+	}
+
+	return rv;
+}
+
+/**
+ * @brief Convert an object into Little Endian byte array format
+ * 
+ * @param[out] dst void Pointer to destination unsigned char array
+ * @param[in] src void Pointer to object to serialize
+ * @param[in] type unsigned enum _FMOB representing type of object to serialize
+ * @return number of serialized bytes, 0 if error 
+ */
+int fmapi_serialize(__u8 *dst, void *src, unsigned type)
+{
+	int rv;
+
+	// Initialize variables 
+	rv = 0;
+
+	// Validate Inputs 
+	if ( (type == FMOB_NULL) || (type >= FMOB_MAX) )
+		return 0;
+
+	if (FMLT_FMOB[type].fields != NULL)
+		return fmapi_encode_layout(dst, src, type);
+
+	switch(type)
+	{
+		case FMOB_HDR: //!< struct fmapi_hdr
+		{
+			struct fmapi_hdr *o = (struct fmapi_hdr*) src;
+			dst[0] = (o->category << 4) & 0xF0;
+			dst[1] = o->tag;
+			fmapi_put_le16(&dst[3], o->opcode);
+			dst[5] = (o->len         ) & 0x00FF;
+			dst[6] = ( o->len >> 8   ) & 0x00FF;
+			dst[7] = ((o->len >> 13  ) & 0x00F8) | (o->background & 0x01);
+			fmapi_put_le16(&dst[8], o->return_code);
+			fmapi_put_le16(&dst[10], o->ext_status);
+			rv = FMLN_HDR;
+		}
+			break;
+
+		case FMOB_PSC_CFG_REQ: //!< struct fmapi_psc_cfg_req
+		{
+			struct fmapi_psc_cfg_req *o = (struct fmapi_psc_cfg_req*) src;
+			dst[0] = o->ppid;
+			dst[1] = o->reg;
+			dst[2] = ((o->fdbe << 4) & 0xF0) | (o->ext & 0x0F);
+			dst[3] = ( o->type << 7) & 0x80;
+			dst[4] = o->data[0];
+			dst[5] = o->data[1];
+			dst[6] = o->data[2];
+			dst[7] = o->data[3];
+			rv = FMLN_PSC_PPB_IO_CFG_REQ;
+		}
+			break;
+
+		case FMOB_VSC_INFO_BLK: //!< struct fmapi_vsc_info_blk
+		{
+			struct fmapi_vsc_info_blk *o = (struct fmapi_vsc_info_blk*) src;
+			dst[0] = o->vcsid;
+			dst[1] = o->state;
+			dst[2] = o->uspid;
+			dst[3] = o->total;
+
+			rv = FMLN_VSC_INFO;
+			for (int i = 0 ; i < o->num ; i++)
+				rv += fmapi_serialize(&dst[rv], &o->list[i], FMOB_VSC_PPB_STAT_BLK);
+		}
+			break;
+
+		case FMOB_VSC_INFO_RSP: //!< struct fmapi_vsc_info_rsp
+		{
+			struct fmapi_vsc_info_rsp *o = (struct fmapi_vsc_info_rsp*) src;
+			dst[0] = o->num;
+
+			rv = FMLN_VSC_GET_INFO_RESP;
+			for ( int i = 0 ; i < o->num ; i++)
+				rv += fmapi_serialize(&dst[rv], &o->list[i], FMOB_VSC_INFO_BLK);
+		}
+			break;
+
+		case FMOB_VSC_UNBIND_REQ: //!< struct fmapi_vsc_unbind_req
+		{
+			struct fmapi_vsc_unbind_req *o = (struct fmapi_vsc_unbind_req*) src;
+			dst[0] = o->vcsid;
+			dst[1] = o->vppbid;
+			dst[2] = o->option;;
+			rv = FMLN_VSC_UNBIND;
+		}
+			break;
+
+		case FMOB_MPC_TMC_REQ: //!< struct fmapi_mpc_tmc_req
+		{
+			struct fmapi_mpc_tmc_req *o = (struct fmapi_mpc_tmc_req*) src;
+			rv = fmapi_serialize_fixed(dst, src, type);
+			memcpy(&dst[rv], o->msg, o->len);
+			rv += o->len;
+		}
+			break;
+
+		case FMOB_MPC_TMC_RSP: //!< struct fmapi_mpc_tmc_rsp
+		{
+			struct fmapi_mpc_tmc_rsp *o = (struct fmapi_mpc_tmc_rsp*) src;
+			rv = fmapi_serialize_fixed(dst, src, type);
+			memcpy(&dst[rv], o->msg, o->len);
+			rv += o->len;
+		}
+			break;
+
+		case FMOB_MPC_CFG_REQ: //!< struct fmapi_mpc_cfg_req
+		{
+			struct fmapi_mpc_cfg_req *o = (struct fmapi_mpc_cfg_req*) src;
+			dst[0] = o->ppid;
+			dst[1] = o->reg;
+			dst[2] = ((o->fdbe << 4) & 0xF0) | (o->ext & 0x0F);
+			dst[3] = (o->type  << 7) & 0x80;
+			fmapi_put_le16(&dst[4], o->ldid);
+			dst[8] = o->data[0];
+			dst[9] = o->data[1];
+			dst[10] = o->data[2];
+			dst[11] = o->data[3];
+			rv = FMLN_MPC_LD_IO_CFG_REQ;
+		}
+			break;
+
+		case FMOB_MPC_MEM_REQ: //!< struct fmapi_mpc_mem_req
+		{
+			struct fmapi_mpc_mem_req *o = (struct fmapi_mpc_mem_req*) src;
+			rv = fmapi_serialize_fixed(dst, src, type);
+			memcpy(&dst[rv], o->data, o->len);
+			rv += o->len;
+		}
+			break;
+
+		default:
+			rv = 0;
+			break;
+	}
+	
+	return rv;
+};
+
+/**
+ * Compute the serialized length of an object without serializing it
+ *
+ * @param[in] src void Pointer to object 
+ * @param[in] type unsigned enum _FMOB representing type of object
+ * @return number of bytes fmapi_serialize() would write, 0 if error 
+ */
+int fmapi_wire_len(void *src, unsigned type)
+{
+	const struct fmapi_layout *l;
+	unsigned num;
+	int rv;
+
+	// Validate Inputs 
+	if ( (src == NULL) || (type == FMOB_NULL) || (type >= FMOB_MAX) )
+		return 0;
+
+	rv = FMLN_FMOB[type];
+
+	l = &FMLT_FMOB[type];
+	if (l->fields != NULL)
+	{
+		if (l->cnt_width == 0)
+			return rv;
+
+		if (l->cnt_width == 1)
+			num = ((__u8*) src)[l->cnt];
+		else 
+			num = *(__u16*) &((__u8*) src)[l->cnt];
+
+		if (l->elem == FMOB_NULL)
+			return rv + num;
+		return rv + num * FMLN_FMOB[l->elem];
+	}
+
+	switch(type)
+	{
+		case FMOB_VSC_INFO_BLK: 
+			rv += ((struct fmapi_vsc_info_blk*) src)->num * FMLN_VSC_PPB_STATUS;
+			break;
+
+		case FMOB_VSC_INFO_RSP: 
+		{
+			struct fmapi_vsc_info_rsp *o = (struct fmapi_vsc_info_rsp*) src;
+			for ( int i = 0 ; i < o->num ; i++ )
+				rv += fmapi_wire_len(&o->list[i], FMOB_VSC_INFO_BLK);
+		}
+			break;
+
+		case FMOB_MPC_TMC_REQ: rv += ((struct fmapi_mpc_tmc_req*) src)->len;	break;
+		case FMOB_MPC_TMC_RSP: rv += ((struct fmapi_mpc_tmc_rsp*) src)->len;	break;
+		case FMOB_MPC_MEM_REQ: rv += ((struct fmapi_mpc_mem_req*) src)->len;	break;
+		default: 																break;
+	}
+
+	return rv;
+}
+
+/**
+ * @brief Serialize an FM API Header and object into a scatter-gather list
+ *
+ * The header and the object are serialized into scratch. For objects that 
+ * carry a bulk data block (FMOB_MPC_MEM_REQ, FMOB_MPC_MEM_RSP, 
+ * FMOB_MPC_TMC_REQ, FMOB_MPC_TMC_RSP) only the fixed portion goes into scratch 
+ * and a second entry points at the bulk data, so it is never copied. The 
+ * result can be passed directly to writev() or sendmsg(). 
+ *
+ * hdr->len is set to the serialized length of the object.
+ *
+ * @param[out] iov struct iovec* array to fill 
+ * @param[in] cnt int Number of entries in iov. 2 is always sufficient
+ * @param[out] scratch __u8* Buffer for the serialized header and object 
+ * @param[in] cap size_t Size of scratch in bytes. FMLN_HDR + FMLN_MPC_LD_MEM_REQ 
+ * 				is sufficient for the objects that carry bulk data 
+ * @param[in] hdr struct fmapi_hdr* to serialize 
+ * @param[in] src void Pointer to object to serialize. May be NULL if type is FMOB_NULL
+ * @param[in] type unsigned enum _FMOB representing type of object to serialize
+ * @param[in] data const void* Bulk data block to send instead of the one 
+ * 				stored in the object. NULL to use the object's own block. The 
+ * 				length is always taken from the object 
+ * @return number of iov entries used, or a negative enum _FMER upon error
+ */
+int fmapi_serialize_iov(struct iovec *iov, int cnt, __u8 *scratch, size_t cap, struct fmapi_hdr *hdr, void *src, unsigned type, const void *data)
+{
+	const __u8 *bulk;
+	size_t blen;
+	int len, rv;
+
+	// Validate Inputs 
+	if ( (iov == NULL) || (cnt < 1) || (scratch == NULL) || (hdr == NULL) || (type >= FMOB_MAX) )
+		return -FMER_INVALID;
+	if ( (type != FMOB_NULL) && (src == NULL) )
+		return -FMER_INVALID;
+
+	bulk = NULL;
+	blen = 0;
+
+	switch(type)
+	{
+		case FMOB_MPC_TMC_REQ: 
+			bulk = ((struct fmapi_mpc_tmc_req*) src)->msg;
+			blen = ((struct fmapi_mpc_tmc_req*) src)->len;
+			break;
+
+		case FMOB_MPC_TMC_RSP: 
+			bulk = ((struct fmapi_mpc_tmc_rsp*) src)->msg;
+			blen = ((struct fmapi_mpc_tmc_rsp*) src)->len;
+			break;
+
+		case FMOB_MPC_MEM_REQ: 
+			bulk = ((struct fmapi_mpc_mem_req*) src)->data;
+			blen = ((struct fmapi_mpc_mem_req*) src)->len;
+			break;
+
+		case FMOB_MPC_MEM_RSP: 
+			bulk = ((struct fmapi_mpc_mem_rsp*) src)->data;
+			blen = ((struct fmapi_mpc_mem_rsp*) src)->len;
+			break;
+
+		default:
+			break;
+	}
+
+	if ( (bulk != NULL) && (data != NULL) )
+		bulk = (const __u8*) data;
+
+	// Serialize the object behind the header 
+	if (bulk != NULL)
+	{
+		if (cap < FMLN_HDR + FMLN_FMOB[type])
+			return -FMER_OVERFLOW;
+		if ( (blen > 0) && (cnt < 2) )
+			return -FMER_OVERFLOW;
+		len = fmapi_serialize_fixed(&scratch[FMLN_HDR], src, type);
+	}
+	else if (type != FMOB_NULL)
+	{
+		if (cap < (size_t) FMLN_HDR + fmapi_wire_len(src, type))
+			return -FMER_OVERFLOW;
+		len = fmapi_serialize(&scratch[FMLN_HDR], src, type);
+	}
+	else 
+	{
+		if (cap < FMLN_HDR)
+			return -FMER_OVERFLOW;
+		len = 0;
+	}
+
+	// Serialize the header with the final payload length 
+	hdr->len = len + blen;
+	fmapi_serialize(scratch, hdr, FMOB_HDR);
+
+	iov[0].iov_base = scratch;
+	iov[0].iov_len = FMLN_HDR + len;
+	rv = 1;
+
+	if (blen > 0)
+	{
+		iov[1].iov_base = (void*) bulk;
+		iov[1].iov_len = blen;
+		rv = 2;
+	}
+
+	return rv;
+}
+
+/**
+ * Patch the 21 bit payload length of a serialized FM API Header in place
+ *
+ * @param[out] hdr __u8* Serialized FM API Header 
+ * @param[in] len __u32 Payload length in bytes
+ */
+static void fmapi_patch_len(__u8 *hdr, __u32 len)
+{
+	hdr[5] = (len      ) & 0x00FF;
+	hdr[6] = (len >> 8 ) & 0x00FF;
+	hdr[7] = (hdr[7] & 0x07) | ((len >> 13) & 0x00F8);
+}
+
+/**
+ * @brief Encode an FM API Message into a complete wire frame 
+ *
+ * The object type is chosen from the opcode and category using the opcode 
+ * registry, and an unknown opcode is rejected like fmapi_msg_decode() does. 
+ * The header is written first and its length field is patched once the 
+ * payload has been written behind it. m->hdr.category, m->hdr.tag and 
+ * m->hdr.len are updated. 
+ *
+ * @param[in,out] m struct fmapi_msg* to encode 
+ * @param[out] dst __u8* Destination buffer 
+ * @param[in] cap size_t Size of dst in bytes 
+ * @param[in] category __u8 Request or Response [FMMT]
+ * @param[in] tag __u8 Tag used to match the response to the request 
+ * @return number of bytes written, or a negative enum _FMER upon error
+ */
+int fmapi_msg_encode(struct fmapi_msg *m, __u8 *dst, size_t cap, __u8 category, __u8 tag)
+{
+	const struct fmapi_opcode_info *info;
+	unsigned type;
+	int len;
+
+	// Validate Inputs 
+	if ( (m == NULL) || (dst == NULL) || (category >= FMMT_MAX) )
+		return -FMER_INVALID;
+
+	info = fmapi_opcode_info(m->hdr.opcode);
+	if (info == NULL)
+		return -FMER_INVALID;
+
+	if (category == FMMT_REQ)
+		type = info->req;
+	else 
+		type = info->rsp;
+
+	if (cap < (size_t) FMLN_HDR + fmapi_wire_len(&m->obj, type))
+		return -FMER_OVERFLOW;
+
+	m->hdr.category = category;
+	m->hdr.tag = tag;
+	m->hdr.len = 0;
+	fmapi_serialize(dst, &m->hdr, FMOB_HDR);
+
+	len = 0;
+	if (type != FMOB_NULL)
+		len = fmapi_serialize(&dst[FMLN_HDR], &m->obj, type);
+
+	m->hdr.len = len;
+	fmapi_patch_len(dst, len);
+
+	return FMLN_HDR + len;
+}
+
+/**
+ * @brief Encode an FM API Message wrapped in one or more Tunnel Management Commands
+ *
+ * Level i (header and tunnel prefix) starts at i * (FMLN_HDR + 5) so no 
+ * offsets need to be remembered for the back-patch pass. 
+ *
+ * @param[in,out] hops struct fmapi_msg** Tunnel messages from outermost to innermost
+ * @param[in] num unsigned Number of entries in hops
+ * @param[in,out] m struct fmapi_msg* Inner message to encode 
+ * @param[out] dst __u8* Destination buffer 
+ * @param[in] cap size_t Size of dst in bytes 
+ * @param[in] category __u8 Request or Response [FMMT]
+ * @param[in] tag __u8 Tag used to match the response to the request 
+ * @return number of bytes written, or a negative enum _FMER upon error
+ */
+int fmapi_msg_encode_tunnel(struct fmapi_msg **hops, unsigned num, struct fmapi_msg *m, __u8 *dst, size_t cap, __u8 category, __u8 tag)
+{
+	struct fmapi_msg *h;
+	size_t off, pos;
+	unsigned i, type, inner;
+	int rv;
+
+	// Validate Inputs 
+	if ( (hops == NULL) || (m == NULL) || (dst == NULL) || (category >= FMMT_MAX) )
+		return -FMER_INVALID;
+
+	if (category == FMMT_REQ)
+		type = FMOB_MPC_TMC_REQ;
+	else 
+		type = FMOB_MPC_TMC_RSP;
+
+	// STEP 1: Write each tunnel header and prefix with zero lengths
+	off = 0;
+	for ( i = 0 ; i < num ; i++ )
+	{
+		h = hops[i];
+		if (h == NULL)
+			return -FMER_INVALID;
+		if (cap - off < FMLN_HDR + FMLN_MPC_TUNNEL_CMD_REQ)
+			return -FMER_OVERFLOW;
+
+		h->hdr.opcode = FMOP_MPC_TMC;
+		h->hdr.category = category;
+		h->hdr.tag = (i == 0) ? tag : 0;
+		h->hdr.len = 0;
+		fmapi_serialize(&dst[off], &h->hdr, FMOB_HDR);
+		off += FMLN_HDR;
+
+		if (type == FMOB_MPC_TMC_REQ)
+			h->obj.mpc_tmc_req.len = 0;
+		else 
+			h->obj.mpc_tmc_rsp.len = 0;
+		off += fmapi_serialize_fixed(&dst[off], &h->obj, type);
+	}
+
+	// STEP 2: Encode the inner message at its final offset 
+	rv = fmapi_msg_encode(m, &dst[off], cap - off, category, (num == 0) ? tag : 0);
+	if (rv < 0)
+		return rv;
+	off += rv;
+
+	// STEP 3: Back-patch the lengths from the innermost level outwards 
+	for ( i = num ; i-- > 0 ; )
+	{
+		h = hops[i];
+		pos = i * (FMLN_HDR + FMLN_MPC_TUNNEL_CMD_REQ);
+		inner = off - pos - FMLN_HDR - FMLN_MPC_TUNNEL_CMD_REQ;
+		if (inner > FMLN_MPC_TUNNEL_PAYLOAD)
+			return -FMER_OVERFLOW;
+
+		if (type == FMOB_MPC_TMC_REQ)
+			h->obj.mpc_tmc_req.len = inner;
+		else 
+			h->obj.mpc_tmc_rsp.len = inner;
+		fmapi_serialize_fixed(&dst[pos + FMLN_HDR], &h->obj, type);
+
+		h->hdr.len = off - pos - FMLN_HDR;
+		fmapi_patch_len(&dst[pos], h->hdr.len);
+	}
+
+	return off;
+}
+
+/**
+ * Determine if a frame is a response that carries no payload 
+ *
+ * A response that fails (e.g. with an error return code) or that starts a 
+ * background operation may omit the payload, so it is exempt from the 
+ * minimum payload length of its opcode. 
+ *
+ * @param[in] hdr struct fmapi_hdr* Decoded header of the frame
+ * @return non zero if the frame is a response without a payload 
+ */
+static int fmapi_msg_bare(struct fmapi_hdr *hdr)
+{
+	return (hdr->category == FMMT_RESP) && (hdr->len == 0) && (hdr->return_code != FMRC_SUCCESS);
+}
+
+/**
+ * @brief Decode a complete wire frame into an FM API Message 
+ *
+ * The header is decoded first and the payload is decoded into m->obj with 
+ * fmapi_deserialize_len(), bounded by the header length field. A payload 
+ * shorter or longer than the registry allows for the opcode is rejected. A 
+ * failed response without a payload (e.g. one carrying an error return code) 
+ * only fills in the header. m->buf is left alone, so a message that owns a 
+ * buffer keeps it. Callers that want the raw frame keep src. 
+ *
+ * @param[out] m struct fmapi_msg* to fill
+ * @param[in] src __u8* Serialized FM API Message (header and payload)
+ * @param[in] len size_t Number of valid bytes in src
+ * @param[in] param void * to data needed to deserialize the payload 
+ * @return number of bytes consumed, or a negative enum _FMER upon error
+ */
+int fmapi_msg_decode(struct fmapi_msg *m, __u8 *src, size_t len, void *param)
+{
+	const struct fmapi_opcode_info *info;
+	unsigned type, min, max;
+	int rv;
+
+	// Validate Inputs 
+	if ( (m == NULL) || (src == NULL) )
+		return -FMER_INVALID;
+
+	if (len < FMLN_HDR)
+		return -FMER_TRUNCATED;
+
+	fmapi_deserialize(&m->hdr, src, FMOB_HDR, NULL);
+
+	// Reject unknown opcodes and mis-sized payloads before decoding anything
+	info = fmapi_opcode_info(m->hdr.opcode);
+	if (info == NULL)
+		return -FMER_INVALID;
+
+	if (m->hdr.category == FMMT_REQ)
+	{
+		type = info->req;
+		min = info->req_min;
+		max = info->req_max;
+	}
+	else 
+	{
+		type = info->rsp;
+		min = info->rsp_min;
+		max = info->rsp_max;
+	}
+
+	if (m->hdr.len > max)
+		return -FMER_OVERFLOW;
+	if ( (m->hdr.len < min) && !fmapi_msg_bare(&m->hdr) )
+		return -FMER_TRUNCATED;
+
+	if (len < (size_t) FMLN_HDR + m->hdr.len)
+		return -FMER_TRUNCATED;
+
+	if ( (type != FMOB_NULL) && (m->hdr.len > 0) )
+	{
+		rv = fmapi_deserialize_len(&m->obj, &src[FMLN_HDR], m->hdr.len, type, param);
+		if (rv < 0)
+			return rv;
+	}
+
+	return FMLN_HDR + m->hdr.len;
+}
 
-		case FMOB_VSC_PPB_STAT_BLK: //!< struct fmapi_vsc_ppb_stat_blk
+/**
+ * @brief Encode a batch of FM API Messages back to back into one buffer 
+ *
+ * Message i is encoded as a complete frame with tag (tag + i) at offset 
+ * offs[i] of dst. offs[n] is set to the end of the last frame, where n is the 
+ * number of messages encoded. The opcode to object lookup is shared between 
+ * consecutive messages with the same opcode, and objects with a wire format 
+ * layout are encoded without going through the fmapi_serialize() switch. 
+ *
+ * @param[in,out] msgs struct fmapi_msg** Array of num messages to encode 
+ * @param[in] num unsigned Number of messages 
+ * @param[out] dst __u8* Destination buffer 
+ * @param[in] cap size_t Size of dst in bytes 
+ * @param[in] category __u8 Request or Response [FMMT]
+ * @param[in] tag __u8 Tag of the first message 
+ * @param[out] offs size_t* Array of num + 1 frame offsets. May be NULL
+ * @return number of messages encoded, which is less than num if dst is full, 
+ * 			or a negative enum _FMER upon error
+ */
+int fmapi_encode_batch(struct fmapi_msg **msgs, unsigned num, __u8 *dst, size_t cap, __u8 category, __u8 tag, size_t *offs)
+{
+	struct fmapi_msg *m;
+	unsigned i, type, op;
+	size_t off;
+	int len;
+
+	// Validate Inputs 
+	if ( (msgs == NULL) || (dst == NULL) || (category >= FMMT_MAX) )
+		return -FMER_INVALID;
+
+	op = 0x10000; 		// Never matches a 16 bit opcode
+	type = FMOB_NULL;
+	off = 0;
+
+	for ( i = 0 ; i < num ; i++ )
+	{
+		m = msgs[i];
+		if (m == NULL)
+			return -FMER_INVALID;
+
+		if (m->hdr.opcode != op)
 		{
-			struct fmapi_vsc_ppb_stat_blk *o = (struct fmapi_vsc_ppb_stat_blk*) src;
-			dst[0] = o->status;
-			dst[1] = o->ppid;
-			dst[2] = o->ldid;
-			rv = FMLN_VSC_PPB_STATUS;
+			op = m->hdr.opcode;
+			if (category == FMMT_REQ)
+				type = fmapi_fmob_req(op);
+			else 
+				type = fmapi_fmob_rsp(op);
 		}
+
+		if (cap - off < (size_t) FMLN_HDR + fmapi_wire_len(&m->obj, type))
 			break;
 
-		case FMOB_VSC_INFO_BLK: //!< struct fmapi_vsc_info_blk
-		{
-			struct fmapi_vsc_info_blk *o = (struct fmapi_vsc_info_blk*) src;
-			dst[0] = o->vcsid;
-			dst[1] = o->state;
-			dst[2] = o->uspid;
-			dst[3] = o->total;
+		if (offs != NULL)
+			offs[i] = off;
 
-			rv = FMLN_VSC_INFO;
-			for (int i = 0 ; i < o->num ; i++)
-				rv += fmapi_serialize(&dst[rv], &o->list[i], FMOB_VSC_PPB_STAT_BLK);
-		}
-			break;
+		len = 0;
+		if (FMLT_FMOB[type].fields != NULL)
+			len = fmapi_encode_layout(&dst[off + FMLN_HDR], &m->obj, type);
+		else if (type != FMOB_NULL)
+			len = fmapi_serialize(&dst[off + FMLN_HDR], &m->obj, type);
 
-		case FMOB_VSC_INFO_RSP: //!< struct fmapi_vsc_info_rsp
-		{
-			struct fmapi_vsc_info_rsp *o = (struct fmapi_vsc_info_rsp*) src;
-			dst[0] = o->num;
+		m->hdr.category = category;
+		m->hdr.tag = tag + i;
+		m->hdr.len = len;
+		fmapi_serialize(&dst[off], &m->hdr, FMOB_HDR);
 
-			rv = FMLN_VSC_GET_INFO_RESP;
-			for ( int i = 0 ; i < o->num ; i++)
-				rv += fmapi_serialize(&dst[rv], &o->list[i], FMOB_VSC_INFO_BLK);
-		}
-			break;
+		off += FMLN_HDR + len;
+	}
 
-		case FMOB_VSC_BIND_REQ: //!< struct fmapi_vsc_bind_req
-		{
-			struct fmapi_vsc_bind_req *o = (struct fmapi_vsc_bind_req*) src;
-			dst[0] = o->vcsid;
-			dst[1] = o->vppbid;
-			dst[2] = o->ppid;
-			dst[4] = (o->ldid      ) & 0x00FF;
-			dst[5] = (o->ldid >> 8 ) & 0x00FF;
-			rv = FMLN_VSC_BIND;
-		}
-			break;
+	if (offs != NULL)
+		offs[i] = off;
 
-		case FMOB_VSC_UNBIND_REQ: //!< struct fmapi_vsc_unbind_req
-		{
-			struct fmapi_vsc_unbind_req *o = (struct fmapi_vsc_unbind_req*) src;
-			dst[0] = o->vcsid;
-			dst[1] = o->vppbid;
-			dst[2] = o->option;;
-			rv = FMLN_VSC_UNBIND;
-		}
-			break;
+	return i;
+}
 
-		case FMOB_VSC_AER_REQ: //!< struct fmapi_vsc_aer_req
-		{
-			struct fmapi_vsc_aer_req *o = (struct fmapi_vsc_aer_req*) src;
-			dst[0] = o->vcsid;
-			dst[1] = o->vppbid;
-			dst[4] = (o->error_type  	 )	& 0x00FF;
-			dst[5] = (o->error_type >>  8) 	& 0x00FF;
-			dst[6] = (o->error_type >> 16) 	& 0x00FF;
-			dst[7] = (o->error_type >> 24) 	& 0x00FF;
-			memcpy(&dst[8], o->header, 32);
-			rv = FMLN_VSC_GEN_AER;
-		}
-			break;
+/**
+ * @brief Decode a batch of back to back FM API Messages 
+ *
+ * Frames are decoded from src into msgs until num messages are decoded or 
+ * src runs out of complete frames. offs[i] is set to the offset of frame i 
+ * in src and offs[n] to the end of the last decoded frame. m->buf is left 
+ * alone, as in fmapi_msg_decode(). 
+ *
+ * @param[out] msgs struct fmapi_msg** Array of num messages to decode into 
+ * @param[in] num unsigned Number of messages 
+ * @param[in] src __u8* Serialized frames 
+ * @param[in] len size_t Number of valid bytes in src
+ * @param[out] offs size_t* Array of num + 1 frame offsets. May be NULL
+ * @param[in] param void * passed to fmapi_deserialize_len() for every frame 
+ * @return number of messages decoded, or a negative enum _FMER if a frame is 
+ * 			malformed 
+ */
+int fmapi_decode_batch(struct fmapi_msg **msgs, unsigned num, __u8 *src, size_t len, size_t *offs, void *param)
+{
+	const struct fmapi_opcode_info *info;
+	struct fmapi_msg *m;
+	unsigned i, type, op, cat, min, max;
+	size_t off;
+	int rv;
 
-		case FMOB_MPC_TMC_REQ: //!< struct fmapi_mpc_tmc_req
-		{
-			struct fmapi_mpc_tmc_req *o = (struct fmapi_mpc_tmc_req*) src;
-			dst[0] = o->ppid;
-			dst[2] = ((o->len+1)      ) & 0x00FF;
-			dst[3] = ((o->len+1) >> 8 ) & 0x00FF;
-			dst[4] = o->type;
-			memcpy(&dst[FMLN_MPC_TUNNEL_CMD_REQ], o->msg, o->len);
-			rv = FMLN_MPC_TUNNEL_CMD_REQ + o->len;
-		}
-			break;
+	// Validate Inputs 
+	if ( (msgs == NULL) || (src == NULL) )
+		return -FMER_INVALID;
 
-		case FMOB_MPC_TMC_RSP: //!< struct fmapi_mpc_tmc_rsp
-		{
-			struct fmapi_mpc_tmc_rsp *o = (struct fmapi_mpc_tmc_rsp*) src;
-			dst[0] = ((o->len+1)      ) & 0x00FF;
-			dst[1] = ((o->len+1) >> 8 ) & 0x00FF;
-			dst[4] = o->type;
-			memcpy(&dst[FMLN_MPC_TUNNEL_CMD_REQ], o->msg, o->len);
-			rv = FMLN_MPC_TUNNEL_CMD_RESP + o->len;
-		}
-			break;
+	op = 0x10000; 		// Never matches a 16 bit opcode
+	cat = FMMT_MAX;
+	type = FMOB_NULL;
+	min = 0;
+	max = 0;
+	off = 0;
 
-		case FMOB_MPC_CFG_REQ: //!< struct fmapi_mpc_cfg_req
-		{
-			struct fmapi_mpc_cfg_req *o = (struct fmapi_mpc_cfg_req*) src;
-			dst[0] = o->ppid;
-			dst[1] = o->reg;
-			dst[2] = ((o->fdbe << 4) & 0xF0) | (o->ext & 0x0F);
-			dst[3] = (o->type  << 7) & 0x80;
-			dst[4] = (o->ldid      ) & 0x00FF;
-			dst[5] = (o->ldid >> 8 ) & 0x00FF;
-			dst[8] = o->data[0];
-			dst[9] = o->data[1];
-			dst[10] = o->data[2];
-			dst[11] = o->data[3];
-			rv = FMLN_MPC_LD_IO_CFG_REQ;
-		}
-			break;
+	for ( i = 0 ; i < num ; i++ )
+	{
+		m = msgs[i];
+		if (m == NULL)
+			return -FMER_INVALID;
 
-		case FMOB_MPC_CFG_RSP: //!< struct fmapi_mpc_cfg_rsp
-		{
-			struct fmapi_mpc_cfg_rsp *o = (struct fmapi_mpc_cfg_rsp*) src;
-			dst[0] = o->data[0];
-			dst[1] = o->data[1];
-			dst[2] = o->data[2];
-			dst[3] = o->data[3];
-			rv = FMLN_MPC_LD_IO_CFG_RESP;
-		}
+		if ( (len - off < FMLN_HDR) || (len - off < fmapi_frame_len(&src[off])) )
 			break;
 
-		case FMOB_MPC_MEM_REQ: //!< struct fmapi_mpc_mem_req
-		{
-			struct fmapi_mpc_mem_req *o = (struct fmapi_mpc_mem_req*) src;
-			dst[ 0] =   o->ppid;
-			dst[ 2] =  (o->fdbe   << 4 ) & 0x00F0; 		
-			dst[ 3] = ((o->type   << 7 ) & 0x0080) | (o->ldbe & 0x000F); 	
-			dst[ 4] =  (o->ldid        ) & 0x00FF;
-			dst[ 5] =  (o->ldid   >> 8 ) & 0x00FF;
-			dst[ 6] =  (o->len         ) & 0x00FF;
-			dst[ 7] =  (o->len    >> 8 ) & 0x00FF;
-			dst[ 8] =  (o->offset      ) & 0x00FF;	
-			dst[ 9] =  (o->offset >>  8) & 0x00FF;	
-			dst[10] =  (o->offset >> 16) & 0x00FF;	
-			dst[11] =  (o->offset >> 24) & 0x00FF;	
-			dst[12] =  (o->offset >> 32) & 0x00FF;	
-			dst[13] =  (o->offset >> 40) & 0x00FF;	
-			dst[14] =  (o->offset >> 48) & 0x00FF;	
-			dst[15] =  (o->offset >> 56) & 0x00FF;	
-			memcpy(&dst[FMLN_MPC_LD_MEM_REQ], o->data, o->len);
-			rv = FMLN_MPC_LD_MEM_REQ + o->len;
-		}
-			break;
+		fmapi_deserialize(&m->hdr, &src[off], FMOB_HDR, NULL);
 
-		case FMOB_MPC_MEM_RSP: //!< struct fmapi_mpc_mem_rsp
+		if ( (m->hdr.opcode != op) || (m->hdr.category != cat) )
 		{
-			struct fmapi_mpc_mem_rsp *o = (struct fmapi_mpc_mem_rsp*) src;
-			dst[0] =  (o->len        ) & 0x00FF;
-			dst[1] =  (o->len   >> 8 ) & 0x00FF;
-			memcpy(&dst[FMLN_MPC_LD_MEM_RESP], o->data, o->len);
-			rv = FMLN_MPC_LD_MEM_RESP + o->len;
+			info = fmapi_opcode_info(m->hdr.opcode);
+			if (info == NULL)
+				return -FMER_INVALID;
+
+			op = m->hdr.opcode;
+			cat = m->hdr.category;
+			if (cat == FMMT_REQ)
+			{
+				type = info->req;
+				min = info->req_min;
+				max = info->req_max;
+			}
+			else 
+			{
+				type = info->rsp;
+				min = info->rsp_min;
+				max = info->rsp_max;
+			}
 		}
-			break;
 
-		case FMOB_MCC_INFO_RSP: //!< struct fmapi_mcc_info_rsp
-		{
-			struct fmapi_mcc_info_rsp *o = (struct fmapi_mcc_info_rsp*) src;
-			dst[0] =  (o->size      ) & 0x00FF;	
-			dst[1] =  (o->size >>  8) & 0x00FF;	
-			dst[2] =  (o->size >> 16) & 0x00FF;	
-			dst[3] =  (o->size >> 24) & 0x00FF;	
-			dst[4] =  (o->size >> 32) & 0x00FF;	
-			dst[5] =  (o->size >> 40) & 0x00FF;	
-			dst[6] =  (o->size >> 48) & 0x00FF;	
-			dst[7] =  (o->size >> 56) & 0x00FF;	
-			dst[8] =  (o->num      ) & 0x00FF;
-			dst[9] =  (o->num >> 8 ) & 0x00FF;
-			dst[10]  = (o->epc & 0x01) << FMQT_EGRESS_PORT_CONGESTION_BIT;
-			dst[10] |= (o->ttr & 0x01) << FMQT_TEMP_THROUGHPUT_REDUCTION_BIT;
-			rv = FMLN_MCC_GET_LD_INFO;
-		}
-			break;
+		if (m->hdr.len > max)
+			return -FMER_OVERFLOW;
+		if ( (m->hdr.len < min) && !fmapi_msg_bare(&m->hdr) )
+			return -FMER_TRUNCATED;
 
-		case FMOB_MCC_ALLOC_BLK: //!< struct fmapi_mcc_ldalloc_entry
+		if ( (type != FMOB_NULL) && (m->hdr.len > 0) )
 		{
-			struct fmapi_mcc_alloc_blk *o = (struct fmapi_mcc_alloc_blk*) src;
-			dst[0] =  (o->rng1      ) & 0x00FF;	
-			dst[1] =  (o->rng1 >>  8) & 0x00FF;	
-			dst[2] =  (o->rng1 >> 16) & 0x00FF;	
-			dst[3] =  (o->rng1 >> 24) & 0x00FF;	
-			dst[4] =  (o->rng1 >> 32) & 0x00FF;	
-			dst[5] =  (o->rng1 >> 40) & 0x00FF;	
-			dst[6] =  (o->rng1 >> 48) & 0x00FF;	
-			dst[7] =  (o->rng1 >> 56) & 0x00FF;	
-			dst[8] =  (o->rng2      ) & 0x00FF;	
-			dst[9] =  (o->rng2 >>  8) & 0x00FF;	
-			dst[10] =  (o->rng2 >> 16) & 0x00FF;	
-			dst[11] =  (o->rng2 >> 24) & 0x00FF;	
-			dst[12] =  (o->rng2 >> 32) & 0x00FF;	
-			dst[13] =  (o->rng2 >> 40) & 0x00FF;	
-			dst[14] =  (o->rng2 >> 48) & 0x00FF;	
-			dst[15] =  (o->rng2 >> 56) & 0x00FF;	
-			rv = FMLN_MCC_LD_ALLOC_ENTRY;
+			if (FMLT_FMOB[type].fields != NULL)
+			{
+				rv = fmapi_check_len(&src[off + FMLN_HDR], m->hdr.len, type, param);
+				if (rv > 0)
+					fmapi_decode_layout(&m->obj, &src[off + FMLN_HDR], type);
+			}
+			else 
+				rv = fmapi_deserialize_len(&m->obj, &src[off + FMLN_HDR], m->hdr.len, type, param);
+			if (rv < 0)
+				return rv;
 		}
-			break;
 
-		case FMOB_MCC_ALLOC_GET_REQ: //!< struct fmapi_mcc_alloc_get_req
-		{
-			struct fmapi_mcc_alloc_get_req *o = (struct fmapi_mcc_alloc_get_req*) src;
-			dst[0] = o->start;
-			dst[1] = o->limit;
-			rv = FMLN_MCC_GET_LD_ALLOC_REQ;
-		}
-			break;
+		if (offs != NULL)
+			offs[i] = off;
 
-		case FMOB_MCC_ALLOC_GET_RSP: //!< struct fmapi_mcc_alloc_get_rsp
-		{
-			struct fmapi_mcc_alloc_get_rsp *o = (struct fmapi_mcc_alloc_get_rsp*) src;
-			dst[0] = o->total;
-			dst[1] = o->granularity;
-			dst[2] = o->start;
-			dst[3] = o->num;
-			rv = FMLN_MCC_GET_LD_ALLOC_RSP;
-			for ( int i = 0 ; i < o->num ; i++ )
-				rv += fmapi_serialize(&dst[rv], &o->list[i], FMOB_MCC_ALLOC_BLK);
-		}
-			break;
+		off += FMLN_HDR + m->hdr.len;
+	}
 
-		case FMOB_MCC_ALLOC_SET_REQ: //!< struct fmapi_mcc_alloc_set_req
-		{
-			struct fmapi_mcc_alloc_set_req *o = (struct fmapi_mcc_alloc_set_req*) src;
-			dst[0] = o->num;
-			dst[1] = o->start;
-			rv = FMLN_MCC_SET_LD_ALLOC_REQ;
-			for ( int i = 0 ; i < o->num ; i++ )
-				rv += fmapi_serialize(&dst[rv], &o->list[i], FMOB_MCC_ALLOC_BLK);
-		}
-			break;
+	if (offs != NULL)
+		offs[i] = off;
 
-		case FMOB_MCC_ALLOC_SET_RSP: //!< struct fmapi_mcc_alloc_set_rsp
-		{
-			struct fmapi_mcc_alloc_set_rsp *o = (struct fmapi_mcc_alloc_set_rsp*) src;
-			dst[0] = o->num;
-			dst[1] = o->start;
-			rv = FMLN_MCC_SET_LD_ALLOC_RSP;
-			for ( int i = 0 ; i < o->num ; i++ )
-				rv += fmapi_serialize(&dst[rv], &o->list[i], FMOB_MCC_ALLOC_BLK);
-		}
-			break;
+	return i;
+}
 
-		case FMOB_MCC_QOS_CTRL: //!< struct fmapi_mcc_qos_ctrl
-		{
-			struct fmapi_mcc_qos_ctrl *o = (struct fmapi_mcc_qos_ctrl*) src;
-			dst[0] = 0;
-			dst[0] |= o->epc_en       << FMQT_EGRESS_PORT_CONGESTION_BIT;
-			dst[0] |= o->ttr_en << FMQT_TEMP_THROUGHPUT_REDUCTION_BIT;
-			dst[1] = o->egress_mod_pcnt;
-			dst[2] = o->egress_sev_pcnt;
-			dst[3] = o->sample_interval;
-			dst[4] = (o->rcb      ) & 0x00FF;
-			dst[5] = (o->rcb >> 8 ) & 0x00FF;
-			dst[6] = o->comp_interval;
-			rv = FMLN_MCC_QOS_CTRL;
-		}
-			break;
+/**
+ * Length of a complete frame (header and payload) from its serialized header 
+ */
+static size_t fmapi_frame_len(const __u8 *hdr)
+{
+	return FMLN_HDR + (((hdr[7] & 0x00F8) << 13) | (hdr[6] << 8) | hdr[5]);
+}
 
-		case FMOB_MCC_QOS_STAT_RSP: //!< struct fmapi_mcc_qos_stat_rsp
-		{
-			struct fmapi_mcc_qos_stat_rsp *o = (struct fmapi_mcc_qos_stat_rsp*) src;
-			dst[0] = o->bp_avg_pcnt;
-			rv = FMLN_MCC_QOS_STATUS;
-		}
-			break;
+/**
+ * Initialize a streaming parser 
+ *
+ * @param[out] p struct fmapi_parser* to initialize 
+ * @param[in] buf __u8* Buffer for a partially received message 
+ * @param[in] cap size_t Size of buf. Messages longer than this are rejected
+ * @param[in] m struct fmapi_msg* to decode each frame into. May be NULL
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_parser_init(struct fmapi_parser *p, __u8 *buf, size_t cap, struct fmapi_msg *m)
+{
+	if ( (p == NULL) || (buf == NULL) || (cap < FMLN_HDR) )
+		return -FMER_INVALID;
 
-		case FMOB_MCC_QOS_BW_GET_REQ:
-		{
-			struct fmapi_mcc_qos_bw_alloc_get_req *o = (struct fmapi_mcc_qos_bw_alloc_get_req*) src;
-			dst[0] = o->num;
-			dst[1] = o->start;
-			rv = FMLN_MCC_GET_QOS_BW_REQ;
-		}
-			break;
+	p->buf = buf;
+	p->cap = cap;
+	p->off = 0;
+	p->end = 0;
+	p->msg = m;
 
-		case FMOB_MCC_QOS_BW_ALLOC: //!< struct fmapi_mcc_qos_bw_alloc
-		{
-			struct fmapi_mcc_qos_bw_alloc *o = (struct fmapi_mcc_qos_bw_alloc*) src;
-			dst[0] = o->num;
-			dst[1] = o->start;
-			rv = FMLN_MCC_QOS_BW_ALLOC;
-			for ( int i = 0 ; i < o->num ; i++ )
-				dst[rv + i] = o->list[i];
-			rv += o->num;
-		}
-			break;
+	return 0;
+}
+
+/**
+ * Discard any partially received message 
+ */
+void fmapi_parser_reset(struct fmapi_parser *p)
+{
+	p->off = 0;
+	p->end = 0;
+}
+
+/**
+ * Pass one complete frame to the callback, decoding it first if requested
+ */
+static void fmapi_parser_emit(struct fmapi_parser *p, __u8 *frame, size_t len, void (*cb)(void *arg, struct fmapi_msg *m, __u8 *frame, size_t len), void *arg)
+{
+	struct fmapi_msg *m;
+
+	m = p->msg;
+	if ( (m != NULL) && (fmapi_msg_decode(m, frame, len, NULL) < 0) )
+		m = NULL;
+
+	cb(arg, m, frame, len);
+}
+
+/**
+ * @brief Feed a chunk of a byte stream to the parser 
+ *
+ * STEPS
+ * 1: Emit any complete frames already in the parser buffer 
+ * 2: Complete a partially buffered frame with bytes from the chunk
+ * 3: Emit frames that lie entirely in the chunk in place 
+ * 4: Buffer the trailing partial frame 
+ *
+ * @param[in] p struct fmapi_parser* 
+ * @param[in] chunk __u8* Bytes received 
+ * @param[in] len size_t Number of bytes in chunk
+ * @param[in] cb Function called for each complete frame 
+ * @param[in] arg void* passed to cb 
+ * @return number of complete messages, or a negative enum _FMER upon error
+ */
+int fmapi_parser_feed(struct fmapi_parser *p, __u8 *chunk, size_t len, void (*cb)(void *arg, struct fmapi_msg *m, __u8 *frame, size_t len), void *arg)
+{
+	__u8 *frame;
+	size_t need, n;
+	int count, rv;
+
+	// Validate Inputs 
+	if ( (p == NULL) || (cb == NULL) || ( (chunk == NULL) && (len > 0) ) )
+		return -FMER_INVALID;
+
+	count = 0;
 
-		case FMOB_MCC_QOS_BW_LIMIT_GET_REQ: //!< struct fmapi_mcc_qos_bw_limit_get_req 
+	// STEP 1: Emit any complete frames already in the parser buffer 
+	while ( (rv = fmapi_parser_next(p, &frame)) > 0 )
+	{
+		fmapi_parser_emit(p, frame, rv, cb, arg);
+		count++;
+	}
+	if (rv < 0)
+		return rv;
+
+	// STEP 2: Complete a partially buffered frame with bytes from the chunk
+	if (p->end > p->off)
+	{
+		if (p->off > 0)
 		{
-			struct fmapi_mcc_qos_bw_limit_get_req *o = (struct fmapi_mcc_qos_bw_limit_get_req*) src;
-			dst[0] = o->num;
-			dst[1] = o->start;
-			rv = FMLN_MCC_GET_QOS_BW_LIMIT_REQ;
+			memmove(p->buf, &p->buf[p->off], p->end - p->off);
+			p->end -= p->off;
+			p->off = 0;
 		}
-			break;
 
-		case FMOB_MCC_QOS_BW_LIMIT: //!< struct fmapi_mcc_qos_bw_limit
+		// Complete the header first to learn the frame length 
+		if (p->end < FMLN_HDR)
 		{
-			struct fmapi_mcc_qos_bw_limit *o = (struct fmapi_mcc_qos_bw_limit*) src;
-			dst[0] = o->num;
-			dst[1] = o->start;
-			rv = FMLN_MCC_QOS_BW_LIMIT;
-			for ( int i = 0 ; i < o->num ; i++ )
-				dst[rv + i] = o->list[i];
-			rv += o->num;
+			n = FMLN_HDR - p->end;
+			if (n > len)
+				n = len;
+			memcpy(&p->buf[p->end], chunk, n);
+			p->end += n;
+			chunk += n;
+			len -= n;
+			if (p->end < FMLN_HDR)
+				return count;
 		}
-			break;
 
-		default:
-			rv = 0;
+		need = fmapi_frame_len(p->buf);
+		if (need > p->cap)
+			goto overflow;
+
+		n = need - p->end;
+		if (n > len)
+			n = len;
+		memcpy(&p->buf[p->end], chunk, n);
+		p->end += n;
+		chunk += n;
+		len -= n;
+		if (p->end < need)
+			return count;
+
+		fmapi_parser_reset(p);
+		fmapi_parser_emit(p, p->buf, need, cb, arg);
+		count++;
+	}
+
+	// STEP 3: Emit frames that lie entirely in the chunk in place 
+	while (len >= FMLN_HDR)
+	{
+		need = fmapi_frame_len(chunk);
+		if (need > p->cap)
+			goto overflow;
+		if (len < need)
 			break;
+
+		fmapi_parser_emit(p, chunk, need, cb, arg);
+		count++;
+		chunk += need;
+		len -= need;
 	}
-	
-	return rv;
-};
+
+	// STEP 4: Buffer the trailing partial frame 
+	if (len > 0)
+	{
+		memcpy(p->buf, chunk, len);
+		p->off = 0;
+		p->end = len;
+	}
+
+	return count;
+
+overflow:
+
+	fmapi_parser_reset(p);
+	return -FMER_OVERFLOW;
+}
+
+/**
+ * Get the free space at the end of the parser buffer to receive into 
+ *
+ * Consumed frames are dropped from the front of the buffer first 
+ *
+ * @param[in] p struct fmapi_parser* 
+ * @param[out] avail size_t* Set to the number of free bytes 
+ * @return __u8* Pointer to the free space 
+ */
+__u8 *fmapi_parser_space(struct fmapi_parser *p, size_t *avail)
+{
+	if (p->off > 0)
+	{
+		memmove(p->buf, &p->buf[p->off], p->end - p->off);
+		p->end -= p->off;
+		p->off = 0;
+	}
+
+	*avail = p->cap - p->end;
+	return &p->buf[p->end];
+}
+
+/**
+ * Mark n bytes received into the space returned by fmapi_parser_space()
+ */
+void fmapi_parser_commit(struct fmapi_parser *p, size_t n)
+{
+	p->end += n;
+	if (p->end > p->cap)
+		p->end = p->cap;
+}
+
+/**
+ * @brief Get the next complete frame from the parser buffer 
+ *
+ * @param[in] p struct fmapi_parser* 
+ * @param[out] frame __u8** Set to the start of the frame 
+ * @return length of the frame, 0 if no complete frame is buffered, or a 
+ * 			negative enum _FMER upon error
+ */
+int fmapi_parser_next(struct fmapi_parser *p, __u8 **frame)
+{
+	size_t need;
+
+	if (p->end - p->off < FMLN_HDR)
+		return 0;
+
+	need = fmapi_frame_len(&p->buf[p->off]);
+	if (need > p->cap)
+	{
+		fmapi_parser_reset(p);
+		return -FMER_OVERFLOW;
+	}
+	if (p->end - p->off < need)
+		return 0;
+
+	*frame = &p->buf[p->off];
+	p->off += need;
+
+	return need;
+}
+
+/**
+ * Check whether a complete frame is buffered without consuming it 
+ *
+ * @param[in] p struct fmapi_parser* 
+ * @return 1 if fmapi_parser_next() would return a frame or an error, 0 otherwise
+ */
+int fmapi_parser_ready(struct fmapi_parser *p)
+{
+	size_t need;
+
+	if (p->end - p->off < FMLN_HDR)
+		return 0;
+
+	need = fmapi_frame_len(&p->buf[p->off]);
+	if ( (need > p->cap) || (p->end - p->off >= need) )
+		return 1;
+
+	return 0;
+}
 
 /* Functions to return a string representation of an object*/
 const char *fmbs(unsigned int u)
@@ -2515,6 +4327,12 @@ const char *fmbs(unsigned int u)
 	else 				return STR_FMBS[u];	
 }
 
+const char *fmcs(unsigned int u)
+{
+	if (u >= FMCS_MAX) 	return NULL;
+	else 				return STR_FMCS[u];	
+}
+
 const char *fmct(unsigned int u)
 {
 	if (u >= FMCT_MAX) 	return NULL;
@@ -2533,6 +4351,12 @@ const char *fmdv(unsigned int u)
 	else 				return STR_FMDV[u];	
 }
 
+const char *fmer(unsigned int u)
+{
+	if (u >= FMER_MAX) 	return NULL;
+	else 				return STR_FMER[u];	
+}
+
 const char *fmet(unsigned int u)
 {
 	if (u >= FMET_MAX) 	return NULL;
@@ -2605,27 +4429,10 @@ const char *fmnw(unsigned int u)
 
 const char *fmop(unsigned int u) 
 {
-	unsigned int group = (u >> 8) & 0x0F;
-	u &= 0x00FF;
-	switch (group) 
-	{
-		case 1:	
-			if (u >= 4) 	return NULL;
-			else			return STR_FMOP_1[u];	
+	const struct fmapi_opcode_info *info = fmapi_opcode_info(u);
 
-		case 2:	
-			if (u >= 4) 	return NULL;
-			else			return STR_FMOP_2[u];	
-
-		case 3:	
-			if (u >= 3)		return NULL;
-			else 			return STR_FMOP_3[u];	
-
-		case 4:	
-			if (u >= 10) 	return NULL;
-			else			return STR_FMOP_4[u];	
-	}
-	return NULL;
+	if (info == NULL) 	return NULL;
+	else 				return info->name;
 }
 
 const char *fmpo(unsigned int u)
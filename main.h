@@ -12,10 +12,12 @@
  * @author 		Barrett Edwards <code@jrlabs.io>
  *
  * Macro / Enumeration Prefixes 
+ * FMCS - FM API Command Sets (CS)
  * FMCT - CXL.io Configuration Request Type
  * FMDT	- CXL Device Type
  * FMDV	- CXL version for the connected device
  * FMEL	- Event Logs
+ * FMER - Length-aware decode and transport error codes (ER)
  * FMET - Physical Switch Event Record - Event Type (ET)
  * FMLF - Link Flags - Bitmask Flags for Link State for CXL Swithc Port info struct
  * FMLN - Serialized Length of each FM API Object (struct) (LN)
@@ -33,6 +35,7 @@
  * FMQT	- QoS Telemetry Capability Bitmask
  * FMRC	- FM API Return Codes
  * FMSS - Bitmask fields for PCIe Supported Link Speeds
+ * FMTW - Timer wheel geometry (TW)
  * FMUB - Unbind options for vPPB Unbind Command
  * FMVS - VCS State
  * FMVT - Virtual CXL Switch Event Record - Event Type (VT)
@@ -53,6 +56,21 @@
  */
 #include <linux/types.h>
 
+/**
+ * For size_t
+ */
+#include <stddef.h>
+
+/**
+ * For memcpy() in the little endian field accessors 
+ */
+#include <string.h>
+
+/**
+ * For struct iovec 
+ */
+#include <sys/uio.h>
+
 /* MACROS ====================================================================*/
 
 /**
@@ -101,6 +119,46 @@
  */
 #define FM_TLP_HEADER 32 
 
+/**
+ * The FM API Header has an 8-bit tag so at most 256 requests can be outstanding
+ */
+#define FM_MAX_TAGS 256
+
+/**
+ * Most list entries one request can ask for: the count fields are 8 bits
+ */
+#define FM_MAX_LIST 255
+
+/**
+ * Range of n in the 2^n byte message size limits of Identify and the 
+ * Get / Set Response Message Limit commands
+ */
+#define FM_MSG_LIMIT_MIN 8
+#define FM_MSG_LIMIT_MAX 20
+
+/**
+ * Length of the PCIe Extended Configuration Space of a function in bytes
+ */
+#define FM_CFG_SPACE_LEN PCI_CFG_SPACE_EXP_SIZE
+
+/**
+ * Maximum number of capabilities recorded in a configuration space image
+ */
+#define FM_MAX_CFG_CAPS 64
+
+/**
+ * Number of opcodes whose background operation duration is remembered 
+ */
+#define FM_BOS_HISTORY 8
+
+/**
+ * Hierarchical timer wheel geometry (TW). Ticks are milliseconds
+ */
+#define FMTW_BITS 		6
+#define FMTW_SLOTS 		(1 << FMTW_BITS)
+#define FMTW_LEVELS 	4
+#define FMTW_MAX_DELAY 	((1UL << (FMTW_BITS * FMTW_LEVELS)) - 1)
+
 /**
  * Serialized Length in bytes of each FM API Object (struct) (LN)
  *
@@ -557,6 +615,40 @@ enum _FMCT {
 	FMCT_MAX
 };
 
+/**
+ * FM API Command Sets (CS)
+ *
+ * CXL 2.0 v1.0 Table 205 
+ */
+enum _FMCS {
+	FMCS_ISC 	= 0,	//!< Information and Status Commands (0x00xx)
+	FMCS_PSC 	= 1,	//!< Physical Switch Command Set (0x51xx)
+	FMCS_VSC 	= 2,	//!< Virtual Switch Command Set (0x52xx)
+	FMCS_MPC 	= 3,	//!< MLD Port Command Set (0x53xx)
+	FMCS_MCC 	= 4,	//!< MLD Component Command Set (0x54xx)
+	FMCS_MAX
+};
+
+/**
+ * Length-aware Decode and Transport Errors (ER)
+ *
+ * Returned as negative values by fmapi_check_len(), fmapi_deserialize_len() 
+ * and the transport functions. 
+ * This is not an enumeration defined by the CXL FM API
+ */
+enum _FMER {
+	FMER_SUCCESS 		= 0,
+	FMER_INVALID 		= 1, //!< NULL pointer, unknown object type or malformed field
+	FMER_TRUNCATED 		= 2, //!< Source buffer is shorter than the serialized object
+	FMER_OVERFLOW 		= 3, //!< Count field exceeds the capacity of the destination object
+	FMER_PARAM 			= 4, //!< Object requires a param that was not provided
+	FMER_IO 			= 5, //!< Transport system call failed. See errno 
+	FMER_CLOSED 		= 6, //!< Transport peer closed the connection
+	FMER_BUSY 			= 7, //!< Session window is full, no tag is available
+	FMER_TIMEOUT 		= 8, //!< No response arrived before the retry policy gave up
+	FMER_MAX
+};
+
 /* STRUCTS ===================================================================*/
 
 /** 
@@ -697,6 +789,37 @@ struct fmapi_psc_port_rsp
 	struct fmapi_psc_port_info list[FM_MAX_PORTS];	//!< Variable list of fm_psc_port_info structs
 };
 
+/**
+ * Get Physical Port State - Response decoded as a table of columns 
+ *
+ * Entry i of each array describes the same port. Fields have the same meaning 
+ * as in struct fmapi_psc_port_info. Filled by fmapi_deserialize_port_table()
+ */
+struct fmapi_psc_port_table 
+{
+	unsigned num;					//!< Number of valid entries in each array 
+	__u8 ppid[FM_MAX_PORTS];		//!< Physical Port ID
+	__u8 state[FM_MAX_PORTS];		//!< Current Port Configuration State [FMPS]
+	__u8 dv[FM_MAX_PORTS];			//!< Connected Device CXL Version [FMDV]
+	__u8 dt[FM_MAX_PORTS];			//!< Connected Device Type [FMDT]
+	__u8 cv[FM_MAX_PORTS];			//!< Connected device CXL Version [FMCV]
+	__u8 mlw[FM_MAX_PORTS];			//!< Max link width
+	__u8 nlw[FM_MAX_PORTS];			//!< Negotiated link width [FMNW]
+	__u8 speeds[FM_MAX_PORTS];		//!< Supported Link speeds vector [FMSS]
+	__u8 mls[FM_MAX_PORTS];			//!< Max Link Speed [FMMS]
+	__u8 cls[FM_MAX_PORTS];			//!< Current Link Speed [FMMS] 
+	__u8 ltssm[FM_MAX_PORTS];		//!< LTSSM State [FMLS]
+	__u8 lane[FM_MAX_PORTS];		//!< First negotiated lane number
+	__u8 flags[FM_MAX_PORTS];		//!< Link State Flags bitmask [FMLF]
+	__u8 num_ld[FM_MAX_PORTS];		//!< Supported Logical Device (LDs) count 
+
+	/* Link State Flags [FMLF] unpacked, one byte per port */
+	__u8 lane_rev[FM_MAX_PORTS]; 	//!< Lane reversal state. 0=standard, 1=rev [FMLO]
+	__u8 perst[FM_MAX_PORTS];		//!< PCIe Reset State PERST#	
+	__u8 prsnt[FM_MAX_PORTS];		//!< Port Presence pin state PRSNT#
+	__u8 pwrctrl[FM_MAX_PORTS];		//!< Power Control State (PWR_CTRL)
+};
+
 /**
  * Physical Port Control (Opcode 5102h) 
  *
@@ -1187,6 +1310,411 @@ struct fmapi_msg
 	} obj;	
 };
 
+/**
+ * Static description of an FM API Opcode [FMOP]
+ *
+ * Payload lengths are the serialized length of the object following the FM API 
+ * Header. Variable length objects give the smallest and largest valid length.
+ */
+struct fmapi_opcode_info 
+{
+	__u16 opcode;			//!< FM API Opcode [FMOP]
+	__u8 cs;				//!< Command Set [FMCS]
+	__u8 bg;				//!< The command may complete as a Background Operation 
+	__u8 req;				//!< Request Object Identifier [FMOB]
+	__u8 rsp;				//!< Response Object Identifier [FMOB]
+	__u16 req_min;			//!< Minimum Request payload length 
+	__u16 req_max;			//!< Maximum Request payload length 
+	__u16 rsp_min;			//!< Minimum Response payload length 
+	__u16 rsp_max;			//!< Maximum Response payload length 
+	const char *name;		//!< String representation of the Opcode
+};
+
+/**
+ * Resumable parser that splits a byte stream into FM API Messages 
+ *
+ * Bytes of a partially received message are kept in a caller provided buffer 
+ * that must be large enough to hold the largest message expected on the 
+ * stream (sizeof(struct fmapi_buf) for any message). 
+ */
+struct fmapi_parser 
+{
+	__u8 *buf;				//!< Buffer for a partially received message 
+	size_t cap;				//!< Size of buf in bytes 
+	size_t off;				//!< Offset of the first unconsumed byte in buf 
+	size_t end;				//!< Offset one past the last valid byte in buf 
+	struct fmapi_msg *msg;	//!< Optional message to decode each frame into. May be NULL
+};
+
+/**
+ * Pool of preallocated struct fmapi_msg objects, each with its own struct fmapi_buf 
+ *
+ * Opaque. Create with fmapi_msg_pool_create()
+ */
+struct fmapi_msg_pool;
+
+/**
+ * Bump pointer arena owning every object of one transaction 
+ *
+ * Objects are carved from one block in order and are released together by 
+ * fmapi_arena_reset(). Intended to hold the request, response and nested 
+ * tunnel messages of a Tunnel Management Command. 
+ */
+struct fmapi_arena 
+{
+	__u8 *base;				//!< Backing storage 
+	size_t cap;				//!< Size of base in bytes 
+	size_t off;				//!< Offset of the first free byte in base 
+	int owned;				//!< base was allocated by fmapi_arena_init()
+};
+
+struct fmapi_transport;
+
+/**
+ * Operations of an FM API transport 
+ *
+ * A transport moves complete FM API frames (12 byte FM API Header followed 
+ * by the payload). Backends fill in a const instance of this struct.
+ */
+struct fmapi_transport_ops 
+{
+	//!< Send one frame gathered from cnt iovecs. Returns bytes sent or negative enum _FMER
+	int (*send_frame)(struct fmapi_transport *t, const struct iovec *iov, int cnt);
+
+	//!< Receive one frame. Returns its length, 0 if none is available yet, or negative enum _FMER
+	int (*recv_frame)(struct fmapi_transport *t, __u8 **frame);
+
+	//!< File descriptor to poll for readability, -1 if there is none 
+	int (*poll_fd)(struct fmapi_transport *t);
+
+	//!< Close the transport and release its memory
+	void (*close)(struct fmapi_transport *t);
+};
+
+/**
+ * FM API transport endpoint 
+ *
+ * Received frames are framed with a struct fmapi_parser and stay valid until 
+ * the next receive. 
+ */
+struct fmapi_transport 
+{
+	const struct fmapi_transport_ops *ops;	//!< Backend operations 
+	int fd;					//!< Socket, -1 if the backend has none 
+	int type;				//!< Socket type: SOCK_STREAM or SOCK_SEQPACKET
+	int send_ms;			//!< Longest wait for a non blocking socket to take a frame. -1 waits forever
+	struct fmapi_parser parser; 	//!< Framing of received bytes 
+	__u8 *scratch;			//!< Header and fixed portion of a message being sent 
+	__u8 *rxbuf;			//!< Receive buffer from fmapi_transport_set_max(). NULL while the built in one is used
+	void *priv;				//!< Backend private data 
+};
+
+/**
+ * Timer armed on a struct fmapi_timer_wheel 
+ *
+ * Embedded in the object it times. Unlinked timers have next == NULL.
+ */
+struct fmapi_timer 
+{
+	struct fmapi_timer *next;	//!< Next timer in the same wheel slot 
+	struct fmapi_timer *prev;	//!< Previous timer in the same wheel slot 
+	__u64 expires;				//!< Tick at which the timer fires 
+};
+
+/**
+ * Hierarchical timer wheel with O(1) arm and cancel
+ *
+ * Level 0 has one slot per tick. Each higher level has one slot per full turn 
+ * of the level below, and its timers are cascaded down as the wheel turns. 
+ * Delays longer than FMTW_MAX_DELAY ticks are clamped. 
+ */
+struct fmapi_timer_wheel 
+{
+	__u64 clk;					//!< Next tick to process 
+	unsigned num;				//!< Number of armed timers 
+	struct fmapi_timer slot[FMTW_LEVELS][FMTW_SLOTS];	//!< List heads 
+};
+
+/**
+ * Timeout and retry policy of a struct fmapi_session 
+ *
+ * A request is resent when its response carries a return code [FMRC] whose 
+ * bit is set in retry_rc, or when no response arrives within timeout_ms and 
+ * retry_timeout is set. The n-th resend waits base_ms * 2^(n-1) capped at 
+ * max_ms, of which the last jitter percent is randomized. 
+ */
+struct fmapi_retry_policy 
+{
+	unsigned timeout_ms;		//!< Response timeout of each attempt. 0 waits forever
+	unsigned max_tries;			//!< Total attempts including the first 
+	unsigned base_ms;			//!< Delay before the first resend 
+	unsigned max_ms;			//!< Upper bound of the delay 
+	unsigned jitter;			//!< Percent of the delay that is randomized, 0 to 100
+	__u32 retry_rc;				//!< Bitmask of return codes to retry: bit n is FMRC n
+	int retry_timeout;			//!< Resend after a timeout 
+};
+
+/**
+ * One request / response exchange on a struct fmapi_session 
+ *
+ * Owned by the caller and must stay valid until the exchange completes. 
+ */
+struct fmapi_xfer 
+{
+	struct fmapi_msg *req;	//!< Request to send 
+	struct fmapi_msg *rsp;	//!< Message to decode the response into. May be NULL
+	void *param;			//!< param passed to fmapi_msg_decode() for the response 
+	int (*decode)(struct fmapi_xfer *x, __u8 *frame, size_t len);	//!< Consumes a successful response frame in place of rsp. May be NULL
+	void (*cb)(struct fmapi_xfer *x);	//!< Called on completion. May be NULL
+	void *arg;				//!< Caller data for cb 
+	int status;				//!< Response return code [FMRC], or negative enum _FMER
+	int done;				//!< Set once the exchange completed 
+	__u8 tag;				//!< Tag assigned by fmapi_session_submit()
+	__u8 backoff;			//!< Waiting to be resent. Responses are ignored unless timedout
+	__u8 timedout;			//!< The last attempt timed out. A late response to it completes the exchange
+	unsigned tries;			//!< Number of times the request was sent 
+	struct fmapi_timer timer; 	//!< Response timeout or resend delay 
+};
+
+/**
+ * Client session that pipelines requests over a transport 
+ *
+ * Each outstanding request holds one tag and responses are matched to their 
+ * request through the slot indexed by tag, in any order. Freed tags are 
+ * reused oldest first so a late response cannot match a newer request. 
+ * A session is not thread safe. 
+ */
+struct fmapi_session 
+{
+	struct fmapi_transport *t;		//!< Transport to the endpoint 
+	unsigned window;				//!< Maximum number of outstanding requests 
+	unsigned inflight;				//!< Number of outstanding requests
+	unsigned head;					//!< Next entry of free to allocate
+	unsigned tail;					//!< Next entry of free to release into 
+	unsigned stray;					//!< Responses that matched no outstanding request
+	__u8 free[FM_MAX_TAGS];			//!< FIFO of free tags 
+	struct fmapi_xfer *slot[FM_MAX_TAGS]; 	//!< Outstanding exchange for each tag 
+	const struct fmapi_retry_policy *policy; 	//!< Timeout and retry policy. NULL for none
+	__u64 seed;						//!< State of the jitter random number generator
+	struct fmapi_timer_wheel wheel;	//!< Timeouts and resend delays 
+	unsigned rsp_limit;				//!< Largest response payload the endpoint may send
+	unsigned req_limit;				//!< Largest request payload the endpoint accepts. Longer requests are refused
+};
+
+struct fmapi_pipe;
+
+/**
+ * Request slot of a struct fmapi_pipe 
+ *
+ * The first member of a larger slot that holds the request and what its 
+ * owner needs to consume the response. x.arg points at the slot. 
+ */
+struct fmapi_pipe_slot 
+{
+	struct fmapi_xfer x;			//!< Exchange of the request 
+	struct fmapi_pipe *pipe;		//!< Owner 
+	struct fmapi_pipe_slot *next;	//!< Next free slot 
+};
+
+/**
+ * Requests generated on demand and kept in flight on a session 
+ *
+ * next() fills the request of a free slot until it returns 0. Slots are sent 
+ * as long as the pipe and the window of the session have room, then freed 
+ * as their exchanges complete. 
+ */
+struct fmapi_pipe 
+{
+	struct fmapi_session *s;		//!< Session the requests are sent on 
+	int (*next)(struct fmapi_pipe *p, struct fmapi_pipe_slot *sl);	//!< Fill the next request. 0 when none is left
+	void *arg;						//!< Caller data for next 
+	unsigned depth;					//!< Number of slots: the most requests in flight 
+	unsigned inflight;				//!< Requests in flight 
+	int rv;							//!< First error 
+	void *slot;						//!< Array of depth slots 
+	struct fmapi_pipe_slot *free;	//!< Free slots 
+};
+
+/**
+ * One Get Physical Port State query issued through a struct fmapi_port_coalescer 
+ *
+ * Owned by the caller and must stay valid until the query completes. 
+ */
+struct fmapi_port_query 
+{
+	__u8 ppid;							//!< Physical Port ID to query 
+	struct fmapi_psc_port_info info;	//!< State of the port once done with status 0
+	void (*cb)(struct fmapi_port_query *q);	//!< Called on completion. May be NULL
+	void *arg;							//!< Caller data for cb 
+	int status;							//!< Response return code [FMRC], or negative enum _FMER
+	int done;							//!< Set once the query completed 
+	struct fmapi_xfer *x;				//!< Exchange carrying the query. NULL while pending
+	struct fmapi_port_query *next;		//!< Next query in the same batch 
+};
+
+/**
+ * Batch of port queries sent as one Get Physical Port State request 
+ *
+ * Opaque. Owned by a struct fmapi_port_coalescer
+ */
+struct fmapi_port_batch;
+
+/**
+ * Merges Get Physical Port State queries into as few requests as possible 
+ *
+ * Queries are held for up to hold_ms and sent together in one FMOP_PSC_PORT 
+ * request whose response fits the rsp_limit of the session. Queries for the 
+ * same port share one entry. 
+ */
+struct fmapi_port_coalescer 
+{
+	struct fmapi_session *s;			//!< Session requests are sent on 
+	unsigned hold_ms;					//!< Longest time a query waits for others 
+	__u64 deadline;						//!< Time the pending queries must be sent by 
+	struct fmapi_port_query *head;		//!< Oldest pending query
+	struct fmapi_port_query *tail;		//!< Newest pending query
+	unsigned num;						//!< Number of distinct ports pending 
+	__u8 map[FM_MAX_PORTS/8];			//!< Bitmask of the ports pending 
+	struct fmapi_port_batch *batch;		//!< Array of nbatch batches
+	struct fmapi_port_batch *idle;		//!< Batches not in flight
+	unsigned nbatch;					//!< Number of batches 
+	unsigned requests;					//!< Number of requests sent 
+	unsigned queries;					//!< Number of queries completed 
+};
+
+/**
+ * Capability found in a configuration space image
+ */
+struct fmapi_cfg_cap 
+{
+	__u16 id;							//!< Capability ID [PCI_CAP_ID_*] or Extended Capability ID [PCI_EXT_CAP_ID_*]
+	__u16 off;							//!< Byte offset of the capability header 
+	__u8 ext;							//!< 1 if in the extended capability list 
+};
+
+/**
+ * Configuration space image of a PPB or LD 
+ *
+ * Only the DWords set in valid were read. The rest are zero.
+ */
+struct fmapi_cfg_image 
+{
+	__u8 data[FM_CFG_SPACE_LEN];		//!< Configuration space, little endian 
+	__u8 valid[FM_CFG_SPACE_LEN/32];	//!< Bitmask of the DWords read 
+	unsigned num;						//!< Number of entries in cap 
+	struct fmapi_cfg_cap cap[FM_MAX_CFG_CAPS]; //!< Capabilities in list order 
+};
+
+/**
+ * Capabilities to read in a configuration space snapshot 
+ */
+struct fmapi_cfg_filter 
+{
+	const __u8 *cap;					//!< Capability IDs [PCI_CAP_ID_*] 
+	unsigned ncap;						//!< Number of entries in cap 
+	const __u16 *ext;					//!< Extended Capability IDs [PCI_EXT_CAP_ID_*] 
+	unsigned next;						//!< Number of entries in ext 
+};
+
+/**
+ * Cache of configuration space DWords of PPBs and LDs 
+ *
+ * Each port has a generation counter that every invalidation advances. A read 
+ * that was sent under an older generation is returned but not cached. 
+ */
+struct fmapi_cfg_cache 
+{
+	struct fmapi_session *s;			//!< Session misses and writes are sent on 
+	struct fmapi_cfg_image *img[FM_MAX_PORTS][FM_MAX_NUM_LD+1]; //!< Cached DWords of the PPB [0] and each LD [1+ldid]. NULL until first read
+	__u32 gen[FM_MAX_PORTS];			//!< Generation of each port 
+	unsigned long hits;					//!< DWords read from the cache 
+	unsigned long misses;				//!< DWords read from the device 
+};
+
+/**
+ * Waiter for the background operation of a device to finish 
+ */
+struct fmapi_bos_wait 
+{
+	__u16 opcode;						//!< Opcode of the command that started the operation. 0 for any
+	void (*cb)(struct fmapi_bos_wait *w); 	//!< Called on completion. May be NULL
+	void *arg;							//!< Caller data for cb 
+	int status;							//!< 0, or a negative enum _FMER. -FMER_INVALID if another operation finished last
+	__u16 rc;							//!< Return Code of the operation [FMRC] 
+	__u16 ext;							//!< Vendor Specific Extended Status of the operation 
+	int done;							//!< Set once the operation finished 
+	struct fmapi_bos_wait *next;		//!< Next waiter 
+};
+
+/**
+ * Shares one Background Operation Status poll of a device among its waiters 
+ *
+ * A device runs one background operation at a time, so every waiter is 
+ * completed by the poll that finds it finished. 
+ */
+struct fmapi_bos_poller 
+{
+	struct fmapi_session *s;			//!< Session polls are sent on 
+	struct fmapi_xfer x;				//!< Exchange of the poll 
+	struct fmapi_msg req;				//!< Background Operation Status request 
+	struct fmapi_msg rsp;				//!< Background Operation Status response 
+	int inflight;						//!< Set while a poll is outstanding 
+	struct fmapi_bos_wait *head;		//!< Oldest waiter 
+	struct fmapi_bos_wait *tail;		//!< Newest waiter 
+	unsigned min_ms;					//!< Shortest interval between polls 
+	unsigned max_ms;					//!< Longest interval between polls 
+	unsigned interval;					//!< Current interval between polls 
+	__u64 due;							//!< Time the next poll is due 
+	__u64 start;						//!< Time the first waiter arrived 
+	__u8 pcnt;							//!< Percent Complete last seen to advance 
+	__u64 pcnt_ms;						//!< Time pcnt was seen 
+	struct {
+		__u16 opcode;					//!< Opcode of a finished operation 
+		unsigned ms;					//!< How long it took. 0 if unused 
+	} hist[FM_BOS_HISTORY];				//!< Recent operation durations 
+	unsigned next_hist;					//!< Entry of hist to replace next 
+	unsigned polls;						//!< Number of polls sent 
+};
+
+/**
+ * Command sent through a struct fmapi_bos_sched 
+ */
+struct fmapi_bos_job 
+{
+	struct fmapi_msg *req;				//!< Request to send 
+	struct fmapi_msg *rsp;				//!< Message to decode the response into. May be NULL
+	void *param;						//!< param passed to fmapi_msg_decode() for the response 
+	void (*cb)(struct fmapi_bos_job *j); 	//!< Called on completion. May be NULL
+	void *arg;							//!< Caller data for cb 
+	int status;							//!< Return Code [FMRC] of the command or of its background operation, or negative enum _FMER
+	__u16 ext;							//!< Vendor Specific Extended Status 
+	int done;							//!< Set once the job completed 
+	int sent;							//!< Set while the request is outstanding or its operation runs 
+	unsigned tries;						//!< Times the request was sent 
+	struct fmapi_xfer x;				//!< Exchange of the request 
+	struct fmapi_bos_wait w;			//!< Wait for the background operation 
+	struct fmapi_bos_sched *sc;			//!< Scheduler the job was submitted on 
+	struct fmapi_bos_job *next;			//!< Next queued job 
+};
+
+/**
+ * Runs the commands of a device that may start a background operation one at 
+ * a time 
+ *
+ * A device runs one background operation at a time. Such commands are queued 
+ * and the next one is sent once the background operation of the last one 
+ * finished. Other commands are sent right away. 
+ */
+struct fmapi_bos_sched 
+{
+	struct fmapi_session *s;			//!< Session commands are sent on 
+	struct fmapi_bos_poller *p;			//!< Poller of the device 
+	struct fmapi_bos_job *cur;			//!< Background job being run 
+	struct fmapi_bos_job *head;			//!< Oldest queued background job 
+	struct fmapi_bos_job *tail;			//!< Newest queued background job 
+	unsigned sent;						//!< Background job requests sent 
+};
+
 /* GLOBAL VARIABLES ==========================================================*/
 
 /* PROTOTYPES ================================================================*/
@@ -1203,6 +1731,48 @@ struct fmapi_msg
  */
 int fmapi_deserialize(void *dst, __u8 *src, unsigned type, void *param);
 
+/**
+ * @brief Compute the serialized length of an object in a bounded byte array
+ *
+ * Every count field read from the source (e.g. psc_port_req.num or 
+ * mpc_mem_req.len) is checked against both the remaining source length and 
+ * the capacity of the destination object. No data is copied.
+ * 
+ * @param[in] src void Pointer to unsigned char array
+ * @param[in] len size_t Number of valid bytes in src
+ * @param[in] type unsigned enum _FMOB representing type of object to check 
+ * @param[in] param void * to data needed to deserialize the byte stream 
+ * @return serialized length of the object, or a negative enum _FMER upon error
+ */
+int fmapi_check_len(__u8 *src, size_t len, unsigned type, void *param);
+
+/**
+ * @brief Convert from a Little Endian byte array to a struct, bounded by len
+ *
+ * The source is validated with fmapi_check_len() before any data is copied.
+ * 
+ * @param[out] dst void Pointer to destination struct
+ * @param[in] src void Pointer to unsigned char array
+ * @param[in] len size_t Number of valid bytes in src
+ * @param[in] type unsigned enum _FMOB representing type of object to deserialize
+ * @param[in] param void * to data needed to deserialize the byte stream 
+ * @return number of bytes consumed, or a negative enum _FMER upon error
+ */
+int fmapi_deserialize_len(void *dst, __u8 *src, size_t len, unsigned type, void *param);
+
+/**
+ * @brief Decode a Get Physical Port State Response into a table of columns
+ *
+ * The port info blocks are transposed 16 (SSE2, NEON) or 32 (AVX2) ports at a 
+ * time when the target supports it. 
+ *
+ * @param[out] t struct fmapi_psc_port_table* to fill 
+ * @param[in] src __u8* Serialized FMOB_PSC_PORT_RSP payload 
+ * @param[in] len size_t Number of valid bytes in src
+ * @return number of bytes consumed, or a negative enum _FMER upon error
+ */
+int fmapi_deserialize_port_table(struct fmapi_psc_port_table *t, __u8 *src, size_t len);
+
 /**
  * Convenience function to populate a fmapi_hdr object 
  *
@@ -1262,6 +1832,14 @@ int fmapi_fill_vsc_bind(struct fmapi_msg *m, int vcsid, int vppbid, int ppid, in
 int fmapi_fill_vsc_get_vcs(struct fmapi_msg *m, int vcsid, int start, int limit);
 int fmapi_fill_vsc_unbind(struct fmapi_msg *m, int vcsid, int vppbid, int option); 
 
+/**
+ * Look up the static description of an FM API Message Opcode [FMOP]
+ *
+ * @param	opcode 	This is an FM API Opcode [FMOP]
+ * @return	struct fmapi_opcode_info* for the opcode, or NULL if the opcode is unknown
+ */
+const struct fmapi_opcode_info *fmapi_opcode_info(unsigned int opcode);
+
 /**
  * Determine the Request Object Identifier [FMOB] for an FM API Message Opcode [FMOP]
  *
@@ -1279,46 +1857,1644 @@ int fmapi_fmob_req(unsigned int opcode);
 int fmapi_fmob_rsp(unsigned int opcode);
 
 /**
- * @brief Convert an object into Little Endian byte array format
- * 
- * @param[out] dst void Pointer to destination unsigned char array
- * @param[in] src void Pointer to object to serialize
- * @param[in] type unsigned enum _FMOB representing type of object to serialize
- * @return number of serialized bytes, 0 if error 
+ * Size in bytes of a right sized struct fmapi_msg holding an object [FMOB]
+ *
+ * num only trims the list of request objects. Every other object is sized to 
+ * its full capacity. 
+ *
+ * @param	type 	enum _FMOB of the object the message will hold, or FMOB_MAX 
+ * 					for a full struct fmapi_msg that can hold any object
+ * @param	num 	Number of entries in the trailing variable length list of a 
+ * 					request object. 0 sizes the list to its full capacity
+ * @return	size_t	Size in bytes. 0 if type is invalid 
  */
-int fmapi_serialize(__u8 *dst, void *src, unsigned type);
+size_t fmapi_msg_size(unsigned type, unsigned num);
 
 /**
- * Print an object to the screen
+ * Allocate a struct fmapi_msg sized for one FM API Object [FMOB]
  *
- * @param ptr A pointer to the object to print 
- * @param type The type of object to be printed from enum _FMOB
+ * Only the hdr, buf and the obj union member for the requested type are 
+ * valid in the returned message. A message that fmapi_msg_decode() or a 
+ * receive path decodes into must be allocated with type FMOB_MAX. 
+ *
+ * @param	type 	enum _FMOB of the object the message will hold, or FMOB_MAX
+ * @param	num 	Number of entries in the trailing variable length list of a 
+ * 					request object. 0 sizes the list to its full capacity
+ * @return	struct fmapi_msg* Zeroed message, NULL upon error. Free with fmapi_msg_free()
  */
-void fmapi_prnt(void *ptr, unsigned type);        
+struct fmapi_msg *fmapi_msg_alloc(unsigned type, unsigned num);
 
-/* Functions to return a string representation of an object*/
-const char *fmbs(unsigned int u);
-const char *fmct(unsigned int u);
-const char *fmdt(unsigned int u);
-const char *fmdv(unsigned int u);
-const char *fmet(unsigned int u);
-const char *fmlf(unsigned int u);
-const char *fmlo(unsigned int u);
-const char *fmls(unsigned int u);
-const char *fmmg(unsigned int u);
-const char *fmmr(unsigned int u);
-const char *fmms(unsigned int u);
-const char *fmmt(unsigned int u);
-const char *fmnw(unsigned int u);
-const char *fmop(unsigned int u);
-const char *fmpo(unsigned int u);
-const char *fmps(unsigned int u);
-const char *fmqt(unsigned int u);
-const char *fmrc(unsigned int u);
-const char *fmss(unsigned int u);
-const char *fmub(unsigned int u);
-const char *fmvc(unsigned int u);
-const char *fmvs(unsigned int u);
-const char *fmvt(unsigned int u);
+/**
+ * Allocate a struct fmapi_msg sized for the payload of an FM API Opcode [FMOP]
+ *
+ * A response is always allocated as a full struct fmapi_msg. 
+ *
+ * @param	opcode 		FM API Opcode [FMOP]
+ * @param	category 	Request or Response [FMMT]
+ * @param	num 		Number of entries in the trailing variable length list of 
+ * 						a request. 0 sizes the list to its full capacity
+ * @return	struct fmapi_msg* Zeroed message with hdr.opcode and hdr.category set.
+ * 						NULL upon error. Free with fmapi_msg_free()
+ */
+struct fmapi_msg *fmapi_msg_alloc_op(unsigned opcode, unsigned category, unsigned num);
+
+/**
+ * Free a message allocated with fmapi_msg_alloc() or fmapi_msg_alloc_op()
+ *
+ * @param	m 	struct fmapi_msg* to free. May be NULL
+ */
+void fmapi_msg_free(struct fmapi_msg *m);
+
+/**
+ * Create a pool of preallocated messages 
+ *
+ * Each message is followed by its own struct fmapi_buf and both are cache line 
+ * aligned. Every thread keeps a private cache of free messages and exchanges 
+ * whole batches with a lock free depot shared by all threads, so getting and 
+ * putting messages does not allocate or take a lock. 
+ *
+ * @param	num 	Number of messages in the pool 
+ * @param	batch 	Number of messages moved between a thread cache and the depot 
+ * 					at once. 0 selects a default
+ * @return	struct fmapi_msg_pool* upon success, NULL upon error
+ */
+struct fmapi_msg_pool *fmapi_msg_pool_create(unsigned num, unsigned batch);
+
+/**
+ * Free a message pool and all of its messages 
+ *
+ * No other thread may be using the pool or any of its messages 
+ *
+ * @param	p 	struct fmapi_msg_pool* to free. May be NULL
+ */
+void fmapi_msg_pool_free(struct fmapi_msg_pool *p);
+
+/**
+ * Get a message from a pool 
+ *
+ * The hdr of the returned message is cleared and buf points to the struct 
+ * fmapi_buf of the message. The obj union is not cleared. 
+ *
+ * @param	p 	struct fmapi_msg_pool* to get the message from
+ * @return	struct fmapi_msg* upon success, NULL if the pool is exhausted 
+ */
+struct fmapi_msg *fmapi_msg_get(struct fmapi_msg_pool *p);
+
+/**
+ * Return a message obtained with fmapi_msg_get() to its pool 
+ *
+ * Messages may be returned by a different thread than the one that got them
+ *
+ * @param	p 	struct fmapi_msg_pool* the message was taken from
+ * @param	m 	struct fmapi_msg* to return. May be NULL
+ */
+void fmapi_msg_put(struct fmapi_msg_pool *p, struct fmapi_msg *m);
+
+/**
+ * Initialize a transaction arena 
+ *
+ * @param	a 		struct fmapi_arena* to initialize
+ * @param	buf 	Backing storage for the arena. NULL to allocate cap bytes 
+ * @param	cap 	Size of buf in bytes 
+ * @return	0 upon success, negative enum _FMER upon error
+ */
+int fmapi_arena_init(struct fmapi_arena *a, void *buf, size_t cap);
+
+/**
+ * Release the storage of an arena allocated by fmapi_arena_init()
+ *
+ * @param	a 	struct fmapi_arena* to free. May be NULL
+ */
+void fmapi_arena_free(struct fmapi_arena *a);
+
+/**
+ * Release every object of an arena at once 
+ *
+ * @param	a 	struct fmapi_arena* to reset
+ */
+void fmapi_arena_reset(struct fmapi_arena *a);
+
+/**
+ * Carve a cache line aligned block from an arena
+ *
+ * @param	a 		struct fmapi_arena* to allocate from
+ * @param	size 	Number of bytes 
+ * @return	void* to the block, NULL if the arena is exhausted. Not cleared
+ */
+void *fmapi_arena_alloc(struct fmapi_arena *a, size_t size);
+
+/**
+ * Carve a right sized struct fmapi_msg from an arena 
+ *
+ * Same sizing rules as fmapi_msg_alloc(). A type of FMOB_MAX carves a full 
+ * struct fmapi_msg that can hold any object, e.g. to decode a response into. 
+ *
+ * @param	a 		struct fmapi_arena* to allocate from
+ * @param	type 	enum _FMOB of the object the message will hold, or FMOB_MAX
+ * @param	num 	Number of entries in the trailing variable length list of a 
+ * 					request object. 0 sizes the list to its full capacity
+ * @param	buf 	Non zero to also carve a struct fmapi_buf and point m->buf at it
+ * @return	struct fmapi_msg* Zeroed message, NULL upon error 
+ */
+struct fmapi_msg *fmapi_arena_msg(struct fmapi_arena *a, unsigned type, unsigned num, int buf);
+
+/**
+ * Carve a right sized struct fmapi_msg for an FM API Opcode [FMOP] from an arena 
+ *
+ * A response is always carved as a full struct fmapi_msg. 
+ *
+ * @param	a 			struct fmapi_arena* to allocate from
+ * @param	opcode 		FM API Opcode [FMOP]
+ * @param	category 	Request or Response [FMMT]
+ * @param	num 		Number of entries in the trailing variable length list of 
+ * 						a request. 0 sizes the list to its full capacity
+ * @param	buf 		Non zero to also carve a struct fmapi_buf and point m->buf at it
+ * @return	struct fmapi_msg* Zeroed message with hdr.opcode and hdr.category set.
+ * 						NULL upon error
+ */
+struct fmapi_msg *fmapi_arena_msg_op(struct fmapi_arena *a, unsigned opcode, unsigned category, unsigned num, int buf);
+
+/**
+ * @brief Convert an object into Little Endian byte array format
+ * 
+ * @param[out] dst void Pointer to destination unsigned char array
+ * @param[in] src void Pointer to object to serialize
+ * @param[in] type unsigned enum _FMOB representing type of object to serialize
+ * @return number of serialized bytes, 0 if error 
+ */
+int fmapi_serialize(__u8 *dst, void *src, unsigned type);
+
+/**
+ * Compute the serialized length of an object without serializing it
+ *
+ * @param[in] src void Pointer to object 
+ * @param[in] type unsigned enum _FMOB representing type of object
+ * @return number of bytes fmapi_serialize() would write, 0 if error 
+ */
+int fmapi_wire_len(void *src, unsigned type);
+
+/**
+ * @brief Serialize an FM API Header and object into a scatter-gather list
+ *
+ * The header and the object are serialized into scratch. For objects that 
+ * carry a bulk data block (FMOB_MPC_MEM_REQ, FMOB_MPC_MEM_RSP, 
+ * FMOB_MPC_TMC_REQ, FMOB_MPC_TMC_RSP) only the fixed portion goes into scratch 
+ * and a second entry points at the bulk data, so it is never copied. 
+ *
+ * hdr->len is set to the serialized length of the object.
+ *
+ * @param[out] iov struct iovec* array to fill 
+ * @param[in] cnt int Number of entries in iov. 2 is always sufficient
+ * @param[out] scratch __u8* Buffer for the serialized header and object 
+ * @param[in] cap size_t Size of scratch in bytes 
+ * @param[in] hdr struct fmapi_hdr* to serialize 
+ * @param[in] src void Pointer to object to serialize 
+ * @param[in] type unsigned enum _FMOB representing type of object to serialize
+ * @param[in] data const void* Bulk data block to send instead of the one 
+ * 				stored in the object. NULL to use the object's own block
+ * @return number of iov entries used, or a negative enum _FMER upon error
+ */
+int fmapi_serialize_iov(struct iovec *iov, int cnt, __u8 *scratch, size_t cap, struct fmapi_hdr *hdr, void *src, unsigned type, const void *data);
+
+/**
+ * @brief Encode an FM API Message into a complete wire frame 
+ *
+ * The object type is chosen from the opcode and category using the opcode 
+ * registry. An unknown opcode is rejected with FMER_INVALID, as 
+ * fmapi_msg_decode() does. m->hdr.category, m->hdr.tag and m->hdr.len are 
+ * updated. 
+ *
+ * @param[in,out] m struct fmapi_msg* to encode 
+ * @param[out] dst __u8* Destination buffer 
+ * @param[in] cap size_t Size of dst in bytes 
+ * @param[in] category __u8 Request or Response [FMMT]
+ * @param[in] tag __u8 Tag used to match the response to the request 
+ * @return number of bytes written, or a negative enum _FMER upon error
+ */
+int fmapi_msg_encode(struct fmapi_msg *m, __u8 *dst, size_t cap, __u8 category, __u8 tag);
+
+/**
+ * @brief Encode an FM API Message wrapped in one or more Tunnel Management Commands
+ *
+ * Each tunnel header and prefix is written once at its final offset, the 
+ * inner message is encoded directly behind the innermost prefix, and the 
+ * lengths of every level are patched in afterwards. The inner message is 
+ * never copied. hops[0] is the outermost tunnel (e.g. switch port to MLD) 
+ * and hops[num-1] the innermost (e.g. MLD to LD). 
+ *
+ * For requests the ppid and type of obj.mpc_tmc_req of each hop are used, 
+ * for responses the type of obj.mpc_tmc_rsp. The opcode, category, tag and 
+ * len of every hop header and the len of every tunnel object are updated. 
+ * The outermost header carries tag, inner headers use tag 0.
+ *
+ * @param[in,out] hops struct fmapi_msg** Tunnel messages from outermost to innermost
+ * @param[in] num unsigned Number of entries in hops
+ * @param[in,out] m struct fmapi_msg* Inner message to encode 
+ * @param[out] dst __u8* Destination buffer 
+ * @param[in] cap size_t Size of dst in bytes 
+ * @param[in] category __u8 Request or Response [FMMT]
+ * @param[in] tag __u8 Tag used to match the response to the request 
+ * @return number of bytes written, or a negative enum _FMER upon error
+ */
+int fmapi_msg_encode_tunnel(struct fmapi_msg **hops, unsigned num, struct fmapi_msg *m, __u8 *dst, size_t cap, __u8 category, __u8 tag);
+
+/**
+ * @brief Decode a complete wire frame into an FM API Message 
+ *
+ * The payload is bounded by the header length field and by len. An unknown 
+ * opcode is rejected with FMER_INVALID, a payload shorter than the opcode 
+ * allows with FMER_TRUNCATED and a longer one with FMER_OVERFLOW. m->buf is 
+ * left alone. Callers that want the raw frame keep src. 
+ *
+ * @param[out] m struct fmapi_msg* to fill
+ * @param[in] src __u8* Serialized FM API Message (header and payload)
+ * @param[in] len size_t Number of valid bytes in src
+ * @param[in] param void * to data needed to deserialize the payload 
+ * @return number of bytes consumed, or a negative enum _FMER upon error
+ */
+int fmapi_msg_decode(struct fmapi_msg *m, __u8 *src, size_t len, void *param);
+
+/**
+ * @brief Encode a batch of FM API Messages back to back into one buffer 
+ *
+ * Message i is encoded as a complete frame with tag (tag + i) at offset 
+ * offs[i] of dst. offs[n] is set to the end of the last frame, where n is the 
+ * number of messages encoded. 
+ *
+ * @param[in,out] msgs struct fmapi_msg** Array of num messages to encode 
+ * @param[in] num unsigned Number of messages 
+ * @param[out] dst __u8* Destination buffer 
+ * @param[in] cap size_t Size of dst in bytes 
+ * @param[in] category __u8 Request or Response [FMMT]
+ * @param[in] tag __u8 Tag of the first message 
+ * @param[out] offs size_t* Array of num + 1 frame offsets. May be NULL
+ * @return number of messages encoded, which is less than num if dst is full, 
+ * 			or a negative enum _FMER upon error
+ */
+int fmapi_encode_batch(struct fmapi_msg **msgs, unsigned num, __u8 *dst, size_t cap, __u8 category, __u8 tag, size_t *offs);
+
+/**
+ * @brief Decode a batch of back to back FM API Messages 
+ *
+ * @param[out] msgs struct fmapi_msg** Array of num messages to decode into 
+ * @param[in] num unsigned Number of messages 
+ * @param[in] src __u8* Serialized frames 
+ * @param[in] len size_t Number of valid bytes in src
+ * @param[out] offs size_t* Array of num + 1 frame offsets. May be NULL
+ * @param[in] param void * passed to fmapi_deserialize_len() for every frame 
+ * @return number of messages decoded, or a negative enum _FMER if a frame is 
+ * 			malformed 
+ */
+int fmapi_decode_batch(struct fmapi_msg **msgs, unsigned num, __u8 *src, size_t len, size_t *offs, void *param);
+
+/**
+ * Initialize a streaming parser 
+ *
+ * @param[out] p struct fmapi_parser* to initialize 
+ * @param[in] buf __u8* Buffer for a partially received message 
+ * @param[in] cap size_t Size of buf. Messages longer than this are rejected
+ * @param[in] m struct fmapi_msg* to decode each frame into. May be NULL
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_parser_init(struct fmapi_parser *p, __u8 *buf, size_t cap, struct fmapi_msg *m);
+
+/**
+ * Discard any partially received message 
+ */
+void fmapi_parser_reset(struct fmapi_parser *p);
+
+/**
+ * @brief Feed a chunk of a byte stream to the parser 
+ *
+ * cb is called once for every complete message, in stream order. Messages 
+ * that lie entirely within chunk are passed to cb in place without copying. 
+ * Only the bytes of a message split across chunks are copied into the parser 
+ * buffer. When the parser has a struct fmapi_msg the frame is decoded into it 
+ * with fmapi_msg_decode() and passed as m. m is NULL if there is no message 
+ * or the frame could not be decoded without a param. 
+ *
+ * @param[in] p struct fmapi_parser* 
+ * @param[in] chunk __u8* Bytes received 
+ * @param[in] len size_t Number of bytes in chunk
+ * @param[in] cb Function called for each complete frame 
+ * @param[in] arg void* passed to cb 
+ * @return number of complete messages, or a negative enum _FMER upon error. 
+ * 			On error the parser is reset as the stream can no longer be framed
+ */
+int fmapi_parser_feed(struct fmapi_parser *p, __u8 *chunk, size_t len, void (*cb)(void *arg, struct fmapi_msg *m, __u8 *frame, size_t len), void *arg);
+
+/**
+ * Get the free space at the end of the parser buffer to receive into 
+ *
+ * Use with fmapi_parser_commit() and fmapi_parser_next() to read directly 
+ * into the parser buffer. 
+ *
+ * @param[in] p struct fmapi_parser* 
+ * @param[out] avail size_t* Set to the number of free bytes 
+ * @return __u8* Pointer to the free space 
+ */
+__u8 *fmapi_parser_space(struct fmapi_parser *p, size_t *avail);
+
+/**
+ * Mark n bytes received into the space returned by fmapi_parser_space()
+ */
+void fmapi_parser_commit(struct fmapi_parser *p, size_t n);
+
+/**
+ * @brief Get the next complete frame from the parser buffer 
+ *
+ * The frame stays valid until the next call to fmapi_parser_space() or 
+ * fmapi_parser_feed(). 
+ *
+ * @param[in] p struct fmapi_parser* 
+ * @param[out] frame __u8** Set to the start of the frame 
+ * @return length of the frame, 0 if no complete frame is buffered, or a 
+ * 			negative enum _FMER upon error
+ */
+int fmapi_parser_next(struct fmapi_parser *p, __u8 **frame);
+
+/**
+ * Check whether a complete frame is buffered without consuming it 
+ *
+ * @param[in] p struct fmapi_parser* 
+ * @return 1 if fmapi_parser_next() would return a frame or an error, 0 otherwise
+ */
+int fmapi_parser_ready(struct fmapi_parser *p);
+
+/**
+ * Send one FM API frame over a transport 
+ *
+ * Blocks until the whole frame is written. On a non blocking socket the send 
+ * waits up to t->send_ms for the peer to make room and fails with 
+ * FMER_TIMEOUT after that. Part of the frame may then have been sent on a 
+ * stream socket, so the transport must be closed. 
+ *
+ * @param[in] t struct fmapi_transport* 
+ * @param[in] iov const struct iovec* Frame split into cnt pieces 
+ * @param[in] cnt int Number of entries in iov 
+ * @return number of bytes sent, or a negative enum _FMER upon error
+ */
+int fmapi_transport_send(struct fmapi_transport *t, const struct iovec *iov, int cnt);
+
+/**
+ * Receive one FM API frame from a transport 
+ *
+ * Blocks on a blocking socket. Returns 0 on a non blocking socket when no 
+ * complete frame has arrived yet. 
+ *
+ * @param[in] t struct fmapi_transport* 
+ * @param[out] frame __u8** Set to the frame. Valid until the next receive 
+ * @return length of the frame, 0 if none is available, or a negative enum _FMER upon error
+ */
+int fmapi_transport_recv(struct fmapi_transport *t, __u8 **frame);
+
+/**
+ * File descriptor that becomes readable when a transport has data 
+ *
+ * @param[in] t struct fmapi_transport* 
+ * @return file descriptor, or -1 if the transport has none 
+ */
+int fmapi_transport_poll_fd(struct fmapi_transport *t);
+
+/**
+ * Let a transport receive frames of up to len bytes 
+ *
+ * The receive buffer only grows. Bytes already received are kept. Frames 
+ * longer than FMLN_MSG can only be read with fmapi_transport_recv() since 
+ * they do not fit in a struct fmapi_msg. 
+ *
+ * @param[in] t struct fmapi_transport* 
+ * @param[in] len size_t Length of the largest frame including the FM API Header, 
+ * 				up to 2^FM_MSG_LIMIT_MAX
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_transport_set_max(struct fmapi_transport *t, size_t len);
+
+/**
+ * Close a transport and release its memory 
+ *
+ * @param[in] t struct fmapi_transport* May be NULL
+ */
+void fmapi_transport_close(struct fmapi_transport *t);
+
+/**
+ * Encode and send an FM API Message 
+ *
+ * The header and fixed portion of the object are serialized into the 
+ * transport scratch buffer and bulk data (tunneled commands and LD memory 
+ * data) is sent straight from the message with fmapi_serialize_iov(). 
+ * m->hdr.category, m->hdr.tag and m->hdr.len are updated. Blocks like 
+ * fmapi_transport_send(). 
+ *
+ * @param[in] t struct fmapi_transport* 
+ * @param[in,out] m struct fmapi_msg* to send 
+ * @param[in] category __u8 Request or Response [FMMT]
+ * @param[in] tag __u8 Tag used to match the response to the request 
+ * @return number of bytes sent, or a negative enum _FMER upon error
+ */
+int fmapi_transport_send_msg(struct fmapi_transport *t, struct fmapi_msg *m, __u8 category, __u8 tag);
+
+/**
+ * Receive and decode an FM API Message 
+ *
+ * m->buf is left alone. Use fmapi_transport_recv() and fmapi_msg_decode() to 
+ * also keep the raw frame 
+ *
+ * @param[in] t struct fmapi_transport* 
+ * @param[out] m struct fmapi_msg* to decode into 
+ * @param[in] param void * passed to fmapi_msg_decode()
+ * @return length of the frame, 0 if none is available, or a negative enum _FMER upon error
+ */
+int fmapi_transport_recv_msg(struct fmapi_transport *t, struct fmapi_msg *m, void *param);
+
+/**
+ * Wrap a connected AF_UNIX socket in a transport 
+ *
+ * The transport owns fd and closes it. 
+ *
+ * @param[in] fd int Connected socket 
+ * @return struct fmapi_transport* upon success, NULL upon error 
+ */
+struct fmapi_transport *fmapi_transport_unix_fd(int fd);
+
+/**
+ * Create a listening AF_UNIX socket 
+ *
+ * An existing socket file at path is removed first. 
+ *
+ * @param[in] path const char* Filesystem path of the socket 
+ * @param[in] type int SOCK_STREAM or SOCK_SEQPACKET 
+ * @return listening file descriptor, or a negative enum _FMER upon error
+ */
+int fmapi_transport_unix_listen(const char *path, int type);
+
+/**
+ * Accept a connection on a socket from fmapi_transport_unix_listen() 
+ *
+ * @param[in] lfd int Listening file descriptor 
+ * @return struct fmapi_transport* upon success, NULL upon error 
+ */
+struct fmapi_transport *fmapi_transport_unix_accept(int lfd);
+
+/**
+ * Connect to an AF_UNIX socket 
+ *
+ * @param[in] path const char* Filesystem path of the socket 
+ * @param[in] type int SOCK_STREAM or SOCK_SEQPACKET 
+ * @return struct fmapi_transport* upon success, NULL upon error 
+ */
+struct fmapi_transport *fmapi_transport_unix_connect(const char *path, int type);
+
+/**
+ * Create a connected pair of loopback transports 
+ *
+ * @param[in] type int SOCK_STREAM or SOCK_SEQPACKET 
+ * @param[out] a struct fmapi_transport** First end 
+ * @param[out] b struct fmapi_transport** Second end 
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_transport_unix_pair(int type, struct fmapi_transport **a, struct fmapi_transport **b);
+
+/**
+ * Initialize a timer wheel 
+ *
+ * @param[out] w struct fmapi_timer_wheel* to initialize 
+ * @param[in] now __u64 Current tick 
+ */
+void fmapi_timer_wheel_init(struct fmapi_timer_wheel *w, __u64 now);
+
+/**
+ * Arm a timer, replacing any earlier expiry 
+ *
+ * @param[in] w struct fmapi_timer_wheel* 
+ * @param[in] t struct fmapi_timer* to arm 
+ * @param[in] expires __u64 Tick at which the timer fires 
+ */
+void fmapi_timer_arm(struct fmapi_timer_wheel *w, struct fmapi_timer *t, __u64 expires);
+
+/**
+ * Disarm a timer. Does nothing if the timer is not armed
+ *
+ * @param[in] w struct fmapi_timer_wheel* 
+ * @param[in] t struct fmapi_timer* to disarm 
+ */
+void fmapi_timer_cancel(struct fmapi_timer_wheel *w, struct fmapi_timer *t);
+
+/**
+ * Turn the wheel up to now and fire every timer that expired 
+ *
+ * Each expired timer is disarmed before fn is called, so fn may arm it again
+ *
+ * @param[in] w struct fmapi_timer_wheel* 
+ * @param[in] now __u64 Current tick 
+ * @param[in] fn Function called for each expired timer 
+ * @param[in] arg void* passed to fn 
+ * @return number of timers fired
+ */
+int fmapi_timer_wheel_advance(struct fmapi_timer_wheel *w, __u64 now, void (*fn)(void *arg, struct fmapi_timer *t), void *arg);
+
+/**
+ * Tick by which fmapi_timer_wheel_advance() must be called next 
+ *
+ * This is the expiry of the earliest timer or an earlier tick at which 
+ * timers of a higher level are cascaded down. 
+ *
+ * @param[in] w struct fmapi_timer_wheel* 
+ * @return tick, or ~0 if no timer is armed
+ */
+__u64 fmapi_timer_wheel_next(struct fmapi_timer_wheel *w);
+
+/**
+ * Current time in milliseconds from a monotonic clock, as used for session timers
+ *
+ * @return __u64 milliseconds 
+ */
+__u64 fmapi_now_ms(void);
+
+/**
+ * Initialize a session 
+ *
+ * @param[out] s struct fmapi_session* to initialize 
+ * @param[in] t struct fmapi_transport* to the endpoint 
+ * @param[in] window unsigned Maximum number of outstanding requests, 
+ * 				1 to FM_MAX_TAGS. 0 selects FM_MAX_TAGS
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_session_init(struct fmapi_session *s, struct fmapi_transport *t, unsigned window);
+
+/**
+ * Change the number of requests that may be outstanding 
+ *
+ * Lowering the window does not affect requests already in flight
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] window unsigned 1 to FM_MAX_TAGS. 0 selects FM_MAX_TAGS
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_session_set_window(struct fmapi_session *s, unsigned window);
+
+/**
+ * Assign a tag to an exchange and send its request 
+ *
+ * A request whose payload is longer than s->req_limit is refused without 
+ * being sent since the endpoint would drop it. 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in,out] x struct fmapi_xfer* with req set. Must stay valid until done
+ * @return tag assigned to the request, -FMER_BUSY if the window is full, 
+ * 			-FMER_OVERFLOW if the request is longer than s->req_limit, or 
+ * 			another negative enum _FMER upon error
+ */
+int fmapi_session_submit(struct fmapi_session *s, struct fmapi_xfer *x);
+
+/**
+ * Receive one response and complete the exchange it belongs to 
+ *
+ * Blocks on a blocking transport. The response is matched to its request by 
+ * tag. Responses that match no outstanding request are dropped. Responses 
+ * with a return code the retry policy retries schedule a resend instead of 
+ * completing the exchange. 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @return 1 if an exchange completed, 0 if not, or a negative enum _FMER 
+ * 			upon a transport error 
+ */
+int fmapi_session_poll(struct fmapi_session *s);
+
+/**
+ * Wait for an exchange to complete 
+ *
+ * Responses to other exchanges that arrive first are completed on the way. 
+ * On a transport error every outstanding exchange is failed. 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] x struct fmapi_xfer* submitted on s 
+ * @return x->status
+ */
+int fmapi_session_wait(struct fmapi_session *s, struct fmapi_xfer *x);
+
+/**
+ * Send a request and wait for its response 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] req struct fmapi_msg* Request to send 
+ * @param[out] rsp struct fmapi_msg* to decode the response into. May be NULL
+ * @param[in] param void * passed to fmapi_msg_decode() for the response 
+ * @return Response return code [FMRC], or a negative enum _FMER upon error
+ */
+int fmapi_session_call(struct fmapi_session *s, struct fmapi_msg *req, struct fmapi_msg *rsp, void *param);
+
+/**
+ * Allocate the slots of a pipe 
+ *
+ * @param[out] p struct fmapi_pipe* to initialize 
+ * @param[in] s struct fmapi_session* to send requests on 
+ * @param[in] depth unsigned Maximum number of requests in flight. 0 selects a default 
+ * @param[in] size size_t Size of one slot, which starts with a struct fmapi_pipe_slot 
+ * @param[in] next Fills the next request into a slot. Returns 0 when none is left 
+ * @param[in] arg void* Caller data for next 
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_pipe_init(struct fmapi_pipe *p, struct fmapi_session *s, unsigned depth, size_t size, int (*next)(struct fmapi_pipe *p, struct fmapi_pipe_slot *sl), void *arg);
+
+/**
+ * Send every request next() produces and wait for them all 
+ *
+ * The window is kept full until next() returns 0, then drained. Once an 
+ * exchange fails no further request is sent. May be called again after 
+ * the state next() reads changed. 
+ *
+ * @param[in] p struct fmapi_pipe* 
+ * @return 0 upon success, the first non zero Response return code [FMRC], 
+ * 			or a negative enum _FMER upon error
+ */
+int fmapi_pipe_run(struct fmapi_pipe *p);
+
+/**
+ * Release the slots of a pipe 
+ *
+ * @param[in] p struct fmapi_pipe* with nothing in flight 
+ */
+void fmapi_pipe_free(struct fmapi_pipe *p);
+
+/**
+ * Agree on message sizes with the endpoint 
+ *
+ * STEPS 
+ * 1: Identify to learn the largest message the endpoint supports 
+ * 2: Set Response Message Limit to the largest size both sides support 
+ * 3: Size the receive buffer of the transport and the request and response 
+ * 	  limits of the session used by pagination and coalescing 
+ *
+ * Sizes are 2^n bytes and include the 12 byte FM API Header. Optional: a 
+ * session that skips it assumes FMLN_MSG. 
+ *
+ * @param[in] s struct fmapi_session* with no request outstanding 
+ * @param[in] max size_t Largest message this side accepts. 0 selects FMLN_MSG
+ * @return 0 upon success, a non zero Response return code [FMRC], or a 
+ * 			negative enum _FMER upon error
+ */
+int fmapi_session_negotiate(struct fmapi_session *s, size_t max);
+
+/**
+ * Fire expired timers, then wait for and process one frame 
+ *
+ * The wait ends early when the next session timer is due. Used to make 
+ * progress while waiting on something other than one exchange. 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @return 1 if an exchange completed, 0 if not, or a negative enum _FMER 
+ */
+int fmapi_session_step(struct fmapi_session *s);
+
+/**
+ * Like fmapi_session_step() but wait no longer than ms 
+ *
+ * Used to make progress while something else falls due at a known time. 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] ms int Longest wait in milliseconds, or -1 for no limit 
+ * @return 1 if an exchange completed, 0 if not, or a negative enum _FMER 
+ */
+int fmapi_session_step_ms(struct fmapi_session *s, int ms);
+
+/**
+ * Set the timeout and retry policy of a session 
+ *
+ * Applies to requests submitted afterwards. The policy is not copied and 
+ * must stay valid while the session uses it. 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] policy const struct fmapi_retry_policy* NULL to disable timeouts and retries
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_session_set_policy(struct fmapi_session *s, const struct fmapi_retry_policy *policy);
+
+/**
+ * Number of list entries that fit in one response of a session 
+ *
+ * Used to size port queries and list pages. At least one entry is always 
+ * allowed so a read can make progress when the response limit is smaller 
+ * than one entry, and at most FM_MAX_LIST as the count fields are 8 bits. 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] fixed unsigned Length of the response before the list 
+ * @param[in] entry unsigned Length of one list entry 
+ * @return number of entries 
+ */
+unsigned fmapi_session_list_max(struct fmapi_session *s, unsigned fixed, unsigned entry);
+
+/**
+ * Fire the session timers that expired 
+ *
+ * Called by fmapi_session_wait() and fmapi_session_call(). Callers running 
+ * their own event loop call it when fmapi_session_timeout() elapses. 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @return number of timers fired 
+ */
+int fmapi_session_expire(struct fmapi_session *s);
+
+/**
+ * Milliseconds until the next session timer may fire 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @return milliseconds, or -1 if no timer is armed. Suitable for poll()
+ */
+int fmapi_session_timeout(struct fmapi_session *s);
+
+/**
+ * Complete every outstanding exchange with an error 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] status int Negative enum _FMER stored in each exchange
+ */
+void fmapi_session_fail(struct fmapi_session *s, int status);
+
+/**
+ * Initialize a port query coalescer 
+ *
+ * @param[out] c struct fmapi_port_coalescer* to initialize 
+ * @param[in] s struct fmapi_session* to send requests on 
+ * @param[in] hold_ms unsigned Longest time a query waits for others. 0 sends 
+ * 				queries only when a batch is full or on fmapi_port_coalescer_flush()
+ * @param[in] nbatch unsigned Maximum number of requests in flight. 0 selects 1
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_port_coalescer_init(struct fmapi_port_coalescer *c, struct fmapi_session *s, unsigned hold_ms, unsigned nbatch);
+
+/**
+ * Release the batches of a coalescer 
+ *
+ * No query may be pending or in flight 
+ *
+ * @param[in] c struct fmapi_port_coalescer* 
+ */
+void fmapi_port_coalescer_free(struct fmapi_port_coalescer *c);
+
+/**
+ * Queue a Get Physical Port State query 
+ *
+ * The query is sent once enough ports are pending to fill a request, when 
+ * hold_ms elapses, or on fmapi_port_coalescer_flush(). 
+ *
+ * @param[in] c struct fmapi_port_coalescer* 
+ * @param[in,out] q struct fmapi_port_query* with ppid set 
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_port_query_submit(struct fmapi_port_coalescer *c, struct fmapi_port_query *q);
+
+/**
+ * Wait for a query to complete 
+ *
+ * A pending query is sent right away since its caller is blocked on it 
+ *
+ * @param[in] c struct fmapi_port_coalescer* 
+ * @param[in] q struct fmapi_port_query* submitted on c 
+ * @return q->status 
+ */
+int fmapi_port_query_wait(struct fmapi_port_coalescer *c, struct fmapi_port_query *q);
+
+/**
+ * Query the state of several ports and wait for all of them 
+ *
+ * @param[in] c struct fmapi_port_coalescer* 
+ * @param[in,out] q struct fmapi_port_query* Array with ppid set in each entry 
+ * @param[in] num unsigned Number of entries in q 
+ * @return 0 upon success, or the first non zero status of q 
+ */
+int fmapi_port_query_all(struct fmapi_port_coalescer *c, struct fmapi_port_query *q, unsigned num);
+
+/**
+ * Send every pending query 
+ *
+ * @param[in] c struct fmapi_port_coalescer* 
+ * @return number of requests sent, -FMER_BUSY if queries remain pending because 
+ * 			no batch or tag is free, or another negative enum _FMER upon error
+ */
+int fmapi_port_coalescer_flush(struct fmapi_port_coalescer *c);
+
+/**
+ * Send the pending queries if they were held for hold_ms 
+ *
+ * Callers running their own event loop call it when 
+ * fmapi_port_coalescer_timeout() elapses. 
+ *
+ * @param[in] c struct fmapi_port_coalescer* 
+ * @return number of requests sent, or a negative enum _FMER upon error
+ */
+int fmapi_port_coalescer_expire(struct fmapi_port_coalescer *c);
+
+/**
+ * Milliseconds until the pending queries must be sent 
+ *
+ * @param[in] c struct fmapi_port_coalescer* 
+ * @return milliseconds, or -1 if no query is pending. Suitable for poll()
+ */
+int fmapi_port_coalescer_timeout(struct fmapi_port_coalescer *c);
+
+/**
+ * Read the state of a VCS and of all of its vPPBs 
+ *
+ * The vPPB list is read in pages sized to s->rsp_limit. The first page learns 
+ * the number of vPPBs and the remaining pages are sent together. 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] vcsid int VCS ID 
+ * @param[out] blk struct fmapi_vsc_info_blk* with num set to the number of vPPBs read 
+ * @return 0 upon success, a non zero Response return code [FMRC], or a 
+ * 			negative enum _FMER upon error
+ */
+int fmapi_page_vsc_info(struct fmapi_session *s, int vcsid, struct fmapi_vsc_info_blk *blk);
+
+/**
+ * Read the memory allocation of every LD of an MLD 
+ *
+ * Paged like fmapi_page_vsc_info()
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[out] rsp struct fmapi_mcc_alloc_get_rsp* with num set to the number of LDs read 
+ * @return 0 upon success, a non zero Response return code [FMRC], or a 
+ * 			negative enum _FMER upon error
+ */
+int fmapi_page_mcc_alloc(struct fmapi_session *s, struct fmapi_mcc_alloc_get_rsp *rsp);
+
+/**
+ * Read the QoS allocated bandwidth fraction of the first num LDs 
+ *
+ * Every page is sent at once since the number of LDs is known 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] num int Number of LDs as returned by Get LD Info 
+ * @param[out] rsp struct fmapi_mcc_qos_bw_alloc* 
+ * @return 0 upon success, a non zero Response return code [FMRC], or a 
+ * 			negative enum _FMER upon error
+ */
+int fmapi_page_mcc_qos_alloc(struct fmapi_session *s, int num, struct fmapi_mcc_qos_bw_alloc *rsp);
+
+/**
+ * Read the QoS bandwidth limit fraction of the first num LDs 
+ *
+ * Every page is sent at once since the number of LDs is known 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] num int Number of LDs as returned by Get LD Info 
+ * @param[out] rsp struct fmapi_mcc_qos_bw_limit* 
+ * @return 0 upon success, a non zero Response return code [FMRC], or a 
+ * 			negative enum _FMER upon error
+ */
+int fmapi_page_mcc_qos_limit(struct fmapi_session *s, int num, struct fmapi_mcc_qos_bw_limit *rsp);
+
+/**
+ * Read LD memory into a buffer 
+ *
+ * The range may have any offset and length. It is split into Send LD CXL.io 
+ * Memory Requests that do not cross a 4 KB boundary, widened to whole DWords 
+ * with First / Last DWord Byte Enables masking the bytes outside the range. 
+ * Each request and its response also fit the req_limit and rsp_limit of 
+ * the session. 
+ * Up to depth requests are kept in flight and read data is copied from each 
+ * response frame straight into buf. 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] ppid int Physical port of the MLD 
+ * @param[in] ldid int Target LD ID 
+ * @param[in] offset __u64 Offset of the first byte in the memory space of the LD 
+ * @param[in] len size_t Number of bytes to read 
+ * @param[out] buf void* Receives len bytes 
+ * @param[in] depth unsigned Maximum number of requests in flight. 0 selects a default 
+ * @return 0 upon success, a non zero Response return code [FMRC], or a 
+ * 			negative enum _FMER upon error. -FMER_TRUNCATED if the device 
+ * 			transferred fewer bytes than requested 
+ */
+int fmapi_ld_mem_read(struct fmapi_session *s, int ppid, int ldid, __u64 offset, size_t len, void *buf, unsigned depth);
+
+/**
+ * Write a buffer to LD memory 
+ *
+ * Split like fmapi_ld_mem_read(). Bytes outside the range in the first and 
+ * last DWord of a request are disabled and left unchanged. 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] ppid int Physical port of the MLD 
+ * @param[in] ldid int Target LD ID 
+ * @param[in] offset __u64 Offset of the first byte in the memory space of the LD 
+ * @param[in] len size_t Number of bytes to write 
+ * @param[in] buf const void* Data to write 
+ * @param[in] depth unsigned Maximum number of requests in flight. 0 selects a default 
+ * @return 0 upon success, a non zero Response return code [FMRC], or a 
+ * 			negative enum _FMER upon error 
+ */
+int fmapi_ld_mem_write(struct fmapi_session *s, int ppid, int ldid, __u64 offset, size_t len, const void *buf, unsigned depth);
+
+/**
+ * Read a configuration space image of a PPB or an LD 
+ *
+ * Each DWord is one Send PPB CXL.io Configuration Request, or one Send LD 
+ * CXL.io Configuration Request when ldid is not negative. Up to depth requests 
+ * are kept in flight. Without a filter all 4 KB are read and the capability 
+ * lists are walked in the image. With a filter only the standard header, the 
+ * capability headers and the selected capabilities are read. A capability is 
+ * taken to extend up to the next capability of its region, or to the length 
+ * in its header for a VSEC or DVSEC. 
+ *
+ * @param[in] s struct fmapi_session* 
+ * @param[in] ppid int Physical port of the PPB or MLD 
+ * @param[in] ldid int Target LD ID, or -1 to read the PPB itself 
+ * @param[in] f const struct fmapi_cfg_filter* Capabilities to read. NULL reads everything 
+ * @param[out] img struct fmapi_cfg_image* to fill 
+ * @param[in] depth unsigned Maximum number of requests in flight. 0 selects a default 
+ * @return 0 upon success, a non zero Response return code [FMRC], or a 
+ * 			negative enum _FMER upon error
+ */
+int fmapi_cfg_snapshot(struct fmapi_session *s, int ppid, int ldid, const struct fmapi_cfg_filter *f, struct fmapi_cfg_image *img, unsigned depth);
+
+/**
+ * Find a capability in a configuration space image 
+ *
+ * @param[in] img struct fmapi_cfg_image* filled by fmapi_cfg_snapshot() 
+ * @param[in] id unsigned Capability ID [PCI_CAP_ID_*] or Extended Capability ID [PCI_EXT_CAP_ID_*] 
+ * @param[in] ext int 1 to look for an extended capability 
+ * @return byte offset of the first matching capability, or 0 if not found 
+ */
+unsigned fmapi_cfg_find(struct fmapi_cfg_image *img, unsigned id, int ext);
+
+/**
+ * Initialize a configuration space cache 
+ *
+ * @param[out] c struct fmapi_cfg_cache* 
+ * @param[in] s struct fmapi_session* Session misses and writes are sent on 
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_cfg_cache_init(struct fmapi_cfg_cache *c, struct fmapi_session *s);
+
+/**
+ * Release the memory held by a configuration space cache 
+ *
+ * @param[in] c struct fmapi_cfg_cache* 
+ */
+void fmapi_cfg_cache_free(struct fmapi_cfg_cache *c);
+
+/**
+ * Read configuration space bytes through a cache 
+ *
+ * DWords not in the cache are read from the device with the requests 
+ * pipelined as in fmapi_cfg_snapshot() and kept for later reads. 
+ *
+ * @param[in] c struct fmapi_cfg_cache* 
+ * @param[in] ppid int Physical port of the PPB or MLD 
+ * @param[in] ldid int Target LD ID, or -1 for the PPB itself 
+ * @param[in] off unsigned Byte offset of the first byte 
+ * @param[in] len unsigned Number of bytes to read 
+ * @param[out] buf void* Receives len bytes 
+ * @return 0 upon success, a non zero Response return code [FMRC], or a 
+ * 			negative enum _FMER upon error
+ */
+int fmapi_cfg_cache_read(struct fmapi_cfg_cache *c, int ppid, int ldid, unsigned off, unsigned len, void *buf);
+
+/**
+ * Write a configuration space DWord through a cache 
+ *
+ * The write is always sent to the device. The DWord is dropped from the cache 
+ * rather than updated since registers may have read only or write 1 to clear 
+ * bits. 
+ *
+ * @param[in] c struct fmapi_cfg_cache* 
+ * @param[in] ppid int Physical port of the PPB or MLD 
+ * @param[in] ldid int Target LD ID, or -1 for the PPB itself 
+ * @param[in] off unsigned Byte offset of the DWord 
+ * @param[in] fdbe int Byte Enables of the bytes to write 
+ * @param[in] val __u32 Value to write 
+ * @return 0 upon success, a non zero Response return code [FMRC], or a 
+ * 			negative enum _FMER upon error
+ */
+int fmapi_cfg_cache_write(struct fmapi_cfg_cache *c, int ppid, int ldid, unsigned off, int fdbe, __u32 val);
+
+/**
+ * Drop the cached DWords of a port and of the LDs behind it 
+ *
+ * @param[in] c struct fmapi_cfg_cache* 
+ * @param[in] ppid int Physical port, or -1 for every port 
+ */
+void fmapi_cfg_cache_invalidate(struct fmapi_cfg_cache *c, int ppid);
+
+/**
+ * Drop the cached DWords a request may change 
+ *
+ * Physical Port Control drops its port and Bind drops the bound port. Unbind 
+ * names a vPPB rather than a port so it drops every port. Other requests are 
+ * ignored. Call when sending such a request and again when it completes. 
+ *
+ * @param[in] c struct fmapi_cfg_cache* 
+ * @param[in] m struct fmapi_msg* Request 
+ */
+void fmapi_cfg_cache_note(struct fmapi_cfg_cache *c, struct fmapi_msg *m);
+
+/**
+ * Send a request and wait for its response, keeping a cache coherent 
+ *
+ * Calls fmapi_cfg_cache_note() before sending the request and after it 
+ * completes. 
+ *
+ * @param[in] c struct fmapi_cfg_cache* 
+ * @param[in] req struct fmapi_msg* Request to send 
+ * @param[out] rsp struct fmapi_msg* to decode the response into. May be NULL
+ * @param[in] param void * passed to fmapi_msg_decode() for the response 
+ * @return Response return code [FMRC], or a negative enum _FMER upon error
+ */
+int fmapi_cfg_cache_call(struct fmapi_cfg_cache *c, struct fmapi_msg *req, struct fmapi_msg *rsp, void *param);
+
+/**
+ * Initialize a background operation poller for the device of a session 
+ *
+ * @param[out] p struct fmapi_bos_poller* 
+ * @param[in] s struct fmapi_session* Session polls are sent on 
+ * @param[in] min_ms unsigned Shortest interval between polls. 0 selects a default 
+ * @param[in] max_ms unsigned Longest interval between polls. 0 selects a default 
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_bos_poller_init(struct fmapi_bos_poller *p, struct fmapi_session *s, unsigned min_ms, unsigned max_ms);
+
+/**
+ * Wait for the background operation of the device to finish 
+ *
+ * Call after a command returned FMRC_BACKGROUND_OP_STARTED. The first poll of 
+ * an operation is delayed by the duration last seen for its opcode, else by a 
+ * short delay for the commands the opcode registry marks as background and 
+ * by max_ms / 8 for the others. Later polls are due when the operation should 
+ * finish at the rate its Percent Complete advanced, or back off while it does 
+ * not advance. 
+ *
+ * @param[in] p struct fmapi_bos_poller* 
+ * @param[in,out] w struct fmapi_bos_wait* with opcode, cb and arg set 
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_bos_wait_submit(struct fmapi_bos_poller *p, struct fmapi_bos_wait *w);
+
+/**
+ * Send the Background Operation Status poll if it is due 
+ *
+ * @param[in] p struct fmapi_bos_poller* 
+ * @return 1 if a poll was sent, 0 if not, or a negative enum _FMER upon error
+ */
+int fmapi_bos_poller_expire(struct fmapi_bos_poller *p);
+
+/**
+ * Milliseconds until the next poll is due 
+ *
+ * For event loops that wait on the session descriptor 
+ *
+ * @param[in] p struct fmapi_bos_poller* 
+ * @return milliseconds, or -1 if no poll is due 
+ */
+int fmapi_bos_poller_timeout(struct fmapi_bos_poller *p);
+
+/**
+ * Wait for a waiter to complete 
+ *
+ * Polls are sent when due and other exchanges on the session make progress 
+ * in between. 
+ *
+ * @param[in] p struct fmapi_bos_poller* 
+ * @param[in] w struct fmapi_bos_wait* submitted on p 
+ * @return w->status
+ */
+int fmapi_bos_wait(struct fmapi_bos_poller *p, struct fmapi_bos_wait *w);
+
+/**
+ * Send a request and wait for it to finish, in the background if it must 
+ *
+ * @param[in] p struct fmapi_bos_poller* 
+ * @param[in] req struct fmapi_msg* Request to send 
+ * @param[out] rsp struct fmapi_msg* to decode the response into. May be NULL
+ * @param[in] param void * passed to fmapi_msg_decode() for the response 
+ * @param[out] ext __u16* Vendor Specific Extended Status of a background 
+ * 				operation, else 0. May be NULL
+ * @return Response return code [FMRC] of the request or of its background 
+ * 			operation, or a negative enum _FMER upon error
+ */
+int fmapi_bos_call(struct fmapi_bos_poller *p, struct fmapi_msg *req, struct fmapi_msg *rsp, void *param, __u16 *ext);
+
+/**
+ * Initialize a background operation scheduler for the device of a session 
+ *
+ * @param[out] sc struct fmapi_bos_sched* 
+ * @param[in] p struct fmapi_bos_poller* of the device. Its session is used 
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_bos_sched_init(struct fmapi_bos_sched *sc, struct fmapi_bos_poller *p);
+
+/**
+ * Submit a job 
+ *
+ * Commands the opcode registry marks as background, such as Bind and Unbind, 
+ * and requests with hdr.background set are queued behind the background job 
+ * being run. The job completes when its background operation finishes, or 
+ * when its command completes without starting one. A job the device answers 
+ * with FMRC_BUSY is sent again once the operation running on the device 
+ * finished. Other jobs are sent right away. 
+ *
+ * @param[in] sc struct fmapi_bos_sched* 
+ * @param[in,out] j struct fmapi_bos_job* with req, rsp, param, cb and arg set 
+ * @return 0 upon success, -FMER_BUSY if a foreground job found no free tag, 
+ * 			or another negative enum _FMER upon error
+ */
+int fmapi_bos_job_submit(struct fmapi_bos_sched *sc, struct fmapi_bos_job *j);
+
+/**
+ * Send what is due: a background job waiting for a tag, or a poll 
+ *
+ * @param[in] sc struct fmapi_bos_sched* 
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_bos_sched_expire(struct fmapi_bos_sched *sc);
+
+/**
+ * Milliseconds until fmapi_bos_sched_expire() has something to send 
+ *
+ * @param[in] sc struct fmapi_bos_sched* 
+ * @return milliseconds, or -1 if nothing falls due 
+ */
+int fmapi_bos_sched_timeout(struct fmapi_bos_sched *sc);
+
+/**
+ * Wait for a job to complete 
+ *
+ * @param[in] sc struct fmapi_bos_sched* 
+ * @param[in] j struct fmapi_bos_job* submitted on sc 
+ * @return j->status
+ */
+int fmapi_bos_job_wait(struct fmapi_bos_sched *sc, struct fmapi_bos_job *j);
+
+/**
+ * Send a request through a scheduler and wait for it to finish 
+ *
+ * @param[in] sc struct fmapi_bos_sched* 
+ * @param[in] req struct fmapi_msg* Request to send 
+ * @param[out] rsp struct fmapi_msg* to decode the response into. May be NULL
+ * @param[in] param void * passed to fmapi_msg_decode() for the response 
+ * @param[out] ext __u16* Vendor Specific Extended Status. May be NULL
+ * @return Response return code [FMRC] of the request or of its background 
+ * 			operation, or a negative enum _FMER upon error
+ */
+int fmapi_bos_sched_call(struct fmapi_bos_sched *sc, struct fmapi_msg *req, struct fmapi_msg *rsp, void *param, __u16 *ext);
+
+/**
+ * Print an object to the screen
+ *
+ * @param ptr A pointer to the object to print 
+ * @param type The type of object to be printed from enum _FMOB
+ */
+void fmapi_prnt(void *ptr, unsigned type);        
+
+/* Functions to return a string representation of an object*/
+const char *fmbs(unsigned int u);
+const char *fmcs(unsigned int u);
+const char *fmct(unsigned int u);
+const char *fmdt(unsigned int u);
+const char *fmdv(unsigned int u);
+const char *fmer(unsigned int u);
+const char *fmet(unsigned int u);
+const char *fmlf(unsigned int u);
+const char *fmlo(unsigned int u);
+const char *fmls(unsigned int u);
+const char *fmmg(unsigned int u);
+const char *fmmr(unsigned int u);
+const char *fmms(unsigned int u);
+const char *fmmt(unsigned int u);
+const char *fmnw(unsigned int u);
+const char *fmop(unsigned int u);
+const char *fmpo(unsigned int u);
+const char *fmps(unsigned int u);
+const char *fmqt(unsigned int u);
+const char *fmrc(unsigned int u);
+const char *fmss(unsigned int u);
+const char *fmub(unsigned int u);
+const char *fmvc(unsigned int u);
+const char *fmvs(unsigned int u);
+const char *fmvt(unsigned int u);
+
+/* BYTE ORDER ================================================================*/
+
+/*
+ * Little endian field accessors
+ *
+ * All multi-byte FM API fields are little endian on the wire. On little endian
+ * hosts these compile to a single unaligned load or store. Other hosts 
+ * assemble the value a byte at a time. 
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define FMAPI_LE_HOST 	1
+#else 
+#define FMAPI_LE_HOST 	0
+#endif
+
+static inline __u16 fmapi_get_le16(const void *p)
+{
+#if FMAPI_LE_HOST
+	__u16 v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+#else 
+	const __u8 *b = (const __u8*) p;
+	return (b[1] << 8) | b[0];
+#endif
+}
+
+static inline __u32 fmapi_get_le32(const void *p)
+{
+#if FMAPI_LE_HOST
+	__u32 v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+#else 
+	const __u8 *b = (const __u8*) p;
+	return ((__u32)b[3] << 24) | ((__u32)b[2] << 16) | ((__u32)b[1] << 8) | b[0];
+#endif
+}
+
+static inline __u64 fmapi_get_le64(const void *p)
+{
+#if FMAPI_LE_HOST
+	__u64 v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+#else 
+	const __u8 *b = (const __u8*) p;
+	return ((__u64)fmapi_get_le32(b + 4) << 32) | fmapi_get_le32(b);
+#endif
+}
+
+static inline void fmapi_put_le16(void *p, __u16 v)
+{
+#if FMAPI_LE_HOST
+	memcpy(p, &v, sizeof(v));
+#else 
+	__u8 *b = (__u8*) p;
+	b[0] = v & 0x00FF;
+	b[1] = (v >> 8) & 0x00FF;
+#endif
+}
+
+static inline void fmapi_put_le32(void *p, __u32 v)
+{
+#if FMAPI_LE_HOST
+	memcpy(p, &v, sizeof(v));
+#else 
+	__u8 *b = (__u8*) p;
+	b[0] = v & 0x00FF;
+	b[1] = (v >>  8) & 0x00FF;
+	b[2] = (v >> 16) & 0x00FF;
+	b[3] = (v >> 24) & 0x00FF;
+#endif
+}
+
+static inline void fmapi_put_le64(void *p, __u64 v)
+{
+#if FMAPI_LE_HOST
+	memcpy(p, &v, sizeof(v));
+#else 
+	__u8 *b = (__u8*) p;
+	fmapi_put_le32(b, v & 0xFFFFFFFF);
+	fmapi_put_le32(b + 4, v >> 32);
+#endif
+}
+
+/* VIEWS =====================================================================*/
+
+/*
+ * Read-only views over serialized FM API Objects 
+ *
+ * A view wraps a pointer to the serialized (wire) bytes of an object and 
+ * reads each field on demand, using the same bit field extraction as 
+ * fmapi_deserialize(). This avoids copying a whole object into struct 
+ * fmapi_msg when only a few fields are needed. 
+ *
+ * Views do not check bounds. Validate the payload once with fmapi_check_len()
+ * before reading through a view. 
+ *
+ * Usage: 
+ *   len = fmapi_transport_recv(t, &frame);
+ *   struct fmapi_psc_port_rsp_view r = fmapi_psc_port_rsp_view(frame + FMLN_HDR);
+ *   for (int i = 0 ; i < fmapi_psc_port_rsp_view_num(r) ; i++)
+ *     ltssm = fmapi_psc_port_info_view_ltssm(fmapi_psc_port_rsp_view_list(r, i));
+ */
+
+/**
+ * Declare a view type and its constructor: struct fmapi_<name>_view 
+ */
+#define FMAPI_VIEW(name) 																\
+	struct fmapi_##name##_view { const __u8 *buf; };									\
+	static inline struct fmapi_##name##_view fmapi_##name##_view(const void *buf) 		\
+	{ struct fmapi_##name##_view v = { (const __u8*) buf }; return v; }
+
+/**
+ * Accessor for a byte wide field at offset off
+ */
+#define FMAPI_VIEW_U8(name, field, off) 												\
+	static inline __u8 fmapi_##name##_view_##field(struct fmapi_##name##_view v) 		\
+	{ return v.buf[off]; }
+
+/**
+ * Accessor for a bit field: (byte at offset off >> shift) & mask
+ */
+#define FMAPI_VIEW_BITS(name, field, off, shift, mask) 									\
+	static inline __u8 fmapi_##name##_view_##field(struct fmapi_##name##_view v) 		\
+	{ return (v.buf[off] >> (shift)) & (mask); }
+
+/**
+ * Accessor for a little endian 16 bit field at offset off
+ */
+#define FMAPI_VIEW_U16(name, field, off) 												\
+	static inline __u16 fmapi_##name##_view_##field(struct fmapi_##name##_view v) 		\
+	{ return fmapi_get_le16(v.buf + (off)); }
+
+/**
+ * Accessor for a little endian 32 bit field at offset off
+ */
+#define FMAPI_VIEW_U32(name, field, off) 												\
+	static inline __u32 fmapi_##name##_view_##field(struct fmapi_##name##_view v) 		\
+	{ return fmapi_get_le32(v.buf + (off)); }
+
+/**
+ * Accessor for a little endian 64 bit field at offset off
+ */
+#define FMAPI_VIEW_U64(name, field, off) 												\
+	static inline __u64 fmapi_##name##_view_##field(struct fmapi_##name##_view v) 		\
+	{ return fmapi_get_le64(v.buf + (off)); }
+
+/**
+ * Accessor for a byte array field. Returns a pointer into the serialized bytes
+ */
+#define FMAPI_VIEW_PTR(name, field, off) 												\
+	static inline const __u8 *fmapi_##name##_view_##field(struct fmapi_##name##_view v) \
+	{ return v.buf + (off); }
+
+/**
+ * Accessor for entry i of a list of fixed length objects of view type elem
+ */
+#define FMAPI_VIEW_LIST(name, field, elem, off, len) 									\
+	static inline struct fmapi_##elem##_view fmapi_##name##_view_##field(struct fmapi_##name##_view v, int i) \
+	{ return fmapi_##elem##_view(v.buf + (off) + i * (len)); }
+
+/* struct fmapi_hdr */
+FMAPI_VIEW(hdr)
+FMAPI_VIEW_BITS(hdr, category, 0, 4, 0x0F)
+FMAPI_VIEW_U8  (hdr, tag, 1)
+FMAPI_VIEW_U16 (hdr, opcode, 3)
+FMAPI_VIEW_BITS(hdr, background, 7, 0, 0x01)
+FMAPI_VIEW_U16 (hdr, return_code, 8)
+FMAPI_VIEW_U16 (hdr, ext_status, 10)
+static inline __u32 fmapi_hdr_view_len(struct fmapi_hdr_view v)
+{ 
+	return ((v.buf[7] & 0x00F8) << 13) | (v.buf[6] << 8) | v.buf[5]; 
+}
+
+/* struct fmapi_isc_id_rsp */
+FMAPI_VIEW(isc_id_rsp)
+FMAPI_VIEW_U16 (isc_id_rsp, vid, 0)
+FMAPI_VIEW_U16 (isc_id_rsp, did, 2)
+FMAPI_VIEW_U16 (isc_id_rsp, svid, 4)
+FMAPI_VIEW_U16 (isc_id_rsp, ssid, 6)
+FMAPI_VIEW_U64 (isc_id_rsp, sn, 8)
+FMAPI_VIEW_U8  (isc_id_rsp, size, 16)
+
+/* struct fmapi_isc_msg_limit */
+FMAPI_VIEW(isc_msg_limit)
+FMAPI_VIEW_U8  (isc_msg_limit, limit, 0)
+
+/* struct fmapi_isc_bos */
+FMAPI_VIEW(isc_bos)
+FMAPI_VIEW_BITS(isc_bos, running, 0, 0, 0x01)
+FMAPI_VIEW_BITS(isc_bos, pcnt, 0, 1, 0x7F)
+FMAPI_VIEW_U16 (isc_bos, opcode, 2)
+FMAPI_VIEW_U16 (isc_bos, rc, 4)
+FMAPI_VIEW_U16 (isc_bos, ext, 6)
+
+/* struct fmapi_psc_id_rsp */
+FMAPI_VIEW(psc_id_rsp)
+FMAPI_VIEW_U8  (psc_id_rsp, ingress_port, 0)
+FMAPI_VIEW_U8  (psc_id_rsp, num_ports, 2)
+FMAPI_VIEW_U8  (psc_id_rsp, num_vcss, 3)
+FMAPI_VIEW_PTR (psc_id_rsp, active_ports, 4)
+FMAPI_VIEW_PTR (psc_id_rsp, active_vcss, 36)
+FMAPI_VIEW_U16 (psc_id_rsp, num_vppbs, 68)
+FMAPI_VIEW_U16 (psc_id_rsp, active_vppbs, 70)
+FMAPI_VIEW_U8  (psc_id_rsp, num_decoders, 72)
+
+/* struct fmapi_psc_port_req */
+FMAPI_VIEW(psc_port_req)
+FMAPI_VIEW_U8  (psc_port_req, num, 0)
+FMAPI_VIEW_PTR (psc_port_req, ports, 1)
+
+/* struct fmapi_psc_port_info */
+FMAPI_VIEW(psc_port_info)
+FMAPI_VIEW_U8  (psc_port_info, ppid, 0)
+FMAPI_VIEW_U8  (psc_port_info, state, 1)
+FMAPI_VIEW_U8  (psc_port_info, dv, 2)
+FMAPI_VIEW_U8  (psc_port_info, dt, 4)
+FMAPI_VIEW_U8  (psc_port_info, cv, 5)
+FMAPI_VIEW_U8  (psc_port_info, mlw, 6)
+FMAPI_VIEW_U8  (psc_port_info, nlw, 7)
+FMAPI_VIEW_U8  (psc_port_info, speeds, 8)
+FMAPI_VIEW_U8  (psc_port_info, mls, 9)
+FMAPI_VIEW_U8  (psc_port_info, cls, 10)
+FMAPI_VIEW_U8  (psc_port_info, ltssm, 11)
+FMAPI_VIEW_U8  (psc_port_info, lane, 12)
+FMAPI_VIEW_BITS(psc_port_info, lane_rev, 13, FMLF_LANE_REVERSAL_BIT, 0x01)
+FMAPI_VIEW_BITS(psc_port_info, perst, 13, FMLF_PERST_STATE_BIT, 0x01)
+FMAPI_VIEW_BITS(psc_port_info, prsnt, 13, FMLF_PRSNT_STATE_BIT, 0x01)
+FMAPI_VIEW_BITS(psc_port_info, pwrctrl, 13, FMLF_PWRCTL_STATE_BIT, 0x01)
+FMAPI_VIEW_U8  (psc_port_info, num_ld, 15)
+
+/* struct fmapi_psc_port_rsp */
+FMAPI_VIEW(psc_port_rsp)
+FMAPI_VIEW_U8  (psc_port_rsp, num, 0)
+FMAPI_VIEW_LIST(psc_port_rsp, list, psc_port_info, FMLN_PSC_GET_PHY_PORT_RESP, FMLN_PSC_GET_PHY_PORT_INFO)
+
+/* struct fmapi_psc_port_ctrl_req */
+FMAPI_VIEW(psc_port_ctrl_req)
+FMAPI_VIEW_U8  (psc_port_ctrl_req, ppid, 0)
+FMAPI_VIEW_U8  (psc_port_ctrl_req, opcode, 1)
+
+/* struct fmapi_psc_cfg_req */
+FMAPI_VIEW(psc_cfg_req)
+FMAPI_VIEW_U8  (psc_cfg_req, ppid, 0)
+FMAPI_VIEW_U8  (psc_cfg_req, reg, 1)
+FMAPI_VIEW_BITS(psc_cfg_req, ext, 2, 0, 0x0F)
+FMAPI_VIEW_BITS(psc_cfg_req, fdbe, 2, 4, 0x0F)
+FMAPI_VIEW_BITS(psc_cfg_req, type, 3, 7, 0x01)
+FMAPI_VIEW_PTR (psc_cfg_req, data, 4)
+
+/* struct fmapi_psc_cfg_rsp */
+FMAPI_VIEW(psc_cfg_rsp)
+FMAPI_VIEW_PTR (psc_cfg_rsp, data, 0)
+
+/* struct fmapi_vsc_info_req */
+FMAPI_VIEW(vsc_info_req)
+FMAPI_VIEW_U8  (vsc_info_req, vppbid_start, 0)
+FMAPI_VIEW_U8  (vsc_info_req, vppbid_limit, 1)
+FMAPI_VIEW_U8  (vsc_info_req, num, 2)
+FMAPI_VIEW_PTR (vsc_info_req, vcss, 3)
+
+/* struct fmapi_vsc_ppb_stat_blk */
+FMAPI_VIEW(vsc_ppb_stat_blk)
+FMAPI_VIEW_U8  (vsc_ppb_stat_blk, status, 0)
+FMAPI_VIEW_U8  (vsc_ppb_stat_blk, ppid, 1)
+FMAPI_VIEW_U8  (vsc_ppb_stat_blk, ldid, 2)
+
+/* struct fmapi_vsc_info_blk. The number of list entries depends on the request */
+FMAPI_VIEW(vsc_info_blk)
+FMAPI_VIEW_U8  (vsc_info_blk, vcsid, 0)
+FMAPI_VIEW_U8  (vsc_info_blk, state, 1)
+FMAPI_VIEW_U8  (vsc_info_blk, uspid, 2)
+FMAPI_VIEW_U8  (vsc_info_blk, total, 3)
+FMAPI_VIEW_LIST(vsc_info_blk, list, vsc_ppb_stat_blk, FMLN_VSC_INFO, FMLN_VSC_PPB_STATUS)
+
+/* struct fmapi_vsc_info_rsp. Blocks are variable length, see fmapi_check_len() */
+FMAPI_VIEW(vsc_info_rsp)
+FMAPI_VIEW_U8  (vsc_info_rsp, num, 0)
+
+/* struct fmapi_vsc_bind_req */
+FMAPI_VIEW(vsc_bind_req)
+FMAPI_VIEW_U8  (vsc_bind_req, vcsid, 0)
+FMAPI_VIEW_U8  (vsc_bind_req, vppbid, 1)
+FMAPI_VIEW_U8  (vsc_bind_req, ppid, 2)
+FMAPI_VIEW_U16 (vsc_bind_req, ldid, 4)
+
+/* struct fmapi_vsc_unbind_req */
+FMAPI_VIEW(vsc_unbind_req)
+FMAPI_VIEW_U8  (vsc_unbind_req, vcsid, 0)
+FMAPI_VIEW_U8  (vsc_unbind_req, vppbid, 1)
+FMAPI_VIEW_BITS(vsc_unbind_req, option, 2, 0, 0x0F)
+
+/* struct fmapi_vsc_aer_req */
+FMAPI_VIEW(vsc_aer_req)
+FMAPI_VIEW_U8  (vsc_aer_req, vcsid, 0)
+FMAPI_VIEW_U8  (vsc_aer_req, vppbid, 1)
+FMAPI_VIEW_U32 (vsc_aer_req, error_type, 4)
+FMAPI_VIEW_PTR (vsc_aer_req, header, 8)
+
+/* struct fmapi_mpc_tmc_req. len excludes the MCTP Type byte */
+FMAPI_VIEW(mpc_tmc_req)
+FMAPI_VIEW_U8  (mpc_tmc_req, ppid, 0)
+FMAPI_VIEW_U8  (mpc_tmc_req, type, 4)
+FMAPI_VIEW_PTR (mpc_tmc_req, msg, FMLN_MPC_TUNNEL_CMD_REQ)
+static inline __u16 fmapi_mpc_tmc_req_view_len(struct fmapi_mpc_tmc_req_view v)
+{ 
+	return ((v.buf[3] << 8) | v.buf[2]) - 1; 
+}
+
+/* struct fmapi_mpc_tmc_rsp. len excludes the MCTP Type byte */
+FMAPI_VIEW(mpc_tmc_rsp)
+FMAPI_VIEW_U8  (mpc_tmc_rsp, type, 4)
+FMAPI_VIEW_PTR (mpc_tmc_rsp, msg, FMLN_MPC_TUNNEL_CMD_RESP)
+static inline __u16 fmapi_mpc_tmc_rsp_view_len(struct fmapi_mpc_tmc_rsp_view v)
+{ 
+	return ((v.buf[1] << 8) | v.buf[0]) - 1; 
+}
+
+/* struct fmapi_mpc_cfg_req */
+FMAPI_VIEW(mpc_cfg_req)
+FMAPI_VIEW_U8  (mpc_cfg_req, ppid, 0)
+FMAPI_VIEW_U8  (mpc_cfg_req, reg, 1)
+FMAPI_VIEW_BITS(mpc_cfg_req, ext, 2, 0, 0x0F)
+FMAPI_VIEW_BITS(mpc_cfg_req, fdbe, 2, 4, 0x0F)
+FMAPI_VIEW_BITS(mpc_cfg_req, type, 3, 7, 0x01)
+FMAPI_VIEW_U16 (mpc_cfg_req, ldid, 4)
+FMAPI_VIEW_PTR (mpc_cfg_req, data, 8)
+
+/* struct fmapi_mpc_cfg_rsp */
+FMAPI_VIEW(mpc_cfg_rsp)
+FMAPI_VIEW_PTR (mpc_cfg_rsp, data, 0)
+
+/* struct fmapi_mpc_mem_req */
+FMAPI_VIEW(mpc_mem_req)
+FMAPI_VIEW_U8  (mpc_mem_req, ppid, 0)
+FMAPI_VIEW_BITS(mpc_mem_req, fdbe, 2, 4, 0x0F)
+FMAPI_VIEW_BITS(mpc_mem_req, ldbe, 3, 0, 0x0F)
+FMAPI_VIEW_BITS(mpc_mem_req, type, 3, 7, 0x01)
+FMAPI_VIEW_U16 (mpc_mem_req, ldid, 4)
+FMAPI_VIEW_U16 (mpc_mem_req, len, 6)
+FMAPI_VIEW_U64 (mpc_mem_req, offset, 8)
+FMAPI_VIEW_PTR (mpc_mem_req, data, FMLN_MPC_LD_MEM_REQ)
+
+/* struct fmapi_mpc_mem_rsp */
+FMAPI_VIEW(mpc_mem_rsp)
+FMAPI_VIEW_U16 (mpc_mem_rsp, len, 0)
+FMAPI_VIEW_PTR (mpc_mem_rsp, data, FMLN_MPC_LD_MEM_RESP)
+
+/* struct fmapi_mcc_info_rsp */
+FMAPI_VIEW(mcc_info_rsp)
+FMAPI_VIEW_U64 (mcc_info_rsp, size, 0)
+FMAPI_VIEW_U16 (mcc_info_rsp, num, 8)
+FMAPI_VIEW_BITS(mcc_info_rsp, epc, 10, FMQT_EGRESS_PORT_CONGESTION_BIT, 0x01)
+FMAPI_VIEW_BITS(mcc_info_rsp, ttr, 10, FMQT_TEMP_THROUGHPUT_REDUCTION_BIT, 0x01)
+
+/* struct fmapi_mcc_alloc_blk */
+FMAPI_VIEW(mcc_alloc_blk)
+FMAPI_VIEW_U64 (mcc_alloc_blk, rng1, 0)
+FMAPI_VIEW_U64 (mcc_alloc_blk, rng2, 8)
+
+/* struct fmapi_mcc_alloc_get_req */
+FMAPI_VIEW(mcc_alloc_get_req)
+FMAPI_VIEW_U8  (mcc_alloc_get_req, start, 0)
+FMAPI_VIEW_U8  (mcc_alloc_get_req, limit, 1)
+
+/* struct fmapi_mcc_alloc_get_rsp */
+FMAPI_VIEW(mcc_alloc_get_rsp)
+FMAPI_VIEW_U8  (mcc_alloc_get_rsp, total, 0)
+FMAPI_VIEW_U8  (mcc_alloc_get_rsp, granularity, 1)
+FMAPI_VIEW_U8  (mcc_alloc_get_rsp, start, 2)
+FMAPI_VIEW_U8  (mcc_alloc_get_rsp, num, 3)
+FMAPI_VIEW_LIST(mcc_alloc_get_rsp, list, mcc_alloc_blk, FMLN_MCC_GET_LD_ALLOC_RSP, FMLN_MCC_LD_ALLOC_ENTRY)
+
+/* struct fmapi_mcc_alloc_set_req */
+FMAPI_VIEW(mcc_alloc_set_req)
+FMAPI_VIEW_U8  (mcc_alloc_set_req, num, 0)
+FMAPI_VIEW_U8  (mcc_alloc_set_req, start, 1)
+FMAPI_VIEW_LIST(mcc_alloc_set_req, list, mcc_alloc_blk, FMLN_MCC_SET_LD_ALLOC_REQ, FMLN_MCC_LD_ALLOC_ENTRY)
+
+/* struct fmapi_mcc_alloc_set_rsp */
+FMAPI_VIEW(mcc_alloc_set_rsp)
+FMAPI_VIEW_U8  (mcc_alloc_set_rsp, num, 0)
+FMAPI_VIEW_U8  (mcc_alloc_set_rsp, start, 1)
+FMAPI_VIEW_LIST(mcc_alloc_set_rsp, list, mcc_alloc_blk, FMLN_MCC_SET_LD_ALLOC_RSP, FMLN_MCC_LD_ALLOC_ENTRY)
+
+/* struct fmapi_mcc_qos_ctrl */
+FMAPI_VIEW(mcc_qos_ctrl)
+FMAPI_VIEW_BITS(mcc_qos_ctrl, epc_en, 0, FMQT_EGRESS_PORT_CONGESTION_BIT, 0x01)
+FMAPI_VIEW_BITS(mcc_qos_ctrl, ttr_en, 0, FMQT_TEMP_THROUGHPUT_REDUCTION_BIT, 0x01)
+FMAPI_VIEW_U8  (mcc_qos_ctrl, egress_mod_pcnt, 1)
+FMAPI_VIEW_U8  (mcc_qos_ctrl, egress_sev_pcnt, 2)
+FMAPI_VIEW_U8  (mcc_qos_ctrl, sample_interval, 3)
+FMAPI_VIEW_U16 (mcc_qos_ctrl, rcb, 4)
+FMAPI_VIEW_U8  (mcc_qos_ctrl, comp_interval, 6)
+
+/* struct fmapi_mcc_qos_stat_rsp */
+FMAPI_VIEW(mcc_qos_stat_rsp)
+FMAPI_VIEW_U8  (mcc_qos_stat_rsp, bp_avg_pcnt, 0)
+
+/* struct fmapi_mcc_qos_bw_alloc_get_req */
+FMAPI_VIEW(mcc_qos_bw_alloc_get_req)
+FMAPI_VIEW_U8  (mcc_qos_bw_alloc_get_req, num, 0)
+FMAPI_VIEW_U8  (mcc_qos_bw_alloc_get_req, start, 1)
+
+/* struct fmapi_mcc_qos_bw_alloc */
+FMAPI_VIEW(mcc_qos_bw_alloc)
+FMAPI_VIEW_U8  (mcc_qos_bw_alloc, num, 0)
+FMAPI_VIEW_U8  (mcc_qos_bw_alloc, start, 1)
+FMAPI_VIEW_PTR (mcc_qos_bw_alloc, list, FMLN_MCC_QOS_BW_ALLOC)
+
+/* struct fmapi_mcc_qos_bw_limit_get_req */
+FMAPI_VIEW(mcc_qos_bw_limit_get_req)
+FMAPI_VIEW_U8  (mcc_qos_bw_limit_get_req, num, 0)
+FMAPI_VIEW_U8  (mcc_qos_bw_limit_get_req, start, 1)
+
+/* struct fmapi_mcc_qos_bw_limit */
+FMAPI_VIEW(mcc_qos_bw_limit)
+FMAPI_VIEW_U8  (mcc_qos_bw_limit, num, 0)
+FMAPI_VIEW_U8  (mcc_qos_bw_limit, start, 1)
+FMAPI_VIEW_PTR (mcc_qos_bw_limit, list, FMLN_MCC_QOS_BW_LIMIT)
 
 #endif //ifndef _FMAPI_H
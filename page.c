@@ -0,0 +1,456 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		page.c
+ *
+ * @brief 		Code file for reading CXL FM API lists that span several
+ * 				responses
+ *
+ * @details 	Get Virtual CXL Switch Info, Get LD Allocations and the Get
+ * 				QoS BW Allocated / Limit commands return a window of a list
+ * 				selected by a start index and a count. These functions size
+ * 				each window to the response limit of the session, send every
+ * 				window at once through the session and merge the responses.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2026
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* calloc(), free()
+ */
+#include <stdlib.h>
+
+/* memset(), memcpy()
+ */
+#include <string.h>
+
+#include "main.h"
+
+/* STRUCTS ===================================================================*/
+
+/**
+ * One page of a list read
+ */
+struct fmapi_page
+{
+	struct fmapi_xfer x;		//!< Exchange of the page
+	struct fmapi_msg req;		//!< Request for the page
+	struct fmapi_msg rsp;		//!< Response for the page
+	unsigned start;				//!< Index of the first entry requested
+	unsigned num;				//!< Number of entries requested
+};
+
+/**
+ * State of a list read
+ */
+struct fmapi_pager
+{
+	struct fmapi_session *s;	//!< Session the pages are sent on
+	__u16 opcode;				//!< Opcode of the Get command [FMOP]
+	int id;						//!< VCS ID for FMOP_VSC_INFO
+	unsigned total;				//!< Number of entries in the list. 0 until known
+	unsigned per;				//!< Number of entries per page
+	void *out;					//!< Merged result
+};
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Number of list entries whose response fits in the response limit of the session
+ */
+static unsigned fmapi_pager_per(struct fmapi_pager *p)
+{
+	unsigned fixed, entry;
+
+	switch (p->opcode)
+	{
+		case FMOP_VSC_INFO:
+			fixed = FMLN_VSC_GET_INFO_RESP + FMLN_VSC_INFO;
+			entry = FMLN_VSC_PPB_STATUS;
+			break;
+
+		case FMOP_MCC_ALLOC_GET:
+			fixed = FMLN_MCC_GET_LD_ALLOC_RSP;
+			entry = FMLN_MCC_LD_ALLOC_ENTRY;
+			break;
+
+		case FMOP_MCC_QOS_BW_ALLOC_GET:
+			fixed = FMLN_MCC_QOS_BW_ALLOC;
+			entry = 1;
+			break;
+
+		case FMOP_MCC_QOS_BW_LIMIT_GET:
+		default:
+			fixed = FMLN_MCC_QOS_BW_LIMIT;
+			entry = 1;
+			break;
+	}
+
+	return fmapi_session_list_max(p->s, fixed, entry);
+}
+
+/**
+ * Prepare the request and exchange of a page
+ */
+static void fmapi_pager_fill(struct fmapi_pager *p, struct fmapi_page *pg, unsigned start, unsigned num)
+{
+	memset(&pg->x, 0, sizeof(pg->x));
+	pg->start = start;
+	pg->num = num;
+	pg->x.req = &pg->req;
+	pg->x.rsp = &pg->rsp;
+
+	switch (p->opcode)
+	{
+		case FMOP_VSC_INFO:
+			fmapi_fill_vsc_get_vcs(&pg->req, p->id, start, num);
+			pg->x.param = &pg->req.obj.vsc_info_req;
+			break;
+
+		case FMOP_MCC_ALLOC_GET:
+			fmapi_fill_mcc_get_alloc(&pg->req, start, num);
+			break;
+
+		case FMOP_MCC_QOS_BW_ALLOC_GET:
+			fmapi_fill_mcc_get_qos_alloc(&pg->req, start, num);
+			break;
+
+		case FMOP_MCC_QOS_BW_LIMIT_GET:
+			fmapi_fill_mcc_get_qos_limit(&pg->req, start, num);
+			break;
+	}
+}
+
+/**
+ * Copy the entries of a page into the merged result
+ *
+ * The first page also sets the fields describing the whole list and the
+ * total number of entries when it was not known.
+ *
+ * @return number of entries copied, or a negative enum _FMER upon error
+ */
+static int fmapi_pager_merge(struct fmapi_pager *p, struct fmapi_page *pg)
+{
+	unsigned start, num;
+
+	switch (p->opcode)
+	{
+		case FMOP_VSC_INFO:
+		{
+			struct fmapi_vsc_info_rsp *r = &pg->rsp.obj.vsc_info_rsp;
+			struct fmapi_vsc_info_blk *o = (struct fmapi_vsc_info_blk*) p->out;
+
+			if ( (r->num != 1) || (r->list[0].vcsid != p->id) )
+				return -FMER_INVALID;
+
+			if (p->total == 0)
+			{
+				o->vcsid = r->list[0].vcsid;
+				o->state = r->list[0].state;
+				o->uspid = r->list[0].uspid;
+				o->total = r->list[0].total;
+				p->total = o->total;
+			}
+
+			start = pg->start;
+			num = r->list[0].num;
+			if (start + num > p->total)
+				return -FMER_OVERFLOW;
+			memcpy(&o->list[start], r->list[0].list, num * sizeof(o->list[0]));
+		}
+			break;
+
+		case FMOP_MCC_ALLOC_GET:
+		{
+			struct fmapi_mcc_alloc_get_rsp *r = &pg->rsp.obj.mcc_alloc_get_rsp;
+			struct fmapi_mcc_alloc_get_rsp *o = (struct fmapi_mcc_alloc_get_rsp*) p->out;
+
+			if (p->total == 0)
+			{
+				o->total = r->total;
+				o->granularity = r->granularity;
+				o->start = 0;
+				p->total = (r->total > FM_MAX_NUM_LD) ? FM_MAX_NUM_LD : r->total;
+			}
+
+			start = r->start;
+			num = r->num;
+			if ( (start != pg->start) || (start + num > p->total) )
+				return -FMER_OVERFLOW;
+			memcpy(&o->list[start], r->list, num * sizeof(o->list[0]));
+		}
+			break;
+
+		case FMOP_MCC_QOS_BW_ALLOC_GET:
+		case FMOP_MCC_QOS_BW_LIMIT_GET:
+		{
+			// Both payloads have the same layout
+			struct fmapi_mcc_qos_bw_alloc *r = &pg->rsp.obj.mcc_qos_bw_alloc;
+			struct fmapi_mcc_qos_bw_alloc *o = (struct fmapi_mcc_qos_bw_alloc*) p->out;
+
+			start = r->start;
+			num = r->num;
+			if ( (start != pg->start) || (start + num > p->total) )
+				return -FMER_OVERFLOW;
+			memcpy(&o->list[start], r->list, num);
+		}
+			break;
+
+		default:
+			return -FMER_INVALID;
+	}
+
+	// Never count past what was asked for
+	return (num > pg->num) ? (int) pg->num : (int) num;
+}
+
+/**
+ * Read one page and wait for it, merging the result
+ *
+ * @param[out] status int* Response return code [FMRC], or negative enum _FMER
+ * @return number of entries merged, or a negative enum _FMER upon error. 0 
+ * 			if status is not 0
+ */
+static int fmapi_pager_call(struct fmapi_pager *p, struct fmapi_page *pg, unsigned start, unsigned num, int *status)
+{
+	fmapi_pager_fill(p, pg, start, num);
+
+	*status = fmapi_session_call(p->s, pg->x.req, pg->x.rsp, pg->x.param);
+	if (*status != 0)
+		return 0;
+
+	return fmapi_pager_merge(p, pg);
+}
+
+/**
+ * Read every page of a list
+ *
+ * When the total is not known the first page is read alone to learn it. The
+ * remaining pages are then sent together, limited only by the window of the
+ * session, and merged as they are waited for. A page that returns fewer
+ * entries than requested is completed by reading the rest of it again.
+ *
+ * @param[in] p struct fmapi_pager*
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+static int fmapi_pager_run(struct fmapi_pager *p)
+{
+	struct fmapi_page *pg;
+	unsigned start, num, npages, sent, i;
+	int rv, status, n;
+
+	p->per = fmapi_pager_per(p);
+
+	// STEP 1: Learn the size of the list from the first page
+	start = 0;
+	if (p->total == 0)
+	{
+		pg = calloc(1, sizeof(struct fmapi_page));
+		if (pg == NULL)
+			return -FMER_OVERFLOW;
+
+		n = fmapi_pager_call(p, pg, 0, p->per, &status);
+		free(pg);
+		if (status != 0)
+			return status;
+		if (n < 0)
+			return n;
+		start = n;
+	}
+
+	if (start >= p->total)
+		return 0;
+
+	npages = (p->total - start + p->per - 1) / p->per;
+	pg = calloc(npages, sizeof(struct fmapi_page));
+	if (pg == NULL)
+		return -FMER_OVERFLOW;
+
+	// STEP 2: Send the remaining pages. A full window is drained as needed
+	rv = 0;
+	for ( sent = 0 ; sent < npages ; sent++ )
+	{
+		num = p->total - start - sent * p->per;
+		if (num > p->per)
+			num = p->per;
+		fmapi_pager_fill(p, &pg[sent], start + sent * p->per, num);
+
+		while ( (n = fmapi_session_submit(p->s, &pg[sent].x)) == -FMER_BUSY )
+		{
+			n = fmapi_session_step(p->s);
+			if (n < 0)
+			{
+				fmapi_session_fail(p->s, n);
+				break;
+			}
+		}
+		if (n < 0)
+		{
+			rv = n;
+			break;
+		}
+	}
+
+	// STEP 3: Wait for each page sent and merge it, filling short pages
+	for ( i = 0 ; i < sent ; i++ )
+	{
+		status = fmapi_session_wait(p->s, &pg[i].x);
+		if (status != 0)
+		{
+			if (rv == 0)
+				rv = status;
+			continue;
+		}
+		if (rv != 0)
+			continue;
+
+		n = fmapi_pager_merge(p, &pg[i]);
+		start = pg[i].start;
+		num = pg[i].num;
+		status = 0;
+		while ( (n > 0) && ((unsigned) n < num) )
+		{
+			start += n;
+			num -= n;
+			n = fmapi_pager_call(p, &pg[i], start, num, &status);
+		}
+		if (status != 0)
+			rv = status;
+		else if (n <= 0)
+			rv = (n == 0) ? -FMER_TRUNCATED : n;
+	}
+
+	free(pg);
+
+	return rv;
+}
+
+/**
+ * Read the state of a VCS and of all of its vPPBs
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] vcsid int VCS ID
+ * @param[out] blk struct fmapi_vsc_info_blk* with num set to the number of vPPBs read
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+int fmapi_page_vsc_info(struct fmapi_session *s, int vcsid, struct fmapi_vsc_info_blk *blk)
+{
+	struct fmapi_pager p;
+	int rv;
+
+	// Validate Inputs
+	if ( (s == NULL) || (blk == NULL) || (vcsid < 0) || (vcsid >= FM_MAX_VCS) )
+		return -FMER_INVALID;
+
+	memset(blk, 0, sizeof(*blk));
+	memset(&p, 0, sizeof(p));
+	p.s = s;
+	p.opcode = FMOP_VSC_INFO;
+	p.id = vcsid;
+	p.out = blk;
+
+	rv = fmapi_pager_run(&p);
+	if (rv == 0)
+		blk->num = blk->total;
+
+	return rv;
+}
+
+/**
+ * Read the memory allocation of every LD of an MLD
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[out] rsp struct fmapi_mcc_alloc_get_rsp* with num set to the number of LDs read
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+int fmapi_page_mcc_alloc(struct fmapi_session *s, struct fmapi_mcc_alloc_get_rsp *rsp)
+{
+	struct fmapi_pager p;
+	int rv;
+
+	// Validate Inputs
+	if ( (s == NULL) || (rsp == NULL) )
+		return -FMER_INVALID;
+
+	memset(rsp, 0, sizeof(*rsp));
+	memset(&p, 0, sizeof(p));
+	p.s = s;
+	p.opcode = FMOP_MCC_ALLOC_GET;
+	p.out = rsp;
+
+	rv = fmapi_pager_run(&p);
+	if (rv == 0)
+		rsp->num = p.total;
+
+	return rv;
+}
+
+/**
+ * Read the QoS allocated bandwidth fraction of the first num LDs
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] num int Number of LDs as returned by Get LD Info
+ * @param[out] rsp struct fmapi_mcc_qos_bw_alloc* with num set to the number of LDs read
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+int fmapi_page_mcc_qos_alloc(struct fmapi_session *s, int num, struct fmapi_mcc_qos_bw_alloc *rsp)
+{
+	struct fmapi_pager p;
+	int rv;
+
+	// Validate Inputs
+	if ( (s == NULL) || (rsp == NULL) || (num <= 0) || (num > FM_MAX_NUM_LD) )
+		return -FMER_INVALID;
+
+	memset(rsp, 0, sizeof(*rsp));
+	memset(&p, 0, sizeof(p));
+	p.s = s;
+	p.opcode = FMOP_MCC_QOS_BW_ALLOC_GET;
+	p.total = num;
+	p.out = rsp;
+
+	rv = fmapi_pager_run(&p);
+	if (rv == 0)
+		rsp->num = num;
+
+	return rv;
+}
+
+/**
+ * Read the QoS bandwidth limit fraction of the first num LDs
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] num int Number of LDs as returned by Get LD Info
+ * @param[out] rsp struct fmapi_mcc_qos_bw_limit* with num set to the number of LDs read
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+int fmapi_page_mcc_qos_limit(struct fmapi_session *s, int num, struct fmapi_mcc_qos_bw_limit *rsp)
+{
+	struct fmapi_pager p;
+	int rv;
+
+	// Validate Inputs
+	if ( (s == NULL) || (rsp == NULL) || (num <= 0) || (num > FM_MAX_NUM_LD) )
+		return -FMER_INVALID;
+
+	memset(rsp, 0, sizeof(*rsp));
+	memset(&p, 0, sizeof(p));
+	p.s = s;
+	p.opcode = FMOP_MCC_QOS_BW_LIMIT_GET;
+	p.total = num;
+	p.out = rsp;
+
+	rv = fmapi_pager_run(&p);
+	if (rv == 0)
+		rsp->num = num;
+
+	return rv;
+}
@@ -0,0 +1,1000 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		session.c
+ *
+ * @brief 		Code file for CXL Fabric Management API client sessions
+ *
+ * @details 	A session pipelines requests to one endpoint over a transport
+ * 				and matches each response to its request by the FM API
+ * 				Header tag.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2026
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* errno
+ */
+#include <errno.h>
+
+/* INT_MAX
+ */
+#include <limits.h>
+
+/* calloc(), free()
+ */
+#include <stdlib.h>
+
+/* memset()
+ */
+#include <string.h>
+
+/* poll()
+ */
+#include <poll.h>
+
+/* clock_gettime()
+ */
+#include <time.h>
+
+#include "main.h"
+
+/* MACROS ====================================================================*/
+
+/**
+ * Default number of requests a struct fmapi_pipe keeps in flight
+ */
+#define FMSN_DEPTH 		16
+
+/**
+ * Index into the free tag FIFO of a session
+ */
+#define FMSN_IDX(i) 	((i) & (FM_MAX_TAGS - 1))
+
+/**
+ * Slot index of a tick in a timer wheel level
+ */
+#define FMTW_IDX(tick, lvl) 	(((tick) >> (FMTW_BITS * (lvl))) & (FMTW_SLOTS - 1))
+
+/* PROTOTYPES ================================================================*/
+
+static void fmapi_session_complete(struct fmapi_session *s, struct fmapi_xfer *x, int status);
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Current time in milliseconds from a monotonic clock, as used for session timers
+ *
+ * @return __u64 milliseconds
+ */
+__u64 fmapi_now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (__u64) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Initialize a timer wheel
+ *
+ * @param[out] w struct fmapi_timer_wheel* to initialize
+ * @param[in] now __u64 Current tick
+ */
+void fmapi_timer_wheel_init(struct fmapi_timer_wheel *w, __u64 now)
+{
+	struct fmapi_timer *h;
+	unsigned l, i;
+
+	for ( l = 0 ; l < FMTW_LEVELS ; l++ )
+	{
+		for ( i = 0 ; i < FMTW_SLOTS ; i++ )
+		{
+			h = &w->slot[l][i];
+			h->next = h->prev = h;
+		}
+	}
+
+	w->clk = now + 1;
+	w->num = 0;
+}
+
+/**
+ * Link a timer into the slot that covers its expiry
+ *
+ * The level is chosen by the distance to the next tick to process and the
+ * slot by the absolute expiry, so a timer is cascaded down exactly when the
+ * wheel reaches the start of its slot.
+ *
+ * @param[in] w struct fmapi_timer_wheel*
+ * @param[in] t struct fmapi_timer* with expires set. Not linked
+ */
+static void fmapi_timer_link(struct fmapi_timer_wheel *w, struct fmapi_timer *t)
+{
+	struct fmapi_timer *h;
+	__u64 delta;
+	unsigned l;
+
+	// Overdue timers fire on the next tick
+	if (t->expires < w->clk)
+		t->expires = w->clk;
+
+	delta = t->expires - w->clk;
+	if (delta > FMTW_MAX_DELAY)
+	{
+		delta = FMTW_MAX_DELAY;
+		t->expires = w->clk + delta;
+	}
+
+	for ( l = 0 ; l < FMTW_LEVELS - 1 ; l++ )
+		if (delta < (1ULL << (FMTW_BITS * (l + 1))))
+			break;
+
+	h = &w->slot[l][FMTW_IDX(t->expires, l)];
+	t->next = h;
+	t->prev = h->prev;
+	h->prev->next = t;
+	h->prev = t;
+}
+
+/**
+ * Remove a timer from its slot
+ */
+static void fmapi_timer_unlink(struct fmapi_timer *t)
+{
+	t->prev->next = t->next;
+	t->next->prev = t->prev;
+	t->next = t->prev = NULL;
+}
+
+/**
+ * Move all timers of a slot to a private list
+ *
+ * @param[in] h struct fmapi_timer* Slot list head
+ * @param[out] list struct fmapi_timer* Head of the private list
+ */
+static void fmapi_timer_splice(struct fmapi_timer *h, struct fmapi_timer *list)
+{
+	if (h->next == h)
+	{
+		list->next = list->prev = list;
+		return;
+	}
+
+	list->next = h->next;
+	list->prev = h->prev;
+	list->next->prev = list;
+	list->prev->next = list;
+	h->next = h->prev = h;
+}
+
+/**
+ * Arm a timer, replacing any earlier expiry
+ *
+ * @param[in] w struct fmapi_timer_wheel*
+ * @param[in] t struct fmapi_timer* to arm
+ * @param[in] expires __u64 Tick at which the timer fires
+ */
+void fmapi_timer_arm(struct fmapi_timer_wheel *w, struct fmapi_timer *t, __u64 expires)
+{
+	if (t->next != NULL)
+		fmapi_timer_unlink(t);
+	else
+		w->num++;
+
+	t->expires = expires;
+	fmapi_timer_link(w, t);
+}
+
+/**
+ * Disarm a timer. Does nothing if the timer is not armed
+ *
+ * @param[in] w struct fmapi_timer_wheel*
+ * @param[in] t struct fmapi_timer* to disarm
+ */
+void fmapi_timer_cancel(struct fmapi_timer_wheel *w, struct fmapi_timer *t)
+{
+	if (t->next == NULL)
+		return;
+
+	fmapi_timer_unlink(t);
+	w->num--;
+}
+
+/**
+ * Turn the wheel up to now and fire every timer that expired
+ *
+ * @param[in] w struct fmapi_timer_wheel*
+ * @param[in] now __u64 Current tick
+ * @param[in] fn Function called for each expired timer
+ * @param[in] arg void* passed to fn
+ * @return number of timers fired
+ */
+int fmapi_timer_wheel_advance(struct fmapi_timer_wheel *w, __u64 now, void (*fn)(void *arg, struct fmapi_timer *t), void *arg)
+{
+	struct fmapi_timer list, *t;
+	unsigned l, i;
+	int fired;
+
+	fired = 0;
+	while (w->clk <= now)
+	{
+		// Nothing armed: jump straight to now
+		if (w->num == 0)
+		{
+			w->clk = now + 1;
+			break;
+		}
+
+		// At the start of a turn of level 0, cascade the next slot of each level
+		if (FMTW_IDX(w->clk, 0) == 0)
+		{
+			for ( l = 1 ; l < FMTW_LEVELS ; l++ )
+			{
+				i = FMTW_IDX(w->clk, l);
+				fmapi_timer_splice(&w->slot[l][i], &list);
+				while (list.next != &list)
+				{
+					t = list.next;
+					fmapi_timer_unlink(t);
+					fmapi_timer_link(w, t);
+				}
+				if (i != 0)
+					break;
+			}
+		}
+
+		// The clock moves first so timers re-armed by fn land on a later tick
+		fmapi_timer_splice(&w->slot[0][FMTW_IDX(w->clk, 0)], &list);
+		w->clk++;
+
+		while (list.next != &list)
+		{
+			t = list.next;
+			fmapi_timer_unlink(t);
+			w->num--;
+			fn(arg, t);
+			fired++;
+		}
+	}
+
+	return fired;
+}
+
+/**
+ * Tick by which fmapi_timer_wheel_advance() must be called next
+ *
+ * @param[in] w struct fmapi_timer_wheel*
+ * @return tick, or ~0 if no timer is armed
+ */
+__u64 fmapi_timer_wheel_next(struct fmapi_timer_wheel *w)
+{
+	struct fmapi_timer *h;
+	__u64 tick;
+
+	if (w->num == 0)
+		return ~0ULL;
+
+	// Scan level 0 up to the next cascade
+	tick = w->clk;
+	do
+	{
+		h = &w->slot[0][FMTW_IDX(tick, 0)];
+		if (h->next != h)
+			return tick;
+		tick++;
+	}
+	while (FMTW_IDX(tick, 0) != 0);
+
+	return tick;
+}
+
+/**
+ * Next value of the jitter random number generator (xorshift64*)
+ */
+static __u64 fmapi_session_rand(struct fmapi_session *s)
+{
+	s->seed ^= s->seed >> 12;
+	s->seed ^= s->seed << 25;
+	s->seed ^= s->seed >> 27;
+
+	return s->seed * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Delay before resending a request that has been sent x->tries times
+ *
+ * @param[in] s struct fmapi_session* with a policy
+ * @param[in] x struct fmapi_xfer*
+ * @return delay in milliseconds
+ */
+static __u64 fmapi_session_delay(struct fmapi_session *s, struct fmapi_xfer *x)
+{
+	const struct fmapi_retry_policy *p = s->policy;
+	__u64 delay, j;
+
+	delay = p->max_ms;
+	if ( (x->tries - 1 < 32) && (((__u64) p->base_ms << (x->tries - 1)) < p->max_ms) )
+		delay = (__u64) p->base_ms << (x->tries - 1);
+
+	j = (p->jitter >= 100) ? delay : delay * p->jitter / 100;
+	if (j > 0)
+		delay = delay - j + fmapi_session_rand(s) % (j + 1);
+
+	return delay;
+}
+
+/**
+ * Check whether the policy allows another attempt after this outcome
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] x struct fmapi_xfer*
+ * @param[in] rc int Response return code [FMRC], or -FMER_TIMEOUT
+ * @return 1 if the request should be resent, 0 otherwise
+ */
+static int fmapi_session_retry(struct fmapi_session *s, struct fmapi_xfer *x, int rc)
+{
+	const struct fmapi_retry_policy *p = s->policy;
+
+	if ( (p == NULL) || (x->tries >= p->max_tries) )
+		return 0;
+
+	if (rc == -FMER_TIMEOUT)
+		return p->retry_timeout;
+
+	return (rc >= 0) && (rc < 32) && (p->retry_rc & (1U << rc));
+}
+
+/**
+ * Send the request of an exchange and arm its response timeout
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] x struct fmapi_xfer* holding a tag
+ * @return number of bytes sent, or a negative enum _FMER upon error
+ */
+static int fmapi_session_send(struct fmapi_session *s, struct fmapi_xfer *x)
+{
+	int rv;
+
+	x->backoff = 0;
+	x->timedout = 0;
+	x->tries++;
+
+	rv = fmapi_transport_send_msg(s->t, x->req, FMMT_REQ, x->tag);
+	if (rv < 0)
+		return rv;
+
+	if ( (s->policy != NULL) && (s->policy->timeout_ms > 0) )
+		fmapi_timer_arm(&s->wheel, &x->timer, fmapi_now_ms() + s->policy->timeout_ms);
+
+	return rv;
+}
+
+/**
+ * Handle an expired session timer
+ *
+ * The timer is either the resend delay of an exchange in backoff or the
+ * response timeout of an exchange in flight.
+ *
+ * @param[in] arg struct fmapi_session*
+ * @param[in] t struct fmapi_timer* embedded in a struct fmapi_xfer
+ */
+static void fmapi_session_fire(void *arg, struct fmapi_timer *t)
+{
+	struct fmapi_session *s = (struct fmapi_session*) arg;
+	struct fmapi_xfer *x;
+	int rv;
+
+	x = (struct fmapi_xfer*) ((__u8*) t - offsetof(struct fmapi_xfer, timer));
+
+	if (x->backoff)
+	{
+		rv = fmapi_session_send(s, x);
+		if (rv < 0)
+			fmapi_session_complete(s, x, rv);
+		return;
+	}
+
+	if (fmapi_session_retry(s, x, -FMER_TIMEOUT))
+	{
+		x->backoff = 1;
+		x->timedout = 1;
+		fmapi_timer_arm(&s->wheel, &x->timer, fmapi_now_ms() + fmapi_session_delay(s, x));
+		return;
+	}
+
+	fmapi_session_complete(s, x, -FMER_TIMEOUT);
+}
+
+/**
+ * Initialize a session
+ *
+ * @param[out] s struct fmapi_session* to initialize
+ * @param[in] t struct fmapi_transport* to the endpoint
+ * @param[in] window unsigned Maximum number of outstanding requests,
+ * 				1 to FM_MAX_TAGS. 0 selects FM_MAX_TAGS
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_session_init(struct fmapi_session *s, struct fmapi_transport *t, unsigned window)
+{
+	unsigned i;
+
+	// Validate Inputs
+	if ( (s == NULL) || (t == NULL) || (window > FM_MAX_TAGS) )
+		return -FMER_INVALID;
+
+	memset(s, 0, sizeof(*s));
+	s->t = t;
+	s->window = (window == 0) ? FM_MAX_TAGS : window;
+
+	// Every tag starts out free
+	for ( i = 0 ; i < FM_MAX_TAGS ; i++ )
+		s->free[i] = i;
+	s->head = 0;
+	s->tail = FM_MAX_TAGS;
+	s->rsp_limit = FMLN_PAYLOAD;
+	s->req_limit = FMLN_PAYLOAD;
+
+	fmapi_timer_wheel_init(&s->wheel, fmapi_now_ms());
+	s->seed = fmapi_now_ms() ^ (__u64) (size_t) s ^ 0x9E3779B97F4A7C15ULL;
+
+	return 0;
+}
+
+/**
+ * Change the number of requests that may be outstanding
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] window unsigned 1 to FM_MAX_TAGS. 0 selects FM_MAX_TAGS
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_session_set_window(struct fmapi_session *s, unsigned window)
+{
+	if ( (s == NULL) || (window > FM_MAX_TAGS) )
+		return -FMER_INVALID;
+
+	s->window = (window == 0) ? FM_MAX_TAGS : window;
+
+	return 0;
+}
+
+/**
+ * Release the tag of an exchange and mark it complete
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] x struct fmapi_xfer* that is outstanding on s
+ * @param[in] status int Return code [FMRC] or negative enum _FMER
+ */
+static void fmapi_session_complete(struct fmapi_session *s, struct fmapi_xfer *x, int status)
+{
+	fmapi_timer_cancel(&s->wheel, &x->timer);
+	s->slot[x->tag] = NULL;
+	s->free[FMSN_IDX(s->tail++)] = x->tag;
+	s->inflight--;
+
+	x->status = status;
+	x->done = 1;
+	if (x->cb != NULL)
+		x->cb(x);
+}
+
+/**
+ * Assign a tag to an exchange and send its request
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in,out] x struct fmapi_xfer* with req set. Must stay valid until done
+ * @return tag assigned to the request, -FMER_BUSY if the window is full,
+ * 			-FMER_OVERFLOW if the request is longer than s->req_limit, or
+ * 			another negative enum _FMER upon error
+ */
+int fmapi_session_submit(struct fmapi_session *s, struct fmapi_xfer *x)
+{
+	__u8 tag;
+	int rv;
+
+	// Validate Inputs
+	if ( (s == NULL) || (x == NULL) || (x->req == NULL) )
+		return -FMER_INVALID;
+
+	// The endpoint drops requests longer than it accepts
+	if ((unsigned) fmapi_wire_len(&x->req->obj, fmapi_fmob_req(x->req->hdr.opcode)) > s->req_limit)
+		return -FMER_OVERFLOW;
+
+	if (s->inflight >= s->window)
+		return -FMER_BUSY;
+
+	tag = s->free[FMSN_IDX(s->head++)];
+	s->slot[tag] = x;
+	s->inflight++;
+
+	x->tag = tag;
+	x->status = 0;
+	x->done = 0;
+	x->tries = 0;
+	x->timer.next = NULL;
+
+	rv = fmapi_session_send(s, x);
+	if (rv < 0)
+	{
+		// Give the tag back without running the callback
+		s->slot[tag] = NULL;
+		s->free[FMSN_IDX(s->tail++)] = tag;
+		s->inflight--;
+		return rv;
+	}
+
+	return tag;
+}
+
+/**
+ * Receive one response and complete the exchange it belongs to
+ *
+ * @param[in] s struct fmapi_session*
+ * @return 1 if an exchange completed, 0 if not, or a negative enum _FMER
+ * 			upon a transport error
+ */
+int fmapi_session_poll(struct fmapi_session *s)
+{
+	struct fmapi_xfer *x;
+	struct fmapi_hdr hdr;
+	__u8 *frame;
+	int len, rv;
+
+	if (s == NULL)
+		return -FMER_INVALID;
+
+	len = fmapi_transport_recv(s->t, &frame);
+	if (len <= 0)
+		return len;
+
+	// Match on the header before decoding any payload. A late response to an 
+	// attempt that timed out still counts and cancels the pending resend, so 
+	// the request is not run twice 
+	fmapi_deserialize(&hdr, frame, FMOB_HDR, NULL);
+	x = s->slot[hdr.tag];
+	if ( (x == NULL) || (x->backoff && !x->timedout) || (hdr.category != FMMT_RESP) || (hdr.opcode != x->req->hdr.opcode) )
+	{
+		s->stray++;
+		return 0;
+	}
+
+	// Resend later if the policy retries this return code
+	if (fmapi_session_retry(s, x, hdr.return_code))
+	{
+		x->backoff = 1;
+		x->timedout = 0;
+		fmapi_timer_arm(&s->wheel, &x->timer, fmapi_now_ms() + fmapi_session_delay(s, x));
+		return 0;
+	}
+
+	rv = hdr.return_code;
+	if ( (x->decode != NULL) && (rv == 0) )
+	{
+		len = x->decode(x, frame, len);
+		if (len < 0)
+			rv = len;
+	}
+	else if (x->rsp != NULL)
+	{
+		len = fmapi_msg_decode(x->rsp, frame, len, x->param);
+		if (len < 0)
+			rv = len;
+	}
+
+	fmapi_session_complete(s, x, rv);
+	return 1;
+}
+
+/**
+ * Fire expired timers, then wait up to ms for and process one frame
+ *
+ * The wait ends early when the next session timer is due
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] ms int Longest wait in milliseconds, or -1 for no limit
+ * @return 1 if an exchange completed, 0 if not, or a negative enum _FMER
+ */
+int fmapi_session_step_ms(struct fmapi_session *s, int ms)
+{
+	struct pollfd pfd;
+	int rv, timeout;
+
+	// Let the caller see exchanges that timed out before blocking again
+	if (fmapi_session_expire(s) > 0)
+		return 0;
+
+	if (!fmapi_parser_ready(&s->t->parser))
+	{
+		pfd.fd = fmapi_transport_poll_fd(s->t);
+		pfd.events = POLLIN;
+		if (pfd.fd >= 0)
+		{
+			timeout = fmapi_session_timeout(s);
+			if ( (ms >= 0) && ((timeout < 0) || (ms < timeout)) )
+				timeout = ms;
+
+			rv = poll(&pfd, 1, timeout);
+			if ( (rv < 0) && (errno != EINTR) )
+				return -FMER_IO;
+			if (rv <= 0)
+				return 0;
+		}
+	}
+
+	return fmapi_session_poll(s);
+}
+
+/**
+ * Fire expired timers, then wait for and process one frame
+ *
+ * The wait ends early when the next session timer is due
+ *
+ * @param[in] s struct fmapi_session*
+ * @return 1 if an exchange completed, 0 if not, or a negative enum _FMER
+ */
+int fmapi_session_step(struct fmapi_session *s)
+{
+	return fmapi_session_step_ms(s, -1);
+}
+
+/**
+ * Wait for an exchange to complete
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] x struct fmapi_xfer* submitted on s
+ * @return x->status
+ */
+int fmapi_session_wait(struct fmapi_session *s, struct fmapi_xfer *x)
+{
+	int rv;
+
+	if ( (s == NULL) || (x == NULL) )
+		return -FMER_INVALID;
+
+	while (!x->done)
+	{
+		rv = fmapi_session_step(s);
+		if (rv < 0)
+			fmapi_session_fail(s, rv);
+	}
+
+	return x->status;
+}
+
+/**
+ * Send a request and wait for its response
+ *
+ * When the window is full, responses to earlier requests are processed
+ * until a tag is free.
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] req struct fmapi_msg* Request to send
+ * @param[out] rsp struct fmapi_msg* to decode the response into. May be NULL
+ * @param[in] param void * passed to fmapi_msg_decode() for the response
+ * @return Response return code [FMRC], or a negative enum _FMER upon error
+ */
+int fmapi_session_call(struct fmapi_session *s, struct fmapi_msg *req, struct fmapi_msg *rsp, void *param)
+{
+	struct fmapi_xfer x;
+	int rv;
+
+	memset(&x, 0, sizeof(x));
+	x.req = req;
+	x.rsp = rsp;
+	x.param = param;
+
+	while ( (rv = fmapi_session_submit(s, &x)) == -FMER_BUSY )
+	{
+		rv = fmapi_session_step(s);
+		if (rv < 0)
+		{
+			fmapi_session_fail(s, rv);
+			return rv;
+		}
+	}
+	if (rv < 0)
+		return rv;
+
+	return fmapi_session_wait(s, &x);
+}
+
+/**
+ * Release the slot of a completed pipe request
+ */
+static void fmapi_pipe_done(struct fmapi_xfer *x)
+{
+	struct fmapi_pipe_slot *sl = (struct fmapi_pipe_slot*) x->arg;
+	struct fmapi_pipe *p = sl->pipe;
+
+	if ( (x->status != 0) && (p->rv == 0) )
+		p->rv = x->status;
+
+	p->inflight--;
+	sl->next = p->free;
+	p->free = sl;
+}
+
+/**
+ * Allocate the slots of a pipe
+ *
+ * @param[out] p struct fmapi_pipe* to initialize
+ * @param[in] s struct fmapi_session* to send requests on
+ * @param[in] depth unsigned Maximum number of requests in flight. 0 selects a default
+ * @param[in] size size_t Size of one slot, which starts with a struct fmapi_pipe_slot
+ * @param[in] next Fills the next request into a slot. Returns 0 when none is left
+ * @param[in] arg void* Caller data for next
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_pipe_init(struct fmapi_pipe *p, struct fmapi_session *s, unsigned depth, size_t size, int (*next)(struct fmapi_pipe *p, struct fmapi_pipe_slot *sl), void *arg)
+{
+	struct fmapi_pipe_slot *sl;
+	unsigned i;
+
+	// Validate Inputs
+	if ( (p == NULL) || (s == NULL) || (next == NULL) || (size < sizeof(struct fmapi_pipe_slot)) )
+		return -FMER_INVALID;
+
+	memset(p, 0, sizeof(*p));
+	p->s = s;
+	p->next = next;
+	p->arg = arg;
+	p->depth = (depth == 0) ? FMSN_DEPTH : depth;
+
+	p->slot = calloc(p->depth, size);
+	if (p->slot == NULL)
+		return -FMER_OVERFLOW;
+
+	for ( i = 0 ; i < p->depth ; i++ )
+	{
+		sl = (struct fmapi_pipe_slot*) ((__u8*) p->slot + i * size);
+		sl->pipe = p;
+		sl->next = p->free;
+		p->free = sl;
+	}
+
+	return 0;
+}
+
+/**
+ * Send every request next() produces and wait for them all
+ *
+ * A request refused because the window of the session is full is kept and
+ * sent again once a tag is free.
+ *
+ * @param[in] p struct fmapi_pipe*
+ * @return 0 upon success, the first non zero Response return code [FMRC],
+ * 			or a negative enum _FMER upon error
+ */
+int fmapi_pipe_run(struct fmapi_pipe *p)
+{
+	struct fmapi_pipe_slot *sl;
+	int rv, more;
+
+	// Validate Inputs
+	if (p == NULL)
+		return -FMER_INVALID;
+
+	sl = NULL;
+	more = 1;
+
+	// Keep the window full until every request is sent, then drain it
+	for (;;)
+	{
+		while ( (p->rv == 0) && ((sl != NULL) || (more && (p->free != NULL))) )
+		{
+			if (sl == NULL)
+			{
+				sl = p->free;
+				memset(&sl->x, 0, sizeof(sl->x));
+				sl->x.cb = fmapi_pipe_done;
+				sl->x.arg = sl;
+				more = p->next(p, sl);
+				if (!more)
+				{
+					sl = NULL;
+					break;
+				}
+				p->free = sl->next;
+			}
+
+			rv = fmapi_session_submit(p->s, &sl->x);
+			if (rv == -FMER_BUSY)
+				break;
+			if (rv < 0)
+			{
+				p->rv = rv;
+				sl->next = p->free;
+				p->free = sl;
+				sl = NULL;
+				break;
+			}
+			p->inflight++;
+			sl = NULL;
+		}
+
+		if ( (p->inflight == 0) && (((sl == NULL) && !more) || (p->rv != 0)) )
+			break;
+
+		rv = fmapi_session_step(p->s);
+		if (rv < 0)
+			fmapi_session_fail(p->s, rv);
+	}
+
+	// A request left unsent after an error goes back to the free list
+	if (sl != NULL)
+	{
+		sl->next = p->free;
+		p->free = sl;
+	}
+
+	return p->rv;
+}
+
+/**
+ * Release the slots of a pipe
+ *
+ * @param[in] p struct fmapi_pipe* with nothing in flight
+ */
+void fmapi_pipe_free(struct fmapi_pipe *p)
+{
+	if (p == NULL)
+		return;
+
+	free(p->slot);
+	p->slot = NULL;
+	p->free = NULL;
+}
+
+/**
+ * Agree on message sizes with the endpoint
+ *
+ * @param[in] s struct fmapi_session* with no request outstanding
+ * @param[in] max size_t Largest message this side accepts. 0 selects FMLN_MSG
+ * @return 0 upon success, a non zero Response return code [FMRC], or a
+ * 			negative enum _FMER upon error
+ */
+int fmapi_session_negotiate(struct fmapi_session *s, size_t max)
+{
+	struct fmapi_msg req, rsp;
+	unsigned dev, ours, n;
+	int rv;
+
+	// Validate Inputs
+	if ( (s == NULL) || (max > (1UL << FM_MSG_LIMIT_MAX)) )
+		return -FMER_INVALID;
+	if (max == 0)
+		max = FMLN_MSG;
+	if (max < (1UL << FM_MSG_LIMIT_MIN))
+		return -FMER_INVALID;
+
+	// Largest power of two that fits this side
+	for ( ours = FM_MSG_LIMIT_MIN ; (ours < FM_MSG_LIMIT_MAX) && ((1UL << (ours + 1)) <= max) ; ours++ ) ;
+
+	// STEP 1: Identify to learn the largest message the endpoint supports
+	fmapi_fill_isc_id(&req);
+	rv = fmapi_session_call(s, &req, &rsp, NULL);
+	if (rv != 0)
+		return rv;
+
+	dev = rsp.obj.isc_id_rsp.size;
+	if ( (dev < FM_MSG_LIMIT_MIN) || (dev > FM_MSG_LIMIT_MAX) )
+		return -FMER_INVALID;
+
+	// STEP 2: Set Response Message Limit to the largest size both sides support
+	n = (dev < ours) ? dev : ours;
+	fmapi_fill_isc_set_msg_limit(&req, n);
+	rv = fmapi_session_call(s, &req, &rsp, NULL);
+	if (rv != 0)
+		return rv;
+
+	// The endpoint reports the limit it applied, which may be lower
+	n = rsp.obj.isc_msg_limit.limit;
+	if ( (n < FM_MSG_LIMIT_MIN) || (n > ours) )
+		return -FMER_INVALID;
+
+	// STEP 3: Size the receive buffer and the limits of the session
+	rv = fmapi_transport_set_max(s->t, 1UL << n);
+	if (rv < 0)
+		return rv;
+
+	s->rsp_limit = (1U << n) - FMLN_HDR;
+	s->req_limit = (1U << ((dev < ours) ? dev : ours)) - FMLN_HDR;
+
+	return 0;
+}
+
+/**
+ * Number of list entries that fit in one response of a session
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] fixed unsigned Length of the response before the list
+ * @param[in] entry unsigned Length of one list entry
+ * @return number of entries
+ */
+unsigned fmapi_session_list_max(struct fmapi_session *s, unsigned fixed, unsigned entry)
+{
+	unsigned max;
+
+	if (s->rsp_limit < fixed + entry)
+		return 1;
+
+	max = (s->rsp_limit - fixed) / entry;
+
+	return (max > FM_MAX_LIST) ? FM_MAX_LIST : max;
+}
+
+/**
+ * Set the timeout and retry policy of a session
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] policy const struct fmapi_retry_policy* NULL to disable timeouts and retries
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_session_set_policy(struct fmapi_session *s, const struct fmapi_retry_policy *policy)
+{
+	if (s == NULL)
+		return -FMER_INVALID;
+
+	s->policy = policy;
+
+	return 0;
+}
+
+/**
+ * Fire the session timers that expired
+ *
+ * @param[in] s struct fmapi_session*
+ * @return number of timers fired
+ */
+int fmapi_session_expire(struct fmapi_session *s)
+{
+	if (s == NULL)
+		return 0;
+
+	return fmapi_timer_wheel_advance(&s->wheel, fmapi_now_ms(), fmapi_session_fire, s);
+}
+
+/**
+ * Milliseconds until the next session timer may fire
+ *
+ * @param[in] s struct fmapi_session*
+ * @return milliseconds, or -1 if no timer is armed. Suitable for poll()
+ */
+int fmapi_session_timeout(struct fmapi_session *s)
+{
+	__u64 next, now;
+
+	if ( (s == NULL) || (s->wheel.num == 0) )
+		return -1;
+
+	next = fmapi_timer_wheel_next(&s->wheel);
+	now = fmapi_now_ms();
+	if (next <= now)
+		return 0;
+	if (next - now > INT_MAX)
+		return INT_MAX;
+
+	return next - now;
+}
+
+/**
+ * Complete every outstanding exchange with an error
+ *
+ * @param[in] s struct fmapi_session*
+ * @param[in] status int Negative enum _FMER stored in each exchange
+ */
+void fmapi_session_fail(struct fmapi_session *s, int status)
+{
+	unsigned i;
+
+	if (s == NULL)
+		return;
+
+	for ( i = 0 ; (i < FM_MAX_TAGS) && (s->inflight > 0) ; i++ )
+		if (s->slot[i] != NULL)
+			fmapi_session_complete(s, s->slot[i], status);
+}
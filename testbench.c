@@ -25,6 +25,26 @@
  */
 #include <string.h>
 
+/* clock_gettime()
+ */
+#include <time.h>
+
+/* SOCK_STREAM, SOCK_SEQPACKET
+ */
+#include <sys/socket.h>
+
+/* poll()
+ */
+#include <poll.h>
+
+/* fcntl(), O_NONBLOCK
+ */
+#include <fcntl.h>
+
+/* pthread_create(), pthread_join()
+ */
+#include <pthread.h>
+
 /* au_prnt_buf()
  */
 #include <arrayutils.h>
@@ -35,6 +55,37 @@
 
 /* ENUMERATIONS ==============================================================*/
 
+/**
+ * Tests that are not tied to a single FM API Object are numbered after FMOB_MAX
+ */
+enum _TEST {
+	TEST_SIZES 				= FMOB_MAX,
+	TEST_DESERIALIZE_LEN,
+	TEST_PARSER,
+	TEST_TRANSPORT,
+	TEST_SESSION,
+	TEST_COALESCE,
+	TEST_MSG_ALLOC,
+	TEST_ROUNDTRIP,
+	TEST_PORT_TABLE,
+	TEST_IOV,
+	TEST_BATCH,
+	TEST_MSG_DECODE,
+	TEST_POOL,
+	TEST_ARENA,
+	TEST_TUNNEL,
+	TEST_RETRY,
+	TEST_PAGE,
+	TEST_LIMIT,
+	TEST_LD_MEM,
+	TEST_CFG_SNAPSHOT,
+	TEST_CFG_CACHE,
+	TEST_BOS_POLL,
+	TEST_BOS_SCHED,
+	TEST_VIEW,
+	TEST_MAX
+};
+
 /* STRUCTS ===================================================================*/
 
 /* GLOBAL VARIABLES ==========================================================*/
@@ -66,6 +117,10 @@ void print_strings()
 	printf("fmop %d: %s\n", i++, fmop(FMOP_MCC_QOS_BW_ALLOC_SET			));
 	printf("fmop %d: %s\n", i++, fmop(FMOP_MCC_QOS_BW_LIMIT_GET				));
 	printf("fmop %d: %s\n", i++, fmop(FMOP_MCC_QOS_BW_LIMIT_SET				));
+	printf("fmop %d: %s\n", i++, fmop(FMOP_ISC_ID						));
+	printf("fmop %d: %s\n", i++, fmop(FMOP_ISC_BOS					));
+	printf("fmop %d: %s\n", i++, fmop(FMOP_ISC_MSG_LIMIT_GET			));
+	printf("fmop %d: %s\n", i++, fmop(FMOP_ISC_MSG_LIMIT_SET			));
 	
 	for ( int i = 0 ; i < FMMT_MAX; i++ )
 		printf("fmmt %d: %s\n", i, fmmt(i));	
@@ -94,6 +149,9 @@ void print_strings()
 	
 	for ( int i = 0 ; i < FMBS_MAX; i++ )
 		printf("fmbs %d: %s\n", i, fmbs(i));	
+	
+	for ( int i = 0 ; i < FMCS_MAX; i++ )
+		printf("fmcs %d: %s\n", i, fmcs(i));	
 }
 
 int verify_object(void *obj, unsigned obj_len, unsigned type, unsigned buf_len)
@@ -1088,9 +1146,2670 @@ int verify_sizes()
 	printf("struct fmapi_isc_bos:                    %lu\n", sizeof(struct fmapi_isc_bos));
 	printf("struct fmapi_buf:                    	 %lu\n", sizeof(struct fmapi_buf));
 	printf("struct fmapi_msg:                    	 %lu\n", sizeof(struct fmapi_msg));
+
+	printf("Right sized struct fmapi_msg:\n");
+	for ( int i = FMOB_HDR ; i < FMOB_MAX ; i++ )
+		printf("FMOB %02d:                                 %lu\n", i, fmapi_msg_size(i, 0));
+	return 0;
+}
+
+int verify_deserialize_len()
+{
+	struct fmapi_psc_port_rsp obj;	
+	__u8 data[FMLN_PSC_GET_PHY_PORT_RESP + 2 * FMLN_PSC_GET_PHY_PORT_INFO];
+	int len, rv;
+
+	/* STEPS 
+	 * 1: Clear memory
+	 * 2: Fill in object with test data and serialize it
+	 * 3: Deserialize with the exact length 
+	 * 4: Deserialize with a truncated length
+	 * 5: Deserialize a count that exceeds the capacity of the object
+	 */
+
+	// STEP 1: Clear memory
+	memset(&obj, 0 , sizeof(obj));
+	memset(data, 0 , sizeof(data));
+
+	// STEP 2: Fill in object with test data and serialize it
+	obj.num = 2;
+	obj.list[0].ppid = 1;
+	obj.list[0].ltssm = FMLS_L0;
+	obj.list[1].ppid = 2;
+	obj.list[1].ltssm = FMLS_DETECT;
+	len = fmapi_serialize(data, &obj, FMOB_PSC_PORT_RSP);
+
+	// STEP 3: Deserialize with the exact length 
+	memset(&obj, 0 , sizeof(obj));
+	rv = fmapi_deserialize_len(&obj, data, len, FMOB_PSC_PORT_RSP, NULL);
+	printf("Exact length:     %d (expect %d)\n", rv, len);
+
+	// STEP 4: Deserialize with a truncated length
+	rv = fmapi_deserialize_len(&obj, data, len - 1, FMOB_PSC_PORT_RSP, NULL);
+	printf("Truncated length: %d - %s\n", rv, fmer(-rv));
+
+	// STEP 5: Deserialize a count that exceeds the capacity of the object
+	data[0] = FM_MAX_NUM_LD + 1;
+	rv = fmapi_deserialize_len(&obj, data, len, FMOB_MCC_QOS_BW_ALLOC, NULL);
+	printf("Count overflow:   %d - %s\n", rv, fmer(-rv));
+
+	return 0;
+}
+
+void parser_cb(void *arg, struct fmapi_msg *m, __u8 *frame, size_t len)
+{
+	int *count = (int*) arg;
+
+	(void) frame;
+
+	if (m == NULL)
+		printf("Frame %d: len: %lu not decoded\n", *count, len);
+	else 
+		printf("Frame %d: len: %lu opcode: 0x%04x tag: %u\n", *count, len, m->hdr.opcode, m->hdr.tag);
+	(*count)++;
+}
+
+int verify_parser()
+{
+	struct fmapi_parser p;
+	struct fmapi_msg m, out;
+	__u8 stream[3 * sizeof(struct fmapi_buf)];
+	__u8 buf[sizeof(struct fmapi_buf)];
+	__u8 ports[] = {1, 2, 3};
+	size_t len, off, n;
+	int count, rv;
+
+	/* STEPS 
+	 * 1: Encode three messages back to back 
+	 * 2: Feed the stream in uneven chunks
+	 * 3: Feed the whole stream at once 
+	 */
+
+	// STEP 1: Encode three messages back to back 
+	len = 0;
+	fmapi_fill_isc_id(&m);
+	len += fmapi_msg_encode(&m, &stream[len], sizeof(stream) - len, FMMT_REQ, 1);
+	fmapi_fill_psc_get_ports(&m, 3, ports);
+	len += fmapi_msg_encode(&m, &stream[len], sizeof(stream) - len, FMMT_REQ, 2);
+	fmapi_fill_mcc_get_alloc(&m, 0, 4);
+	len += fmapi_msg_encode(&m, &stream[len], sizeof(stream) - len, FMMT_REQ, 3);
+
+	// STEP 2: Feed the stream in uneven chunks
+	fmapi_parser_init(&p, buf, sizeof(buf), &out);
+	count = 0;
+	for ( off = 0, n = 1 ; off < len ; off += n, n += 3 ) 
+	{
+		if (off + n > len)
+			n = len - off;
+		rv = fmapi_parser_feed(&p, &stream[off], n, parser_cb, &count);
+		if (rv < 0)
+			printf("Feed error: %d - %s\n", rv, fmer(-rv));
+	}
+
+	// STEP 3: Feed the whole stream at once 
+	count = 0;
+	rv = fmapi_parser_feed(&p, stream, len, parser_cb, &count);
+	printf("Frames in one chunk: %d\n", rv);
+
+	return 0;
+}
+
+int verify_transport()
+{
+	struct fmapi_transport *a, *b;
+	struct fmapi_msg req, rsp, m;
+	struct timespec t0, t1;
+	const int types[] = {SOCK_STREAM, SOCK_SEQPACKET};
+	const char *tnames[] = {"stream", "seqpacket"};
+	double secs;
+	int i, k, n, rv;
+
+	/* STEPS 
+	 * 1: Create a loopback pair 
+	 * 2: Send a request, echo a response and check the tag
+	 * 3: Time a series of round trips
+	 * 4: Send on a non blocking socket whose peer does not read 
+	 */
+
+	n = 10000;
+	for ( k = 0 ; k < 2 ; k++ )
+	{
+		// STEP 1: Create a loopback pair 
+		rv = fmapi_transport_unix_pair(types[k], &a, &b);
+		if (rv < 0)
+		{
+			printf("Pair error: %d - %s\n", rv, fmer(-rv));
+			return 1;
+		}
+
+		// STEP 2: Send a request, echo a response and check the tag
+		fmapi_fill_mcc_get_alloc(&req, 0, 4);
+		fmapi_fill_mcc_get_alloc(&rsp, 0, 4);
+		rsp.obj.mcc_alloc_get_rsp.total = 4;
+		rsp.obj.mcc_alloc_get_rsp.num = 4;
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for ( i = 0 ; i < n ; i++ )
+		{
+			fmapi_transport_send_msg(a, &req, FMMT_REQ, i);
+			fmapi_transport_recv_msg(b, &m, NULL);
+			fmapi_transport_send_msg(b, &rsp, FMMT_RESP, m.hdr.tag);
+			rv = fmapi_transport_recv_msg(a, &m, NULL);
+			if ( (rv <= 0) || (m.hdr.tag != (i & 0xFF)) || (m.obj.mcc_alloc_get_rsp.num != 4) )
+			{
+				printf("Round trip %d failed: %d\n", i, rv);
+				break;
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		// STEP 3: Time a series of round trips
+		secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		printf("%s: %d round trips in %.3f s: %.0f/s\n", tnames[k], i, secs, i / secs);
+
+		fmapi_transport_close(a);
+		fmapi_transport_close(b);
+	}
+
+	// STEP 4: Send on a non blocking socket whose peer does not read 
+	rv = fmapi_transport_unix_pair(SOCK_STREAM, &a, &b);
+	if (rv < 0)
+		return 1;
+	fcntl(a->fd, F_SETFL, fcntl(a->fd, F_GETFL) | O_NONBLOCK);
+	a->send_ms = 50;
+	fmapi_fill_mcc_get_alloc(&req, 0, 4);
+	for ( i = 0 ; (rv = fmapi_transport_send_msg(a, &req, FMMT_REQ, i)) > 0 ; i++ )
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("Peer not reading: %d - %s after %d frames, waited %s (expect Timeout)\n", rv, fmer(-rv), i, ( (secs >= 0.045) && (secs < 0.5) ) ? "send_ms" : "other");
+	fmapi_transport_close(a);
+	fmapi_transport_close(b);
+
+	return 0;
+}
+
+int verify_session()
+{
+	struct fmapi_transport *a, *b;
+	struct fmapi_session s;
+	struct fmapi_xfer x[8];
+	struct fmapi_msg req[8], rsp[8], m;
+	__u8 tags[8];
+	int i, rv, done;
+
+	/* STEPS 
+	 * 1: Create a loopback pair and a session on one end
+	 * 2: Submit more requests than the window allows 
+	 * 3: Answer the outstanding requests in reverse order
+	 * 4: Complete the exchanges and check each got its own response
+	 */
+
+	// STEP 1: Create a loopback pair and a session on one end
+	rv = fmapi_transport_unix_pair(SOCK_STREAM, &a, &b);
+	if (rv < 0)
+		return 1;
+	fmapi_session_init(&s, a, 4);
+
+	// STEP 2: Submit more requests than the window allows 
+	memset(x, 0, sizeof(x));
+	for ( i = 0 ; i < 8 ; i++ )
+	{
+		fmapi_fill_mcc_get_alloc(&req[i], i, 1);
+		x[i].req = &req[i];
+		x[i].rsp = &rsp[i];
+		rv = fmapi_session_submit(&s, &x[i]);
+		printf("Submit %d: %d %s\n", i, rv, (rv < 0) ? fmer(-rv) : "");
+	}
+
+	// STEP 3: Answer the outstanding requests in reverse order
+	for ( i = 0 ; i < 4 ; i++ )
+	{
+		fmapi_transport_recv_msg(b, &m, NULL);
+		tags[i] = m.hdr.tag;
+	}
+	for ( i = 3 ; i >= 0 ; i-- )
+	{
+		fmapi_fill_mcc_get_alloc(&m, 0, 1);
+		m.obj.mcc_alloc_get_rsp.total = tags[i];
+		fmapi_transport_send_msg(b, &m, FMMT_RESP, tags[i]);
+	}
+
+	// STEP 4: Complete the exchanges and check each got its own response
+	for ( done = 0 ; done < 4 ; done += rv )
+		rv = fmapi_session_poll(&s);
+	for ( i = 0 ; i < 4 ; i++ )
+		printf("Xfer %d: tag: %u done: %d status: %d response tag: %u\n", i, x[i].tag, x[i].done, x[i].status, rsp[i].obj.mcc_alloc_get_rsp.total);
+
+	fmapi_transport_close(a);
+	fmapi_transport_close(b);
+
+	return 0;
+}
+
+/**
+ * Answer num Get Physical Port State requests with one info block per port
+ */
+void serve_ports(struct fmapi_transport *t, int num)
+{
+	struct fmapi_msg m;
+	struct fmapi_psc_port_rsp *r = &m.obj.psc_port_rsp;
+	__u8 ports[FM_MAX_PORTS];
+	int i, k, n;
+	__u8 tag;
+
+	for ( i = 0 ; i < num ; i++ )
+	{
+		fmapi_transport_recv_msg(t, &m, NULL);
+		tag = m.hdr.tag;
+		n = m.obj.psc_port_req.num;
+		memcpy(ports, m.obj.psc_port_req.ports, n);
+		printf("Request %d: %d ports\n", i, n);
+
+		memset(r, 0, sizeof(*r));
+		r->num = n;
+		for ( k = 0 ; k < n ; k++ )
+		{
+			r->list[k].ppid = ports[k];
+			r->list[k].state = FMPS_DSP;
+			r->list[k].lane = ports[k] * 4;
+		}
+		fmapi_transport_send_msg(t, &m, FMMT_RESP, tag);
+	}
+}
+
+int verify_coalesce()
+{
+	struct fmapi_transport *a, *b;
+	struct fmapi_session s;
+	struct fmapi_port_coalescer c;
+	struct fmapi_port_query q[20];
+	int i, rv, done;
+
+	/* STEPS 
+	 * 1: Create a loopback pair and a session limited to 8 port info blocks
+	 * 2: Query 12 distinct ports 20 times. Full batches are sent right away
+	 * 3: Answer and complete the two requests sent 
+	 * 4: Flush the remaining ports, answer and complete
+	 * 5: Check every query got the info of its own port
+	 */
+
+	// STEP 1: Create a loopback pair and a session limited to 8 port info blocks
+	rv = fmapi_transport_unix_pair(SOCK_STREAM, &a, &b);
+	if (rv < 0)
+		return 1;
+	fmapi_session_init(&s, a, 4);
+	s.rsp_limit = FMLN_PSC_GET_PHY_PORT_RESP + 8 * FMLN_PSC_GET_PHY_PORT_INFO;
+	fmapi_port_coalescer_init(&c, &s, 0, 2);
+
+	// STEP 2: Query 12 distinct ports 20 times. Full batches are sent right away
+	memset(q, 0, sizeof(q));
+	for ( i = 0 ; i < 20 ; i++ )
+	{
+		q[i].ppid = i % 12;
+		fmapi_port_query_submit(&c, &q[i]);
+	}
+
+	// STEP 3: Answer and complete the two requests sent 
+	serve_ports(b, c.requests);
+	for ( done = 0 ; done < 2 ; done += rv )
+		rv = fmapi_session_poll(&s);
+
+	// STEP 4: Flush the remaining ports, answer and complete
+	rv = fmapi_port_coalescer_flush(&c);
+	serve_ports(b, rv);
+	fmapi_port_query_wait(&c, &q[19]);
+
+	// STEP 5: Check every query got the info of its own port
+	for ( i = 0 ; i < 20 ; i++ )
+		printf("Query %d: port: %u done: %d status: %d info port: %u lane: %u\n", i, q[i].ppid, q[i].done, q[i].status, q[i].info.ppid, q[i].info.lane);
+	printf("Queries: %u Requests: %u\n", c.queries, c.requests);
+
+	fmapi_port_coalescer_free(&c);
+	fmapi_transport_close(a);
+	fmapi_transport_close(b);
+
+	return 0;
+}
+
+int verify_msg_alloc()
+{
+	struct fmapi_msg *m, *r;
+	struct fmapi_buf buf;
+	__u8 ports[8];
+	int i, len, rv;
+
+	/* STEPS 
+	 * 1: A request trims its list, a response object does not 
+	 * 2: Decode an 8 port response into a response allocated for 1 port 
+	 * 3: Decode a count that exceeds the capacity of the object 
+	 */
+
+	// STEP 1: A request trims its list, a response object does not 
+	printf("Request  1 port: %lu full: %lu\n", fmapi_msg_size(FMOB_PSC_PORT_REQ, 1), fmapi_msg_size(FMOB_PSC_PORT_REQ, 0));
+	printf("Response 1 port: %lu full: %lu\n", fmapi_msg_size(FMOB_PSC_PORT_RSP, 1), fmapi_msg_size(FMOB_PSC_PORT_RSP, 0));
+	printf("Any object:      %lu (expect %lu)\n", fmapi_msg_size(FMOB_MAX, 0), sizeof(struct fmapi_msg));
+
+	// STEP 2: Decode an 8 port response into a response allocated for 1 port 
+	m = fmapi_msg_alloc(FMOB_MAX, 0);
+	r = fmapi_msg_alloc_op(FMOP_PSC_PORT, FMMT_RESP, 1);
+	if ( (m == NULL) || (r == NULL) )
+		return 1;
+
+	for ( i = 0 ; i < 8 ; i++ )
+		ports[i] = i;
+	fmapi_fill_psc_get_ports(m, 8, ports);
+	m->obj.psc_port_rsp.num = 8;
+	for ( i = 0 ; i < 8 ; i++ )
+		m->obj.psc_port_rsp.list[i].ppid = i;
+	len = fmapi_msg_encode(m, (__u8*) &buf, sizeof(buf), FMMT_RESP, 1);
+	rv = fmapi_msg_decode(r, (__u8*) &buf, len, NULL);
+	printf("Decode 8 ports: %d (expect %d) num: %u last port: %u\n", rv, len, r->obj.psc_port_rsp.num, r->obj.psc_port_rsp.list[7].ppid);
+
+	// STEP 3: Decode a count that exceeds the capacity of the object 
+	fmapi_fill_mcc_get_alloc(m, 0, FM_MAX_NUM_LD);
+	memset(&m->obj, 0, sizeof(m->obj.mcc_alloc_get_rsp));
+	m->obj.mcc_alloc_get_rsp.num = FM_MAX_NUM_LD;
+	len = fmapi_msg_encode(m, (__u8*) &buf, sizeof(buf), FMMT_RESP, 2);
+	buf.payload[3] = FM_MAX_NUM_LD + 1;
+	rv = fmapi_msg_decode(r, (__u8*) &buf, len, NULL);
+	printf("Count overflow: %d - %s\n", rv, fmer(-rv));
+
+	fmapi_msg_free(m);
+	fmapi_msg_free(r);
+
+	return 0;
+}
+
+/**
+ * Deterministic pseudo random number generator for repeatable test data
+ */
+__u32 test_rand(__u32 *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+/**
+ * FNV-1a hash of a byte array
+ */
+__u32 test_hash(__u8 *data, size_t len)
+{
+	__u32 h = 2166136261u;
+
+	for ( size_t i = 0 ; i < len ; i++ )
+		h = (h ^ data[i]) * 16777619u;
+	return h;
+}
+
+/**
+ * Clamp the count fields of a random serialized object to its capacity 
+ */
+void roundtrip_clamp(__u8 *src, unsigned type, __u32 *state)
+{
+	unsigned num;
+
+	switch(type)
+	{
+		case FMOB_PSC_PORT_REQ: 		src[0] = test_rand(state) % 8;						break;
+		case FMOB_PSC_PORT_RSP: 		src[0] = test_rand(state) % 8;						break;
+		case FMOB_VSC_INFO_REQ:			src[2] = test_rand(state) % 8;						break;
+		case FMOB_VSC_INFO_RSP:			src[0] = test_rand(state) % FM_MAX_VCS_PER_RSP;		break;
+		case FMOB_MCC_ALLOC_GET_RSP: 	src[3] = test_rand(state) % FM_MAX_NUM_LD;			break;
+		case FMOB_MCC_ALLOC_SET_REQ: 
+		case FMOB_MCC_ALLOC_SET_RSP: 
+		case FMOB_MCC_QOS_BW_ALLOC: 
+		case FMOB_MCC_QOS_BW_LIMIT:		src[0] = test_rand(state) % FM_MAX_NUM_LD;			break;
+
+		case FMOB_MPC_TMC_REQ:
+			num = 1 + test_rand(state) % 64;
+			src[2] = num & 0xFF;
+			src[3] = num >> 8;
+			break;
+
+		case FMOB_MPC_TMC_RSP:
+			num = 1 + test_rand(state) % 64;
+			src[0] = num & 0xFF;
+			src[1] = num >> 8;
+			break;
+
+		case FMOB_MPC_MEM_REQ:
+			num = test_rand(state) % 256;
+			src[6] = num & 0xFF;
+			src[7] = num >> 8;
+			break;
+
+		case FMOB_MPC_MEM_RSP:
+			num = test_rand(state) % 256;
+			src[0] = num & 0xFF;
+			src[1] = num >> 8;
+			break;
+	}
+}
+
+int verify_roundtrip()
+{
+	// Hash of the encoded random object, recorded with the fmapi_serialize() 
+	// switch that the wire format layout tables replaced
+	static const __u32 expect[FMOB_MAX] = {
+		[FMOB_HDR]							= 0x4b3ed320,
+		[FMOB_PSC_ID_RSP]					= 0x2e29c043,
+		[FMOB_PSC_PORT_REQ]					= 0x9dbc29fa,
+		[FMOB_PSC_PORT_INFO]				= 0x558621b3,
+		[FMOB_PSC_PORT_RSP]					= 0x5fc7698f,
+		[FMOB_PSC_PORT_CTRL_REQ]			= 0x95ceade2,
+		[FMOB_PSC_CFG_REQ]					= 0xb51a66aa,
+		[FMOB_PSC_CFG_RSP]					= 0x6ff354c8,
+		[FMOB_VSC_INFO_REQ]					= 0xabb99658,
+		[FMOB_VSC_PPB_STAT_BLK]				= 0x2592e5eb,
+		[FMOB_VSC_INFO_BLK]					= 0x047421d3,
+		[FMOB_VSC_INFO_RSP]					= 0x4b95f515,
+		[FMOB_VSC_BIND_REQ]					= 0x3c6c4540,
+		[FMOB_VSC_UNBIND_REQ]				= 0xb48948b5,
+		[FMOB_VSC_AER_REQ]					= 0x273c99d5,
+		[FMOB_MPC_TMC_REQ]					= 0x350dfe0a,
+		[FMOB_MPC_TMC_RSP]					= 0x818c7349,
+		[FMOB_MPC_CFG_REQ]					= 0x3513b693,
+		[FMOB_MPC_CFG_RSP]					= 0x7d91bf3b,
+		[FMOB_MPC_MEM_REQ]					= 0x00d008fa,
+		[FMOB_MPC_MEM_RSP]					= 0x8ac41789,
+		[FMOB_MCC_INFO_RSP]					= 0xce660029,
+		[FMOB_MCC_ALLOC_BLK]				= 0x64048429,
+		[FMOB_MCC_ALLOC_GET_REQ]			= 0x6cc545ee,
+		[FMOB_MCC_ALLOC_GET_RSP]			= 0x509e4346,
+		[FMOB_MCC_ALLOC_SET_REQ]			= 0xfa05504c,
+		[FMOB_MCC_ALLOC_SET_RSP]			= 0x68b0fd73,
+		[FMOB_MCC_QOS_CTRL]					= 0x987c2bdd,
+		[FMOB_MCC_QOS_STAT_RSP]				= 0x800b8bc0,
+		[FMOB_MCC_QOS_BW_GET_REQ]			= 0x64e5ba0e,
+		[FMOB_MCC_QOS_BW_ALLOC]				= 0xe82e1495,
+		[FMOB_MCC_QOS_BW_LIMIT_GET_REQ]		= 0x6f65e2a6,
+		[FMOB_MCC_QOS_BW_LIMIT]				= 0x47ca20e0,
+		[FMOB_ISC_ID_RSP]					= 0x8ad76a21,
+		[FMOB_ISC_MSG_LIMIT]				= 0x1d0c82e7,
+		[FMOB_ISC_BOS]						= 0xc4e498a0,
+	};
+	struct fmapi_vsc_info_req req;
+	struct fmapi_msg *m1, *m2;
+	__u8 src[FMLN_PAYLOAD], w1[FMLN_PAYLOAD], w2[FMLN_PAYLOAD];
+	int type, rv, n1, n2, fail;
+	size_t size;
+	__u32 state;
+
+	/* STEPS 
+	 * For every object:
+	 * 1: Fill a serialized object with repeatable random data
+	 * 2: Decode, encode, decode and encode again 
+	 * 3: Check both decodes and both encodes match 
+	 * 4: Check the encoded bytes against the known wire format
+	 */
+
+	m1 = fmapi_msg_alloc(FMOB_MAX, 0);
+	m2 = fmapi_msg_alloc(FMOB_MAX, 0);
+	if ( (m1 == NULL) || (m2 == NULL) )
+		return 1;
+
+	// The vPPB count of a VCS info block is derived from the request 
+	memset(&req, 0, sizeof(req));
+	req.vppbid_start = 0;
+	req.vppbid_limit = 4;
+
+	fail = 0;
+	for ( type = FMOB_HDR ; type < FMOB_MAX ; type++ )
+	{
+		// STEP 1: Fill a serialized object with repeatable random data
+		state = 0x9E3779B9 ^ type;
+		for ( unsigned i = 0 ; i < sizeof(src) ; i++ )
+			src[i] = test_rand(&state);
+		roundtrip_clamp(src, type, &state);
+
+		// STEP 2: Decode, encode, decode and encode again 
+		size = fmapi_msg_size(type, 0) - offsetof(struct fmapi_msg, obj);
+		memset(m1, 0, sizeof(*m1));
+		memset(m2, 0, sizeof(*m2));
+		memset(w1, 0, sizeof(w1));
+		memset(w2, 0, sizeof(w2));
+		rv = fmapi_deserialize_len(&m1->obj, src, sizeof(src), type, &req);
+		n1 = fmapi_serialize(w1, &m1->obj, type);
+		fmapi_deserialize_len(&m2->obj, w1, n1, type, &req);
+		n2 = fmapi_serialize(w2, &m2->obj, type);
+
+		// STEP 3: Check both decodes and both encodes match 
+		// STEP 4: Check the encoded bytes against the known wire format
+		if ( (rv <= 0) || (rv != n1) || (n1 != n2) || memcmp(w1, w2, n1) || memcmp(&m1->obj, &m2->obj, size) || (test_hash(w1, n1) != expect[type]) )
+		{
+			printf("FMOB %02d: len: %d %d %d hash: 0x%08x (expect 0x%08x) FAIL\n", type, rv, n1, n2, test_hash(w1, n1), expect[type]);
+			fail++;
+		}
+		else 
+			printf("FMOB %02d: len: %d hash: 0x%08x PASS\n", type, n1, test_hash(w1, n1));
+	}
+	printf("Round trip failures: %d\n", fail);
+
+	fmapi_msg_free(m1);
+	fmapi_msg_free(m2);
+
+	return fail;
+}
+
+int verify_port_table()
+{
+	// Port counts around the 16 (SSE2, NEON) and 32 (AVX2) port vector widths
+	const unsigned counts[] = {0, 1, 7, 15, 16, 17, 31, 32, 33, 48, 63, 100, 255};
+	static struct fmapi_psc_port_table t;
+	static struct fmapi_psc_port_rsp r;
+	__u8 src[FMLN_PSC_GET_PHY_PORT_RESP + FM_MAX_PORTS * FMLN_PSC_GET_PHY_PORT_INFO];
+	struct fmapi_psc_port_info *p;
+	unsigned k, i, n, bad, fail;
+	int rv, rt;
+	__u32 state;
+
+	/* STEPS 
+	 * For each port count: 
+	 * 1: Fill a serialized response with random port info blocks
+	 * 2: Decode it as a table of columns and with the scalar decoder 
+	 * 3: Check every column entry against the scalar port info block
+	 */
+
+	fail = 0;
+	state = 0x2545F491;
+	for ( k = 0 ; k < sizeof(counts) / sizeof(counts[0]) ; k++ )
+	{
+		// STEP 1: Fill a serialized response with random port info blocks
+		n = counts[k];
+		for ( i = 0 ; i < sizeof(src) ; i++ )
+			src[i] = test_rand(&state);
+		src[0] = n;
+
+		// STEP 2: Decode it as a table of columns and with the scalar decoder 
+		memset(&t, 0xA5, sizeof(t));
+		memset(&r, 0, sizeof(r));
+		rt = fmapi_deserialize_port_table(&t, src, sizeof(src));
+		rv = fmapi_deserialize_len(&r, src, sizeof(src), FMOB_PSC_PORT_RSP, NULL);
+
+		// STEP 3: Check every column entry against the scalar port info block
+		bad = (rt != rv) || (t.num != n);
+		for ( i = 0 ; i < n ; i++ )
+		{
+			p = &r.list[i];
+			if ( (t.ppid[i] != p->ppid) || (t.state[i] != p->state) || (t.dv[i] != p->dv) 
+				|| (t.dt[i] != p->dt) || (t.cv[i] != p->cv) || (t.mlw[i] != p->mlw) 
+				|| (t.nlw[i] != p->nlw) || (t.speeds[i] != p->speeds) || (t.mls[i] != p->mls) 
+				|| (t.cls[i] != p->cls) || (t.ltssm[i] != p->ltssm) || (t.lane[i] != p->lane) 
+				|| (t.num_ld[i] != p->num_ld) || (t.lane_rev[i] != p->lane_rev) 
+				|| (t.perst[i] != p->perst) || (t.prsnt[i] != p->prsnt) || (t.pwrctrl[i] != p->pwrctrl) 
+				|| (t.flags[i] != src[FMLN_PSC_GET_PHY_PORT_RESP + i * FMLN_PSC_GET_PHY_PORT_INFO + 13]) )
+				bad++;
+		}
+
+		printf("Ports %3u: len: %d %d mismatches: %u %s\n", n, rt, rv, bad, bad ? "FAIL" : "PASS");
+		if (bad)
+			fail++;
+	}
+	printf("Port table failures: %u\n", fail);
+
+	return fail;
+}
+
+int verify_iov()
+{
+	static struct fmapi_msg m[7], sub;
+	const __u8 cats[7] = {FMMT_REQ, FMMT_REQ, FMMT_REQ, FMMT_REQ, FMMT_RESP, FMMT_REQ, FMMT_RESP};
+	__u8 enc[sizeof(struct fmapi_buf)], gat[sizeof(struct fmapi_buf)];
+	__u8 scratch[sizeof(struct fmapi_buf)];
+	__u8 data[256], ports[] = {1, 2, 3, 4, 5};
+	__u64 rng1[2] = {1, 2}, rng2[2] = {3, 4};
+	struct iovec iov[2];
+	struct fmapi_hdr hdr;
+	const void *bulk;
+	int i, k, cnt, len, n, fail;
+	unsigned type;
+
+	/* STEPS 
+	 * 1: Fill messages without and with bulk data, requests and responses 
+	 * 2: Encode each message with fmapi_msg_encode()
+	 * 3: Gather it with fmapi_serialize_iov(), once from the object and once 
+	 *    with a separate bulk data block 
+	 * 4: Check the gathered bytes equal the encoded frame
+	 */
+
+	// STEP 1: Fill messages without and with bulk data, requests and responses 
+	for ( i = 0 ; i < (int) sizeof(data) ; i++ )
+		data[i] = i * 7;
+	fmapi_fill_isc_id(&m[0]);
+	fmapi_fill_psc_get_ports(&m[1], sizeof(ports), ports);
+	fmapi_fill_mcc_set_alloc(&m[2], 0, 2, rng1, rng2);
+	fmapi_fill_mpc_mem(&m[3], 1, 2, 0x1000, 200, 0xF, 0x3, FMCT_WRITE, data);
+	fmapi_fill_mpc_mem(&m[4], 1, 2, 0x1000, 0, 0xF, 0xF, FMCT_READ, NULL);
+	m[4].obj.mpc_mem_rsp.len = 128;
+	memcpy(m[4].obj.mpc_mem_rsp.data, data, 128);
+	fmapi_fill_psc_id(&sub);
+	// 0x07 is the MCTP Message Type of the CXL FM API
+	fmapi_fill_mpc_tmc(&m[5], 3, 0x07, &sub);
+	fmapi_fill_mpc_tmc(&m[6], 3, 0x07, &sub);
+	m[6].obj.mpc_tmc_rsp.len = 40;
+	memcpy(m[6].obj.mpc_tmc_rsp.msg, data, 40);
+
+	fail = 0;
+	for ( i = 0 ; i < 7 ; i++ )
+	{
+		// STEP 2: Encode each message with fmapi_msg_encode()
+		len = fmapi_msg_encode(&m[i], enc, sizeof(enc), cats[i], i);
+		type = (cats[i] == FMMT_REQ) ? fmapi_fmob_req(m[i].hdr.opcode) : fmapi_fmob_rsp(m[i].hdr.opcode);
+
+		for ( k = 0 ; k < 2 ; k++ )
+		{
+			// STEP 3: Gather it with fmapi_serialize_iov()
+			bulk = NULL;
+			if (k == 1)
+			{
+				switch (type)
+				{
+					case FMOB_MPC_MEM_REQ: 	bulk = data; 	break;
+					case FMOB_MPC_MEM_RSP: 	bulk = data; 	break;
+					case FMOB_MPC_TMC_RSP: 	bulk = data; 	break;
+					default: 								continue;
+				}
+			}
+
+			hdr = m[i].hdr;
+			cnt = fmapi_serialize_iov(iov, 2, scratch, sizeof(scratch), &hdr, &m[i].obj, type, bulk);
+			n = 0;
+			for ( int j = 0 ; j < cnt ; j++ )
+			{
+				memcpy(&gat[n], iov[j].iov_base, iov[j].iov_len);
+				n += iov[j].iov_len;
+			}
+
+			// STEP 4: Check the gathered bytes equal the encoded frame
+			if ( (cnt <= 0) || (n != len) || memcmp(enc, gat, len) )
+			{
+				printf("Message %d opcode 0x%04x %s: len: %d iov: %d gathered: %d FAIL\n", i, m[i].hdr.opcode, k ? "bulk" : "object", len, cnt, n);
+				fail++;
+			}
+			else 
+				printf("Message %d opcode 0x%04x %s: len: %d iov: %d PASS\n", i, m[i].hdr.opcode, k ? "bulk" : "object", len, cnt);
+		}
+	}
+	printf("Gather failures: %d\n", fail);
+
+	return fail;
+}
+
+int verify_batch()
+{
+	static struct fmapi_msg m[6], d[6];
+	static __u8 bat[6 * sizeof(struct fmapi_buf)], ref[6 * sizeof(struct fmapi_buf)];
+	struct fmapi_msg *msgs[6], *dec[6];
+	__u8 ports[] = {1, 2, 3}, data[64];
+	__u64 rng1[2] = {1, 2}, rng2[2] = {3, 4};
+	size_t offs[7], doffs[7], len;
+	int i, n, rv, fail;
+
+	/* STEPS 
+	 * 1: Fill messages, some sharing an opcode 
+	 * 2: Encode the batch and each message on its own and compare 
+	 * 3: Encode into a buffer too small for the whole batch
+	 * 4: Decode the batch and compare the offsets and headers 
+	 * 5: Decode a batch cut in the middle of a frame 
+	 * 6: Decode a batch with a frame whose count exceeds its length 
+	 */
+
+	// STEP 1: Fill messages, some sharing an opcode 
+	memset(data, 0x5A, sizeof(data));
+	fmapi_fill_isc_id(&m[0]);
+	fmapi_fill_psc_get_ports(&m[1], 3, ports);
+	fmapi_fill_psc_get_ports(&m[2], 2, ports);
+	fmapi_fill_mcc_get_alloc(&m[3], 0, 4);
+	fmapi_fill_mcc_set_alloc(&m[4], 0, 2, rng1, rng2);
+	fmapi_fill_mpc_mem(&m[5], 1, 2, 0x2000, sizeof(data), 0xF, 0xF, FMCT_WRITE, data);
+	for ( i = 0 ; i < 6 ; i++ )
+	{
+		msgs[i] = &m[i];
+		dec[i] = &d[i];
+	}
+
+	// STEP 2: Encode the batch and each message on its own and compare 
+	fail = 0;
+	n = fmapi_encode_batch(msgs, 6, bat, sizeof(bat), FMMT_REQ, 10, offs);
+	len = 0;
+	for ( i = 0 ; i < 6 ; i++ )
+		len += fmapi_msg_encode(&m[i], &ref[len], sizeof(ref) - len, FMMT_REQ, 10 + i);
+	if ( (n != 6) || (offs[6] != len) || memcmp(bat, ref, len) )
+		fail++;
+	printf("Batch encode:     %d messages %lu bytes (expect 6 %lu) %s\n", n, offs[6], len, memcmp(bat, ref, len) ? "FAIL" : "PASS");
+
+	// STEP 3: Encode into a buffer too small for the whole batch
+	memset(bat, 0, sizeof(bat));
+	n = fmapi_encode_batch(msgs, 6, bat, offs[3] + FMLN_HDR, FMMT_REQ, 10, offs);
+	if ( (n != 3) || memcmp(bat, ref, offs[3]) )
+		fail++;
+	printf("Short buffer:     %d messages %lu bytes (expect 3) %s\n", n, offs[n], memcmp(bat, ref, offs[3]) ? "FAIL" : "PASS");
+	fmapi_encode_batch(msgs, 6, bat, sizeof(bat), FMMT_REQ, 10, offs);
+
+	// STEP 4: Decode the batch and compare the offsets and headers 
+	n = fmapi_decode_batch(dec, 6, bat, offs[6], doffs, NULL);
+	rv = (n == 6) && !memcmp(offs, doffs, sizeof(offs));
+	for ( i = 0 ; i < n ; i++ )
+		if ( (d[i].hdr.opcode != m[i].hdr.opcode) || (d[i].hdr.tag != 10 + i) || (d[i].hdr.len != m[i].hdr.len) )
+			rv = 0;
+	rv = rv && !memcmp(d[1].obj.psc_port_req.ports, ports, 3) && !memcmp(d[5].obj.mpc_mem_req.data, data, sizeof(data));
+	if (!rv)
+		fail++;
+	printf("Batch decode:     %d messages %s\n", n, rv ? "PASS" : "FAIL");
+
+	// STEP 5: Decode a batch cut in the middle of a frame 
+	n = fmapi_decode_batch(dec, 6, bat, offs[5] - 1, doffs, NULL);
+	if ( (n != 4) || (doffs[4] != offs[4]) )
+		fail++;
+	printf("Truncated batch:  %d messages %lu bytes (expect 4 %lu)\n", n, doffs[n], offs[4]);
+
+	// STEP 6: Decode a batch with a frame whose count exceeds its length 
+	bat[offs[1] + FMLN_HDR] = 200;
+	n = fmapi_decode_batch(dec, 6, bat, offs[6], doffs, NULL);
+	if (n != -FMER_TRUNCATED)
+		fail++;
+	printf("Malformed frame:  %d - %s\n", n, fmer(-n));
+	printf("Batch failures: %d\n", fail);
+
+	return fail;
+}
+
+/**
+ * Build a frame from a header and len bytes of zero payload and decode it 
+ */
+int decode_frame(struct fmapi_msg *m, __u8 category, __u16 opcode, __u32 len, __u16 rc)
+{
+	struct fmapi_buf buf;
+	struct fmapi_hdr hdr;
+
+	memset(&buf, 0, sizeof(buf));
+	fmapi_fill_hdr(&hdr, category, 1, opcode, 0, len, rc, 0);
+	fmapi_serialize(buf.hdr, &hdr, FMOB_HDR);
+
+	return fmapi_msg_decode(m, (__u8*) &buf, FMLN_HDR + len, NULL);
+}
+
+int verify_msg_decode()
+{
+	static struct fmapi_msg m;
+	static struct fmapi_buf own;
+	struct fmapi_buf frame;
+	int rv;
+
+	/* STEPS 
+	 * 1: Decode a frame with an unknown opcode
+	 * 2: Decode requests with a payload of exactly, less and more than the 
+	 *    length of the object
+	 * 3: Decode a response without a payload, failed and successful 
+	 * 4: Encode a message with an unknown opcode
+	 * 5: Decode into a message that owns a buffer 
+	 */
+
+	// STEP 1: Decode a frame with an unknown opcode
+	rv = decode_frame(&m, FMMT_REQ, 0x51FF, 0, FMRC_SUCCESS);
+	printf("Unknown opcode:       %d - %s\n", rv, fmer(-rv));
+
+	// STEP 2: Decode requests with a payload of exactly, less and more than the length of the object
+	rv = decode_frame(&m, FMMT_REQ, FMOP_PSC_CFG, FMLN_PSC_PPB_IO_CFG_REQ, FMRC_SUCCESS);
+	printf("Exact payload:        %d (expect %d)\n", rv, FMLN_HDR + FMLN_PSC_PPB_IO_CFG_REQ);
+	rv = decode_frame(&m, FMMT_REQ, FMOP_PSC_CFG, FMLN_PSC_PPB_IO_CFG_REQ - 1, FMRC_SUCCESS);
+	printf("Short payload:        %d - %s\n", rv, fmer(-rv));
+	rv = decode_frame(&m, FMMT_REQ, FMOP_PSC_PORT_CTRL, FMLN_PSC_PHY_PORT_CTRL + 1, FMRC_SUCCESS);
+	printf("Long payload:         %d - %s\n", rv, fmer(-rv));
+
+	// STEP 3: Decode a response without a payload, failed and successful 
+	rv = decode_frame(&m, FMMT_RESP, FMOP_PSC_CFG, 0, FMRC_INVALID_INPUT);
+	printf("Failed response:      %d (expect %d)\n", rv, FMLN_HDR);
+	rv = decode_frame(&m, FMMT_RESP, FMOP_PSC_CFG, 0, FMRC_SUCCESS);
+	printf("Empty response:       %d - %s\n", rv, fmer(-rv));
+
+	// STEP 4: Encode a message with an unknown opcode
+	memset(&m, 0, sizeof(m));
+	m.hdr.opcode = 0x51FF;
+	rv = fmapi_msg_encode(&m, (__u8*) &frame, sizeof(frame), FMMT_REQ, 1);
+	printf("Encode unknown:       %d - %s\n", rv, fmer(-rv));
+
+	// STEP 5: Decode into a message that owns a buffer 
+	fmapi_fill_isc_bos(&m);
+	rv = fmapi_msg_encode(&m, (__u8*) &frame, sizeof(frame), FMMT_REQ, 1);
+	m.buf = &own;
+	rv = fmapi_msg_decode(&m, (__u8*) &frame, rv, NULL);
+	printf("Owned buffer:         %d (expect %d) %s\n", rv, FMLN_HDR, (m.buf == &own) ? "kept" : "replaced");
+
+	return 0;
+}
+
+#define POOL_MSGS 		256
+#define POOL_THREADS 	8
+#define POOL_ROUNDS 	200000
+
+/**
+ * State shared by the threads of verify_pool()
+ */
+struct pool_test 
+{
+	struct fmapi_msg_pool *pool;
+	struct fmapi_msg *handoff[POOL_THREADS];	//!< Message each thread leaves for the next one to put
+	unsigned errors;
+};
+
+struct pool_arg 
+{
+	struct pool_test *t;
+	unsigned id;
+};
+
+/**
+ * Get and put messages, stamping each one to detect a message handed out twice
+ */
+void *pool_thread(void *arg)
+{
+	struct pool_arg *a = (struct pool_arg*) arg;
+	struct pool_test *t = a->t;
+	struct fmapi_msg *m[16], *h;
+	unsigned i, k, n;
+	__u32 state, stamp;
+
+	state = 0x1234567 + a->id;
+	for ( i = 0 ; i < POOL_ROUNDS ; i++ )
+	{
+		n = 1 + test_rand(&state) % 16;
+		for ( k = 0 ; k < n ; k++ )
+		{
+			m[k] = fmapi_msg_get(t->pool);
+			if (m[k] == NULL)
+				break;
+			stamp = (a->id << 24) | (i & 0xFFFFFF);
+			__atomic_store_n((__u32*) &m[k]->obj, stamp, __ATOMIC_RELAXED);
+		}
+		n = k;
+
+		for ( k = 0 ; k < n ; k++ )
+			if (__atomic_load_n((__u32*) &m[k]->obj, __ATOMIC_RELAXED) != ((a->id << 24) | (i & 0xFFFFFF)))
+				__atomic_add_fetch(&t->errors, 1, __ATOMIC_RELAXED);
+
+		// Leave one message for the next thread to put and put the one left for us
+		if (n > 0)
+		{
+			h = __atomic_exchange_n(&t->handoff[(a->id + 1) % POOL_THREADS], m[--n], __ATOMIC_ACQ_REL);
+			if (h != NULL)
+				fmapi_msg_put(t->pool, h);
+		}
+		h = __atomic_exchange_n(&t->handoff[a->id], NULL, __ATOMIC_ACQ_REL);
+		if (h != NULL)
+			fmapi_msg_put(t->pool, h);
+		for ( k = 0 ; k < n ; k++ )
+			fmapi_msg_put(t->pool, m[k]);
+	}
+
+	return NULL;
+}
+
+int verify_pool()
+{
+	static struct pool_test t;
+	struct pool_arg args[POOL_THREADS];
+	pthread_t th[POOL_THREADS];
+	struct fmapi_msg *m, *seen[POOL_MSGS + 1];
+	unsigned i, k, n, dup;
+
+	/* STEPS 
+	 * 1: Create a pool with fewer messages than the threads can hold 
+	 * 2: Get and put messages from several threads, passing some between them
+	 * 3: Put the handed off messages and drain the pool
+	 * 4: Check every message was recovered exactly once
+	 */
+
+	// STEP 1: Create a pool with fewer messages than the threads can hold 
+	memset(&t, 0, sizeof(t));
+	t.pool = fmapi_msg_pool_create(POOL_MSGS, 8);
+	if (t.pool == NULL)
+		return 1;
+
+	// STEP 2: Get and put messages from several threads, passing some between them
+	for ( i = 0 ; i < POOL_THREADS ; i++ )
+	{
+		args[i].t = &t;
+		args[i].id = i;
+		pthread_create(&th[i], NULL, pool_thread, &args[i]);
+	}
+	for ( i = 0 ; i < POOL_THREADS ; i++ )
+		pthread_join(th[i], NULL);
+
+	// STEP 3: Put the handed off messages and drain the pool
+	for ( i = 0 ; i < POOL_THREADS ; i++ )
+		fmapi_msg_put(t.pool, t.handoff[i]);
+	for ( n = 0 ; n <= POOL_MSGS ; n++ )
+	{
+		m = fmapi_msg_get(t.pool);
+		if (m == NULL)
+			break;
+		seen[n] = m;
+	}
+
+	// STEP 4: Check every message was recovered exactly once
+	dup = 0;
+	for ( i = 0 ; i < n ; i++ )
+		for ( k = i + 1 ; k < n ; k++ )
+			if (seen[i] == seen[k])
+				dup++;
+	printf("Threads: %d rounds: %d recovered: %u (expect %d) duplicates: %u double handouts: %u\n", POOL_THREADS, POOL_ROUNDS, n, POOL_MSGS, dup, t.errors);
+
+	for ( i = 0 ; i < n ; i++ )
+		fmapi_msg_put(t.pool, seen[i]);
+	fmapi_msg_pool_free(t.pool);
+
+	return (n != POOL_MSGS) || dup || t.errors;
+}
+
+int verify_arena()
+{
+	struct fmapi_arena a;
+	struct fmapi_msg *req, *rsp, *m, *first;
+	__u8 ports[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+	size_t off, used;
+	int i, len, rv, n;
+
+	/* STEPS 
+	 * 1: Create an arena and carve a request and a response for 1 port
+	 * 2: Answer the request with 8 ports and decode into the response 
+	 * 3: Carve until the arena is exhausted 
+	 * 4: Reset the arena and carve the same transaction again 
+	 * 5: Carve a response for an unknown opcode
+	 */
+
+	// STEP 1: Create an arena and carve a request and a response for 1 port
+	if (fmapi_arena_init(&a, NULL, 64 * 1024) != 0)
+		return 1;
+	req = fmapi_arena_msg_op(&a, FMOP_PSC_PORT, FMMT_REQ, 1, 1);
+	off = a.off;
+	rsp = fmapi_arena_msg_op(&a, FMOP_PSC_PORT, FMMT_RESP, 1, 1);
+	if ( (req == NULL) || (rsp == NULL) )
+		return 1;
+	used = a.off;
+	printf("Request:  %lu bytes aligned: %d\n", off - sizeof(struct fmapi_buf), ((unsigned long) req % 64) == 0);
+	printf("Response: %lu bytes (at least %lu) aligned: %d\n", a.off - off - sizeof(struct fmapi_buf), sizeof(struct fmapi_msg), ((unsigned long) rsp % 64) == 0);
+
+	// STEP 2: Answer the request with 8 ports and decode into the response 
+	fmapi_fill_psc_get_port(req, 3);
+	len = fmapi_msg_encode(req, (__u8*) req->buf, sizeof(struct fmapi_buf), FMMT_REQ, 1);
+	m = fmapi_arena_msg(&a, FMOB_MAX, 0, 0);
+	fmapi_fill_psc_get_ports(m, 8, ports);
+	m->obj.psc_port_rsp.num = 8;
+	for ( i = 0 ; i < 8 ; i++ )
+		m->obj.psc_port_rsp.list[i].ppid = i;
+	len = fmapi_msg_encode(m, (__u8*) rsp->buf, sizeof(struct fmapi_buf), FMMT_RESP, 1);
+	rv = fmapi_msg_decode(rsp, (__u8*) rsp->buf, len, NULL);
+	printf("Decode 8 ports: %d (expect %d) num: %u last port: %u\n", rv, len, rsp->obj.psc_port_rsp.num, rsp->obj.psc_port_rsp.list[7].ppid);
+
+	// STEP 3: Carve until the arena is exhausted 
+	for ( n = 0 ; ; n++ )
+	{
+		off = a.off;
+		if (fmapi_arena_msg(&a, FMOB_MAX, 0, 1) == NULL)
+			break;
+	}
+	printf("Exhausted after %d more messages: off: %lu cap: %lu restored: %d\n", n, a.off, a.cap, a.off == off);
+
+	// STEP 4: Reset the arena and carve the same transaction again 
+	first = req;
+	fmapi_arena_reset(&a);
+	req = fmapi_arena_msg_op(&a, FMOP_PSC_PORT, FMMT_REQ, 1, 1);
+	rsp = fmapi_arena_msg_op(&a, FMOP_PSC_PORT, FMMT_RESP, 1, 1);
+	printf("Reuse: same block: %d same size: %d cleared: %d\n", req == first, a.off == used, rsp->obj.psc_port_rsp.num == 0);
+
+	// STEP 5: Carve a response for an unknown opcode
+	m = fmapi_arena_msg_op(&a, 0x51FF, FMMT_RESP, 0, 0);
+	printf("Unknown opcode: %s\n", (m == NULL) ? "NULL" : "carved");
+
+	fmapi_arena_free(&a);
+
 	return 0;
 }
 
+int verify_tunnel()
+{
+	static struct fmapi_msg inner, lvl[2], hop[2];
+	static __u8 ref[sizeof(struct fmapi_buf)], dst[sizeof(struct fmapi_buf)];
+	struct fmapi_msg *hops[2] = {&hop[0], &hop[1]};
+	__u8 ports[] = {4, 5, 6};
+	int k, n, len, rv, fail;
+
+	/* STEPS 
+	 * For 0, 1 and 2 levels of tunneling:
+	 * 1: Wrap the inner message with nested fmapi_fill_mpc_tmc() and encode it
+	 * 2: Encode the same message with fmapi_msg_encode_tunnel()
+	 * 3: Compare the frames 
+	 */
+
+	fail = 0;
+	for ( n = 0 ; n <= 2 ; n++ )
+	{
+		// STEP 1: Wrap the inner message with nested fmapi_fill_mpc_tmc() and encode it
+		// 0x07 is the MCTP Message Type of the CXL FM API
+		fmapi_fill_psc_get_ports(&inner, sizeof(ports), ports);
+		if (n == 0)
+			len = fmapi_msg_encode(&inner, ref, sizeof(ref), FMMT_REQ, 9);
+		else if (n == 1)
+		{
+			fmapi_fill_mpc_tmc(&lvl[0], 1, 0x07, &inner);
+			len = fmapi_msg_encode(&lvl[0], ref, sizeof(ref), FMMT_REQ, 9);
+		}
+		else 
+		{
+			fmapi_fill_mpc_tmc(&lvl[1], 2, 0x07, &inner);
+			fmapi_fill_mpc_tmc(&lvl[0], 1, 0x07, &lvl[1]);
+			len = fmapi_msg_encode(&lvl[0], ref, sizeof(ref), FMMT_REQ, 9);
+		}
+
+		// STEP 2: Encode the same message with fmapi_msg_encode_tunnel()
+		memset(hop, 0, sizeof(hop));
+		for ( k = 0 ; k < n ; k++ )
+		{
+			hop[k].obj.mpc_tmc_req.ppid = k + 1;
+			hop[k].obj.mpc_tmc_req.type = 0x07;
+		}
+		fmapi_fill_psc_get_ports(&inner, sizeof(ports), ports);
+		memset(dst, 0, sizeof(dst));
+		rv = fmapi_msg_encode_tunnel(hops, n, &inner, dst, sizeof(dst), FMMT_REQ, 9);
+
+		// STEP 3: Compare the frames 
+		if ( (rv != len) || memcmp(dst, ref, len) )
+		{
+			printf("Levels %d: len: %d (expect %d) FAIL\n", n, rv, len);
+			fail++;
+		}
+		else 
+			printf("Levels %d: len: %d PASS\n", n, rv);
+	}
+	printf("Tunnel failures: %d\n", fail);
+
+	return fail;
+}
+
+/**
+ * Count the timers fired by fmapi_timer_wheel_advance() 
+ */
+void timer_cb(void *arg, struct fmapi_timer *t)
+{
+	(void) t;
+	(*(int*) arg)++;
+}
+
+/**
+ * Current time in milliseconds from the clock used by session timers
+ */
+__u64 test_ms()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (__u64) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Receive a request on t if one arrives within ms
+ */
+int recv_within(struct fmapi_transport *t, struct fmapi_msg *m, int ms)
+{
+	struct pollfd pfd;
+
+	if (!fmapi_parser_ready(&t->parser))
+	{
+		pfd.fd = fmapi_transport_poll_fd(t);
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, ms) <= 0)
+			return 0;
+	}
+
+	return fmapi_transport_recv_msg(t, m, NULL);
+}
+
+int verify_retry()
+{
+	static struct fmapi_timer_wheel w;
+	struct fmapi_timer tm[4];
+	struct fmapi_transport *a, *b;
+	struct fmapi_session s;
+	struct fmapi_retry_policy pol;
+	struct fmapi_xfer x;
+	struct fmapi_msg req, rsp, m;
+	__u64 t0, dt;
+	int i, rv, fired, sent;
+	__u8 tag;
+
+	/* STEPS 
+	 * 1: Arm timers on every wheel level, cancel one and turn the wheel 
+	 * 2: Create a loopback pair and a session that retries busy and timeouts
+	 * 3: Answer busy and check the request is resent with the same tag after 
+	 *    the backoff delay 
+	 * 4: Let the resend time out, then answer it late during the backoff 
+	 * 5: Check the late response completed the exchange without a resend 
+	 * 6: Never answer and check the exchange times out after every attempt
+	 * 7: Answer an exchange that already completed 
+	 */
+
+	// STEP 1: Arm timers on every wheel level, cancel one and turn the wheel 
+	memset(tm, 0, sizeof(tm));
+	fmapi_timer_wheel_init(&w, 1000);
+	fmapi_timer_arm(&w, &tm[0], 1005);
+	fmapi_timer_arm(&w, &tm[1], 1000 + 3 * FMTW_SLOTS + 7);
+	fmapi_timer_arm(&w, &tm[2], 1000 + 5 * FMTW_SLOTS * FMTW_SLOTS);
+	fmapi_timer_arm(&w, &tm[3], 1010);
+	fmapi_timer_cancel(&w, &tm[3]);
+	printf("Wheel armed: %u next: %llu\n", w.num, (unsigned long long) fmapi_timer_wheel_next(&w));
+	fired = 0;
+	fmapi_timer_wheel_advance(&w, 1004, timer_cb, &fired);
+	printf("Wheel at 1004: fired: %d (expect 0)\n", fired);
+	fmapi_timer_wheel_advance(&w, 1005, timer_cb, &fired);
+	printf("Wheel at 1005: fired: %d (expect 1)\n", fired);
+	fmapi_timer_wheel_advance(&w, 1000 + 3 * FMTW_SLOTS + 6, timer_cb, &fired);
+	fmapi_timer_wheel_advance(&w, 1000 + 3 * FMTW_SLOTS + 7, timer_cb, &fired);
+	printf("Wheel level 1: fired: %d (expect 2)\n", fired);
+	fmapi_timer_wheel_advance(&w, 1000 + 5 * FMTW_SLOTS * FMTW_SLOTS, timer_cb, &fired);
+	printf("Wheel level 2: fired: %d (expect 3) armed: %u\n", fired, w.num);
+
+	// STEP 2: Create a loopback pair and a session that retries busy and timeouts
+	rv = fmapi_transport_unix_pair(SOCK_STREAM, &a, &b);
+	if (rv < 0)
+		return 1;
+	fmapi_session_init(&s, a, 4);
+	memset(&pol, 0, sizeof(pol));
+	pol.timeout_ms = 30;
+	pol.max_tries = 3;
+	pol.base_ms = 20;
+	pol.max_ms = 80;
+	pol.jitter = 0;
+	pol.retry_rc = 1U << FMRC_BUSY;
+	pol.retry_timeout = 1;
+	fmapi_session_set_policy(&s, &pol);
+
+	// STEP 3: Answer busy and check the request is resent with the same tag after the backoff delay 
+	memset(&x, 0, sizeof(x));
+	fmapi_fill_mcc_get_alloc(&req, 0, 2);
+	x.req = &req;
+	x.rsp = &rsp;
+	fmapi_session_submit(&s, &x);
+	fmapi_transport_recv_msg(b, &m, NULL);
+	tag = m.hdr.tag;
+	fmapi_fill_hdr(&m.hdr, FMMT_RESP, tag, FMOP_MCC_ALLOC_GET, 0, 0, FMRC_BUSY, 0);
+	fmapi_transport_send_msg(b, &m, FMMT_RESP, tag);
+	t0 = test_ms();
+	rv = fmapi_session_step_ms(&s, 100);
+	printf("Busy: poll: %d backoff: %u tries: %u\n", rv, x.backoff, x.tries);
+	while ( x.backoff && (test_ms() - t0 < 1000) )
+		fmapi_session_step_ms(&s, 5);
+	dt = test_ms() - t0;
+	rv = recv_within(b, &m, 100);
+	printf("Resend: tag: %s tries: %u delay: %s\n", (rv > 0) && (m.hdr.tag == tag) ? "same" : "other", x.tries, (dt >= pol.base_ms) && (dt < pol.base_ms + pol.timeout_ms) ? "base_ms" : "wrong");
+
+	// STEP 4: Let the resend time out, then answer it late during the backoff 
+	while ( !(x.backoff && x.timedout) && !x.done )
+		fmapi_session_step_ms(&s, 5);
+	printf("Timeout: backoff: %u timedout: %u tries: %u\n", x.backoff, x.timedout, x.tries);
+	fmapi_fill_mcc_get_alloc(&m, 0, 2);
+	m.obj.mcc_alloc_get_rsp.total = 42;
+	fmapi_transport_send_msg(b, &m, FMMT_RESP, tag);
+	while (!x.done)
+		fmapi_session_step_ms(&s, 5);
+
+	// STEP 5: Check the late response completed the exchange without a resend 
+	sent = 0;
+	while (recv_within(b, &m, 2 * pol.max_ms) > 0)
+		sent++;
+	printf("Late response: status: %d total: %u tries: %u resent: %d stray: %u\n", x.status, rsp.obj.mcc_alloc_get_rsp.total, x.tries, sent, s.stray);
+
+	// STEP 6: Never answer and check the exchange times out after every attempt
+	memset(&x, 0, sizeof(x));
+	x.req = &req;
+	fmapi_session_submit(&s, &x);
+	t0 = test_ms();
+	while (!x.done)
+		fmapi_session_step_ms(&s, 5);
+	sent = 0;
+	for ( i = 0 ; recv_within(b, &m, 10) > 0 ; i++ )
+		if (m.hdr.tag == x.tag)
+			sent++;
+	printf("No response: status: %d - %s tries: %u sent: %d same tag: %d\n", x.status, fmer(-x.status), x.tries, i, sent);
+
+	// STEP 7: Answer an exchange that already completed 
+	fmapi_fill_mcc_get_alloc(&m, 0, 2);
+	fmapi_transport_send_msg(b, &m, FMMT_RESP, x.tag);
+	rv = fmapi_session_step_ms(&s, 100);
+	printf("Stale response: poll: %d stray: %u\n", rv, s.stray);
+
+	fmapi_transport_close(a);
+	fmapi_transport_close(b);
+
+	return 0;
+}
+
+/**
+ * Endpoint that answers list reads from another thread
+ */
+struct page_server
+{
+	struct fmapi_transport *t;	//!< Endpoint side of the loopback pair
+	int vsc_total;				//!< Number of vPPBs in the VCS
+	int ld_max;					//!< Most LDs returned per MCC allocation page
+	int requests;				//!< Requests answered
+	int batch;					//!< Most requests outstanding at once
+	int first;					//!< Entries requested by the first request
+};
+
+/**
+ * Answer one list read in place
+ */
+void page_answer(struct page_server *ps, struct fmapi_msg *m)
+{
+	int i, n, start;
+	__u8 id;
+
+	switch (m->hdr.opcode)
+	{
+		case FMOP_VSC_INFO:
+		{
+			struct fmapi_vsc_info_blk *b = &m->obj.vsc_info_rsp.list[0];
+
+			start = m->obj.vsc_info_req.vppbid_start;
+			n = m->obj.vsc_info_req.vppbid_limit;
+			id = m->obj.vsc_info_req.vcss[0];
+			if (n > ps->vsc_total - start)
+				n = ps->vsc_total - start;
+			memset(&m->obj.vsc_info_rsp, 0, sizeof(m->obj.vsc_info_rsp));
+			m->obj.vsc_info_rsp.num = 1;
+			b->vcsid = id;
+			b->state = FMVS_ENABLED;
+			b->uspid = 3;
+			b->total = ps->vsc_total;
+			b->num = n;
+			for ( i = 0 ; i < n ; i++ )
+			{
+				b->list[i].ppid = start + i;
+				b->list[i].ldid = (start + i) ^ 0x55;
+			}
+		}
+			break;
+
+		case FMOP_MCC_ALLOC_GET:
+		{
+			struct fmapi_mcc_alloc_get_rsp *r = &m->obj.mcc_alloc_get_rsp;
+
+			start = m->obj.mcc_alloc_get_req.start;
+			n = m->obj.mcc_alloc_get_req.limit;
+			if (n > FM_MAX_NUM_LD - start)
+				n = FM_MAX_NUM_LD - start;
+			if (n > ps->ld_max)
+				n = ps->ld_max;
+			memset(r, 0, sizeof(*r));
+			r->total = FM_MAX_NUM_LD;
+			r->granularity = 1;
+			r->start = start;
+			r->num = n;
+			for ( i = 0 ; i < n ; i++ )
+			{
+				r->list[i].rng1 = start + i;
+				r->list[i].rng2 = 100 + start + i;
+			}
+		}
+			break;
+
+		case FMOP_MCC_QOS_BW_ALLOC_GET:
+		case FMOP_MCC_QOS_BW_LIMIT_GET:
+		{
+			// Both payloads have the same layout
+			struct fmapi_mcc_qos_bw_alloc *r = &m->obj.mcc_qos_bw_alloc;
+
+			start = m->obj.mcc_qos_bw_alloc_get_req.start;
+			n = m->obj.mcc_qos_bw_alloc_get_req.num;
+			r->start = start;
+			r->num = n;
+			for ( i = 0 ; i < n ; i++ )
+				r->list[i] = start + i + ((m->hdr.opcode == FMOP_MCC_QOS_BW_LIMIT_GET) ? 50 : 10);
+		}
+			break;
+	}
+}
+
+/**
+ * Collect every request outstanding and answer them newest first
+ */
+void *page_thread(void *arg)
+{
+	static struct fmapi_msg m[FM_MAX_TAGS];
+	struct page_server *ps = (struct page_server*) arg;
+	int i, n;
+
+	while (recv_within(ps->t, &m[0], 1000) > 0)
+	{
+		if (ps->requests == 0)
+			ps->first = (m[0].hdr.opcode == FMOP_VSC_INFO) ? m[0].obj.vsc_info_req.vppbid_limit : 0;
+		for ( n = 1 ; (n < FM_MAX_TAGS) && (recv_within(ps->t, &m[n], 20) > 0) ; n++ ) ;
+		if (n > ps->batch)
+			ps->batch = n;
+		for ( i = n - 1 ; i >= 0 ; i-- )
+		{
+			page_answer(ps, &m[i]);
+			fmapi_transport_send_msg(ps->t, &m[i], FMMT_RESP, m[i].hdr.tag);
+			ps->requests++;
+		}
+	}
+
+	return NULL;
+}
+
+int verify_page()
+{
+	static struct fmapi_vsc_info_blk blk;
+	struct fmapi_transport *a, *b;
+	struct fmapi_session s;
+	struct fmapi_mcc_alloc_get_rsp alloc;
+	struct fmapi_mcc_qos_bw_alloc qa;
+	struct fmapi_mcc_qos_bw_limit ql;
+	struct page_server ps;
+	pthread_t th;
+	int i, rv, bad;
+
+	/* STEPS 
+	 * 1: Create a loopback pair, a session and an endpoint thread
+	 * 2: Read a VCS 8 vPPBs at a time. The first page learns the total 
+	 * 3: Read the MCC allocation 4 LDs at a time from an endpoint that 
+	 *    returns at most 3. Every short page is refilled 
+	 * 4: Read the QoS allocated and limit fractions 5 LDs at a time 
+	 * 5: Close the session and stop the endpoint 
+	 */
+
+	// STEP 1: Create a loopback pair, a session and an endpoint thread
+	rv = fmapi_transport_unix_pair(SOCK_STREAM, &a, &b);
+	if (rv < 0)
+		return 1;
+	fmapi_session_init(&s, a, 4);
+	memset(&ps, 0, sizeof(ps));
+	ps.t = b;
+	ps.vsc_total = 40;
+	ps.ld_max = 3;
+	pthread_create(&th, NULL, page_thread, &ps);
+
+	// STEP 2: Read a VCS 8 vPPBs at a time. The first page learns the total 
+	s.rsp_limit = FMLN_VSC_GET_INFO_RESP + FMLN_VSC_INFO + 8 * FMLN_VSC_PPB_STATUS;
+	rv = fmapi_page_vsc_info(&s, 5, &blk);
+	for ( bad = 0, i = 0 ; i < blk.num ; i++ )
+		if ( (blk.list[i].ppid != i) || (blk.list[i].ldid != (i ^ 0x55)) )
+			bad++;
+	printf("VSC: rv: %d vcsid: %u usp: %u total: %u num: %u bad: %d\n", rv, blk.vcsid, blk.uspid, blk.total, blk.num, bad);
+	printf("VSC: first page: %d requests: %d (expect 5) most outstanding: %d (expect 4)\n", ps.first, ps.requests, ps.batch);
+	printf("%s\n", ( (rv == 0) && (blk.num == 40) && (bad == 0) && (ps.first == 8) && (ps.requests == 5) && (ps.batch == 4) ) ? "PASS" : "FAIL");
+
+	// STEP 3: Read the MCC allocation 4 LDs at a time from an endpoint that returns at most 3. Every short page is refilled 
+	ps.requests = ps.batch = 0;
+	s.rsp_limit = FMLN_MCC_GET_LD_ALLOC_RSP + 4 * FMLN_MCC_LD_ALLOC_ENTRY;
+	rv = fmapi_page_mcc_alloc(&s, &alloc);
+	for ( bad = 0, i = 0 ; i < alloc.num ; i++ )
+		if ( (alloc.list[i].rng1 != (__u64) i) || (alloc.list[i].rng2 != (__u64) (100 + i)) )
+			bad++;
+	printf("MCC alloc: rv: %d total: %u num: %u bad: %d requests: %d (expect 8)\n", rv, alloc.total, alloc.num, bad, ps.requests);
+	printf("%s\n", ( (rv == 0) && (alloc.num == FM_MAX_NUM_LD) && (bad == 0) && (ps.requests == 8) ) ? "PASS" : "FAIL");
+
+	// STEP 4: Read the QoS allocated and limit fractions 5 LDs at a time 
+	ps.requests = ps.batch = 0;
+	s.rsp_limit = FMLN_MCC_QOS_BW_ALLOC + 5;
+	rv = fmapi_page_mcc_qos_alloc(&s, FM_MAX_NUM_LD, &qa);
+	for ( bad = 0, i = 0 ; i < FM_MAX_NUM_LD ; i++ )
+		if (qa.list[i] != i + 10)
+			bad++;
+	printf("QoS alloc: rv: %d num: %u bad: %d requests: %d (expect 4) most outstanding: %d (expect 4)\n", rv, qa.num, bad, ps.requests, ps.batch);
+	printf("%s\n", ( (rv == 0) && (qa.num == FM_MAX_NUM_LD) && (bad == 0) && (ps.requests == 4) && (ps.batch == 4) ) ? "PASS" : "FAIL");
+
+	ps.requests = 0;
+	rv = fmapi_page_mcc_qos_limit(&s, 7, &ql);
+	for ( bad = 0, i = 0 ; i < 7 ; i++ )
+		if (ql.list[i] != i + 50)
+			bad++;
+	printf("QoS limit: rv: %d num: %u bad: %d requests: %d (expect 2)\n", rv, ql.num, bad, ps.requests);
+	printf("%s\n", ( (rv == 0) && (ql.num == 7) && (bad == 0) && (ps.requests == 2) ) ? "PASS" : "FAIL");
+
+	// STEP 5: Close the session and stop the endpoint 
+	fmapi_transport_close(a);
+	pthread_join(th, NULL);
+	fmapi_transport_close(b);
+
+	return 0;
+}
+
+/**
+ * Answer Identify and Set Response Message Limit for fmapi_session_negotiate()
+ */
+struct limit_server
+{
+	struct fmapi_transport *t;	//!< Endpoint side of the loopback pair
+	int size;					//!< Largest message of the endpoint as 2^size
+};
+
+void *limit_thread(void *arg)
+{
+	struct limit_server *ls = (struct limit_server*) arg;
+	struct fmapi_msg m;
+	int i;
+
+	for ( i = 0 ; i < 2 ; i++ )
+	{
+		if (fmapi_transport_recv_msg(ls->t, &m, NULL) <= 0)
+			break;
+		if (m.hdr.opcode == FMOP_ISC_ID)
+		{
+			memset(&m.obj.isc_id_rsp, 0, sizeof(m.obj.isc_id_rsp));
+			m.obj.isc_id_rsp.size = ls->size;
+		}
+		// Set Response Message Limit echoes the limit applied
+		fmapi_transport_send_msg(ls->t, &m, FMMT_RESP, m.hdr.tag);
+	}
+
+	return NULL;
+}
+
+/**
+ * Send a raw frame of len bytes including the FM API Header
+ */
+int send_frame_len(struct fmapi_transport *t, size_t len)
+{
+	static __u8 buf[16384];
+	struct fmapi_hdr hdr;
+	struct iovec iov;
+
+	memset(buf, 0, len);
+	fmapi_fill_hdr(&hdr, FMMT_RESP, 1, FMOP_MPC_MEM, 0, len - FMLN_HDR, FMRC_SUCCESS, 0);
+	fmapi_serialize(buf, &hdr, FMOB_HDR);
+	iov.iov_base = buf;
+	iov.iov_len = len;
+
+	return fmapi_transport_send(t, &iov, 1);
+}
+
+int verify_limit()
+{
+	static __u8 data[FM_LD_MEM_REQ_LEN];
+	struct fmapi_transport *a, *b;
+	struct fmapi_session s;
+	struct limit_server ls;
+	struct fmapi_xfer x;
+	struct fmapi_msg req, m;
+	pthread_t th;
+	__u8 *frame;
+	int rv, tag, sent;
+
+	/* STEPS 
+	 * 1: Negotiate with an endpoint that accepts at most 512 byte messages
+	 * 2: Submit a request longer than the endpoint accepts and check it is 
+	 *    refused without being sent 
+	 * 3: Submit a request that fits and check it is sent 
+	 * 4: Send a frame longer than the receive buffer of a transport
+	 * 5: Negotiate a 16 KiB limit and check the same frame is received 
+	 */
+
+	// STEP 1: Negotiate with an endpoint that accepts at most 512 byte messages
+	rv = fmapi_transport_unix_pair(SOCK_STREAM, &a, &b);
+	if (rv < 0)
+		return 1;
+	fmapi_session_init(&s, a, 4);
+	ls.t = b;
+	ls.size = 9;
+	pthread_create(&th, NULL, limit_thread, &ls);
+	rv = fmapi_session_negotiate(&s, 0);
+	pthread_join(th, NULL);
+	printf("Negotiate 512: rv: %d req_limit: %u rsp_limit: %u (expect %u)\n", rv, s.req_limit, s.rsp_limit, 512 - FMLN_HDR);
+
+	// STEP 2: Submit a request longer than the endpoint accepts and check it is refused without being sent 
+	memset(&x, 0, sizeof(x));
+	fmapi_fill_mpc_mem(&req, 1, 0, 0, 512, 0xF, 0xF, FMCT_WRITE, data);
+	x.req = &req;
+	tag = fmapi_session_submit(&s, &x);
+	sent = recv_within(b, &m, 50);
+	printf("Oversized request: submit: %d - %s inflight: %u sent: %d\n", tag, (tag < 0) ? fmer(-tag) : "", s.inflight, sent > 0);
+	printf("%s\n", ( (rv == 0) && (s.req_limit == 512 - FMLN_HDR) && (tag == -FMER_OVERFLOW) && (s.inflight == 0) && (sent <= 0) ) ? "PASS" : "FAIL");
+
+	// STEP 3: Submit a request that fits and check it is sent 
+	fmapi_fill_mpc_mem(&req, 1, 0, 0, 256, 0xF, 0xF, FMCT_WRITE, data);
+	tag = fmapi_session_submit(&s, &x);
+	sent = recv_within(b, &m, 50);
+	printf("Request that fits: submit: %d inflight: %u sent: %d len: %u\n", tag, s.inflight, sent > 0, m.obj.mpc_mem_req.len);
+	printf("%s\n", ( (tag >= 0) && (s.inflight == 1) && (sent > 0) && (m.obj.mpc_mem_req.len == 256) ) ? "PASS" : "FAIL");
+	fmapi_session_fail(&s, -FMER_CLOSED);
+	fmapi_transport_close(a);
+	fmapi_transport_close(b);
+
+	// STEP 4: Send a frame longer than the receive buffer of a transport
+	rv = fmapi_transport_unix_pair(SOCK_SEQPACKET, &a, &b);
+	if (rv < 0)
+		return 1;
+	fmapi_session_init(&s, a, 4);
+	send_frame_len(b, 12288);
+	rv = fmapi_transport_recv(a, &frame);
+	printf("12 KiB frame before: %d - %s (expect overflow)\n", rv, (rv < 0) ? fmer(-rv) : "");
+	printf("%s\n", (rv == -FMER_OVERFLOW) ? "PASS" : "FAIL");
+
+	// STEP 5: Negotiate a 16 KiB limit and check the same frame is received 
+	ls.t = b;
+	ls.size = 14;
+	pthread_create(&th, NULL, limit_thread, &ls);
+	rv = fmapi_session_negotiate(&s, 16384);
+	pthread_join(th, NULL);
+	printf("Negotiate 16 KiB: rv: %d req_limit: %u rsp_limit: %u\n", rv, s.req_limit, s.rsp_limit);
+	send_frame_len(b, 12288);
+	rv = fmapi_transport_recv(a, &frame);
+	printf("12 KiB frame after: %d\n", rv);
+	printf("Set max smaller: %d larger than 2^FM_MSG_LIMIT_MAX: %d\n", fmapi_transport_set_max(a, 4096), fmapi_transport_set_max(a, (1UL << FM_MSG_LIMIT_MAX) + 1));
+	printf("%s\n", ( (s.rsp_limit == 16384 - FMLN_HDR) && (rv == 12288) ) ? "PASS" : "FAIL");
+
+	fmapi_transport_close(a);
+	fmapi_transport_close(b);
+
+	return 0;
+}
+
+/**
+ * LD memory answering Send LD CXL.io Memory Requests from another thread
+ */
+struct ld_mem_server
+{
+	struct fmapi_transport *t;	//!< Endpoint side of the loopback pair
+	__u8 mem[3 * FM_LD_MEM_REQ_LEN];	//!< Memory of the LD
+	int requests;				//!< Requests answered
+	unsigned most;				//!< Longest request
+	int bad;					//!< Requests with a length or byte enables outside the rules
+};
+
+void *ld_mem_thread(void *arg)
+{
+	static struct fmapi_msg m;
+	struct ld_mem_server *ms = (struct ld_mem_server*) arg;
+	struct fmapi_mpc_mem_req q;
+	unsigned i, be;
+
+	while (fmapi_transport_recv_msg(ms->t, &m, NULL) > 0)
+	{
+		q = m.obj.mpc_mem_req;
+		ms->requests++;
+		if (q.len > ms->most)
+			ms->most = q.len;
+
+		// Whole DWords that do not cross a 4 KB boundary. One DWord uses no Last DWord Byte Enable
+		if ( (q.len == 0) || (q.len & 3) || (q.offset & 3) || (q.offset + q.len > sizeof(ms->mem)) 
+			|| ((q.offset / FM_LD_MEM_REQ_LEN) != ((q.offset + q.len - 1) / FM_LD_MEM_REQ_LEN))
+			|| ((q.len == 4) && (q.ldbe != 0)) || ((q.len > 4) && ( (q.fdbe == 0) || (q.ldbe == 0) )) )
+		{
+			ms->bad++;
+			q.len = 0;
+		}
+
+		if (q.type == FMCT_WRITE)
+		{
+			for ( i = 0 ; i < q.len ; i++ )
+			{
+				if (i < 4)
+					be = q.fdbe;
+				else if (i >= q.len - 4u)
+					be = q.ldbe;
+				else
+					be = 0xF;
+				if (be & (1 << (i & 3)))
+					ms->mem[q.offset + i] = q.data[i];
+			}
+		}
+
+		m.obj.mpc_mem_rsp.len = q.len;
+		memcpy(m.obj.mpc_mem_rsp.data, &ms->mem[q.offset], q.len);
+		fmapi_transport_send_msg(ms->t, &m, FMMT_RESP, m.hdr.tag);
+	}
+
+	return NULL;
+}
+
+/**
+ * Check the LD memory holds src over [off, off + len) and fill elsewhere 
+ */
+int ld_mem_check(struct ld_mem_server *ms, unsigned off, unsigned len, const __u8 *src, __u8 fill)
+{
+	unsigned i;
+	int bad;
+
+	for ( bad = 0, i = 0 ; i < sizeof(ms->mem) ; i++ )
+		if (ms->mem[i] != ( ((i >= off) && (i < off + len)) ? src[i - off] : fill ))
+			bad++;
+
+	return bad;
+}
+
+int verify_ld_mem()
+{
+	static struct ld_mem_server ms;
+	static __u8 src[2 * FM_LD_MEM_REQ_LEN], dst[2 * FM_LD_MEM_REQ_LEN];
+	const unsigned offs[] = {1, 2, 3, 4, 4093, 4094};
+	const unsigned lens[] = {1, 2, 3, 5, 6, 4000, 5001};
+	struct fmapi_transport *a, *b;
+	struct fmapi_session s;
+	struct limit_server ls;
+	pthread_t th;
+	unsigned i, k;
+	int rv, bad, fail;
+
+	/* STEPS 
+	 * 1: Negotiate 512 byte messages and start the LD memory 
+	 * 2: Write ranges with unaligned starts and ends and check only the 
+	 *    bytes of the range changed 
+	 * 3: Read the ranges back 
+	 * 4: Check every request fit the negotiated limits 
+	 * 5: Raise the limits and check a range is split at 4 KB boundaries
+	 */
+
+	// STEP 1: Negotiate 512 byte messages and start the LD memory 
+	rv = fmapi_transport_unix_pair(SOCK_STREAM, &a, &b);
+	if (rv < 0)
+		return 1;
+	fmapi_session_init(&s, a, 4);
+	ls.t = b;
+	ls.size = 9;
+	pthread_create(&th, NULL, limit_thread, &ls);
+	rv = fmapi_session_negotiate(&s, 0);
+	pthread_join(th, NULL);
+	printf("Negotiate 512: rv: %d req_limit: %u rsp_limit: %u\n", rv, s.req_limit, s.rsp_limit);
+
+	memset(&ms, 0, sizeof(ms));
+	ms.t = b;
+	pthread_create(&th, NULL, ld_mem_thread, &ms);
+	for ( i = 0 ; i < sizeof(src) ; i++ )
+		src[i] = i * 7 + 1;
+
+	fail = 0;
+	for ( k = 0 ; k < sizeof(offs) / sizeof(offs[0]) ; k++ )
+	{
+		for ( i = 0 ; i < sizeof(lens) / sizeof(lens[0]) ; i++ )
+		{
+			// STEP 2: Write ranges with unaligned starts and ends and check only the bytes of the range changed 
+			memset(ms.mem, 0xEE, sizeof(ms.mem));
+			rv = fmapi_ld_mem_write(&s, 1, 0, offs[k], lens[i], src, 0);
+			bad = ld_mem_check(&ms, offs[k], lens[i], src, 0xEE);
+
+			// STEP 3: Read the ranges back 
+			memset(dst, 0, sizeof(dst));
+			if (rv == 0)
+				rv = fmapi_ld_mem_read(&s, 1, 0, offs[k], lens[i], dst, 0);
+			if (memcmp(dst, src, lens[i]) != 0)
+				bad++;
+
+			if ( (rv != 0) || (bad != 0) )
+			{
+				printf("Offset %u length %u: rv: %d bad bytes: %d\n", offs[k], lens[i], rv, bad);
+				fail++;
+			}
+		}
+	}
+
+	// STEP 4: Check every request fit the negotiated limits 
+	printf("512 byte limit: ranges failed: %d requests: %d longest: %u (expect %u) bad: %d\n", fail, ms.requests, ms.most, (s.req_limit - FMLN_MPC_LD_MEM_REQ) & ~3U, ms.bad);
+	printf("%s\n", ( (fail == 0) && (ms.most == ((s.req_limit - FMLN_MPC_LD_MEM_REQ) & ~3U)) && (ms.bad == 0) ) ? "PASS" : "FAIL");
+
+	// STEP 5: Raise the limits and check a range is split at 4 KB boundaries
+	s.req_limit = s.rsp_limit = FMLN_PAYLOAD;
+	ms.requests = ms.most = 0;
+	memset(ms.mem, 0xEE, sizeof(ms.mem));
+	rv = fmapi_ld_mem_write(&s, 1, 0, 4093, 5001, src, 0);
+	bad = ld_mem_check(&ms, 4093, 5001, src, 0xEE);
+	printf("Default limit: rv: %d bad bytes: %d requests: %d (expect 3) longest: %u bad: %d\n", rv, bad, ms.requests, ms.most, ms.bad);
+	printf("%s\n", ( (rv == 0) && (bad == 0) && (ms.requests == 3) && (ms.most == FM_LD_MEM_REQ_LEN) && (ms.bad == 0) ) ? "PASS" : "FAIL");
+
+	fmapi_transport_close(a);
+	pthread_join(th, NULL);
+	fmapi_transport_close(b);
+
+	return 0;
+}
+
+/**
+ * Configuration space of 4 ports and their LDs answered from another thread
+ */
+struct cfg_server
+{
+	struct fmapi_transport *t;				//!< Endpoint side of the loopback pair
+	__u8 mem[4][FM_MAX_NUM_LD + 1][FM_CFG_SPACE_LEN];	//!< Space of each PPB, then of each LD
+	int requests;							//!< Configuration requests answered
+	int bad;								//!< Requests for an unaligned or unknown DWord
+};
+
+void *cfg_thread(void *arg)
+{
+	static struct fmapi_msg m;
+	struct cfg_server *cs = (struct cfg_server*) arg;
+	unsigned off, i, be;
+	__u8 *p, *data;
+	int wr;
+
+	while (fmapi_transport_recv_msg(cs->t, &m, NULL) > 0)
+	{
+		p = NULL;
+		switch (m.hdr.opcode)
+		{
+			case FMOP_PSC_CFG:
+				off = m.obj.psc_cfg_req.reg | (m.obj.psc_cfg_req.ext << 8);
+				if (m.obj.psc_cfg_req.ppid < 4)
+					p = &cs->mem[m.obj.psc_cfg_req.ppid][0][off];
+				be = m.obj.psc_cfg_req.fdbe;
+				wr = (m.obj.psc_cfg_req.type == FMCT_WRITE);
+				data = m.obj.psc_cfg_req.data;
+				break;
+
+			case FMOP_MPC_CFG:
+				off = m.obj.mpc_cfg_req.reg | (m.obj.mpc_cfg_req.ext << 8);
+				if ( (m.obj.mpc_cfg_req.ppid < 4) && (m.obj.mpc_cfg_req.ldid < FM_MAX_NUM_LD) )
+					p = &cs->mem[m.obj.mpc_cfg_req.ppid][1 + m.obj.mpc_cfg_req.ldid][off];
+				be = m.obj.mpc_cfg_req.fdbe;
+				wr = (m.obj.mpc_cfg_req.type == FMCT_WRITE);
+				data = m.obj.mpc_cfg_req.data;
+				break;
+
+			// Link changes alter what is behind the port
+			case FMOP_PSC_PORT_CTRL:
+				memset(cs->mem[m.obj.psc_port_ctrl_req.ppid], 0x55, sizeof(cs->mem[0]));
+				fmapi_transport_send_msg(cs->t, &m, FMMT_RESP, m.hdr.tag);
+				continue;
+
+			case FMOP_VSC_BIND:
+				memset(cs->mem[m.obj.vsc_bind_req.ppid], 0x66, sizeof(cs->mem[0]));
+				fmapi_transport_send_msg(cs->t, &m, FMMT_RESP, m.hdr.tag);
+				continue;
+
+			// The unbound port is not named in the request. Port 2 is behind every vPPB here
+			case FMOP_VSC_UNBIND:
+				memset(cs->mem[2], 0x77, sizeof(cs->mem[0]));
+				fmapi_transport_send_msg(cs->t, &m, FMMT_RESP, m.hdr.tag);
+				continue;
+
+			default:
+				continue;
+		}
+
+		cs->requests++;
+		if ( (p == NULL) || (off & 3) )
+		{
+			cs->bad++;
+			fmapi_fill_hdr(&m.hdr, FMMT_RESP, m.hdr.tag, m.hdr.opcode, 0, 0, FMRC_INVALID_INPUT, 0);
+			fmapi_transport_send_msg(cs->t, &m, FMMT_RESP, m.hdr.tag);
+			continue;
+		}
+
+		if (wr)
+			for ( i = 0 ; i < 4 ; i++ )
+				if (be & (1 << i))
+					p[i] = data[i];
+
+		// Both response payloads are the 4 data bytes
+		memcpy(m.obj.psc_cfg_rsp.data, p, 4);
+		fmapi_transport_send_msg(cs->t, &m, FMMT_RESP, m.hdr.tag);
+	}
+
+	return NULL;
+}
+
+/**
+ * Lay out a capability list and an extended capability list with a PCIe 
+ * Capability and a DVSEC
+ */
+void cfg_layout(__u8 *mem)
+{
+	unsigned i;
+
+	for ( i = 0 ; i < FM_CFG_SPACE_LEN ; i++ )
+		mem[i] = i * 7 + 1;
+
+	fmapi_put_le32(&mem[PCI_COMMAND], PCI_STATUS_CAP_LIST << 16);
+	fmapi_put_le32(&mem[PCI_CAPABILITY_LIST], 0x40);
+	fmapi_put_le32(&mem[0x40], (0x50 << 8) | PCI_CAP_ID_PM);
+	fmapi_put_le32(&mem[0x50], (0x00 << 8) | PCI_CAP_ID_EXP);
+	fmapi_put_le32(&mem[0x100], (0x148 << 20) | (1 << 16) | PCI_EXT_CAP_ID_ERR);
+	fmapi_put_le32(&mem[0x148], (0x000 << 20) | (1 << 16) | PCI_EXT_CAP_ID_DVSEC);
+	fmapi_put_le32(&mem[0x148 + PCI_VNDR_HEADER], (0x38 << 20) | (1 << 16) | 0x1E98);
+}
+
+int verify_cfg_snapshot()
+{
+	static struct cfg_server cs;
+	static struct fmapi_cfg_image full, img;
+	const __u8 caps[] = {PCI_CAP_ID_EXP};
+	const __u16 exts[] = {PCI_EXT_CAP_ID_DVSEC};
+	struct fmapi_cfg_filter f;
+	struct fmapi_transport *a, *b;
+	struct fmapi_session s;
+	pthread_t th;
+	unsigned i, num, off, end;
+	int rv, bad, missing;
+
+	/* STEPS 
+	 * 1: Create a loopback pair, a session and a device with two capabilities 
+	 *    in each list 
+	 * 2: Take a full snapshot and check it matches the device 
+	 * 3: Take a snapshot filtered to the PCIe Capability and the DVSEC 
+	 * 4: Check the filtered snapshot agrees with the full one 
+	 */
+
+	// STEP 1: Create a loopback pair, a session and a device with two capabilities in each list 
+	rv = fmapi_transport_unix_pair(SOCK_STREAM, &a, &b);
+	if (rv < 0)
+		return 1;
+	fmapi_session_init(&s, a, 8);
+	memset(&cs, 0, sizeof(cs));
+	cs.t = b;
+	cfg_layout(cs.mem[3][0]);
+	cfg_layout(cs.mem[3][3]);
+	pthread_create(&th, NULL, cfg_thread, &cs);
+
+	// STEP 2: Take a full snapshot and check it matches the device 
+	rv = fmapi_cfg_snapshot(&s, 3, -1, NULL, &full, 0);
+	printf("Full: rv: %d caps: %u requests: %d (expect %d) same: %d\n", rv, full.num, cs.requests, FM_CFG_SPACE_LEN / 4, memcmp(full.data, cs.mem[3][0], FM_CFG_SPACE_LEN) == 0);
+	for ( i = 0 ; i < full.num ; i++ )
+		printf("Cap %u: id: 0x%02x off: 0x%03x ext: %d\n", i, full.cap[i].id, full.cap[i].off, full.cap[i].ext);
+	printf("%s\n", ( (rv == 0) && (full.num == 4) && (cs.requests == FM_CFG_SPACE_LEN / 4) && (memcmp(full.data, cs.mem[3][0], FM_CFG_SPACE_LEN) == 0) ) ? "PASS" : "FAIL");
+
+	// STEP 3: Take a snapshot filtered to the PCIe Capability and the DVSEC 
+	cs.requests = 0;
+	f.cap = caps;
+	f.ncap = 1;
+	f.ext = exts;
+	f.next = 1;
+	rv = fmapi_cfg_snapshot(&s, 3, 2, &f, &img, 4);
+
+	// STEP 4: Check the filtered snapshot agrees with the full one 
+	bad = num = 0;
+	for ( i = 0 ; i < FM_CFG_SPACE_LEN / 4 ; i++ )
+	{
+		if (!(img.valid[i >> 3] & (1 << (i & 7))))
+			continue;
+		num++;
+		if (memcmp(&img.data[i * 4], &full.data[i * 4], 4) != 0)
+			bad++;
+	}
+	if ( (img.num != full.num) || (memcmp(img.cap, full.cap, full.num * sizeof(full.cap[0])) != 0) )
+		bad++;
+
+	// The PCIe Capability runs to the end of the legacy region and the DVSEC for its DVSEC Length
+	missing = 0;
+	off = fmapi_cfg_find(&img, PCI_CAP_ID_EXP, 0);
+	for ( end = PCI_CFG_SPACE_SIZE ; off < end ; off += 4 )
+		if (!(img.valid[(off / 4) >> 3] & (1 << ((off / 4) & 7))))
+			missing++;
+	off = fmapi_cfg_find(&img, PCI_EXT_CAP_ID_DVSEC, 1);
+	for ( end = off + 0x38 ; off < end ; off += 4 )
+		if (!(img.valid[(off / 4) >> 3] & (1 << ((off / 4) & 7))))
+			missing++;
+
+	printf("Filtered: rv: %d caps: %u requests: %d DWords: %u differ: %d missing: %d bad requests: %d\n", rv, img.num, cs.requests, num, bad, missing, cs.bad);
+	printf("%s\n", ( (rv == 0) && (bad == 0) && (missing == 0) && ((unsigned) cs.requests == num) && (num < FM_CFG_SPACE_LEN / 4) && (cs.bad == 0) ) ? "PASS" : "FAIL");
+
+	fmapi_transport_close(a);
+	pthread_join(th, NULL);
+	fmapi_transport_close(b);
+
+	return 0;
+}
+
+/**
+ * Read through a cache and compare with the device 
+ *
+ * @return number of configuration requests the read sent, or -1 on a mismatch
+ */
+int cache_read(struct fmapi_cfg_cache *c, struct cfg_server *cs, int ppid, int ldid, unsigned off, unsigned len)
+{
+	__u8 buf[FM_CFG_SPACE_LEN];
+	int rv, n;
+
+	n = cs->requests;
+	rv = fmapi_cfg_cache_read(c, ppid, ldid, off, len, buf);
+	if ( (rv != 0) || (memcmp(buf, &cs->mem[ppid][ldid + 1][off], len) != 0) )
+		return -1;
+
+	return cs->requests - n;
+}
+
+int verify_cfg_cache()
+{
+	static struct cfg_server cs;
+	static struct fmapi_cfg_cache c;
+	struct fmapi_transport *a, *b;
+	struct fmapi_session s;
+	struct fmapi_msg m;
+	__u32 gen[4];
+	pthread_t th;
+	int i, rv, n0, n1, n2, n3;
+
+	/* STEPS 
+	 * 1: Create a loopback pair, a session, a cache and 4 ports 
+	 * 2: Read ranges twice and check the second reads hit the cache 
+	 * 3: Write through the cache and check only the written DWord is read again 
+	 * 4: Send Physical Port Control and check only its port is dropped 
+	 * 5: Bind a port and check only that port is dropped 
+	 * 6: Unbind a vPPB and check every port is dropped 
+	 */
+
+	// STEP 1: Create a loopback pair, a session, a cache and 4 ports 
+	rv = fmapi_transport_unix_pair(SOCK_STREAM, &a, &b);
+	if (rv < 0)
+		return 1;
+	fmapi_session_init(&s, a, 8);
+	fmapi_cfg_cache_init(&c, &s);
+	memset(&cs, 0, sizeof(cs));
+	cs.t = b;
+	srand(2);
+	for ( i = 0 ; i < (int) sizeof(cs.mem) ; i++ )
+		((__u8*) cs.mem)[i] = rand();
+	pthread_create(&th, NULL, cfg_thread, &cs);
+
+	// STEP 2: Read ranges twice and check the second reads hit the cache 
+	n0 = cache_read(&c, &cs, 1, -1, 0x50, 16);
+	n1 = cache_read(&c, &cs, 1, -1, 0x52, 6);
+	n2 = cache_read(&c, &cs, 1, 3, 0x1FE, 9);
+	n3 = cache_read(&c, &cs, 1, 3, 0x200, 4);
+	printf("Repeat reads: requests: %d %d %d %d (expect 4 0 3 0) hits: %lu misses: %lu\n", n0, n1, n2, n3, c.hits, c.misses);
+	printf("%s\n", ( (n0 == 4) && (n1 == 0) && (n2 == 3) && (n3 == 0) && (c.hits == 3) && (c.misses == 7) ) ? "PASS" : "FAIL");
+
+	// STEP 3: Write through the cache and check only the written DWord is read again 
+	gen[1] = c.gen[1];
+	rv = fmapi_cfg_cache_write(&c, 1, -1, 0x54, 0x3, 0xAABBCCDD);
+	n0 = cache_read(&c, &cs, 1, -1, 0x50, 16);
+	n1 = cache_read(&c, &cs, 1, 3, 0x1FE, 9);
+	printf("Write through: rv: %d requests: %d (expect 1) other LD: %d (expect 0) generation: +%u value: 0x%08x\n", rv, n0, n1, c.gen[1] - gen[1], fmapi_get_le32(&cs.mem[1][0][0x54]));
+	printf("%s\n", ( (rv == 0) && (n0 == 1) && (n1 == 0) && (c.gen[1] != gen[1]) && ((fmapi_get_le32(&cs.mem[1][0][0x54]) & 0xFFFF) == 0xCCDD) ) ? "PASS" : "FAIL");
+
+	// STEP 4: Send Physical Port Control and check only its port is dropped 
+	cache_read(&c, &cs, 3, -1, 0, 64);
+	for ( i = 0 ; i < 4 ; i++ )
+		gen[i] = c.gen[i];
+	fmapi_fill_psc_port_ctrl(&m, 1, FMPO_RESET_PPB);
+	rv = fmapi_cfg_cache_call(&c, &m, NULL, NULL);
+	n0 = cache_read(&c, &cs, 1, -1, 0x50, 16);
+	n1 = cache_read(&c, &cs, 1, 3, 0x1FE, 9);
+	n2 = cache_read(&c, &cs, 3, -1, 0, 64);
+	printf("Port Control: rv: %d port 1: %d %d (expect 4 3) port 3: %d (expect 0) generations: +%u +%u\n", rv, n0, n1, n2, c.gen[1] - gen[1], c.gen[3] - gen[3]);
+	printf("%s\n", ( (rv == 0) && (n0 == 4) && (n1 == 3) && (n2 == 0) && (c.gen[1] != gen[1]) && (c.gen[3] == gen[3]) ) ? "PASS" : "FAIL");
+
+	// STEP 5: Bind a port and check only that port is dropped 
+	for ( i = 0 ; i < 4 ; i++ )
+		gen[i] = c.gen[i];
+	fmapi_fill_vsc_bind(&m, 0, 1, 3, 0xFFFF);
+	rv = fmapi_cfg_cache_call(&c, &m, NULL, NULL);
+	n0 = cache_read(&c, &cs, 3, -1, 0, 64);
+	n1 = cache_read(&c, &cs, 1, -1, 0x50, 16);
+	printf("Bind: rv: %d port 3: %d (expect 16) port 1: %d (expect 0) generations: +%u +%u\n", rv, n0, n1, c.gen[3] - gen[3], c.gen[1] - gen[1]);
+	printf("%s\n", ( (rv == 0) && (n0 == 16) && (n1 == 0) && (c.gen[3] != gen[3]) && (c.gen[1] == gen[1]) ) ? "PASS" : "FAIL");
+
+	// STEP 6: Unbind a vPPB and check every port is dropped 
+	cache_read(&c, &cs, 2, 0, 0, 64);
+	for ( i = 0 ; i < 4 ; i++ )
+		gen[i] = c.gen[i];
+	fmapi_fill_vsc_unbind(&m, 0, 1, 0);
+	rv = fmapi_cfg_cache_call(&c, &m, NULL, NULL);
+	n0 = cache_read(&c, &cs, 2, 0, 0, 64);
+	n1 = cache_read(&c, &cs, 1, -1, 0x50, 16);
+	for ( n2 = 0, i = 0 ; i < 4 ; i++ )
+		if (c.gen[i] != gen[i])
+			n2++;
+	printf("Unbind: rv: %d port 2: %d (expect 16) port 1: %d (expect 4) ports dropped: %d (expect 4)\n", rv, n0, n1, n2);
+	printf("%s\n", ( (rv == 0) && (n0 == 16) && (n1 == 4) && (n2 == 4) ) ? "PASS" : "FAIL");
+
+	fmapi_cfg_cache_free(&c);
+	fmapi_transport_close(a);
+	pthread_join(th, NULL);
+	fmapi_transport_close(b);
+
+	return 0;
+}
+
+/**
+ * Device running background operations, answered from another thread
+ */
+struct bos_server
+{
+	struct fmapi_transport *t;	//!< Endpoint side of the loopback pair
+	unsigned dur;				//!< Duration of the next operation in milliseconds
+	unsigned len;				//!< Duration of the operation running
+	int stall;					//!< Percent Complete stays 0 until the operation finishes
+	__u16 op;					//!< Opcode of the operation running
+	__u64 t0;					//!< Time the operation started
+	int busy;					//!< Commands answered busy while an operation runs
+	int polls;					//!< Background Operation Status requests answered
+	__u64 at[64];				//!< Time of each poll relative to t0
+	__u16 order[16];			//!< Opcodes of the operations started, in order
+	int started;				//!< Number of operations started
+};
+
+void *bos_thread(void *arg)
+{
+	static struct fmapi_msg m;
+	struct bos_server *bs = (struct bos_server*) arg;
+	struct fmapi_isc_bos *b = &m.obj.isc_bos;
+	__u64 el;
+	__u16 op;
+	__u8 tag;
+
+	while (fmapi_transport_recv_msg(bs->t, &m, NULL) > 0)
+	{
+		op = m.hdr.opcode;
+		tag = m.hdr.tag;
+		el = fmapi_now_ms() - bs->t0;
+
+		if (op == FMOP_ISC_BOS)
+		{
+			if (bs->polls < 64)
+				bs->at[bs->polls] = el;
+			bs->polls++;
+			memset(b, 0, sizeof(*b));
+			b->opcode = bs->op;
+			if (el >= bs->len)
+			{
+				b->pcnt = 100;
+				b->ext = 0x1234;
+			}
+			else
+			{
+				b->running = 1;
+				b->pcnt = bs->stall ? 0 : el * 100 / bs->len;
+			}
+		}
+		else if (op == FMOP_ISC_ID)
+		{
+			// A command that never runs in the background
+			memset(&m.obj.isc_id_rsp, 0, sizeof(m.obj.isc_id_rsp));
+		}
+		else if ( (bs->started > 0) && (el < bs->len) )
+		{
+			// One background operation at a time
+			bs->busy++;
+			fmapi_fill_hdr(&m.hdr, FMMT_RESP, tag, op, 0, 0, FMRC_BUSY, 0);
+		}
+		else
+		{
+			bs->op = op;
+			bs->len = bs->dur;
+			bs->t0 = fmapi_now_ms();
+			if (bs->started < 16)
+				bs->order[bs->started] = op;
+			bs->started++;
+			fmapi_fill_hdr(&m.hdr, FMMT_RESP, tag, op, 0, 0, FMRC_BACKGROUND_OP_STARTED, 0);
+		}
+
+		fmapi_transport_send_msg(bs->t, &m, FMMT_RESP, tag);
+	}
+
+	return NULL;
+}
+
+int verify_bos_poll()
+{
+	static struct bos_server bs;
+	static struct fmapi_bos_poller p;
+	struct fmapi_transport *a, *b;
+	struct fmapi_session s;
+	struct fmapi_bos_wait w;
+	struct fmapi_msg req, rsp;
+	pthread_t th;
+	__u64 t0, took, gap, prev;
+	unsigned i, first[3], learned;
+	int rv, ok;
+	__u16 ext;
+
+	/* STEPS 
+	 * 1: Check the first interval of each kind of command on a new poller 
+	 * 2: Bind with steady progress and check the polls follow its rate 
+	 * 3: Check the next bind starts with the duration learned 
+	 * 4: Reset a port that makes no progress and check the interval doubles 
+	 *    up to max_ms 
+	 */
+
+	// STEP 1: Check the first interval of each kind of command on a new poller 
+	rv = fmapi_transport_unix_pair(SOCK_STREAM, &a, &b);
+	if (rv < 0)
+		return 1;
+	fmapi_session_init(&s, a, 8);
+	memset(&w, 0, sizeof(w));
+	w.opcode = FMOP_VSC_BIND;
+	fmapi_bos_poller_init(&p, &s, 0, 800);
+	fmapi_bos_wait_submit(&p, &w);
+	first[0] = p.interval;
+	w.opcode = FMOP_PSC_PORT_CTRL;
+	fmapi_bos_poller_init(&p, &s, 0, 800);
+	fmapi_bos_wait_submit(&p, &w);
+	first[1] = p.interval;
+	w.opcode = FMOP_MCC_ALLOC_SET;
+	fmapi_bos_poller_init(&p, &s, 0, 800);
+	fmapi_bos_wait_submit(&p, &w);
+	first[2] = p.interval;
+	printf("First interval: bind: %u (expect 10) port control: %u (expect 100) set allocation: %u (expect 100)\n", first[0], first[1], first[2]);
+	printf("%s\n", ( (first[0] == 10) && (first[1] == 100) && (first[2] == 100) ) ? "PASS" : "FAIL");
+
+	// STEP 2: Bind with steady progress and check the polls follow its rate 
+	memset(&bs, 0, sizeof(bs));
+	bs.t = b;
+	bs.dur = 60;
+	pthread_create(&th, NULL, bos_thread, &bs);
+	fmapi_bos_poller_init(&p, &s, 0, 800);
+	fmapi_fill_vsc_bind(&req, 0, 1, 2, 0xFFFF);
+	t0 = fmapi_now_ms();
+	rv = fmapi_bos_call(&p, &req, &rsp, NULL, &ext);
+	took = fmapi_now_ms() - t0;
+	printf("Steady bind: rv: %d ext: 0x%04x polls: %d took: %s\n", rv, ext, bs.polls, (took < bs.dur + 40) ? "near its duration" : "too long");
+	printf("%s\n", ( (rv == 0) && (ext == 0x1234) && (bs.polls >= 2) && (bs.polls <= 6) && (took < bs.dur + 40) ) ? "PASS" : "FAIL");
+
+	// STEP 3: Check the next bind starts with the duration learned 
+	for ( learned = 0, i = 0 ; i < FM_BOS_HISTORY ; i++ )
+		if ( (p.hist[i].ms > 0) && (p.hist[i].opcode == FMOP_VSC_BIND) )
+			learned = p.hist[i].ms;
+	memset(&w, 0, sizeof(w));
+	w.opcode = FMOP_VSC_BIND;
+	fmapi_bos_wait_submit(&p, &w);
+	first[0] = p.interval;
+	rv = fmapi_bos_wait(&p, &w);
+	printf("Learned bind: %s first interval: %s (expect near its duration, learned)\n", ( (learned + 10 >= bs.dur) && (learned < bs.dur + 40) ) ? "near its duration" : "off", (first[0] == learned) ? "learned" : "other");
+	printf("%s\n", ( (rv == 0) && (first[0] == learned) && (learned + 10 >= bs.dur) && (learned < bs.dur + 40) ) ? "PASS" : "FAIL");
+
+	// STEP 4: Reset a port that makes no progress and check the interval doubles up to max_ms 
+	bs.polls = 0;
+	bs.dur = 300;
+	bs.stall = 1;
+	fmapi_bos_poller_init(&p, &s, 0, 80);
+	fmapi_fill_psc_port_ctrl(&req, 1, FMPO_RESET_PPB);
+	rv = fmapi_bos_call(&p, &req, &rsp, NULL, &ext);
+	ok = (rv == 0) && (bs.polls >= 5) && (bs.polls <= 8);
+	printf("Stalled reset: rv: %d polls: %d gaps:", rv, bs.polls);
+	for ( prev = 0, i = 0 ; (i < (unsigned) bs.polls) && (i < 64) ; i++ )
+	{
+		gap = bs.at[i] - ((i > 0) ? bs.at[i - 1] : 0);
+		printf(" %llu", (unsigned long long) gap);
+
+		// Each gap doubles the one before up to max_ms, give or take scheduling
+		if ( (prev > 0) && (gap + 5 < ((2 * prev < 80) ? 2 * prev : 80)) )
+			ok = 0;
+		if (gap > 80 + 20)
+			ok = 0;
+		prev = gap;
+	}
+	printf(" (expect 10 20 40 80 80 ...)\n");
+	printf("%s\n", ok ? "PASS" : "FAIL");
+
+	fmapi_transport_close(a);
+	pthread_join(th, NULL);
+	fmapi_transport_close(b);
+
+	return 0;
+}
+
+/**
+ * Jobs of a scheduler in the order they completed
+ */
+struct sched_log
+{
+	struct fmapi_bos_job *done[8];
+	int num;
+};
+
+void sched_cb(struct fmapi_bos_job *j)
+{
+	struct sched_log *l = (struct sched_log*) j->arg;
+
+	if (l->num < 8)
+		l->done[l->num] = j;
+	l->num++;
+}
+
+int verify_bos_sched()
+{
+	static struct bos_server bs;
+	static struct fmapi_bos_poller p;
+	static struct fmapi_bos_sched sc;
+	static struct fmapi_msg req[4], rsp[4];
+	static struct fmapi_bos_job j[4];
+	struct fmapi_transport *a, *b;
+	struct fmapi_session s;
+	struct sched_log l;
+	pthread_t th;
+	int rv, i, ok;
+
+	/* STEPS 
+	 * 1: Create a loopback pair, a session and a scheduler 
+	 * 2: Submit a bind, an unbind, a port control flagged as background and 
+	 *    an identify 
+	 * 3: Wait for the last background job and check the order jobs ran in 
+	 * 4: Bind outside the scheduler and check an unbind waits for it 
+	 */
+
+	// STEP 1: Create a loopback pair, a session and a scheduler 
+	rv = fmapi_transport_unix_pair(SOCK_STREAM, &a, &b);
+	if (rv < 0)
+		return 1;
+	fmapi_session_init(&s, a, 8);
+	fmapi_bos_poller_init(&p, &s, 0, 100);
+	fmapi_bos_sched_init(&sc, &p);
+	memset(&bs, 0, sizeof(bs));
+	bs.t = b;
+	bs.dur = 30;
+	pthread_create(&th, NULL, bos_thread, &bs);
+
+	// STEP 2: Submit a bind, an unbind, a port control flagged as background and an identify 
+	fmapi_fill_vsc_bind(&req[0], 0, 1, 2, 0xFFFF);
+	fmapi_fill_vsc_unbind(&req[1], 0, 1, FMUB_WAIT);
+	fmapi_fill_psc_port_ctrl(&req[2], 1, FMPO_RESET_PPB);
+	req[2].hdr.background = 1;
+	fmapi_fill_isc_id(&req[3]);
+	memset(&l, 0, sizeof(l));
+	memset(j, 0, sizeof(j));
+	for ( rv = 0, i = 0 ; i < 4 ; i++ )
+	{
+		j[i].req = &req[i];
+		j[i].rsp = &rsp[i];
+		j[i].cb = sched_cb;
+		j[i].arg = &l;
+		rv |= fmapi_bos_job_submit(&sc, &j[i]);
+	}
+	printf("Submitted: rv: %d background sent: %d current: %s queued: %s\n", rv, sc.sent, (sc.cur == &j[0]) ? "bind" : "other", ( (sc.head == &j[1]) && (j[1].next == &j[2]) && (sc.tail == &j[2]) ) ? "unbind, port control" : "other");
+	printf("%s\n", ( (rv == 0) && (sc.sent == 1) && (sc.cur == &j[0]) && (sc.head == &j[1]) && (j[1].next == &j[2]) && (sc.tail == &j[2]) ) ? "PASS" : "FAIL");
+
+	// STEP 3: Wait for the last background job and check the order jobs ran in 
+	rv = fmapi_bos_job_wait(&sc, &j[2]);
+	ok = (rv == 0) && (l.num == 4) && (l.done[0] == &j[3]) && (l.done[1] == &j[0]) && (l.done[2] == &j[1]) && (l.done[3] == &j[2]);
+	printf("Completed: rv: %d jobs: %d order:", rv, l.num);
+	for ( i = 0 ; (i < l.num) && (i < 8) ; i++ )
+		printf(" %ld", (long) (l.done[i] - j));
+	printf(" (expect 3 0 1 2)\n");
+	printf("Started on the device: %d busy: %d order:", bs.started, bs.busy);
+	for ( i = 0 ; (i < bs.started) && (i < 16) ; i++ )
+		printf(" 0x%04x", bs.order[i]);
+	printf(" (expect 0x%04x 0x%04x 0x%04x busy 0)\n", FMOP_VSC_BIND, FMOP_VSC_UNBIND, FMOP_PSC_PORT_CTRL);
+	ok = ok && (bs.started == 3) && (bs.busy == 0) && (bs.order[0] == FMOP_VSC_BIND) && (bs.order[1] == FMOP_VSC_UNBIND) && (bs.order[2] == FMOP_PSC_PORT_CTRL);
+	for ( i = 0 ; i < 3 ; i++ )
+		if ( (j[i].status != 0) || (j[i].ext != 0x1234) || (j[i].tries != 1) )
+			ok = 0;
+	printf("%s\n", ok ? "PASS" : "FAIL");
+
+	// STEP 4: Bind outside the scheduler and check an unbind waits for it 
+	rv = fmapi_session_call(&s, &req[0], &rsp[0], NULL);
+	memset(&j[1], 0, sizeof(j[1]));
+	j[1].req = &req[1];
+	j[1].rsp = &rsp[1];
+	fmapi_bos_job_submit(&sc, &j[1]);
+	fmapi_bos_job_wait(&sc, &j[1]);
+	printf("Unbind behind a bind: bind: %d unbind: %d ext: 0x%04x tries: %u busy: %d last started: 0x%04x (expect %d 0 0x1234 2 1 0x%04x)\n", rv, j[1].status, j[1].ext, j[1].tries, bs.busy, bs.order[bs.started - 1], FMRC_BACKGROUND_OP_STARTED, FMOP_VSC_UNBIND);
+	printf("%s\n", ( (rv == FMRC_BACKGROUND_OP_STARTED) && (j[1].status == 0) && (j[1].ext == 0x1234) && (j[1].tries == 2) && (bs.busy == 1) && (bs.started == 5) && (bs.order[4] == FMOP_VSC_UNBIND) ) ? "PASS" : "FAIL");
+
+	fmapi_transport_close(a);
+	pthread_join(th, NULL);
+	fmapi_transport_close(b);
+
+	return 0;
+}
+
+/**
+ * Compare a view accessor against the field of the deserialized object 
+ */
+#define VIEW_EQ(name, field) 		bad += (fmapi_##name##_view_##field(fmapi_##name##_view(p)) != ((struct fmapi_##name*) o)->field)
+#define VIEW_MEM(name, field, len) 	bad += (memcmp(fmapi_##name##_view_##field(fmapi_##name##_view(p)), ((struct fmapi_##name*) o)->field, (len)) != 0)
+
+/**
+ * Check every view accessor of an object against fmapi_deserialize()
+ *
+ * @param[in] p __u8* Serialized object 
+ * @param[in] type unsigned Object type [FMOB]
+ * @param[in] o void* Deserialized object 
+ * @return number of accessors that disagree 
+ */
+unsigned view_check(__u8 *p, unsigned type, void *o)
+{
+	unsigned bad, i, k;
+
+	bad = 0;
+	switch (type)
+	{
+		case FMOB_HDR:
+			VIEW_EQ(hdr, category);
+			VIEW_EQ(hdr, tag);
+			VIEW_EQ(hdr, opcode);
+			VIEW_EQ(hdr, background);
+			VIEW_EQ(hdr, len);
+			VIEW_EQ(hdr, return_code);
+			VIEW_EQ(hdr, ext_status);
+			break;
+
+		case FMOB_ISC_ID_RSP:
+			VIEW_EQ(isc_id_rsp, vid);
+			VIEW_EQ(isc_id_rsp, did);
+			VIEW_EQ(isc_id_rsp, svid);
+			VIEW_EQ(isc_id_rsp, ssid);
+			VIEW_EQ(isc_id_rsp, sn);
+			VIEW_EQ(isc_id_rsp, size);
+			break;
+
+		case FMOB_ISC_MSG_LIMIT:
+			VIEW_EQ(isc_msg_limit, limit);
+			break;
+
+		case FMOB_ISC_BOS:
+			VIEW_EQ(isc_bos, running);
+			VIEW_EQ(isc_bos, pcnt);
+			VIEW_EQ(isc_bos, opcode);
+			VIEW_EQ(isc_bos, rc);
+			VIEW_EQ(isc_bos, ext);
+			break;
+
+		case FMOB_PSC_ID_RSP:
+			VIEW_EQ(psc_id_rsp, ingress_port);
+			VIEW_EQ(psc_id_rsp, num_ports);
+			VIEW_EQ(psc_id_rsp, num_vcss);
+			VIEW_MEM(psc_id_rsp, active_ports, sizeof(((struct fmapi_psc_id_rsp*) o)->active_ports));
+			VIEW_MEM(psc_id_rsp, active_vcss, sizeof(((struct fmapi_psc_id_rsp*) o)->active_vcss));
+			VIEW_EQ(psc_id_rsp, num_vppbs);
+			VIEW_EQ(psc_id_rsp, active_vppbs);
+			VIEW_EQ(psc_id_rsp, num_decoders);
+			break;
+
+		case FMOB_PSC_PORT_REQ:
+			VIEW_EQ(psc_port_req, num);
+			VIEW_MEM(psc_port_req, ports, ((struct fmapi_psc_port_req*) o)->num);
+			break;
+
+		case FMOB_PSC_PORT_INFO:
+		case FMOB_PSC_PORT_RSP:
+			k = 1;
+			if (type == FMOB_PSC_PORT_RSP)
+			{
+				VIEW_EQ(psc_port_rsp, num);
+				k = ((struct fmapi_psc_port_rsp*) o)->num;
+			}
+			for ( i = 0 ; i < k ; i++ )
+			{
+				struct fmapi_psc_port_info *q = (type == FMOB_PSC_PORT_RSP) ? &((struct fmapi_psc_port_rsp*) o)->list[i] : (struct fmapi_psc_port_info*) o;
+				struct fmapi_psc_port_info_view v = (type == FMOB_PSC_PORT_RSP) ? fmapi_psc_port_rsp_view_list(fmapi_psc_port_rsp_view(p), i) : fmapi_psc_port_info_view(p);
+
+				bad += (fmapi_psc_port_info_view_ppid(v) != q->ppid);
+				bad += (fmapi_psc_port_info_view_state(v) != q->state);
+				bad += (fmapi_psc_port_info_view_dv(v) != q->dv);
+				bad += (fmapi_psc_port_info_view_dt(v) != q->dt);
+				bad += (fmapi_psc_port_info_view_cv(v) != q->cv);
+				bad += (fmapi_psc_port_info_view_mlw(v) != q->mlw);
+				bad += (fmapi_psc_port_info_view_nlw(v) != q->nlw);
+				bad += (fmapi_psc_port_info_view_speeds(v) != q->speeds);
+				bad += (fmapi_psc_port_info_view_mls(v) != q->mls);
+				bad += (fmapi_psc_port_info_view_cls(v) != q->cls);
+				bad += (fmapi_psc_port_info_view_ltssm(v) != q->ltssm);
+				bad += (fmapi_psc_port_info_view_lane(v) != q->lane);
+				bad += (fmapi_psc_port_info_view_lane_rev(v) != q->lane_rev);
+				bad += (fmapi_psc_port_info_view_perst(v) != q->perst);
+				bad += (fmapi_psc_port_info_view_prsnt(v) != q->prsnt);
+				bad += (fmapi_psc_port_info_view_pwrctrl(v) != q->pwrctrl);
+				bad += (fmapi_psc_port_info_view_num_ld(v) != q->num_ld);
+			}
+			break;
+
+		case FMOB_PSC_PORT_CTRL_REQ:
+			VIEW_EQ(psc_port_ctrl_req, ppid);
+			VIEW_EQ(psc_port_ctrl_req, opcode);
+			break;
+
+		case FMOB_PSC_CFG_REQ:
+			VIEW_EQ(psc_cfg_req, ppid);
+			VIEW_EQ(psc_cfg_req, reg);
+			VIEW_EQ(psc_cfg_req, ext);
+			VIEW_EQ(psc_cfg_req, fdbe);
+			VIEW_EQ(psc_cfg_req, type);
+			VIEW_MEM(psc_cfg_req, data, 4);
+			break;
+
+		case FMOB_PSC_CFG_RSP:
+			VIEW_MEM(psc_cfg_rsp, data, 4);
+			break;
+
+		case FMOB_VSC_INFO_REQ:
+			VIEW_EQ(vsc_info_req, vppbid_start);
+			VIEW_EQ(vsc_info_req, vppbid_limit);
+			VIEW_EQ(vsc_info_req, num);
+			VIEW_MEM(vsc_info_req, vcss, ((struct fmapi_vsc_info_req*) o)->num);
+			break;
+
+		case FMOB_VSC_PPB_STAT_BLK:
+			VIEW_EQ(vsc_ppb_stat_blk, status);
+			VIEW_EQ(vsc_ppb_stat_blk, ppid);
+			VIEW_EQ(vsc_ppb_stat_blk, ldid);
+			break;
+
+		case FMOB_VSC_INFO_BLK:
+			VIEW_EQ(vsc_info_blk, vcsid);
+			VIEW_EQ(vsc_info_blk, state);
+			VIEW_EQ(vsc_info_blk, uspid);
+			VIEW_EQ(vsc_info_blk, total);
+			for ( i = 0 ; i < ((struct fmapi_vsc_info_blk*) o)->num ; i++ )
+			{
+				struct fmapi_vsc_ppb_stat_blk_view v = fmapi_vsc_info_blk_view_list(fmapi_vsc_info_blk_view(p), i);
+
+				bad += (fmapi_vsc_ppb_stat_blk_view_status(v) != ((struct fmapi_vsc_info_blk*) o)->list[i].status);
+				bad += (fmapi_vsc_ppb_stat_blk_view_ppid(v) != ((struct fmapi_vsc_info_blk*) o)->list[i].ppid);
+				bad += (fmapi_vsc_ppb_stat_blk_view_ldid(v) != ((struct fmapi_vsc_info_blk*) o)->list[i].ldid);
+			}
+			break;
+
+		case FMOB_VSC_INFO_RSP:
+			VIEW_EQ(vsc_info_rsp, num);
+			break;
+
+		case FMOB_VSC_BIND_REQ:
+			VIEW_EQ(vsc_bind_req, vcsid);
+			VIEW_EQ(vsc_bind_req, vppbid);
+			VIEW_EQ(vsc_bind_req, ppid);
+			VIEW_EQ(vsc_bind_req, ldid);
+			break;
+
+		case FMOB_VSC_UNBIND_REQ:
+			VIEW_EQ(vsc_unbind_req, vcsid);
+			VIEW_EQ(vsc_unbind_req, vppbid);
+			VIEW_EQ(vsc_unbind_req, option);
+			break;
+
+		case FMOB_VSC_AER_REQ:
+			VIEW_EQ(vsc_aer_req, vcsid);
+			VIEW_EQ(vsc_aer_req, vppbid);
+			VIEW_EQ(vsc_aer_req, error_type);
+			VIEW_MEM(vsc_aer_req, header, FM_TLP_HEADER);
+			break;
+
+		case FMOB_MPC_TMC_REQ:
+			VIEW_EQ(mpc_tmc_req, ppid);
+			VIEW_EQ(mpc_tmc_req, len);
+			VIEW_EQ(mpc_tmc_req, type);
+			VIEW_MEM(mpc_tmc_req, msg, ((struct fmapi_mpc_tmc_req*) o)->len);
+			break;
+
+		case FMOB_MPC_TMC_RSP:
+			VIEW_EQ(mpc_tmc_rsp, len);
+			VIEW_EQ(mpc_tmc_rsp, type);
+			VIEW_MEM(mpc_tmc_rsp, msg, ((struct fmapi_mpc_tmc_rsp*) o)->len);
+			break;
+
+		case FMOB_MPC_CFG_REQ:
+			VIEW_EQ(mpc_cfg_req, ppid);
+			VIEW_EQ(mpc_cfg_req, reg);
+			VIEW_EQ(mpc_cfg_req, ext);
+			VIEW_EQ(mpc_cfg_req, fdbe);
+			VIEW_EQ(mpc_cfg_req, type);
+			VIEW_EQ(mpc_cfg_req, ldid);
+			VIEW_MEM(mpc_cfg_req, data, 4);
+			break;
+
+		case FMOB_MPC_CFG_RSP:
+			VIEW_MEM(mpc_cfg_rsp, data, 4);
+			break;
+
+		case FMOB_MPC_MEM_REQ:
+			VIEW_EQ(mpc_mem_req, ppid);
+			VIEW_EQ(mpc_mem_req, fdbe);
+			VIEW_EQ(mpc_mem_req, ldbe);
+			VIEW_EQ(mpc_mem_req, type);
+			VIEW_EQ(mpc_mem_req, ldid);
+			VIEW_EQ(mpc_mem_req, len);
+			VIEW_EQ(mpc_mem_req, offset);
+			VIEW_MEM(mpc_mem_req, data, ((struct fmapi_mpc_mem_req*) o)->len);
+			break;
+
+		case FMOB_MPC_MEM_RSP:
+			VIEW_EQ(mpc_mem_rsp, len);
+			VIEW_MEM(mpc_mem_rsp, data, ((struct fmapi_mpc_mem_rsp*) o)->len);
+			break;
+
+		case FMOB_MCC_INFO_RSP:
+			VIEW_EQ(mcc_info_rsp, size);
+			VIEW_EQ(mcc_info_rsp, num);
+			VIEW_EQ(mcc_info_rsp, epc);
+			VIEW_EQ(mcc_info_rsp, ttr);
+			break;
+
+		case FMOB_MCC_ALLOC_BLK:
+			VIEW_EQ(mcc_alloc_blk, rng1);
+			VIEW_EQ(mcc_alloc_blk, rng2);
+			break;
+
+		case FMOB_MCC_ALLOC_GET_REQ:
+			VIEW_EQ(mcc_alloc_get_req, start);
+			VIEW_EQ(mcc_alloc_get_req, limit);
+			break;
+
+		case FMOB_MCC_ALLOC_GET_RSP:
+			VIEW_EQ(mcc_alloc_get_rsp, total);
+			VIEW_EQ(mcc_alloc_get_rsp, granularity);
+			VIEW_EQ(mcc_alloc_get_rsp, start);
+			VIEW_EQ(mcc_alloc_get_rsp, num);
+			for ( i = 0 ; i < ((struct fmapi_mcc_alloc_get_rsp*) o)->num ; i++ )
+			{
+				bad += (fmapi_mcc_alloc_blk_view_rng1(fmapi_mcc_alloc_get_rsp_view_list(fmapi_mcc_alloc_get_rsp_view(p), i)) != ((struct fmapi_mcc_alloc_get_rsp*) o)->list[i].rng1);
+				bad += (fmapi_mcc_alloc_blk_view_rng2(fmapi_mcc_alloc_get_rsp_view_list(fmapi_mcc_alloc_get_rsp_view(p), i)) != ((struct fmapi_mcc_alloc_get_rsp*) o)->list[i].rng2);
+			}
+			break;
+
+		case FMOB_MCC_ALLOC_SET_REQ:
+			VIEW_EQ(mcc_alloc_set_req, num);
+			VIEW_EQ(mcc_alloc_set_req, start);
+			for ( i = 0 ; i < ((struct fmapi_mcc_alloc_set_req*) o)->num ; i++ )
+			{
+				bad += (fmapi_mcc_alloc_blk_view_rng1(fmapi_mcc_alloc_set_req_view_list(fmapi_mcc_alloc_set_req_view(p), i)) != ((struct fmapi_mcc_alloc_set_req*) o)->list[i].rng1);
+				bad += (fmapi_mcc_alloc_blk_view_rng2(fmapi_mcc_alloc_set_req_view_list(fmapi_mcc_alloc_set_req_view(p), i)) != ((struct fmapi_mcc_alloc_set_req*) o)->list[i].rng2);
+			}
+			break;
+
+		case FMOB_MCC_ALLOC_SET_RSP:
+			VIEW_EQ(mcc_alloc_set_rsp, num);
+			VIEW_EQ(mcc_alloc_set_rsp, start);
+			for ( i = 0 ; i < ((struct fmapi_mcc_alloc_set_rsp*) o)->num ; i++ )
+			{
+				bad += (fmapi_mcc_alloc_blk_view_rng1(fmapi_mcc_alloc_set_rsp_view_list(fmapi_mcc_alloc_set_rsp_view(p), i)) != ((struct fmapi_mcc_alloc_set_rsp*) o)->list[i].rng1);
+				bad += (fmapi_mcc_alloc_blk_view_rng2(fmapi_mcc_alloc_set_rsp_view_list(fmapi_mcc_alloc_set_rsp_view(p), i)) != ((struct fmapi_mcc_alloc_set_rsp*) o)->list[i].rng2);
+			}
+			break;
+
+		case FMOB_MCC_QOS_CTRL:
+			VIEW_EQ(mcc_qos_ctrl, epc_en);
+			VIEW_EQ(mcc_qos_ctrl, ttr_en);
+			VIEW_EQ(mcc_qos_ctrl, egress_mod_pcnt);
+			VIEW_EQ(mcc_qos_ctrl, egress_sev_pcnt);
+			VIEW_EQ(mcc_qos_ctrl, sample_interval);
+			VIEW_EQ(mcc_qos_ctrl, rcb);
+			VIEW_EQ(mcc_qos_ctrl, comp_interval);
+			break;
+
+		case FMOB_MCC_QOS_STAT_RSP:
+			VIEW_EQ(mcc_qos_stat_rsp, bp_avg_pcnt);
+			break;
+
+		case FMOB_MCC_QOS_BW_GET_REQ:
+			VIEW_EQ(mcc_qos_bw_alloc_get_req, num);
+			VIEW_EQ(mcc_qos_bw_alloc_get_req, start);
+			break;
+
+		case FMOB_MCC_QOS_BW_ALLOC:
+			VIEW_EQ(mcc_qos_bw_alloc, num);
+			VIEW_EQ(mcc_qos_bw_alloc, start);
+			VIEW_MEM(mcc_qos_bw_alloc, list, ((struct fmapi_mcc_qos_bw_alloc*) o)->num);
+			break;
+
+		case FMOB_MCC_QOS_BW_LIMIT_GET_REQ:
+			VIEW_EQ(mcc_qos_bw_limit_get_req, num);
+			VIEW_EQ(mcc_qos_bw_limit_get_req, start);
+			break;
+
+		case FMOB_MCC_QOS_BW_LIMIT:
+			VIEW_EQ(mcc_qos_bw_limit, num);
+			VIEW_EQ(mcc_qos_bw_limit, start);
+			VIEW_MEM(mcc_qos_bw_limit, list, ((struct fmapi_mcc_qos_bw_limit*) o)->num);
+			break;
+
+		default:
+			bad++;
+			break;
+	}
+
+	return bad;
+}
+
+int verify_view()
+{
+	struct fmapi_vsc_info_req req;
+	struct fmapi_msg *m;
+	__u8 src[FMLN_PAYLOAD];
+	unsigned type, round, bad, fail;
+	int rv;
+	__u32 state;
+
+	/* STEPS 
+	 * For every object, a number of times:
+	 * 1: Fill a serialized object with random data
+	 * 2: Deserialize it 
+	 * 3: Check every view accessor against the deserialized object 
+	 */
+
+	m = fmapi_msg_alloc(FMOB_MAX, 0);
+	if (m == NULL)
+		return 1;
+
+	// The vPPB count of a VCS info block is derived from the request 
+	memset(&req, 0, sizeof(req));
+	req.vppbid_start = 0;
+	req.vppbid_limit = 4;
+
+	fail = 0;
+	state = 0x6A09E667;
+	for ( type = FMOB_HDR ; type < FMOB_MAX ; type++ )
+	{
+		for ( bad = 0, rv = 0, round = 0 ; round < 64 ; round++ )
+		{
+			// STEP 1: Fill a serialized object with random data
+			for ( unsigned i = 0 ; i < sizeof(src) ; i++ )
+				src[i] = test_rand(&state);
+			roundtrip_clamp(src, type, &state);
+
+			// STEP 2: Deserialize it 
+			memset(m, 0, sizeof(*m));
+			rv = fmapi_deserialize_len(&m->obj, src, sizeof(src), type, &req);
+			if (rv <= 0)
+				break;
+
+			// STEP 3: Check every view accessor against the deserialized object 
+			bad += view_check(src, type, &m->obj);
+		}
+
+		printf("FMOB %02u: len: %d mismatches: %u %s\n", type, rv, bad, ( (rv > 0) && (bad == 0) ) ? "PASS" : "FAIL");
+		if ( (rv <= 0) || bad )
+			fail++;
+	}
+	printf("View failures: %u\n", fail);
+
+	fmapi_msg_free(m);
+
+	return fail;
+}
+
 int main(int argc, char **argv)
 {
 	int i, max;
@@ -1137,10 +3856,33 @@ int main(int argc, char **argv)
 		"fmapi_isc_id_rsp",					// 34
 		"fmapi_isc_msg_limit",				// 35
 		"fmapi_isc_bos",					// 36
-		"sizeof()"
+		"sizeof()",							// 37
+		"deserialize_len",					// 38
+		"parser",							// 39
+		"transport",						// 40
+		"session",							// 41
+		"coalesce",							// 42
+		"msg_alloc",						// 43
+		"roundtrip",						// 44
+		"port_table",						// 45
+		"iov",								// 46
+		"batch",							// 47
+		"msg_decode",						// 48
+		"pool",								// 49
+		"arena",							// 50
+		"tunnel",							// 51
+		"retry",							// 52
+		"page",								// 53
+		"limit",							// 54
+		"ld_mem",							// 55
+		"cfg_snapshot",						// 56
+		"cfg_cache",							// 57
+		"bos_poll",								// 58
+		"bos_sched",							// 59
+		"view",									// 60
 	};
 
-	max = FMOB_MAX;
+	max = TEST_MAX - 1;
 
 	if (argc > 1)
 		i = atoi(argv[1]);
@@ -1193,6 +3935,29 @@ int main(int argc, char **argv)
 		case FMOB_ISC_MSG_LIMIT 			: verify_isc_msg_limit();      			break;	// 34, //!< struct fmapi_isc_msg_limit
 		case FMOB_ISC_BOS        	 		: verify_isc_bos();     	 			break;	// 36, //!< struct fmapi_isc_bos
 		case FMOB_MAX 						: verify_sizes();						break;  // 37
+		case TEST_DESERIALIZE_LEN 			: verify_deserialize_len();				break;  // 38
+		case TEST_PARSER 					: verify_parser();						break;  // 39
+		case TEST_TRANSPORT 				: verify_transport();					break;  // 40
+		case TEST_SESSION 					: verify_session();						break;  // 41
+		case TEST_COALESCE 					: verify_coalesce();					break;  // 42
+		case TEST_MSG_ALLOC 				: verify_msg_alloc();					break;  // 43
+		case TEST_ROUNDTRIP 				: verify_roundtrip();					break;  // 44
+		case TEST_PORT_TABLE 				: verify_port_table();					break;  // 45
+		case TEST_IOV 						: verify_iov();							break;  // 46
+		case TEST_BATCH 					: verify_batch();						break;  // 47
+		case TEST_MSG_DECODE 				: verify_msg_decode();					break;  // 48
+		case TEST_POOL 						: verify_pool();						break;  // 49
+		case TEST_ARENA 					: verify_arena();						break;  // 50
+		case TEST_TUNNEL 					: verify_tunnel();						break;  // 51
+		case TEST_RETRY 					: verify_retry();						break;  // 52
+		case TEST_PAGE 						: verify_page();							break;  // 53
+		case TEST_LIMIT 					: verify_limit();						break;  // 54
+		case TEST_LD_MEM 					: verify_ld_mem();						break;  // 55
+		case TEST_CFG_SNAPSHOT 				: verify_cfg_snapshot();					break;  // 56
+		case TEST_CFG_CACHE 				: verify_cfg_cache();					break;  // 57
+		case TEST_BOS_POLL 					: verify_bos_poll();					break;  // 58
+		case TEST_BOS_SCHED 				: verify_bos_sched();					break;  // 59
+		case TEST_VIEW 						: verify_view();						break;  // 60
 		default 							: print_strings();						break;
 	}
 
@@ -0,0 +1,594 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/**
+ * @file 		transport.c
+ *
+ * @brief 		Code file for the CXL Fabric Management API transport layer
+ *
+ * @details 	A transport moves complete FM API frames (header and payload).
+ * 				The reference backend carries frames over AF_UNIX stream or
+ * 				seqpacket sockets so clients and servers can run against a
+ * 				local endpoint without MCTP hardware.
+ *
+ * @copyright 	Copyright (C) 2024 Jackrabbit Founders LLC. All rights reserved.
+ *
+ * @date 		Oct 2026
+ * @author 		Barrett Edwards <code@jrlabs.io>
+ *
+ */
+/* INCLUDES ==================================================================*/
+
+/* accept4()
+ */
+#define _GNU_SOURCE
+
+/* errno
+ */
+#include <errno.h>
+
+/* memset(), strncpy()
+ */
+#include <string.h>
+
+/* calloc(), free()
+ */
+#include <stdlib.h>
+
+/* close(), unlink()
+ */
+#include <unistd.h>
+
+/* poll()
+ */
+#include <poll.h>
+
+/* socket(), sendmsg(), recv()
+ */
+#include <sys/socket.h>
+
+/* struct sockaddr_un
+ */
+#include <sys/un.h>
+
+#include "main.h"
+
+/* MACROS ====================================================================*/
+
+/**
+ * Size of the receive and scratch buffers of a transport. Holds any frame
+ */
+#define FMTP_BUF_LEN 	sizeof(struct fmapi_buf)
+
+/**
+ * Maximum number of pieces a frame may be split into for sending
+ */
+#define FMTP_MAX_IOV 	8
+
+/**
+ * Default longest wait in milliseconds for the peer to make room for a frame
+ */
+#define FMTP_SEND_MS 	1000
+
+/* PROTOTYPES ================================================================*/
+
+static int fmapi_unix_send_frame(struct fmapi_transport *t, const struct iovec *iov, int cnt);
+static int fmapi_unix_recv_frame(struct fmapi_transport *t, __u8 **frame);
+static int fmapi_unix_poll_fd(struct fmapi_transport *t);
+static void fmapi_unix_close(struct fmapi_transport *t);
+
+/* GLOBAL VARIABLES ==========================================================*/
+
+/**
+ * AF_UNIX stream / seqpacket backend
+ */
+static const struct fmapi_transport_ops FMTP_UNIX = {
+	.send_frame = fmapi_unix_send_frame,
+	.recv_frame = fmapi_unix_recv_frame,
+	.poll_fd 	= fmapi_unix_poll_fd,
+	.close 		= fmapi_unix_close,
+};
+
+/* FUNCTIONS =================================================================*/
+
+/**
+ * Send one frame on an AF_UNIX socket
+ *
+ * Blocks until the whole frame is written. A stream socket may accept only
+ * part of the frame. The remainder is sent after waiting for the socket to
+ * become writable, so a frame is never interleaved with another one. A
+ * seqpacket socket sends the frame as one record. A non blocking socket
+ * waits up to t->send_ms for the peer to make room.
+ *
+ * @param[in] t struct fmapi_transport*
+ * @param[in] iov const struct iovec* Frame split into cnt pieces
+ * @param[in] cnt int Number of entries in iov
+ * @return number of bytes sent, or a negative enum _FMER upon error
+ */
+static int fmapi_unix_send_frame(struct fmapi_transport *t, const struct iovec *iov, int cnt)
+{
+	struct iovec v[FMTP_MAX_IOV];
+	struct msghdr mh;
+	struct pollfd pfd;
+	size_t total;
+	ssize_t n;
+	int i, first, rv;
+
+	if ( (cnt < 1) || (cnt > FMTP_MAX_IOV) )
+		return -FMER_INVALID;
+
+	total = 0;
+	for ( i = 0 ; i < cnt ; i++ )
+	{
+		v[i] = iov[i];
+		total += iov[i].iov_len;
+	}
+
+	memset(&mh, 0, sizeof(mh));
+	mh.msg_iov = v;
+	mh.msg_iovlen = cnt;
+	first = 0;
+
+	while (first < cnt)
+	{
+		mh.msg_iov = &v[first];
+		mh.msg_iovlen = cnt - first;
+
+		n = sendmsg(t->fd, &mh, MSG_NOSIGNAL);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+			{
+				pfd.fd = t->fd;
+				pfd.events = POLLOUT;
+				pfd.revents = 0;
+				rv = poll(&pfd, 1, t->send_ms);
+				if ( (rv < 0) && (errno == EINTR) )
+					continue;
+				if (rv < 0)
+					return -FMER_IO;
+
+				// A peer that stopped reading. Part of a stream frame may be sent
+				if (rv == 0)
+					return -FMER_TIMEOUT;
+				if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))
+					return -FMER_IO;
+				continue;
+			}
+			if (errno == EPIPE)
+				return -FMER_CLOSED;
+			return -FMER_IO;
+		}
+
+		if (t->type == SOCK_SEQPACKET)
+			return ((size_t) n == total) ? (int) n : -FMER_IO;
+
+		// Skip the iovecs that were sent completely
+		while ( (first < cnt) && ((size_t) n >= v[first].iov_len) )
+			n -= v[first++].iov_len;
+		if (first < cnt)
+		{
+			v[first].iov_base = (__u8*) v[first].iov_base + n;
+			v[first].iov_len -= n;
+		}
+	}
+
+	return total;
+}
+
+/**
+ * Receive one frame from an AF_UNIX socket
+ *
+ * Bytes are read straight into the parser buffer. A stream socket keeps
+ * reading until a complete frame is buffered. A seqpacket record that does
+ * not fit in the buffer is rejected.
+ *
+ * @param[in] t struct fmapi_transport*
+ * @param[out] frame __u8** Set to the frame
+ * @return length of the frame, 0 if none is available, or a negative enum _FMER upon error
+ */
+static int fmapi_unix_recv_frame(struct fmapi_transport *t, __u8 **frame)
+{
+	size_t avail;
+	ssize_t n;
+	__u8 *space;
+	int rv, flags;
+
+	flags = (t->type == SOCK_SEQPACKET) ? MSG_TRUNC : 0;
+
+	for (;;)
+	{
+		rv = fmapi_parser_next(&t->parser, frame);
+		if (rv != 0)
+			return rv;
+
+		space = fmapi_parser_space(&t->parser, &avail);
+		if (avail == 0)
+		{
+			fmapi_parser_reset(&t->parser);
+			return -FMER_OVERFLOW;
+		}
+
+		n = recv(t->fd, space, avail, flags);
+		if (n == 0)
+			return -FMER_CLOSED;
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+				return 0;
+			return -FMER_IO;
+		}
+		if ((size_t) n > avail)
+		{
+			fmapi_parser_reset(&t->parser);
+			return -FMER_OVERFLOW;
+		}
+
+		fmapi_parser_commit(&t->parser, n);
+
+		// A seqpacket record must hold a whole frame
+		if (t->type == SOCK_SEQPACKET)
+		{
+			rv = fmapi_parser_next(&t->parser, frame);
+			if (rv == 0)
+			{
+				fmapi_parser_reset(&t->parser);
+				return -FMER_TRUNCATED;
+			}
+			return rv;
+		}
+	}
+}
+
+/**
+ * File descriptor of an AF_UNIX transport
+ */
+static int fmapi_unix_poll_fd(struct fmapi_transport *t)
+{
+	return t->fd;
+}
+
+/**
+ * Close an AF_UNIX transport and release its memory
+ */
+static void fmapi_unix_close(struct fmapi_transport *t)
+{
+	if (t->fd >= 0)
+		close(t->fd);
+	free(t);
+}
+
+/**
+ * Send one FM API frame over a transport
+ *
+ * @param[in] t struct fmapi_transport*
+ * @param[in] iov const struct iovec* Frame split into cnt pieces
+ * @param[in] cnt int Number of entries in iov
+ * @return number of bytes sent, or a negative enum _FMER upon error
+ */
+int fmapi_transport_send(struct fmapi_transport *t, const struct iovec *iov, int cnt)
+{
+	if ( (t == NULL) || (iov == NULL) )
+		return -FMER_INVALID;
+
+	return t->ops->send_frame(t, iov, cnt);
+}
+
+/**
+ * Receive one FM API frame from a transport
+ *
+ * @param[in] t struct fmapi_transport*
+ * @param[out] frame __u8** Set to the frame. Valid until the next receive
+ * @return length of the frame, 0 if none is available, or a negative enum _FMER upon error
+ */
+int fmapi_transport_recv(struct fmapi_transport *t, __u8 **frame)
+{
+	if ( (t == NULL) || (frame == NULL) )
+		return -FMER_INVALID;
+
+	return t->ops->recv_frame(t, frame);
+}
+
+/**
+ * File descriptor that becomes readable when a transport has data
+ *
+ * @param[in] t struct fmapi_transport*
+ * @return file descriptor, or -1 if the transport has none
+ */
+int fmapi_transport_poll_fd(struct fmapi_transport *t)
+{
+	if (t == NULL)
+		return -1;
+
+	return t->ops->poll_fd(t);
+}
+
+/**
+ * Close a transport and release its memory
+ *
+ * @param[in] t struct fmapi_transport* May be NULL
+ */
+void fmapi_transport_close(struct fmapi_transport *t)
+{
+	if (t == NULL)
+		return;
+
+	free(t->rxbuf);
+	t->ops->close(t);
+}
+
+/**
+ * Let a transport receive frames of up to len bytes
+ *
+ * @param[in] t struct fmapi_transport*
+ * @param[in] len size_t Length of the largest frame including the FM API Header
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_transport_set_max(struct fmapi_transport *t, size_t len)
+{
+	struct fmapi_parser *p;
+	__u8 *buf;
+
+	// Validate Inputs
+	if ( (t == NULL) || (len > (1UL << FM_MSG_LIMIT_MAX)) )
+		return -FMER_INVALID;
+
+	p = &t->parser;
+	if (len <= p->cap)
+		return 0;
+
+	buf = malloc(len);
+	if (buf == NULL)
+		return -FMER_OVERFLOW;
+
+	// Keep a partially received frame
+	memcpy(buf, &p->buf[p->off], p->end - p->off);
+	p->end -= p->off;
+	p->off = 0;
+	p->buf = buf;
+	p->cap = len;
+
+	free(t->rxbuf);
+	t->rxbuf = buf;
+
+	return 0;
+}
+
+/**
+ * Encode and send an FM API Message
+ *
+ * @param[in] t struct fmapi_transport*
+ * @param[in,out] m struct fmapi_msg* to send
+ * @param[in] category __u8 Request or Response [FMMT]
+ * @param[in] tag __u8 Tag used to match the response to the request
+ * @return number of bytes sent, or a negative enum _FMER upon error
+ */
+int fmapi_transport_send_msg(struct fmapi_transport *t, struct fmapi_msg *m, __u8 category, __u8 tag)
+{
+	struct iovec iov[2];
+	unsigned type;
+	int cnt;
+
+	// Validate Inputs
+	if ( (t == NULL) || (m == NULL) || (category >= FMMT_MAX) )
+		return -FMER_INVALID;
+
+	if (category == FMMT_REQ)
+		type = fmapi_fmob_req(m->hdr.opcode);
+	else
+		type = fmapi_fmob_rsp(m->hdr.opcode);
+
+	m->hdr.category = category;
+	m->hdr.tag = tag;
+
+	cnt = fmapi_serialize_iov(iov, 2, t->scratch, FMTP_BUF_LEN, &m->hdr, &m->obj, type, NULL);
+	if (cnt < 0)
+		return cnt;
+
+	return t->ops->send_frame(t, iov, cnt);
+}
+
+/**
+ * Receive and decode an FM API Message
+ *
+ * @param[in] t struct fmapi_transport*
+ * @param[out] m struct fmapi_msg* to decode into
+ * @param[in] param void * passed to fmapi_msg_decode()
+ * @return length of the frame, 0 if none is available, or a negative enum _FMER upon error
+ */
+int fmapi_transport_recv_msg(struct fmapi_transport *t, struct fmapi_msg *m, void *param)
+{
+	__u8 *frame;
+	int len, rv;
+
+	if ( (t == NULL) || (m == NULL) )
+		return -FMER_INVALID;
+
+	len = t->ops->recv_frame(t, &frame);
+	if (len <= 0)
+		return len;
+
+	rv = fmapi_msg_decode(m, frame, len, param);
+	if (rv < 0)
+		return rv;
+
+	return len;
+}
+
+/**
+ * Wrap a connected AF_UNIX socket in a transport
+ *
+ * The transport, its receive buffer and its scratch buffer are one allocation
+ *
+ * @param[in] fd int Connected socket
+ * @return struct fmapi_transport* upon success, NULL upon error
+ */
+struct fmapi_transport *fmapi_transport_unix_fd(int fd)
+{
+	struct fmapi_transport *t;
+	socklen_t len;
+	int type;
+
+	len = sizeof(type);
+	if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len) != 0)
+		return NULL;
+	if ( (type != SOCK_STREAM) && (type != SOCK_SEQPACKET) )
+		return NULL;
+
+	t = (struct fmapi_transport*) calloc(1, sizeof(*t) + 2 * FMTP_BUF_LEN);
+	if (t == NULL)
+		return NULL;
+
+	t->ops = &FMTP_UNIX;
+	t->fd = fd;
+	t->type = type;
+	t->send_ms = FMTP_SEND_MS;
+	t->scratch = (__u8*) &t[1];
+	fmapi_parser_init(&t->parser, t->scratch + FMTP_BUF_LEN, FMTP_BUF_LEN, NULL);
+
+	return t;
+}
+
+/**
+ * Fill in an AF_UNIX socket address
+ *
+ * @param[out] sa struct sockaddr_un* to fill
+ * @param[in] path const char* Filesystem path of the socket
+ * @return 0 upon success, or a negative enum _FMER if path is too long
+ */
+static int fmapi_unix_addr(struct sockaddr_un *sa, const char *path)
+{
+	if ( (path == NULL) || (strlen(path) >= sizeof(sa->sun_path)) )
+		return -FMER_INVALID;
+
+	memset(sa, 0, sizeof(*sa));
+	sa->sun_family = AF_UNIX;
+	strncpy(sa->sun_path, path, sizeof(sa->sun_path) - 1);
+
+	return 0;
+}
+
+/**
+ * Create a listening AF_UNIX socket
+ *
+ * @param[in] path const char* Filesystem path of the socket
+ * @param[in] type int SOCK_STREAM or SOCK_SEQPACKET
+ * @return listening file descriptor, or a negative enum _FMER upon error
+ */
+int fmapi_transport_unix_listen(const char *path, int type)
+{
+	struct sockaddr_un sa;
+	int fd;
+
+	if ( (type != SOCK_STREAM) && (type != SOCK_SEQPACKET) )
+		return -FMER_INVALID;
+	if (fmapi_unix_addr(&sa, path) != 0)
+		return -FMER_INVALID;
+
+	fd = socket(AF_UNIX, type | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -FMER_IO;
+
+	unlink(path);
+	if ( (bind(fd, (struct sockaddr*) &sa, sizeof(sa)) != 0) || (listen(fd, SOMAXCONN) != 0) )
+	{
+		close(fd);
+		return -FMER_IO;
+	}
+
+	return fd;
+}
+
+/**
+ * Accept a connection on a socket from fmapi_transport_unix_listen()
+ *
+ * @param[in] lfd int Listening file descriptor
+ * @return struct fmapi_transport* upon success, NULL upon error
+ */
+struct fmapi_transport *fmapi_transport_unix_accept(int lfd)
+{
+	struct fmapi_transport *t;
+	int fd;
+
+	do
+		fd = accept4(lfd, NULL, NULL, SOCK_CLOEXEC);
+	while ( (fd < 0) && (errno == EINTR) );
+	if (fd < 0)
+		return NULL;
+
+	t = fmapi_transport_unix_fd(fd);
+	if (t == NULL)
+		close(fd);
+
+	return t;
+}
+
+/**
+ * Connect to an AF_UNIX socket
+ *
+ * @param[in] path const char* Filesystem path of the socket
+ * @param[in] type int SOCK_STREAM or SOCK_SEQPACKET
+ * @return struct fmapi_transport* upon success, NULL upon error
+ */
+struct fmapi_transport *fmapi_transport_unix_connect(const char *path, int type)
+{
+	struct fmapi_transport *t;
+	struct sockaddr_un sa;
+	int fd;
+
+	if ( (type != SOCK_STREAM) && (type != SOCK_SEQPACKET) )
+		return NULL;
+	if (fmapi_unix_addr(&sa, path) != 0)
+		return NULL;
+
+	fd = socket(AF_UNIX, type | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return NULL;
+
+	if (connect(fd, (struct sockaddr*) &sa, sizeof(sa)) != 0)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	t = fmapi_transport_unix_fd(fd);
+	if (t == NULL)
+		close(fd);
+
+	return t;
+}
+
+/**
+ * Create a connected pair of loopback transports
+ *
+ * @param[in] type int SOCK_STREAM or SOCK_SEQPACKET
+ * @param[out] a struct fmapi_transport** First end
+ * @param[out] b struct fmapi_transport** Second end
+ * @return 0 upon success, or a negative enum _FMER upon error
+ */
+int fmapi_transport_unix_pair(int type, struct fmapi_transport **a, struct fmapi_transport **b)
+{
+	int sv[2];
+
+	if ( (a == NULL) || (b == NULL) )
+		return -FMER_INVALID;
+	if ( (type != SOCK_STREAM) && (type != SOCK_SEQPACKET) )
+		return -FMER_INVALID;
+
+	if (socketpair(AF_UNIX, type | SOCK_CLOEXEC, 0, sv) != 0)
+		return -FMER_IO;
+
+	*a = fmapi_transport_unix_fd(sv[0]);
+	*b = fmapi_transport_unix_fd(sv[1]);
+	if ( (*a == NULL) || (*b == NULL) )
+	{
+		if (*a != NULL) fmapi_transport_close(*a); else close(sv[0]);
+		if (*b != NULL) fmapi_transport_close(*b); else close(sv[1]);
+		*a = *b = NULL;
+		return -FMER_IO;
+	}
+
+	return 0;
+}